@@ -232,6 +232,24 @@ if(MSVC)
   endif()
 endif()
 
+# Flags for the sources (*_avx2.cpp) that hold runtime-dispatched AVX2 code paths
+set(OPENCV_AVX2_FLAGS "")
+ocv_clear_vars(HAVE_AVX2_DISPATCH)
+if(ENABLE_AVX2_DISPATCH)
+  if(MSVC)
+    # MSVC accepts AVX2 intrinsics without /arch:AVX2, so the rest of the code stays generic
+    if(NOT MSVC_VERSION LESS 1700)
+      set(HAVE_AVX2_DISPATCH 1)
+    endif()
+  elseif(CMAKE_COMPILER_IS_GNUCXX AND NOT MINGW)
+    ocv_check_flag_support(CXX "-mavx2" _varname "${OPENCV_EXTRA_CXX_FLAGS}")
+    if(${_varname})
+      set(OPENCV_AVX2_FLAGS "-mavx2")
+      set(HAVE_AVX2_DISPATCH 1)
+    endif()
+  endif()
+endif()
+
 # Extra link libs if the user selects building static libs:
 if(NOT BUILD_SHARED_LIBS AND CMAKE_COMPILER_IS_GNUCXX AND NOT ANDROID)
   # Android does not need these settings because they are already set by toolchain file
@@ -185,7 +185,8 @@ MACRO(ADD_PRECOMPILED_HEADER_TO_TARGET _targetName _input _pch_output_to_use )
 
     GET_TARGET_PROPERTY(_sources ${_targetName} SOURCES)
     FOREACH(src ${_sources})
-      if(NOT "${src}" MATCHES "\\.mm$")
+      # *_avx2.cpp are built with different code generation flags and must not see precomp.hpp
+      if(NOT "${src}" MATCHES "\\.mm$" AND NOT "${src}" MATCHES "_avx2\\.cpp$")
         get_source_file_property(_flags "${src}" COMPILE_FLAGS)
         if(_flags)
           set(_flags "${_flags} ${_target_cflags}")
@@ -166,6 +166,15 @@
 /* C= */
 #cmakedefine  HAVE_CSTRIPES
 
+/* Built-in pthreads thread pool for parallel_for_ */
+#cmakedefine  HAVE_PTHREADS_PF
+
+/* Trace regions (CV_TRACE_REGION) */
+#cmakedefine  ENABLE_TRACE
+
+/* AVX2 code paths selected at runtime */
+#cmakedefine  HAVE_AVX2_DISPATCH
+
 /* Eigen Matrix & Linear Algebra Library */
 #cmakedefine  HAVE_EIGEN
 
@@ -264,6 +264,7 @@ CV_EXPORTS_W int64 getCPUTickCount();
   - CV_CPU_SSE4_2 - SSE 4.2
   - CV_CPU_POPCNT - POPCOUNT
   - CV_CPU_AVX - AVX
+  - CV_CPU_AVX2 - AVX 2
 
   \note {Note that the function output is not static. Once you called cv::useOptimized(false),
   most of the hardware acceleration is disabled and thus the function will returns false,
@@ -1441,6 +1442,90 @@ public:
     virtual void deallocate(int* refcount, uchar* datastart, uchar* data) = 0;
 };
 
+/*!
+   Statistics of the pooling matrix allocator (see getPoolMatAllocator())
+*/
+struct CV_EXPORTS MatPoolStats
+{
+    MatPoolStats();
+
+    size_t hits;         //!< allocations served by the cached buffers
+    size_t misses;       //!< allocations served by the system allocator
+    size_t cachedBlocks; //!< the number of free buffers kept by the pool
+    size_t cachedBytes;  //!< the total size of the free buffers kept by the pool
+};
+
+/*!
+   Returns the pooling matrix allocator.
+
+   The buffers of the released matrices are not returned to the system,
+   but kept in size-class free lists (a small per-thread cache backed by the global pool)
+   and reused by the subsequent allocations of a similar size. Use it for the whole process with
+   Mat::setDefaultAllocator(getPoolMatAllocator()) or for a part of the code with MatAllocatorScope.
+   The matrices allocated by the pool keep using it for the further re-allocations.
+*/
+CV_EXPORTS MatAllocator* getPoolMatAllocator();
+//! returns the statistics of the pool; the numbers may be slightly off while other threads allocate
+CV_EXPORTS MatPoolStats getMatPoolStats();
+//! resets hits and misses of the pool
+CV_EXPORTS void resetMatPoolStats();
+//! returns the free buffers of the global pool and of the calling thread cache to the system
+CV_EXPORTS void trimMatPool();
+
+/*!
+   Sets the default allocator of the matrices created by the current thread until the object is destroyed
+
+   \code
+   {
+       MatAllocatorScope scope(getPoolMatAllocator());
+       for(;;)
+       {
+           cap >> frame;
+           cvtColor(frame, gray, CV_BGR2GRAY); // temporary buffers are reused between the frames
+           ...
+       }
+   }
+   \endcode
+*/
+class CV_EXPORTS MatAllocatorScope
+{
+public:
+    explicit MatAllocatorScope(MatAllocator* allocator);
+    ~MatAllocatorScope();
+
+protected:
+    MatAllocator* prevAllocator;
+
+private:
+    MatAllocatorScope(const MatAllocatorScope&);
+    MatAllocatorScope& operator = (const MatAllocatorScope&);
+};
+
+//! the file mapping modes of mapMat()
+enum
+{
+    MAP_READ_ONLY=0,     //!< the matrix data must not be modified
+    MAP_COPY_ON_WRITE=1, //!< the modified pages are private copies, the file stays unchanged
+    MAP_READ_WRITE=2     //!< the modifications are written back to the file
+};
+
+/*!
+   Maps the file written by writeMappedMat() to memory and returns the matrix that uses it without copying.
+
+   The pages are loaded by the system on demand, so the matrix may be much larger than the available RAM.
+   ROIs, headers and all the functions reading the matrix work directly on the mapped data; the file
+   is unmapped when the last matrix referencing it is released. Returns an empty matrix if the file
+   can not be opened.
+*/
+CV_EXPORTS Mat mapMat(const string& filename, int mode=MAP_READ_ONLY);
+//! maps the raw 2D matrix data stored in the file starting at the specified offset
+CV_EXPORTS Mat mapMat(const string& filename, Size size, int type, size_t offset=0, int mode=MAP_READ_ONLY);
+//! maps the raw n-dimensional matrix data stored in the file starting at the specified offset
+CV_EXPORTS Mat mapMat(const string& filename, int ndims, const int* sizes, int type,
+                      size_t offset=0, int mode=MAP_READ_ONLY);
+//! writes the matrix with a small header so that it can be loaded back with mapMat(filename)
+CV_EXPORTS void writeMappedMat(const string& filename, const Mat& m);
+
 /*!
    The n-dimensional matrix class.
 
@@ -1770,6 +1855,12 @@ public:
     static MatExpr eye(int rows, int cols, int type);
     static MatExpr eye(Size size, int type);
 
+    //! returns the allocator used by create() when the matrix has no custom allocator
+    // (the one set by MatAllocatorScope in the current thread or the process-wide one, NULL means fastMalloc)
+    static MatAllocator* getDefaultAllocator();
+    //! sets the process-wide default allocator
+    static void setDefaultAllocator(MatAllocator* allocator);
+
     //! allocates new matrix data unless the matrix already has specified size and type.
     // previous data is unreferenced if needed.
     void create(int rows, int cols, int type);
@@ -3987,7 +4078,8 @@ public:
         FORMAT_MASK=(7<<3),
         FORMAT_AUTO=0,
         FORMAT_XML=(1<<3),
-        FORMAT_YAML=(2<<3)
+        FORMAT_YAML=(2<<3),
+        FORMAT_BINARY=(3<<3) //!< the compact binary format, selected automatically for *.bin and *.bin.gz files
     };
     enum
     {
@@ -4612,6 +4704,112 @@ protected:
     Impl* impl;
 };
 
+////////////////////////////// Memory Usage Tracking /////////////////////////////////
+
+/*!
+ Memory usage counters of the buffers allocated by cv::fastMalloc (the matrix data,
+ memory storages etc.) while the tracking is enabled
+*/
+struct CV_EXPORTS MemoryUsage
+{
+    enum { MEMORY_HISTOGRAM_SIZE = 40 };
+
+    MemoryUsage();
+
+    int64 currentBytes;  //!< the size of the allocated and not yet released buffers
+    int64 peakBytes;     //!< the maximum of currentBytes since the last resetMemoryUsage()
+    int64 totalBytes;    //!< the total size of the buffers allocated since the last resetMemoryUsage()
+    int64 allocations;   //!< the number of allocations since the last resetMemoryUsage()
+    int64 deallocations; //!< the number of deallocations since the last resetMemoryUsage()
+    //! sizeHistogram[k] is the number of allocations of [2^k, 2^(k+1)) bytes (the last bucket takes all the larger ones)
+    vector<int64> sizeHistogram;
+};
+
+//! enables or disables tracking of the allocations; the buffers allocated while it is disabled are never accounted
+CV_EXPORTS void setMemoryTracking(bool enabled);
+CV_EXPORTS bool isMemoryTrackingEnabled();
+//! sets the peak usage to the current one and clears the rest of the counters
+CV_EXPORTS void resetMemoryUsage();
+//! returns the memory usage of the whole process
+CV_EXPORTS MemoryUsage getMemoryUsage();
+//! returns the memory usage per tag; the first tag is the empty one, it accounts the untagged allocations
+CV_EXPORTS void getMemoryUsage(vector<string>& tags, vector<MemoryUsage>& usage);
+//! writes the counters to the file storage
+CV_EXPORTS void write(FileStorage& fs, const string& name, const MemoryUsage& usage);
+//! writes the process-wide and the per-tag memory usage to the file storage
+CV_EXPORTS void writeMemoryUsage(FileStorage& fs, const string& name);
+
+/*!
+ Accounts the allocations made by the current thread to the specified tag until the object is destroyed
+
+ \code
+ setMemoryTracking(true);
+ {
+     MemoryTagScope tag("preprocessing");
+     cvtColor(frame, gray, CV_BGR2GRAY);
+     resize(gray, small, Size(), 0.5, 0.5);
+ }
+ FileStorage fs("memory.yml", FileStorage::WRITE);
+ writeMemoryUsage(fs, "memory_usage");
+ \endcode
+*/
+class CV_EXPORTS MemoryTagScope
+{
+public:
+    explicit MemoryTagScope(const string& tag);
+    ~MemoryTagScope();
+
+protected:
+    int prevTag;
+
+private:
+    MemoryTagScope(const MemoryTagScope&);
+    MemoryTagScope& operator = (const MemoryTagScope&);
+};
+
+////////////////////////////////// Trace Regions /////////////////////////////////////
+
+//! enables or disables collecting of the trace events
+CV_EXPORTS void setTracing(bool enabled);
+CV_EXPORTS bool isTracingEnabled();
+//! discards the collected events
+CV_EXPORTS void clearTrace();
+//! writes the collected events in the Chrome trace format (see chrome://tracing), one timeline per thread
+CV_EXPORTS bool writeTrace(const string& filename);
+
+/*!
+ Records the time spent between the construction and the destruction of the object
+ as a trace event of the current thread, when the tracing is enabled.
+
+ The name must be a string literal or have the static storage duration.
+ Inside the library the regions are placed with the CV_TRACE_REGION() macro,
+ which can be compiled out with the ENABLE_TRACE=OFF CMake option.
+
+ \code
+ setTracing(true);
+ for(;;)
+ {
+     TraceRegion frameRegion("frame");
+     ...
+ }
+ writeTrace("trace.json");
+ \endcode
+*/
+class CV_EXPORTS TraceRegion
+{
+public:
+    explicit TraceRegion(const char* name);
+    ~TraceRegion();
+
+protected:
+    const char* name;
+    int64 start;
+
+private:
+    TraceRegion(const TraceRegion&);
+    TraceRegion& operator = (const TraceRegion&);
+};
+
 /////////////////////////////// Parallel Primitives //////////////////////////////////
 
 // a base body class
@@ -4624,6 +4822,60 @@ public:
 
 CV_EXPORTS void parallel_for_(const Range& range, const ParallelLoopBody& body, double nstripes=-1.);
 
+/*!
+ The interface of the parallel_for_ backends.
+
+ parallel_for_ splits the range into stripes and passes them to the current backend
+ together with the thread budget of the calling thread (see ParallelScope).
+ The backend that OpenCV has been built with (TBB, OpenMP, pthreads etc.) and
+ the "serial" backend are always registered; the others can be registered by the user
+ and selected at runtime.
+*/
+class CV_EXPORTS ParallelForBackend
+{
+public:
+    virtual ~ParallelForBackend();
+    //! runs body over the stripes; maxThreads > 0 limits the number of threads processing them concurrently
+    virtual void parallel_for(const Range& stripes, const ParallelLoopBody& body, int maxThreads) = 0;
+    virtual int getNumThreads() const = 0;
+    virtual void setNumThreads(int nthreads) = 0;
+    virtual int getThreadNum() const = 0;
+};
+
+//! registers the backend under the specified name (the previously registered backend with the same name is replaced)
+CV_EXPORTS void registerParallelForBackend(const string& name, const Ptr<ParallelForBackend>& backend);
+//! makes the registered backend current; returns false if there is no backend with the specified name
+CV_EXPORTS bool setParallelForBackend(const string& name, bool propagateNumThreads=true);
+//! returns the name of the current backend
+CV_EXPORTS string getParallelForBackend();
+//! returns the names of all the registered backends
+CV_EXPORTS void getParallelForBackends(vector<string>& names);
+
+/*!
+ Limits the number of threads used by parallel_for_ called from the current thread.
+
+ The limit is active until the object is destroyed. Nested scopes can only decrease the limit.
+ \code
+ {
+     ParallelScope scope(2); // this pipeline uses at most 2 threads
+     GaussianBlur(frame, blurred, Size(7, 7), 1.5);
+ }
+ \endcode
+*/
+class CV_EXPORTS ParallelScope
+{
+public:
+    explicit ParallelScope(int maxThreads);
+    ~ParallelScope();
+
+protected:
+    int prevMaxThreads;
+
+private:
+    ParallelScope(const ParallelScope&);
+    ParallelScope& operator = (const ParallelScope&);
+};
+
 /////////////////////////// Synchronization Primitives ///////////////////////////////
 
 class CV_EXPORTS Mutex
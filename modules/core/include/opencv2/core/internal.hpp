@@ -371,6 +371,13 @@ namespace cv
 
 #define CV_DBG_BREAK() { volatile int* crashMe = 0; *crashMe = 0; }
 
+/* records the rest of the enclosing scope as a trace event (see cv::TraceRegion) */
+#ifdef ENABLE_TRACE
+#  define CV_TRACE_REGION(name) cv::TraceRegion cv_trace_region_(name)
+#else
+#  define CV_TRACE_REGION(name)
+#endif
+
 /* default step, set in case of continuous data
    to work around checks for valid step in some ipp functions */
 #define  CV_STUB_STEP     (1 << 30)
@@ -0,0 +1,904 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* The header is for internal use and it is likely to change.
+   It defines portable 128-bit vector types (v_uint8x16, v_int8x16, v_uint16x8, v_int16x8,
+   v_uint32x4, v_int32x4, v_float32x4) and the operations on them, so that a vectorized
+   kernel is written once and compiled to SSE2 on x86, to NEON on ARM and to plain C++
+   everywhere else.
+
+   Semantics that are common to all the implementations:
+   - 8- and 16-bit + and - saturate, 32-bit + and - wrap around;
+   - comparisons return a mask vector of the same type with all bits of a lane set or cleared;
+   - v_pack* saturate; v_round rounds to the nearest integer (ties are resolved the same
+     way as cvRound() does on the platform).
+
+   A kernel should be guarded with "#if CV_SIMD128" at compile time and with hasSIMD128()
+   at run time. Define CV_FORCE_SIMD128_CPP before including the header to use the
+   C++ reference implementation (useful for testing the kernels on any platform).
+*/
+#ifndef __OPENCV_CORE_INTRIN_HPP__
+#define __OPENCV_CORE_INTRIN_HPP__
+
+#include "opencv2/core/core.hpp"
+#include "opencv2/core/internal.hpp"
+#include <float.h>
+#include <string.h>
+
+#if !defined CV_FORCE_SIMD128_CPP && CV_SSE2
+#  define CV_SIMD128 1
+#  define CV_SIMD128_SSE2 1
+#elif !defined CV_FORCE_SIMD128_CPP && CV_NEON
+#  define CV_SIMD128 1
+#  define CV_SIMD128_NEON 1
+#else
+#  ifdef CV_FORCE_SIMD128_CPP
+#    define CV_SIMD128 1
+#  else
+#    define CV_SIMD128 0
+#  endif
+#  define CV_SIMD128_CPP 1
+#endif
+
+namespace cv
+{
+
+//! returns true if the vectorized kernels may be used on the current CPU
+static inline bool hasSIMD128()
+{
+#if defined CV_SIMD128_SSE2
+    return checkHardwareSupport(CV_CPU_SSE2);
+#else
+    return CV_SIMD128 != 0;
+#endif
+}
+
+#if defined CV_SIMD128_SSE2
+
+/****************************************************************************************\
+*                                    SSE2 implementation                                 *
+\****************************************************************************************/
+
+#define OPENCV_INTRIN_SSE2_TYPE(_Tpvec, _Tp, n, native, get0expr) \
+struct _Tpvec \
+{ \
+    typedef _Tp lane_type; \
+    enum { nlanes = n }; \
+    _Tpvec() {} \
+    explicit _Tpvec(const native& v) : val(v) {} \
+    _Tp get0() const { return (_Tp)get0expr; } \
+    native val; \
+};
+
+OPENCV_INTRIN_SSE2_TYPE(v_uint8x16, uchar, 16, __m128i, _mm_cvtsi128_si32(val))
+OPENCV_INTRIN_SSE2_TYPE(v_int8x16, schar, 16, __m128i, _mm_cvtsi128_si32(val))
+OPENCV_INTRIN_SSE2_TYPE(v_uint16x8, ushort, 8, __m128i, _mm_cvtsi128_si32(val))
+OPENCV_INTRIN_SSE2_TYPE(v_int16x8, short, 8, __m128i, _mm_cvtsi128_si32(val))
+OPENCV_INTRIN_SSE2_TYPE(v_uint32x4, unsigned, 4, __m128i, _mm_cvtsi128_si32(val))
+OPENCV_INTRIN_SSE2_TYPE(v_int32x4, int, 4, __m128i, _mm_cvtsi128_si32(val))
+OPENCV_INTRIN_SSE2_TYPE(v_float32x4, float, 4, __m128, _mm_cvtss_f32(val))
+
+#define OPENCV_INTRIN_SSE2_INT(_Tpvec, _Tp, suffix, setsuffix, _Tps, bits, addop, subop, signbit) \
+inline _Tpvec v_setzero_##suffix() { return _Tpvec(_mm_setzero_si128()); } \
+inline _Tpvec v_setall_##suffix(_Tp v) { return _Tpvec(_mm_set1_##setsuffix((_Tps)v)); } \
+inline _Tpvec v_load(const _Tp* ptr) { return _Tpvec(_mm_loadu_si128((const __m128i*)ptr)); } \
+inline _Tpvec v_load_aligned(const _Tp* ptr) { return _Tpvec(_mm_load_si128((const __m128i*)ptr)); } \
+inline _Tpvec v_load_low(const _Tp* ptr) { return _Tpvec(_mm_loadl_epi64((const __m128i*)ptr)); } \
+inline void v_store(_Tp* ptr, const _Tpvec& a) { _mm_storeu_si128((__m128i*)ptr, a.val); } \
+inline void v_store_aligned(_Tp* ptr, const _Tpvec& a) { _mm_store_si128((__m128i*)ptr, a.val); } \
+inline void v_store_low(_Tp* ptr, const _Tpvec& a) { _mm_storel_epi64((__m128i*)ptr, a.val); } \
+inline _Tpvec operator + (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(addop(a.val, b.val)); } \
+inline _Tpvec operator - (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(subop(a.val, b.val)); } \
+inline _Tpvec operator & (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(_mm_and_si128(a.val, b.val)); } \
+inline _Tpvec operator | (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(_mm_or_si128(a.val, b.val)); } \
+inline _Tpvec operator ^ (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(_mm_xor_si128(a.val, b.val)); } \
+inline _Tpvec operator ~ (const _Tpvec& a) { return _Tpvec(_mm_xor_si128(a.val, _mm_set1_epi32(-1))); } \
+inline _Tpvec operator == (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(_mm_cmpeq_epi##bits(a.val, b.val)); } \
+inline _Tpvec operator != (const _Tpvec& a, const _Tpvec& b) { return ~(a == b); } \
+inline _Tpvec operator < (const _Tpvec& a, const _Tpvec& b) \
+{ \
+    __m128i delta = signbit; \
+    return _Tpvec(_mm_cmplt_epi##bits(_mm_xor_si128(a.val, delta), _mm_xor_si128(b.val, delta))); \
+} \
+inline _Tpvec operator > (const _Tpvec& a, const _Tpvec& b) { return b < a; } \
+inline _Tpvec operator <= (const _Tpvec& a, const _Tpvec& b) { return ~(b < a); } \
+inline _Tpvec operator >= (const _Tpvec& a, const _Tpvec& b) { return ~(a < b); } \
+inline _Tpvec v_select(const _Tpvec& mask, const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(_mm_xor_si128(b.val, _mm_and_si128(_mm_xor_si128(a.val, b.val), mask.val))); }
+
+OPENCV_INTRIN_SSE2_INT(v_uint8x16, uchar, u8, epi8, char, 8, _mm_adds_epu8, _mm_subs_epu8, _mm_set1_epi8((char)0x80))
+OPENCV_INTRIN_SSE2_INT(v_int8x16, schar, s8, epi8, char, 8, _mm_adds_epi8, _mm_subs_epi8, _mm_setzero_si128())
+OPENCV_INTRIN_SSE2_INT(v_uint16x8, ushort, u16, epi16, short, 16, _mm_adds_epu16, _mm_subs_epu16, _mm_set1_epi16((short)0x8000))
+OPENCV_INTRIN_SSE2_INT(v_int16x8, short, s16, epi16, short, 16, _mm_adds_epi16, _mm_subs_epi16, _mm_setzero_si128())
+OPENCV_INTRIN_SSE2_INT(v_uint32x4, unsigned, u32, epi32, int, 32, _mm_add_epi32, _mm_sub_epi32, _mm_set1_epi32((int)0x80000000))
+OPENCV_INTRIN_SSE2_INT(v_int32x4, int, s32, epi32, int, 32, _mm_add_epi32, _mm_sub_epi32, _mm_setzero_si128())
+
+inline v_float32x4 v_setzero_f32() { return v_float32x4(_mm_setzero_ps()); }
+inline v_float32x4 v_setall_f32(float v) { return v_float32x4(_mm_set1_ps(v)); }
+inline v_float32x4 v_load(const float* ptr) { return v_float32x4(_mm_loadu_ps(ptr)); }
+inline v_float32x4 v_load_aligned(const float* ptr) { return v_float32x4(_mm_load_ps(ptr)); }
+inline v_float32x4 v_load_low(const float* ptr)
+{ return v_float32x4(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)ptr))); }
+inline void v_store(float* ptr, const v_float32x4& a) { _mm_storeu_ps(ptr, a.val); }
+inline void v_store_aligned(float* ptr, const v_float32x4& a) { _mm_store_ps(ptr, a.val); }
+inline void v_store_low(float* ptr, const v_float32x4& a) { _mm_storel_epi64((__m128i*)ptr, _mm_castps_si128(a.val)); }
+
+#define OPENCV_INTRIN_SSE2_FLT_OP(op, intrin) \
+inline v_float32x4 operator op (const v_float32x4& a, const v_float32x4& b) \
+{ return v_float32x4(intrin(a.val, b.val)); }
+
+OPENCV_INTRIN_SSE2_FLT_OP(+, _mm_add_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(-, _mm_sub_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(*, _mm_mul_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(/, _mm_div_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(&, _mm_and_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(|, _mm_or_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(^, _mm_xor_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(==, _mm_cmpeq_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(!=, _mm_cmpneq_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(<, _mm_cmplt_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(<=, _mm_cmple_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(>, _mm_cmpgt_ps)
+OPENCV_INTRIN_SSE2_FLT_OP(>=, _mm_cmpge_ps)
+
+inline v_float32x4 operator ~ (const v_float32x4& a)
+{ return v_float32x4(_mm_xor_ps(a.val, _mm_castsi128_ps(_mm_set1_epi32(-1)))); }
+inline v_float32x4 v_select(const v_float32x4& mask, const v_float32x4& a, const v_float32x4& b)
+{ return v_float32x4(_mm_xor_ps(b.val, _mm_and_ps(_mm_xor_ps(a.val, b.val), mask.val))); }
+
+// min/max
+inline v_uint8x16 v_min(const v_uint8x16& a, const v_uint8x16& b) { return v_uint8x16(_mm_min_epu8(a.val, b.val)); }
+inline v_uint8x16 v_max(const v_uint8x16& a, const v_uint8x16& b) { return v_uint8x16(_mm_max_epu8(a.val, b.val)); }
+inline v_int8x16 v_min(const v_int8x16& a, const v_int8x16& b) { return v_select(a < b, a, b); }
+inline v_int8x16 v_max(const v_int8x16& a, const v_int8x16& b) { return v_select(a > b, a, b); }
+inline v_uint16x8 v_min(const v_uint16x8& a, const v_uint16x8& b)
+{ return v_uint16x8(_mm_subs_epu16(a.val, _mm_subs_epu16(a.val, b.val))); }
+inline v_uint16x8 v_max(const v_uint16x8& a, const v_uint16x8& b)
+{ return v_uint16x8(_mm_adds_epu16(_mm_subs_epu16(a.val, b.val), b.val)); }
+inline v_int16x8 v_min(const v_int16x8& a, const v_int16x8& b) { return v_int16x8(_mm_min_epi16(a.val, b.val)); }
+inline v_int16x8 v_max(const v_int16x8& a, const v_int16x8& b) { return v_int16x8(_mm_max_epi16(a.val, b.val)); }
+inline v_uint32x4 v_min(const v_uint32x4& a, const v_uint32x4& b) { return v_select(a < b, a, b); }
+inline v_uint32x4 v_max(const v_uint32x4& a, const v_uint32x4& b) { return v_select(a > b, a, b); }
+inline v_int32x4 v_min(const v_int32x4& a, const v_int32x4& b) { return v_select(a < b, a, b); }
+inline v_int32x4 v_max(const v_int32x4& a, const v_int32x4& b) { return v_select(a > b, a, b); }
+inline v_float32x4 v_min(const v_float32x4& a, const v_float32x4& b) { return v_float32x4(_mm_min_ps(a.val, b.val)); }
+inline v_float32x4 v_max(const v_float32x4& a, const v_float32x4& b) { return v_float32x4(_mm_max_ps(a.val, b.val)); }
+
+// |a - b|; the result of the signed versions is unsigned, so it never overflows
+inline v_uint8x16 v_absdiff(const v_uint8x16& a, const v_uint8x16& b)
+{ return v_uint8x16(_mm_or_si128(_mm_subs_epu8(a.val, b.val), _mm_subs_epu8(b.val, a.val))); }
+inline v_uint16x8 v_absdiff(const v_uint16x8& a, const v_uint16x8& b)
+{ return v_uint16x8(_mm_or_si128(_mm_subs_epu16(a.val, b.val), _mm_subs_epu16(b.val, a.val))); }
+
+#define OPENCV_INTRIN_SSE2_ABSDIFF(_Tpuvec, _Tpvec, bits) \
+inline _Tpuvec v_absdiff(const _Tpvec& a, const _Tpvec& b) \
+{ \
+    __m128i d = _mm_sub_epi##bits(a.val, b.val), m = (b > a).val; \
+    return _Tpuvec(_mm_sub_epi##bits(_mm_xor_si128(d, m), m)); \
+}
+
+OPENCV_INTRIN_SSE2_ABSDIFF(v_uint8x16, v_int8x16, 8)
+OPENCV_INTRIN_SSE2_ABSDIFF(v_uint16x8, v_int16x8, 16)
+OPENCV_INTRIN_SSE2_ABSDIFF(v_uint32x4, v_uint32x4, 32)
+OPENCV_INTRIN_SSE2_ABSDIFF(v_uint32x4, v_int32x4, 32)
+
+inline v_float32x4 v_absdiff(const v_float32x4& a, const v_float32x4& b)
+{ return v_float32x4(_mm_and_ps(_mm_sub_ps(a.val, b.val), _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)))); }
+
+// shifts
+#define OPENCV_INTRIN_SSE2_SHIFT(_Tpvec, bits, srai) \
+inline _Tpvec operator << (const _Tpvec& a, int imm) { return _Tpvec(_mm_slli_epi##bits(a.val, imm)); } \
+inline _Tpvec operator >> (const _Tpvec& a, int imm) { return _Tpvec(srai##bits(a.val, imm)); }
+
+OPENCV_INTRIN_SSE2_SHIFT(v_uint16x8, 16, _mm_srli_epi)
+OPENCV_INTRIN_SSE2_SHIFT(v_int16x8, 16, _mm_srai_epi)
+OPENCV_INTRIN_SSE2_SHIFT(v_uint32x4, 32, _mm_srli_epi)
+OPENCV_INTRIN_SSE2_SHIFT(v_int32x4, 32, _mm_srai_epi)
+
+// pack with saturation
+inline v_uint8x16 v_pack(const v_uint16x8& a, const v_uint16x8& b)
+{
+    __m128i delta = _mm_set1_epi16(255);
+    return v_uint8x16(_mm_packus_epi16(_mm_subs_epu16(a.val, _mm_subs_epu16(a.val, delta)),
+                                       _mm_subs_epu16(b.val, _mm_subs_epu16(b.val, delta))));
+}
+inline v_int8x16 v_pack(const v_int16x8& a, const v_int16x8& b)
+{ return v_int8x16(_mm_packs_epi16(a.val, b.val)); }
+inline v_uint8x16 v_pack_u(const v_int16x8& a, const v_int16x8& b)
+{ return v_uint8x16(_mm_packus_epi16(a.val, b.val)); }
+inline v_int16x8 v_pack(const v_int32x4& a, const v_int32x4& b)
+{ return v_int16x8(_mm_packs_epi32(a.val, b.val)); }
+inline v_uint16x8 v_pack(const v_uint32x4& a, const v_uint32x4& b)
+{
+    // there is no unsigned 32->16 pack in SSE2: clip, shift to the signed range, pack, shift back
+    __m128i delta32 = _mm_set1_epi32(32768), delta16 = _mm_set1_epi16((short)0x8000);
+    v_uint32x4 maxval = v_setall_u32(65535);
+    __m128i a1 = _mm_sub_epi32(v_min(a, maxval).val, delta32);
+    __m128i b1 = _mm_sub_epi32(v_min(b, maxval).val, delta32);
+    return v_uint16x8(_mm_xor_si128(_mm_packs_epi32(a1, b1), delta16));
+}
+inline v_uint16x8 v_pack_u(const v_int32x4& a, const v_int32x4& b)
+{
+    __m128i delta32 = _mm_set1_epi32(32768), delta16 = _mm_set1_epi16((short)0x8000);
+    v_int32x4 z = v_setzero_s32(), maxval = v_setall_s32(65535);
+    __m128i a1 = _mm_sub_epi32(v_min(v_max(a, z), maxval).val, delta32);
+    __m128i b1 = _mm_sub_epi32(v_min(v_max(b, z), maxval).val, delta32);
+    return v_uint16x8(_mm_xor_si128(_mm_packs_epi32(a1, b1), delta16));
+}
+
+// widen the lower and the upper halves of a vector
+inline void v_expand(const v_uint8x16& a, v_uint16x8& b0, v_uint16x8& b1)
+{
+    __m128i z = _mm_setzero_si128();
+    b0.val = _mm_unpacklo_epi8(a.val, z);
+    b1.val = _mm_unpackhi_epi8(a.val, z);
+}
+inline void v_expand(const v_int8x16& a, v_int16x8& b0, v_int16x8& b1)
+{
+    b0.val = _mm_srai_epi16(_mm_unpacklo_epi8(a.val, a.val), 8);
+    b1.val = _mm_srai_epi16(_mm_unpackhi_epi8(a.val, a.val), 8);
+}
+inline void v_expand(const v_uint16x8& a, v_uint32x4& b0, v_uint32x4& b1)
+{
+    __m128i z = _mm_setzero_si128();
+    b0.val = _mm_unpacklo_epi16(a.val, z);
+    b1.val = _mm_unpackhi_epi16(a.val, z);
+}
+inline void v_expand(const v_int16x8& a, v_int32x4& b0, v_int32x4& b1)
+{
+    b0.val = _mm_srai_epi32(_mm_unpacklo_epi16(a.val, a.val), 16);
+    b1.val = _mm_srai_epi32(_mm_unpackhi_epi16(a.val, a.val), 16);
+}
+
+// full 32-bit products of the 16-bit lanes: c0 gets the lower half, c1 the upper one
+inline void v_mul_expand(const v_int16x8& a, const v_int16x8& b, v_int32x4& c0, v_int32x4& c1)
+{
+    __m128i lo = _mm_mullo_epi16(a.val, b.val), hi = _mm_mulhi_epi16(a.val, b.val);
+    c0.val = _mm_unpacklo_epi16(lo, hi);
+    c1.val = _mm_unpackhi_epi16(lo, hi);
+}
+
+inline v_uint16x8 v_load_expand(const uchar* ptr)
+{ return v_uint16x8(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)ptr), _mm_setzero_si128())); }
+inline v_int16x8 v_load_expand(const schar* ptr)
+{
+    __m128i a = _mm_loadl_epi64((const __m128i*)ptr);
+    return v_int16x8(_mm_srai_epi16(_mm_unpacklo_epi8(a, a), 8));
+}
+inline v_uint32x4 v_load_expand(const ushort* ptr)
+{ return v_uint32x4(_mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)ptr), _mm_setzero_si128())); }
+inline v_int32x4 v_load_expand(const short* ptr)
+{
+    __m128i a = _mm_loadl_epi64((const __m128i*)ptr);
+    return v_int32x4(_mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16));
+}
+
+// conversions and floating-point math
+inline v_float32x4 v_cvt_f32(const v_int32x4& a) { return v_float32x4(_mm_cvtepi32_ps(a.val)); }
+inline v_int32x4 v_round(const v_float32x4& a) { return v_int32x4(_mm_cvtps_epi32(a.val)); }
+inline v_int32x4 v_trunc(const v_float32x4& a) { return v_int32x4(_mm_cvttps_epi32(a.val)); }
+
+inline v_float32x4 v_sqrt(const v_float32x4& a) { return v_float32x4(_mm_sqrt_ps(a.val)); }
+inline v_float32x4 v_abs(const v_float32x4& a)
+{ return v_float32x4(_mm_and_ps(a.val, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)))); }
+inline v_float32x4 v_muladd(const v_float32x4& a, const v_float32x4& b, const v_float32x4& c)
+{ return v_float32x4(_mm_add_ps(_mm_mul_ps(a.val, b.val), c.val)); }
+
+// horizontal sums
+inline int v_reduce_sum(const v_int32x4& a)
+{
+    __m128i s = _mm_add_epi32(a.val, _mm_srli_si128(a.val, 8));
+    s = _mm_add_epi32(s, _mm_srli_si128(s, 4));
+    return _mm_cvtsi128_si32(s);
+}
+inline unsigned v_reduce_sum(const v_uint32x4& a)
+{ return (unsigned)v_reduce_sum(v_int32x4(a.val)); }
+inline float v_reduce_sum(const v_float32x4& a)
+{
+    __m128 s = _mm_add_ps(a.val, _mm_movehl_ps(a.val, a.val));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+// reinterpretation of the bits
+#define OPENCV_INTRIN_SSE2_REINTERPRET(_Tpvec, suffix) \
+template<typename _Tpvec0> inline _Tpvec v_reinterpret_as_##suffix(const _Tpvec0& a) \
+{ return _Tpvec(a.val); } \
+inline _Tpvec v_reinterpret_as_##suffix(const v_float32x4& a) \
+{ return _Tpvec(_mm_castps_si128(a.val)); }
+
+OPENCV_INTRIN_SSE2_REINTERPRET(v_uint8x16, u8)
+OPENCV_INTRIN_SSE2_REINTERPRET(v_int8x16, s8)
+OPENCV_INTRIN_SSE2_REINTERPRET(v_uint16x8, u16)
+OPENCV_INTRIN_SSE2_REINTERPRET(v_int16x8, s16)
+OPENCV_INTRIN_SSE2_REINTERPRET(v_uint32x4, u32)
+OPENCV_INTRIN_SSE2_REINTERPRET(v_int32x4, s32)
+
+template<typename _Tpvec0> inline v_float32x4 v_reinterpret_as_f32(const _Tpvec0& a)
+{ return v_float32x4(_mm_castsi128_ps(a.val)); }
+inline v_float32x4 v_reinterpret_as_f32(const v_float32x4& a) { return a; }
+
+#elif defined CV_SIMD128_NEON
+
+/****************************************************************************************\
+*                                    NEON implementation                                 *
+\****************************************************************************************/
+
+#define OPENCV_INTRIN_NEON_TYPE(_Tpvec, _Tp, n, native, suffix) \
+struct _Tpvec \
+{ \
+    typedef _Tp lane_type; \
+    enum { nlanes = n }; \
+    _Tpvec() {} \
+    explicit _Tpvec(const native& v) : val(v) {} \
+    _Tp get0() const { return vgetq_lane_##suffix(val, 0); } \
+    native val; \
+};
+
+OPENCV_INTRIN_NEON_TYPE(v_uint8x16, uchar, 16, uint8x16_t, u8)
+OPENCV_INTRIN_NEON_TYPE(v_int8x16, schar, 16, int8x16_t, s8)
+OPENCV_INTRIN_NEON_TYPE(v_uint16x8, ushort, 8, uint16x8_t, u16)
+OPENCV_INTRIN_NEON_TYPE(v_int16x8, short, 8, int16x8_t, s16)
+OPENCV_INTRIN_NEON_TYPE(v_uint32x4, unsigned, 4, uint32x4_t, u32)
+OPENCV_INTRIN_NEON_TYPE(v_int32x4, int, 4, int32x4_t, s32)
+OPENCV_INTRIN_NEON_TYPE(v_float32x4, float, 4, float32x4_t, f32)
+
+#define OPENCV_INTRIN_NEON_INIT(_Tpvec, _Tp, suffix, addop, subop) \
+inline _Tpvec v_setzero_##suffix() { return _Tpvec(vdupq_n_##suffix((_Tp)0)); } \
+inline _Tpvec v_setall_##suffix(_Tp v) { return _Tpvec(vdupq_n_##suffix(v)); } \
+inline _Tpvec v_load(const _Tp* ptr) { return _Tpvec(vld1q_##suffix(ptr)); } \
+inline _Tpvec v_load_aligned(const _Tp* ptr) { return _Tpvec(vld1q_##suffix(ptr)); } \
+inline _Tpvec v_load_low(const _Tp* ptr) { return _Tpvec(vcombine_##suffix(vld1_##suffix(ptr), vdup_n_##suffix((_Tp)0))); } \
+inline void v_store(_Tp* ptr, const _Tpvec& a) { vst1q_##suffix(ptr, a.val); } \
+inline void v_store_aligned(_Tp* ptr, const _Tpvec& a) { vst1q_##suffix(ptr, a.val); } \
+inline void v_store_low(_Tp* ptr, const _Tpvec& a) { vst1_##suffix(ptr, vget_low_##suffix(a.val)); } \
+inline _Tpvec operator + (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(addop##_##suffix(a.val, b.val)); } \
+inline _Tpvec operator - (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(subop##_##suffix(a.val, b.val)); } \
+inline _Tpvec v_min(const _Tpvec& a, const _Tpvec& b) { return _Tpvec(vminq_##suffix(a.val, b.val)); } \
+inline _Tpvec v_max(const _Tpvec& a, const _Tpvec& b) { return _Tpvec(vmaxq_##suffix(a.val, b.val)); }
+
+OPENCV_INTRIN_NEON_INIT(v_uint8x16, uchar, u8, vqaddq, vqsubq)
+OPENCV_INTRIN_NEON_INIT(v_int8x16, schar, s8, vqaddq, vqsubq)
+OPENCV_INTRIN_NEON_INIT(v_uint16x8, ushort, u16, vqaddq, vqsubq)
+OPENCV_INTRIN_NEON_INIT(v_int16x8, short, s16, vqaddq, vqsubq)
+OPENCV_INTRIN_NEON_INIT(v_uint32x4, unsigned, u32, vaddq, vsubq)
+OPENCV_INTRIN_NEON_INIT(v_int32x4, int, s32, vaddq, vsubq)
+OPENCV_INTRIN_NEON_INIT(v_float32x4, float, f32, vaddq, vsubq)
+
+// the bitwise operations, comparisons and v_select work on the unsigned view of the lanes
+#define OPENCV_INTRIN_NEON_UNSIGNED_VIEW(_Tpvec, suffix, usuffix, to_u, from_u) \
+inline _Tpvec operator & (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(from_u(vandq_##usuffix(to_u(a.val), to_u(b.val)))); } \
+inline _Tpvec operator | (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(from_u(vorrq_##usuffix(to_u(a.val), to_u(b.val)))); } \
+inline _Tpvec operator ^ (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(from_u(veorq_##usuffix(to_u(a.val), to_u(b.val)))); } \
+inline _Tpvec operator ~ (const _Tpvec& a) { return _Tpvec(from_u(vmvnq_##usuffix(to_u(a.val)))); } \
+inline _Tpvec operator == (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(from_u(vceqq_##suffix(a.val, b.val))); } \
+inline _Tpvec operator != (const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(from_u(vmvnq_##usuffix(vceqq_##suffix(a.val, b.val)))); } \
+inline _Tpvec operator < (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(from_u(vcltq_##suffix(a.val, b.val))); } \
+inline _Tpvec operator > (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(from_u(vcgtq_##suffix(a.val, b.val))); } \
+inline _Tpvec operator <= (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(from_u(vcleq_##suffix(a.val, b.val))); } \
+inline _Tpvec operator >= (const _Tpvec& a, const _Tpvec& b) { return _Tpvec(from_u(vcgeq_##suffix(a.val, b.val))); } \
+inline _Tpvec v_select(const _Tpvec& mask, const _Tpvec& a, const _Tpvec& b) \
+{ return _Tpvec(vbslq_##suffix(to_u(mask.val), a.val, b.val)); }
+
+#define OPENCV_INTRIN_NEON_NOCAST(x) (x)
+
+OPENCV_INTRIN_NEON_UNSIGNED_VIEW(v_uint8x16, u8, u8, OPENCV_INTRIN_NEON_NOCAST, OPENCV_INTRIN_NEON_NOCAST)
+OPENCV_INTRIN_NEON_UNSIGNED_VIEW(v_int8x16, s8, u8, vreinterpretq_u8_s8, vreinterpretq_s8_u8)
+OPENCV_INTRIN_NEON_UNSIGNED_VIEW(v_uint16x8, u16, u16, OPENCV_INTRIN_NEON_NOCAST, OPENCV_INTRIN_NEON_NOCAST)
+OPENCV_INTRIN_NEON_UNSIGNED_VIEW(v_int16x8, s16, u16, vreinterpretq_u16_s16, vreinterpretq_s16_u16)
+OPENCV_INTRIN_NEON_UNSIGNED_VIEW(v_uint32x4, u32, u32, OPENCV_INTRIN_NEON_NOCAST, OPENCV_INTRIN_NEON_NOCAST)
+OPENCV_INTRIN_NEON_UNSIGNED_VIEW(v_int32x4, s32, u32, vreinterpretq_u32_s32, vreinterpretq_s32_u32)
+OPENCV_INTRIN_NEON_UNSIGNED_VIEW(v_float32x4, f32, u32, vreinterpretq_u32_f32, vreinterpretq_f32_u32)
+
+inline v_float32x4 operator * (const v_float32x4& a, const v_float32x4& b)
+{ return v_float32x4(vmulq_f32(a.val, b.val)); }
+inline v_float32x4 operator / (const v_float32x4& a, const v_float32x4& b)
+{
+#ifdef __aarch64__
+    return v_float32x4(vdivq_f32(a.val, b.val));
+#else
+    // reciprocal estimate refined by two Newton-Raphson iterations
+    float32x4_t r = vrecpeq_f32(b.val);
+    r = vmulq_f32(vrecpsq_f32(b.val, r), r);
+    r = vmulq_f32(vrecpsq_f32(b.val, r), r);
+    return v_float32x4(vmulq_f32(a.val, r));
+#endif
+}
+
+inline v_uint8x16 v_absdiff(const v_uint8x16& a, const v_uint8x16& b) { return v_uint8x16(vabdq_u8(a.val, b.val)); }
+inline v_uint8x16 v_absdiff(const v_int8x16& a, const v_int8x16& b)
+{ return v_uint8x16(vreinterpretq_u8_s8(vabdq_s8(a.val, b.val))); }
+inline v_uint16x8 v_absdiff(const v_uint16x8& a, const v_uint16x8& b) { return v_uint16x8(vabdq_u16(a.val, b.val)); }
+inline v_uint16x8 v_absdiff(const v_int16x8& a, const v_int16x8& b)
+{ return v_uint16x8(vreinterpretq_u16_s16(vabdq_s16(a.val, b.val))); }
+inline v_uint32x4 v_absdiff(const v_uint32x4& a, const v_uint32x4& b) { return v_uint32x4(vabdq_u32(a.val, b.val)); }
+inline v_uint32x4 v_absdiff(const v_int32x4& a, const v_int32x4& b)
+{ return v_uint32x4(vreinterpretq_u32_s32(vabdq_s32(a.val, b.val))); }
+inline v_float32x4 v_absdiff(const v_float32x4& a, const v_float32x4& b) { return v_float32x4(vabdq_f32(a.val, b.val)); }
+
+// shifts; vshlq_* with a negative count shifts to the right
+#define OPENCV_INTRIN_NEON_SHIFT(_Tpvec, suffix, _Tps, ssuffix) \
+inline _Tpvec operator << (const _Tpvec& a, int imm) \
+{ return _Tpvec(vshlq_##suffix(a.val, vdupq_n_##ssuffix((_Tps)imm))); } \
+inline _Tpvec operator >> (const _Tpvec& a, int imm) \
+{ return _Tpvec(vshlq_##suffix(a.val, vdupq_n_##ssuffix((_Tps)-imm))); }
+
+OPENCV_INTRIN_NEON_SHIFT(v_uint16x8, u16, short, s16)
+OPENCV_INTRIN_NEON_SHIFT(v_int16x8, s16, short, s16)
+OPENCV_INTRIN_NEON_SHIFT(v_uint32x4, u32, int, s32)
+OPENCV_INTRIN_NEON_SHIFT(v_int32x4, s32, int, s32)
+
+#define OPENCV_INTRIN_NEON_PACK(_Tpvec, _Tpwvec, func, narrow, wsuffix) \
+inline _Tpvec func(const _Tpwvec& a, const _Tpwvec& b) \
+{ return _Tpvec(vcombine_##narrow(vq##func##_##wsuffix(a.val), vq##func##_##wsuffix(b.val))); }
+
+#define vqv_pack_u16 vqmovn_u16
+#define vqv_pack_s16 vqmovn_s16
+#define vqv_pack_u32 vqmovn_u32
+#define vqv_pack_s32 vqmovn_s32
+#define vqv_pack_u_s16 vqmovun_s16
+#define vqv_pack_u_s32 vqmovun_s32
+
+OPENCV_INTRIN_NEON_PACK(v_uint8x16, v_uint16x8, v_pack, u8, u16)
+OPENCV_INTRIN_NEON_PACK(v_int8x16, v_int16x8, v_pack, s8, s16)
+OPENCV_INTRIN_NEON_PACK(v_uint8x16, v_int16x8, v_pack_u, u8, s16)
+OPENCV_INTRIN_NEON_PACK(v_uint16x8, v_uint32x4, v_pack, u16, u32)
+OPENCV_INTRIN_NEON_PACK(v_int16x8, v_int32x4, v_pack, s16, s32)
+OPENCV_INTRIN_NEON_PACK(v_uint16x8, v_int32x4, v_pack_u, u16, s32)
+
+#undef vqv_pack_u16
+#undef vqv_pack_s16
+#undef vqv_pack_u32
+#undef vqv_pack_s32
+#undef vqv_pack_u_s16
+#undef vqv_pack_u_s32
+
+#define OPENCV_INTRIN_NEON_EXPAND(_Tpvec, _Tp, _Tpwvec, suffix) \
+inline void v_expand(const _Tpvec& a, _Tpwvec& b0, _Tpwvec& b1) \
+{ \
+    b0.val = vmovl_##suffix(vget_low_##suffix(a.val)); \
+    b1.val = vmovl_##suffix(vget_high_##suffix(a.val)); \
+} \
+inline _Tpwvec v_load_expand(const _Tp* ptr) { return _Tpwvec(vmovl_##suffix(vld1_##suffix(ptr))); }
+
+OPENCV_INTRIN_NEON_EXPAND(v_uint8x16, uchar, v_uint16x8, u8)
+OPENCV_INTRIN_NEON_EXPAND(v_int8x16, schar, v_int16x8, s8)
+OPENCV_INTRIN_NEON_EXPAND(v_uint16x8, ushort, v_uint32x4, u16)
+OPENCV_INTRIN_NEON_EXPAND(v_int16x8, short, v_int32x4, s16)
+
+inline void v_mul_expand(const v_int16x8& a, const v_int16x8& b, v_int32x4& c0, v_int32x4& c1)
+{
+    c0.val = vmull_s16(vget_low_s16(a.val), vget_low_s16(b.val));
+    c1.val = vmull_s16(vget_high_s16(a.val), vget_high_s16(b.val));
+}
+
+inline v_float32x4 v_cvt_f32(const v_int32x4& a) { return v_float32x4(vcvtq_f32_s32(a.val)); }
+inline v_int32x4 v_round(const v_float32x4& a)
+{
+#ifdef __aarch64__
+    return v_int32x4(vcvtnq_s32_f32(a.val));
+#else
+    // add +/-0.5 and truncate: ties are rounded away from zero, as cvRound() does on ARM
+    int32x4_t half = vreinterpretq_s32_f32(vdupq_n_f32(0.5f));
+    int32x4_t sign = vandq_s32(vreinterpretq_s32_f32(a.val), vdupq_n_s32((int)0x80000000));
+    return v_int32x4(vcvtq_s32_f32(vaddq_f32(a.val, vreinterpretq_f32_s32(vorrq_s32(half, sign)))));
+#endif
+}
+inline v_int32x4 v_trunc(const v_float32x4& a) { return v_int32x4(vcvtq_s32_f32(a.val)); }
+
+inline v_float32x4 v_sqrt(const v_float32x4& a)
+{
+#ifdef __aarch64__
+    return v_float32x4(vsqrtq_f32(a.val));
+#else
+    // a*rsqrt(a), the estimate is refined by two Newton-Raphson iterations;
+    // the input is clipped from below so that sqrt(0) = 0*finite = 0
+    float32x4_t x = vmaxq_f32(a.val, vdupq_n_f32(FLT_MIN));
+    float32x4_t e = vrsqrteq_f32(x);
+    e = vmulq_f32(vrsqrtsq_f32(vmulq_f32(x, e), e), e);
+    e = vmulq_f32(vrsqrtsq_f32(vmulq_f32(x, e), e), e);
+    return v_float32x4(vmulq_f32(a.val, e));
+#endif
+}
+inline v_float32x4 v_abs(const v_float32x4& a) { return v_float32x4(vabsq_f32(a.val)); }
+inline v_float32x4 v_muladd(const v_float32x4& a, const v_float32x4& b, const v_float32x4& c)
+{ return v_float32x4(vmlaq_f32(c.val, a.val, b.val)); }
+
+inline int v_reduce_sum(const v_int32x4& a)
+{
+    int32x2_t s = vadd_s32(vget_low_s32(a.val), vget_high_s32(a.val));
+    return vget_lane_s32(vpadd_s32(s, s), 0);
+}
+inline unsigned v_reduce_sum(const v_uint32x4& a)
+{
+    uint32x2_t s = vadd_u32(vget_low_u32(a.val), vget_high_u32(a.val));
+    return vget_lane_u32(vpadd_u32(s, s), 0);
+}
+inline float v_reduce_sum(const v_float32x4& a)
+{
+    float32x2_t s = vadd_f32(vget_low_f32(a.val), vget_high_f32(a.val));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+// reinterpretation of the bits; everything goes through the u8 view
+#define OPENCV_INTRIN_NEON_TO_U8(_Tpvec, suffix) \
+inline v_uint8x16 v_reinterpret_as_u8(const _Tpvec& a) { return v_uint8x16(vreinterpretq_u8_##suffix(a.val)); }
+
+inline v_uint8x16 v_reinterpret_as_u8(const v_uint8x16& a) { return a; }
+OPENCV_INTRIN_NEON_TO_U8(v_int8x16, s8)
+OPENCV_INTRIN_NEON_TO_U8(v_uint16x8, u16)
+OPENCV_INTRIN_NEON_TO_U8(v_int16x8, s16)
+OPENCV_INTRIN_NEON_TO_U8(v_uint32x4, u32)
+OPENCV_INTRIN_NEON_TO_U8(v_int32x4, s32)
+OPENCV_INTRIN_NEON_TO_U8(v_float32x4, f32)
+
+#define OPENCV_INTRIN_NEON_REINTERPRET(_Tpvec, suffix) \
+template<typename _Tpvec0> inline _Tpvec v_reinterpret_as_##suffix(const _Tpvec0& a) \
+{ return _Tpvec(vreinterpretq_##suffix##_u8(v_reinterpret_as_u8(a).val)); } \
+inline _Tpvec v_reinterpret_as_##suffix(const _Tpvec& a) { return a; }
+
+OPENCV_INTRIN_NEON_REINTERPRET(v_int8x16, s8)
+OPENCV_INTRIN_NEON_REINTERPRET(v_uint16x8, u16)
+OPENCV_INTRIN_NEON_REINTERPRET(v_int16x8, s16)
+OPENCV_INTRIN_NEON_REINTERPRET(v_uint32x4, u32)
+OPENCV_INTRIN_NEON_REINTERPRET(v_int32x4, s32)
+OPENCV_INTRIN_NEON_REINTERPRET(v_float32x4, f32)
+
+#else
+
+/****************************************************************************************\
+*                               C++ reference implementation                             *
+\****************************************************************************************/
+
+template<typename _Tp, int n> struct v_reg
+{
+    typedef _Tp lane_type;
+    enum { nlanes = n };
+    v_reg() {}
+    _Tp get0() const { return s[0]; }
+    _Tp s[n];
+};
+
+typedef v_reg<uchar, 16> v_uint8x16;
+typedef v_reg<schar, 16> v_int8x16;
+typedef v_reg<ushort, 8> v_uint16x8;
+typedef v_reg<short, 8> v_int16x8;
+typedef v_reg<unsigned, 4> v_uint32x4;
+typedef v_reg<int, 4> v_int32x4;
+typedef v_reg<float, 4> v_float32x4;
+
+// per-lane arithmetic of the particular type and the integer view of its bits
+template<typename _Tp> struct V_TypeTraits {};
+
+#define OPENCV_INTRIN_CPP_TRAITS(_Tp, _IntTp, _AbsTp, addexpr, subexpr) \
+template<> struct V_TypeTraits<_Tp> \
+{ \
+    typedef _IntTp int_type; \
+    typedef _AbsTp abs_type; \
+    static _Tp add(_Tp a, _Tp b) { return addexpr; } \
+    static _Tp sub(_Tp a, _Tp b) { return subexpr; } \
+    static _Tp mul(_Tp a, _Tp b) { return (_Tp)(a*b); } \
+    static _Tp div(_Tp a, _Tp b) { return (_Tp)(a/b); } \
+    static int_type reinterpret_int(_Tp x) { union { _Tp l; int_type i; } v; v.l = x; return v.i; } \
+    static _Tp reinterpret_from_int(int_type x) { union { _Tp l; int_type i; } v; v.i = x; return v.l; } \
+};
+
+OPENCV_INTRIN_CPP_TRAITS(uchar, uchar, uchar, saturate_cast<uchar>((int)a + b), saturate_cast<uchar>((int)a - b))
+OPENCV_INTRIN_CPP_TRAITS(schar, schar, uchar, saturate_cast<schar>((int)a + b), saturate_cast<schar>((int)a - b))
+OPENCV_INTRIN_CPP_TRAITS(ushort, ushort, ushort, saturate_cast<ushort>((int)a + b), saturate_cast<ushort>((int)a - b))
+OPENCV_INTRIN_CPP_TRAITS(short, short, ushort, saturate_cast<short>((int)a + b), saturate_cast<short>((int)a - b))
+OPENCV_INTRIN_CPP_TRAITS(unsigned, unsigned, unsigned, a + b, a - b)
+OPENCV_INTRIN_CPP_TRAITS(int, int, unsigned, (int)((unsigned)a + (unsigned)b), (int)((unsigned)a - (unsigned)b))
+OPENCV_INTRIN_CPP_TRAITS(float, int, float, a + b, a - b)
+
+#define OPENCV_INTRIN_CPP_INIT(_Tpvec, _Tp, suffix) \
+inline _Tpvec v_setzero_##suffix() { _Tpvec c; for( int i = 0; i < _Tpvec::nlanes; i++ ) c.s[i] = 0; return c; } \
+inline _Tpvec v_setall_##suffix(_Tp v) { _Tpvec c; for( int i = 0; i < _Tpvec::nlanes; i++ ) c.s[i] = v; return c; } \
+inline _Tpvec v_load(const _Tp* ptr) { _Tpvec c; for( int i = 0; i < _Tpvec::nlanes; i++ ) c.s[i] = ptr[i]; return c; } \
+inline _Tpvec v_load_aligned(const _Tp* ptr) { return v_load(ptr); } \
+inline _Tpvec v_load_low(const _Tp* ptr) \
+{ \
+    _Tpvec c; \
+    for( int i = 0; i < _Tpvec::nlanes/2; i++ ) \
+    { \
+        c.s[i] = ptr[i]; \
+        c.s[i + _Tpvec::nlanes/2] = 0; \
+    } \
+    return c; \
+} \
+inline void v_store(_Tp* ptr, const _Tpvec& a) { for( int i = 0; i < _Tpvec::nlanes; i++ ) ptr[i] = a.s[i]; } \
+inline void v_store_aligned(_Tp* ptr, const _Tpvec& a) { v_store(ptr, a); } \
+inline void v_store_low(_Tp* ptr, const _Tpvec& a) { for( int i = 0; i < _Tpvec::nlanes/2; i++ ) ptr[i] = a.s[i]; }
+
+OPENCV_INTRIN_CPP_INIT(v_uint8x16, uchar, u8)
+OPENCV_INTRIN_CPP_INIT(v_int8x16, schar, s8)
+OPENCV_INTRIN_CPP_INIT(v_uint16x8, ushort, u16)
+OPENCV_INTRIN_CPP_INIT(v_int16x8, short, s16)
+OPENCV_INTRIN_CPP_INIT(v_uint32x4, unsigned, u32)
+OPENCV_INTRIN_CPP_INIT(v_int32x4, int, s32)
+OPENCV_INTRIN_CPP_INIT(v_float32x4, float, f32)
+
+#define OPENCV_INTRIN_CPP_BIN_OP(op, expr) \
+template<typename _Tp, int n> inline v_reg<_Tp, n> operator op (const v_reg<_Tp, n>& a, const v_reg<_Tp, n>& b) \
+{ \
+    typedef V_TypeTraits<_Tp> T; \
+    v_reg<_Tp, n> c; \
+    for( int i = 0; i < n; i++ ) \
+        c.s[i] = expr; \
+    return c; \
+}
+
+OPENCV_INTRIN_CPP_BIN_OP(+, T::add(a.s[i], b.s[i]))
+OPENCV_INTRIN_CPP_BIN_OP(-, T::sub(a.s[i], b.s[i]))
+OPENCV_INTRIN_CPP_BIN_OP(*, T::mul(a.s[i], b.s[i]))
+OPENCV_INTRIN_CPP_BIN_OP(/, T::div(a.s[i], b.s[i]))
+OPENCV_INTRIN_CPP_BIN_OP(&, T::reinterpret_from_int(T::reinterpret_int(a.s[i]) & T::reinterpret_int(b.s[i])))
+OPENCV_INTRIN_CPP_BIN_OP(|, T::reinterpret_from_int(T::reinterpret_int(a.s[i]) | T::reinterpret_int(b.s[i])))
+OPENCV_INTRIN_CPP_BIN_OP(^, T::reinterpret_from_int(T::reinterpret_int(a.s[i]) ^ T::reinterpret_int(b.s[i])))
+
+#define OPENCV_INTRIN_CPP_CMP_OP(op) \
+OPENCV_INTRIN_CPP_BIN_OP(op, T::reinterpret_from_int(a.s[i] op b.s[i] ? (typename T::int_type)-1 : 0))
+
+OPENCV_INTRIN_CPP_CMP_OP(==)
+OPENCV_INTRIN_CPP_CMP_OP(!=)
+OPENCV_INTRIN_CPP_CMP_OP(<)
+OPENCV_INTRIN_CPP_CMP_OP(>)
+OPENCV_INTRIN_CPP_CMP_OP(<=)
+OPENCV_INTRIN_CPP_CMP_OP(>=)
+
+template<typename _Tp, int n> inline v_reg<_Tp, n> operator ~ (const v_reg<_Tp, n>& a)
+{
+    typedef V_TypeTraits<_Tp> T;
+    v_reg<_Tp, n> c;
+    for( int i = 0; i < n; i++ )
+        c.s[i] = T::reinterpret_from_int(~T::reinterpret_int(a.s[i]));
+    return c;
+}
+
+template<typename _Tp, int n> inline v_reg<_Tp, n> v_select(const v_reg<_Tp, n>& mask, const v_reg<_Tp, n>& a,
+                                                            const v_reg<_Tp, n>& b)
+{
+    typedef V_TypeTraits<_Tp> T;
+    v_reg<_Tp, n> c;
+    for( int i = 0; i < n; i++ )
+    {
+        typename T::int_type ia = T::reinterpret_int(a.s[i]), ib = T::reinterpret_int(b.s[i]);
+        c.s[i] = T::reinterpret_from_int(ib ^ ((ia ^ ib) & T::reinterpret_int(mask.s[i])));
+    }
+    return c;
+}
+
+template<typename _Tp, int n> inline v_reg<_Tp, n> v_min(const v_reg<_Tp, n>& a, const v_reg<_Tp, n>& b)
+{
+    v_reg<_Tp, n> c;
+    for( int i = 0; i < n; i++ )
+        c.s[i] = std::min(a.s[i], b.s[i]);
+    return c;
+}
+
+template<typename _Tp, int n> inline v_reg<_Tp, n> v_max(const v_reg<_Tp, n>& a, const v_reg<_Tp, n>& b)
+{
+    v_reg<_Tp, n> c;
+    for( int i = 0; i < n; i++ )
+        c.s[i] = std::max(a.s[i], b.s[i]);
+    return c;
+}
+
+template<typename _Tp, int n> inline v_reg<typename V_TypeTraits<_Tp>::abs_type, n>
+v_absdiff(const v_reg<_Tp, n>& a, const v_reg<_Tp, n>& b)
+{
+    typedef typename V_TypeTraits<_Tp>::abs_type _AbsTp;
+    v_reg<_AbsTp, n> c;
+    for( int i = 0; i < n; i++ )
+        c.s[i] = a.s[i] > b.s[i] ? (_AbsTp)((_AbsTp)a.s[i] - (_AbsTp)b.s[i]) :
+                                   (_AbsTp)((_AbsTp)b.s[i] - (_AbsTp)a.s[i]);
+    return c;
+}
+
+#define OPENCV_INTRIN_CPP_SHIFT(_Tpvec) \
+inline _Tpvec operator << (const _Tpvec& a, int imm) \
+{ \
+    _Tpvec c; \
+    for( int i = 0; i < _Tpvec::nlanes; i++ ) \
+        c.s[i] = (_Tpvec::lane_type)(a.s[i] << imm); \
+    return c; \
+} \
+inline _Tpvec operator >> (const _Tpvec& a, int imm) \
+{ \
+    _Tpvec c; \
+    for( int i = 0; i < _Tpvec::nlanes; i++ ) \
+        c.s[i] = (_Tpvec::lane_type)(a.s[i] >> imm); \
+    return c; \
+}
+
+OPENCV_INTRIN_CPP_SHIFT(v_uint16x8)
+OPENCV_INTRIN_CPP_SHIFT(v_int16x8)
+OPENCV_INTRIN_CPP_SHIFT(v_uint32x4)
+OPENCV_INTRIN_CPP_SHIFT(v_int32x4)
+
+#define OPENCV_INTRIN_CPP_PACK(_Tpvec, _Tpwvec, func) \
+inline _Tpvec func(const _Tpwvec& a, const _Tpwvec& b) \
+{ \
+    _Tpvec c; \
+    for( int i = 0; i < _Tpwvec::nlanes; i++ ) \
+    { \
+        c.s[i] = saturate_cast<_Tpvec::lane_type>(a.s[i]); \
+        c.s[i + _Tpwvec::nlanes] = saturate_cast<_Tpvec::lane_type>(b.s[i]); \
+    } \
+    return c; \
+}
+
+OPENCV_INTRIN_CPP_PACK(v_uint8x16, v_uint16x8, v_pack)
+OPENCV_INTRIN_CPP_PACK(v_int8x16, v_int16x8, v_pack)
+OPENCV_INTRIN_CPP_PACK(v_uint8x16, v_int16x8, v_pack_u)
+OPENCV_INTRIN_CPP_PACK(v_uint16x8, v_uint32x4, v_pack)
+OPENCV_INTRIN_CPP_PACK(v_int16x8, v_int32x4, v_pack)
+OPENCV_INTRIN_CPP_PACK(v_uint16x8, v_int32x4, v_pack_u)
+
+#define OPENCV_INTRIN_CPP_EXPAND(_Tpvec, _Tp, _Tpwvec) \
+inline void v_expand(const _Tpvec& a, _Tpwvec& b0, _Tpwvec& b1) \
+{ \
+    for( int i = 0; i < _Tpwvec::nlanes; i++ ) \
+    { \
+        b0.s[i] = a.s[i]; \
+        b1.s[i] = a.s[i + _Tpwvec::nlanes]; \
+    } \
+} \
+inline _Tpwvec v_load_expand(const _Tp* ptr) \
+{ \
+    _Tpwvec c; \
+    for( int i = 0; i < _Tpwvec::nlanes; i++ ) \
+        c.s[i] = ptr[i]; \
+    return c; \
+}
+
+OPENCV_INTRIN_CPP_EXPAND(v_uint8x16, uchar, v_uint16x8)
+OPENCV_INTRIN_CPP_EXPAND(v_int8x16, schar, v_int16x8)
+OPENCV_INTRIN_CPP_EXPAND(v_uint16x8, ushort, v_uint32x4)
+OPENCV_INTRIN_CPP_EXPAND(v_int16x8, short, v_int32x4)
+
+inline void v_mul_expand(const v_int16x8& a, const v_int16x8& b, v_int32x4& c0, v_int32x4& c1)
+{
+    for( int i = 0; i < 4; i++ )
+    {
+        c0.s[i] = (int)a.s[i]*b.s[i];
+        c1.s[i] = (int)a.s[i + 4]*b.s[i + 4];
+    }
+}
+
+inline v_float32x4 v_cvt_f32(const v_int32x4& a)
+{
+    v_float32x4 c;
+    for( int i = 0; i < 4; i++ )
+        c.s[i] = (float)a.s[i];
+    return c;
+}
+
+inline v_int32x4 v_round(const v_float32x4& a)
+{
+    v_int32x4 c;
+    for( int i = 0; i < 4; i++ )
+        c.s[i] = cvRound(a.s[i]);
+    return c;
+}
+
+inline v_int32x4 v_trunc(const v_float32x4& a)
+{
+    v_int32x4 c;
+    for( int i = 0; i < 4; i++ )
+        c.s[i] = (int)a.s[i];
+    return c;
+}
+
+inline v_float32x4 v_sqrt(const v_float32x4& a)
+{
+    v_float32x4 c;
+    for( int i = 0; i < 4; i++ )
+        c.s[i] = std::sqrt(a.s[i]);
+    return c;
+}
+
+inline v_float32x4 v_abs(const v_float32x4& a)
+{
+    v_float32x4 c;
+    for( int i = 0; i < 4; i++ )
+        c.s[i] = (float)std::fabs(a.s[i]);
+    return c;
+}
+
+inline v_float32x4 v_muladd(const v_float32x4& a, const v_float32x4& b, const v_float32x4& c)
+{ return a*b + c; }
+
+template<typename _Tp, int n> inline _Tp v_reduce_sum(const v_reg<_Tp, n>& a)
+{
+    typedef V_TypeTraits<_Tp> T;
+    _Tp s = a.s[0];
+    for( int i = 1; i < n; i++ )
+        s = T::add(s, a.s[i]);
+    return s;
+}
+
+#define OPENCV_INTRIN_CPP_REINTERPRET(_Tpvec, suffix) \
+template<typename _Tp0, int n0> inline _Tpvec v_reinterpret_as_##suffix(const v_reg<_Tp0, n0>& a) \
+{ \
+    _Tpvec c; \
+    memcpy(&c.s[0], &a.s[0], sizeof(c.s)); \
+    return c; \
+}
+
+OPENCV_INTRIN_CPP_REINTERPRET(v_uint8x16, u8)
+OPENCV_INTRIN_CPP_REINTERPRET(v_int8x16, s8)
+OPENCV_INTRIN_CPP_REINTERPRET(v_uint16x8, u16)
+OPENCV_INTRIN_CPP_REINTERPRET(v_int16x8, s16)
+OPENCV_INTRIN_CPP_REINTERPRET(v_uint32x4, u32)
+OPENCV_INTRIN_CPP_REINTERPRET(v_int32x4, s32)
+OPENCV_INTRIN_CPP_REINTERPRET(v_float32x4, f32)
+
+#endif
+
+// compound assignment operators shared by all the implementations
+#define OPENCV_INTRIN_COMPOUND_OPS(_Tpvec) \
+inline _Tpvec& operator += (_Tpvec& a, const _Tpvec& b) { a = a + b; return a; } \
+inline _Tpvec& operator -= (_Tpvec& a, const _Tpvec& b) { a = a - b; return a; } \
+inline _Tpvec& operator &= (_Tpvec& a, const _Tpvec& b) { a = a & b; return a; } \
+inline _Tpvec& operator |= (_Tpvec& a, const _Tpvec& b) { a = a | b; return a; } \
+inline _Tpvec& operator ^= (_Tpvec& a, const _Tpvec& b) { a = a ^ b; return a; }
+
+OPENCV_INTRIN_COMPOUND_OPS(v_uint8x16)
+OPENCV_INTRIN_COMPOUND_OPS(v_int8x16)
+OPENCV_INTRIN_COMPOUND_OPS(v_uint16x8)
+OPENCV_INTRIN_COMPOUND_OPS(v_int16x8)
+OPENCV_INTRIN_COMPOUND_OPS(v_uint32x4)
+OPENCV_INTRIN_COMPOUND_OPS(v_int32x4)
+OPENCV_INTRIN_COMPOUND_OPS(v_float32x4)
+
+inline v_float32x4& operator *= (v_float32x4& a, const v_float32x4& b) { a = a * b; return a; }
+inline v_float32x4& operator /= (v_float32x4& a, const v_float32x4& b) { a = a / b; return a; }
+
+}
+
+#endif
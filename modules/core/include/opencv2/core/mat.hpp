@@ -1298,34 +1298,74 @@ CV_EXPORTS MatExpr operator / (const MatExpr& e1, const MatExpr& e2);
 CV_EXPORTS MatExpr operator < (const Mat& a, const Mat& b);
 CV_EXPORTS MatExpr operator < (const Mat& a, double s);
 CV_EXPORTS MatExpr operator < (double s, const Mat& a);
+CV_EXPORTS MatExpr operator < (const MatExpr& e1, const MatExpr& e2);
+CV_EXPORTS MatExpr operator < (const MatExpr& e, const Mat& m);
+CV_EXPORTS MatExpr operator < (const Mat& m, const MatExpr& e);
+CV_EXPORTS MatExpr operator < (const MatExpr& e, double s);
+CV_EXPORTS MatExpr operator < (double s, const MatExpr& e);
 
 CV_EXPORTS MatExpr operator <= (const Mat& a, const Mat& b);
 CV_EXPORTS MatExpr operator <= (const Mat& a, double s);
 CV_EXPORTS MatExpr operator <= (double s, const Mat& a);
+CV_EXPORTS MatExpr operator <= (const MatExpr& e1, const MatExpr& e2);
+CV_EXPORTS MatExpr operator <= (const MatExpr& e, const Mat& m);
+CV_EXPORTS MatExpr operator <= (const Mat& m, const MatExpr& e);
+CV_EXPORTS MatExpr operator <= (const MatExpr& e, double s);
+CV_EXPORTS MatExpr operator <= (double s, const MatExpr& e);
 
 CV_EXPORTS MatExpr operator == (const Mat& a, const Mat& b);
 CV_EXPORTS MatExpr operator == (const Mat& a, double s);
 CV_EXPORTS MatExpr operator == (double s, const Mat& a);
+CV_EXPORTS MatExpr operator == (const MatExpr& e1, const MatExpr& e2);
+CV_EXPORTS MatExpr operator == (const MatExpr& e, const Mat& m);
+CV_EXPORTS MatExpr operator == (const Mat& m, const MatExpr& e);
+CV_EXPORTS MatExpr operator == (const MatExpr& e, double s);
+CV_EXPORTS MatExpr operator == (double s, const MatExpr& e);
 
 CV_EXPORTS MatExpr operator != (const Mat& a, const Mat& b);
 CV_EXPORTS MatExpr operator != (const Mat& a, double s);
 CV_EXPORTS MatExpr operator != (double s, const Mat& a);
+CV_EXPORTS MatExpr operator != (const MatExpr& e1, const MatExpr& e2);
+CV_EXPORTS MatExpr operator != (const MatExpr& e, const Mat& m);
+CV_EXPORTS MatExpr operator != (const Mat& m, const MatExpr& e);
+CV_EXPORTS MatExpr operator != (const MatExpr& e, double s);
+CV_EXPORTS MatExpr operator != (double s, const MatExpr& e);
 
 CV_EXPORTS MatExpr operator >= (const Mat& a, const Mat& b);
 CV_EXPORTS MatExpr operator >= (const Mat& a, double s);
 CV_EXPORTS MatExpr operator >= (double s, const Mat& a);
+CV_EXPORTS MatExpr operator >= (const MatExpr& e1, const MatExpr& e2);
+CV_EXPORTS MatExpr operator >= (const MatExpr& e, const Mat& m);
+CV_EXPORTS MatExpr operator >= (const Mat& m, const MatExpr& e);
+CV_EXPORTS MatExpr operator >= (const MatExpr& e, double s);
+CV_EXPORTS MatExpr operator >= (double s, const MatExpr& e);
 
 CV_EXPORTS MatExpr operator > (const Mat& a, const Mat& b);
 CV_EXPORTS MatExpr operator > (const Mat& a, double s);
 CV_EXPORTS MatExpr operator > (double s, const Mat& a);
+CV_EXPORTS MatExpr operator > (const MatExpr& e1, const MatExpr& e2);
+CV_EXPORTS MatExpr operator > (const MatExpr& e, const Mat& m);
+CV_EXPORTS MatExpr operator > (const Mat& m, const MatExpr& e);
+CV_EXPORTS MatExpr operator > (const MatExpr& e, double s);
+CV_EXPORTS MatExpr operator > (double s, const MatExpr& e);
 
 CV_EXPORTS MatExpr min(const Mat& a, const Mat& b);
 CV_EXPORTS MatExpr min(const Mat& a, double s);
 CV_EXPORTS MatExpr min(double s, const Mat& a);
+CV_EXPORTS MatExpr min(const MatExpr& e1, const MatExpr& e2);
+CV_EXPORTS MatExpr min(const MatExpr& e, const Mat& m);
+CV_EXPORTS MatExpr min(const Mat& m, const MatExpr& e);
+CV_EXPORTS MatExpr min(const MatExpr& e, double s);
+CV_EXPORTS MatExpr min(double s, const MatExpr& e);
 
 CV_EXPORTS MatExpr max(const Mat& a, const Mat& b);
 CV_EXPORTS MatExpr max(const Mat& a, double s);
 CV_EXPORTS MatExpr max(double s, const Mat& a);
+CV_EXPORTS MatExpr max(const MatExpr& e1, const MatExpr& e2);
+CV_EXPORTS MatExpr max(const MatExpr& e, const Mat& m);
+CV_EXPORTS MatExpr max(const Mat& m, const MatExpr& e);
+CV_EXPORTS MatExpr max(const MatExpr& e, double s);
+CV_EXPORTS MatExpr max(double s, const MatExpr& e);
 
 template<typename _Tp> static inline MatExpr min(const Mat_<_Tp>& a, const Mat_<_Tp>& b)
 {
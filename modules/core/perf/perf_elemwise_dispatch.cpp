@@ -0,0 +1,128 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+/*
+  Element-wise kernels that have runtime-dispatched AVX2 variants, for every depth
+  and channel count. To measure the gain run the tests twice, with and without
+  OPENCV_CPU_DISABLE=AVX2 in the environment, and compare the two reports.
+*/
+
+#define ELEMWISE_DEPTHS testing::Values(MatDepth(CV_8U), MatDepth(CV_8S), MatDepth(CV_16U), \
+                                        MatDepth(CV_16S), MatDepth(CV_32S), MatDepth(CV_32F))
+
+typedef std::tr1::tuple<Size, MatDepth, int> Size_Depth_Channels_t;
+typedef perf::TestBaseWithParam<Size_Depth_Channels_t> Size_Depth_Channels;
+
+typedef std::tr1::tuple<Size, MatDepth, MatDepth, int> Size_DepthSrc_DepthDst_Channels_t;
+typedef perf::TestBaseWithParam<Size_DepthSrc_DepthDst_Channels_t> Size_DepthSrc_DepthDst_Channels;
+
+PERF_TEST_P(Size_Depth_Channels, add_dispatch,
+            testing::Combine(testing::Values(szVGA, sz1080p), ELEMWISE_DEPTHS, testing::Values(1, 3, 4)))
+{
+    Size sz = get<0>(GetParam());
+    int type = CV_MAKETYPE(get<1>(GetParam()), get<2>(GetParam()));
+    Mat a(sz, type), b(sz, type), c(sz, type);
+
+    declare.in(a, b, WARMUP_RNG).out(c);
+
+    TEST_CYCLE() add(a, b, c);
+
+    SANITY_CHECK(c, 1e-6);
+}
+
+PERF_TEST_P(Size_Depth_Channels, subtract_dispatch,
+            testing::Combine(testing::Values(szVGA, sz1080p), ELEMWISE_DEPTHS, testing::Values(1, 3, 4)))
+{
+    Size sz = get<0>(GetParam());
+    int type = CV_MAKETYPE(get<1>(GetParam()), get<2>(GetParam()));
+    Mat a(sz, type), b(sz, type), c(sz, type);
+
+    declare.in(a, b, WARMUP_RNG).out(c);
+
+    TEST_CYCLE() subtract(a, b, c);
+
+    SANITY_CHECK(c, 1e-6);
+}
+
+PERF_TEST_P(Size_Depth_Channels, absdiff_dispatch,
+            testing::Combine(testing::Values(szVGA, sz1080p), ELEMWISE_DEPTHS, testing::Values(1, 3, 4)))
+{
+    Size sz = get<0>(GetParam());
+    int type = CV_MAKETYPE(get<1>(GetParam()), get<2>(GetParam()));
+    Mat a(sz, type), b(sz, type), c(sz, type);
+
+    declare.in(a, b, WARMUP_RNG).out(c);
+
+    TEST_CYCLE() absdiff(a, b, c);
+
+    SANITY_CHECK(c, 1e-6);
+}
+
+PERF_TEST_P(Size_Depth_Channels, compare_dispatch,
+            testing::Combine(testing::Values(szVGA, sz1080p), ELEMWISE_DEPTHS, testing::Values(1, 3, 4)))
+{
+    Size sz = get<0>(GetParam());
+    int type = CV_MAKETYPE(get<1>(GetParam()), get<2>(GetParam()));
+    Mat a(sz, type), b(sz, type), c(sz, CV_8UC(get<2>(GetParam())));
+
+    declare.in(a, b, WARMUP_RNG).out(c);
+
+    TEST_CYCLE() compare(a, b, c, CMP_GE);
+
+    SANITY_CHECK(c);
+}
+
+PERF_TEST_P(Size_Depth_Channels, addWeighted_dispatch,
+            testing::Combine(testing::Values(szVGA, sz1080p),
+                             testing::Values(MatDepth(CV_8U), MatDepth(CV_32F)),
+                             testing::Values(1, 3, 4)))
+{
+    Size sz = get<0>(GetParam());
+    int type = CV_MAKETYPE(get<1>(GetParam()), get<2>(GetParam()));
+    Mat a(sz, type), b(sz, type), c(sz, type);
+
+    declare.in(a, b, WARMUP_RNG).out(c);
+
+    TEST_CYCLE() addWeighted(a, 0.75, b, 0.25, 10., c);
+
+    SANITY_CHECK(c, 1);
+}
+
+PERF_TEST_P(Size_DepthSrc_DepthDst_Channels, convertTo_dispatch,
+            testing::Combine(testing::Values(szVGA, sz1080p),
+                             testing::Values(MatDepth(CV_8U), MatDepth(CV_16U), MatDepth(CV_16S), MatDepth(CV_32F)),
+                             testing::Values(MatDepth(CV_8U), MatDepth(CV_16S), MatDepth(CV_32S), MatDepth(CV_32F)),
+                             testing::Values(1, 3, 4)))
+{
+    Size sz = get<0>(GetParam());
+    int sdepth = get<1>(GetParam()), ddepth = get<2>(GetParam()), cn = get<3>(GetParam());
+    Mat src(sz, CV_MAKETYPE(sdepth, cn)), dst(sz, CV_MAKETYPE(ddepth, cn));
+    randu(src, 0, 255);
+
+    declare.in(src).out(dst);
+
+    TEST_CYCLE() src.convertTo(dst, ddepth, 0.5, 1.);
+
+    SANITY_CHECK(dst, 1);
+}
+
+PERF_TEST_P(Size_Depth_Channels, LUT_dispatch,
+            testing::Combine(testing::Values(szVGA, sz1080p),
+                             testing::Values(MatDepth(CV_32S), MatDepth(CV_32F)),
+                             testing::Values(1, 3, 4)))
+{
+    Size sz = get<0>(GetParam());
+    int ddepth = get<1>(GetParam()), cn = get<2>(GetParam());
+    Mat src(sz, CV_8UC(cn)), lut(1, 256, CV_MAKETYPE(ddepth, 1)), dst(sz, CV_MAKETYPE(ddepth, cn));
+
+    declare.in(src, lut, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE() LUT(src, lut, dst);
+
+    SANITY_CHECK(dst);
+}
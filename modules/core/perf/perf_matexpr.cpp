@@ -0,0 +1,35 @@
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+#define TYPICAL_MATS_MATEXPR  testing::Combine(testing::Values(szVGA, sz1080p), testing::Values(CV_8UC1, CV_8UC3, CV_16SC1, CV_32FC1))
+
+PERF_TEST_P(Size_MatType, MatExpr_weightedDifference, TYPICAL_MATS_MATEXPR)
+{
+    Size size = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(size, type), b(size, type), c(size, type), dst(size, type);
+
+    declare.in(a, b, c, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE() dst = a*0.75 + b*0.5 - c;
+
+    SANITY_CHECK(dst, 1);
+}
+
+PERF_TEST_P(Size_MatType, MatExpr_scoreMask, TYPICAL_MATS_MATEXPR)
+{
+    Size size = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    Mat a(size, type), b(size, type), c(size, type), dst(size, CV_8UC(CV_MAT_CN(type)));
+
+    declare.in(a, b, c, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE() dst = min(abs(a - b), 100)*2 + a.mul(c, 0.01) > b;
+
+    SANITY_CHECK(dst);
+}
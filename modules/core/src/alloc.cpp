@@ -42,6 +42,14 @@
 
 #include "precomp.hpp"
 
+#if defined WIN32 || defined WINCE
+    #include <windows.h>
+    #undef small
+    #undef min
+    #undef max
+    #undef abs
+#endif
+
 #define CV_USE_SYSTEM_MALLOC 1
 
 namespace cv
@@ -53,19 +61,255 @@ static void* OutOfMemoryError(size_t size)
     return 0;
 }
 
+/****************************************************************************************\
+*                                 Memory usage tracking                                  *
+\****************************************************************************************/
+
+MemoryUsage::MemoryUsage()
+    : currentBytes(0), peakBytes(0), totalBytes(0), allocations(0), deallocations(0),
+      sizeHistogram(MEMORY_HISTOGRAM_SIZE, (int64)0)
+{}
+
+namespace
+{
+
+struct MemoryTracker
+{
+    MemoryTracker()
+    {
+        tags.push_back(string());
+        usage.push_back(MemoryUsage());
+    }
+
+    Mutex mutex;
+    vector<string> tags;        // tags[0] is used for the allocations made outside of MemoryTagScope
+    vector<MemoryUsage> usage;
+    MemoryUsage total;
+};
+
+// the tracker is never destroyed, since the memory can be released during the static deinitialization
+static MemoryTracker& getMemoryTracker()
+{
+    static MemoryTracker* tracker = new MemoryTracker;
+    return *tracker;
+}
+
+static volatile bool memoryTracking = false;
+
+#if defined WIN32 || defined _WIN32
+#ifdef WINCE
+#   define TLS_OUT_OF_INDEXES ((DWORD)0xFFFFFFFF)
+#endif
+static DWORD tlsMemoryTagKey = TLS_OUT_OF_INDEXES;
+
+static int getThreadMemoryTag()
+{
+    if( tlsMemoryTagKey == TLS_OUT_OF_INDEXES )
+        return 0;
+    return (int)(size_t)TlsGetValue( tlsMemoryTagKey );
+}
+
+static void setThreadMemoryTag(int tag)
+{
+    if( tlsMemoryTagKey == TLS_OUT_OF_INDEXES )
+    {
+        tlsMemoryTagKey = TlsAlloc();
+        CV_Assert(tlsMemoryTagKey != TLS_OUT_OF_INDEXES);
+    }
+    TlsSetValue( tlsMemoryTagKey, (void*)(size_t)tag );
+}
+#else
+static pthread_key_t tlsMemoryTagKey = 0;
+static pthread_once_t tlsMemoryTagKeyOnce = PTHREAD_ONCE_INIT;
+
+static void makeMemoryTagKey()
+{
+    int errcode = pthread_key_create(&tlsMemoryTagKey, 0);
+    CV_Assert(errcode == 0);
+}
+
+static int getThreadMemoryTag()
+{
+    pthread_once(&tlsMemoryTagKeyOnce, makeMemoryTagKey);
+    return (int)(size_t)pthread_getspecific(tlsMemoryTagKey);
+}
+
+static void setThreadMemoryTag(int tag)
+{
+    pthread_once(&tlsMemoryTagKeyOnce, makeMemoryTagKey);
+    pthread_setspecific(tlsMemoryTagKey, (void*)(size_t)tag);
+}
+#endif
+
+static inline void addAllocation(MemoryUsage& u, size_t size, int bucket)
+{
+    u.currentBytes += size;
+    u.peakBytes = std::max(u.peakBytes, u.currentBytes);
+    u.totalBytes += size;
+    u.allocations++;
+    u.sizeHistogram[bucket]++;
+}
+
+static inline void addDeallocation(MemoryUsage& u, size_t size)
+{
+    u.currentBytes -= size;
+    u.deallocations++;
+}
+
+// returns the tag the allocation is accounted to
+static int trackAllocation(size_t size)
+{
+    int bucket = 0;
+    while( bucket < MemoryUsage::MEMORY_HISTOGRAM_SIZE - 1 && ((size_t)2 << bucket) <= size )
+        bucket++;
+
+    int tag = getThreadMemoryTag();
+    MemoryTracker& tracker = getMemoryTracker();
+    AutoLock lock(tracker.mutex);
+    addAllocation(tracker.total, size, bucket);
+    addAllocation(tracker.usage[tag], size, bucket);
+    return tag;
+}
+
+static void trackDeallocation(size_t size, int tag)
+{
+    MemoryTracker& tracker = getMemoryTracker();
+    AutoLock lock(tracker.mutex);
+    addDeallocation(tracker.total, size);
+    addDeallocation(tracker.usage[tag], size);
+}
+
+static void resetUsage(MemoryUsage& u)
+{
+    u.peakBytes = u.currentBytes;
+    u.totalBytes = u.allocations = u.deallocations = 0;
+    std::fill(u.sizeHistogram.begin(), u.sizeHistogram.end(), (int64)0);
+}
+
+static void writeCounter(FileStorage& fs, const string& name, int64 value)
+{
+    if( value <= INT_MAX )
+        write(fs, name, (int)value);
+    else
+        write(fs, name, (double)value);
+}
+
+} // namespace
+
+void setMemoryTracking(bool enabled)
+{
+    memoryTracking = enabled;
+}
+
+bool isMemoryTrackingEnabled()
+{
+    return memoryTracking;
+}
+
+void resetMemoryUsage()
+{
+    MemoryTracker& tracker = getMemoryTracker();
+    AutoLock lock(tracker.mutex);
+    resetUsage(tracker.total);
+    for( size_t i = 0; i < tracker.usage.size(); i++ )
+        resetUsage(tracker.usage[i]);
+}
+
+MemoryUsage getMemoryUsage()
+{
+    MemoryTracker& tracker = getMemoryTracker();
+    AutoLock lock(tracker.mutex);
+    return tracker.total;
+}
+
+void getMemoryUsage(vector<string>& tags, vector<MemoryUsage>& usage)
+{
+    MemoryTracker& tracker = getMemoryTracker();
+    AutoLock lock(tracker.mutex);
+    tags = tracker.tags;
+    usage = tracker.usage;
+}
+
+void write(FileStorage& fs, const string& name, const MemoryUsage& u)
+{
+    fs << name << "{";
+    writeCounter(fs, "current_bytes", u.currentBytes);
+    writeCounter(fs, "peak_bytes", u.peakBytes);
+    writeCounter(fs, "total_bytes", u.totalBytes);
+    writeCounter(fs, "allocations", u.allocations);
+    writeCounter(fs, "deallocations", u.deallocations);
+    fs << "size_histogram" << "[:";
+    for( size_t i = 0; i < u.sizeHistogram.size(); i++ )
+        writeCounter(fs, string(), u.sizeHistogram[i]);
+    fs << "]" << "}";
+}
+
+void writeMemoryUsage(FileStorage& fs, const string& name)
+{
+    vector<string> tags;
+    vector<MemoryUsage> usage;
+    getMemoryUsage(tags, usage);
+
+    fs << name << "{";
+    write(fs, "total", getMemoryUsage());
+    fs << "tags" << "[";
+    for( size_t i = 0; i < tags.size(); i++ )
+    {
+        fs << "{" << "tag" << tags[i];
+        write(fs, "usage", usage[i]);
+        fs << "}";
+    }
+    fs << "]" << "}";
+}
+
+MemoryTagScope::MemoryTagScope(const string& tag)
+{
+    prevTag = getThreadMemoryTag();
+
+    MemoryTracker& tracker = getMemoryTracker();
+    int idx;
+    {
+        AutoLock lock(tracker.mutex);
+        idx = (int)(std::find(tracker.tags.begin(), tracker.tags.end(), tag) - tracker.tags.begin());
+        if( idx == (int)tracker.tags.size() )
+        {
+            tracker.tags.push_back(tag);
+            tracker.usage.push_back(MemoryUsage());
+        }
+    }
+    setThreadMemoryTag(idx);
+}
+
+MemoryTagScope::~MemoryTagScope()
+{
+    setThreadMemoryTag(prevTag);
+}
+
 #if CV_USE_SYSTEM_MALLOC
 
 #if defined WIN32 || defined _WIN32
 void deleteThreadAllocData() {}
 #endif
 
+// the header is stored right before the aligned buffer;
+// the pointer to the allocated block must be the last field
+struct AllocHeader
+{
+    size_t size;
+    int tag;        // the memory tag the buffer is accounted to or -1 if the buffer is not tracked
+    uchar* udata;
+};
+
 void* fastMalloc( size_t size )
 {
-    uchar* udata = (uchar*)malloc(size + sizeof(void*) + CV_MALLOC_ALIGN);
+    uchar* udata = (uchar*)malloc(size + sizeof(AllocHeader) + CV_MALLOC_ALIGN);
     if(!udata)
         return OutOfMemoryError(size);
-    uchar** adata = alignPtr((uchar**)udata + 1, CV_MALLOC_ALIGN);
-    adata[-1] = udata;
+    uchar* adata = alignPtr(udata + sizeof(AllocHeader), CV_MALLOC_ALIGN);
+    AllocHeader* hdr = (AllocHeader*)adata - 1;
+    hdr->udata = udata;
+    hdr->size = size;
+    hdr->tag = memoryTracking ? trackAllocation(size) : -1;
     return adata;
 }
 
@@ -73,9 +317,12 @@ void fastFree(void* ptr)
 {
     if(ptr)
     {
-        uchar* udata = ((uchar**)ptr)[-1];
+        AllocHeader* hdr = (AllocHeader*)ptr - 1;
+        uchar* udata = hdr->udata;
         CV_DbgAssert(udata < (uchar*)ptr &&
-               ((uchar*)ptr - udata) <= (ptrdiff_t)(sizeof(void*)+CV_MALLOC_ALIGN));
+               ((uchar*)ptr - udata) <= (ptrdiff_t)(sizeof(AllocHeader)+CV_MALLOC_ALIGN));
+        if( hdr->tag >= 0 )
+            trackDeallocation(hdr->size, hdr->tag);
         free(udata);
     }
 }
@@ -681,6 +928,434 @@ void fastFree( void* ptr )
 
 #endif //CV_USE_SYSTEM_MALLOC
 
+/****************************************************************************************\
+*                                Pooling matrix allocator                                *
+\****************************************************************************************/
+
+MatPoolStats::MatPoolStats() : hits(0), misses(0), cachedBlocks(0), cachedBytes(0) {}
+
+namespace
+{
+
+// every power-of-two interval (2^k, 2^(k+1)] of the buffer sizes is split into 4 size classes
+enum
+{
+    POOL_MIN_SHIFT = 6,     // the smallest size class is 64 bytes
+    POOL_MAX_SHIFT = 28,    // buffers larger than 256Mb are not pooled
+    POOL_CLASSES = (POOL_MAX_SHIFT - POOL_MIN_SHIFT)*4 + 1,
+    POOL_HEADER_SIZE = CV_MALLOC_ALIGN,
+    POOL_THREAD_MAX_BLOCKS = 4
+};
+
+static const size_t POOL_THREAD_MAX_BYTES = (size_t)1 << 27;
+static const size_t POOL_GLOBAL_MAX_BYTES = (size_t)1 << 30;
+
+// returns the size class of the buffer or -1 if the buffer is too large to be pooled
+static int poolSizeClass(size_t size)
+{
+    if( size <= ((size_t)1 << POOL_MIN_SHIFT) )
+        return 0;
+    int k = POOL_MIN_SHIFT;
+    while( ((size_t)1 << (k + 1)) < size )
+        k++;
+    if( k >= POOL_MAX_SHIFT )
+        return -1;
+    size_t base = (size_t)1 << k, quarter = base >> 2;
+    return (k - POOL_MIN_SHIFT)*4 + (int)((size - base + quarter - 1)/quarter);
+}
+
+static size_t poolClassSize(int idx)
+{
+    if( idx == 0 )
+        return (size_t)1 << POOL_MIN_SHIFT;
+    size_t base = (size_t)1 << ((idx - 1)/4 + POOL_MIN_SHIFT);
+    return base + (base >> 2)*((idx - 1)%4 + 1);
+}
+
+// The block layout is [header: size class][data]. The free blocks are linked
+// through the first word of their data.
+static inline uchar*& nextBlock(uchar* block)
+{
+    return *(uchar**)(block + POOL_HEADER_SIZE);
+}
+
+struct PoolThreadCache
+{
+    PoolThreadCache() : bytes(0), hits(0), misses(0), prev(0), next(0)
+    {
+        memset(lists, 0, sizeof(lists));
+        memset(counts, 0, sizeof(counts));
+    }
+
+    uchar* lists[POOL_CLASSES];
+    int counts[POOL_CLASSES];
+    size_t bytes;
+    size_t hits, misses;
+    PoolThreadCache *prev, *next;
+};
+
+struct GlobalPool
+{
+    GlobalPool() : blocks(0), bytes(0), hits(0), misses(0), caches(0)
+    {
+        memset(lists, 0, sizeof(lists));
+    }
+
+    Mutex mutex;
+    uchar* lists[POOL_CLASSES];
+    size_t blocks, bytes;
+    size_t hits, misses;        // of the caches of the finished threads
+    PoolThreadCache* caches;    // caches of the running threads
+};
+
+// the pool is never destroyed, since the thread caches can be flushed into it
+// by the threads finishing during the static deinitialization
+static GlobalPool& getGlobalPool()
+{
+    static GlobalPool* pool = new GlobalPool;
+    return *pool;
+}
+
+// moves the block to the global pool or frees it if the pool is full
+static void releaseToGlobalPool(GlobalPool& pool, uchar* block, int idx)
+{
+    size_t size = poolClassSize(idx);
+    {
+        AutoLock lock(pool.mutex);
+        if( pool.bytes + size <= POOL_GLOBAL_MAX_BYTES )
+        {
+            nextBlock(block) = pool.lists[idx];
+            pool.lists[idx] = block;
+            pool.blocks++;
+            pool.bytes += size;
+            return;
+        }
+    }
+    fastFree(block);
+}
+
+static PoolThreadCache* createThreadCache()
+{
+    PoolThreadCache* cache = new PoolThreadCache;
+    GlobalPool& pool = getGlobalPool();
+    AutoLock lock(pool.mutex);
+    cache->next = pool.caches;
+    if( pool.caches )
+        pool.caches->prev = cache;
+    pool.caches = cache;
+    return cache;
+}
+
+static void deleteThreadCache(void* data)
+{
+    PoolThreadCache* cache = (PoolThreadCache*)data;
+    if( !cache )
+        return;
+    GlobalPool& pool = getGlobalPool();
+    for( int idx = 0; idx < POOL_CLASSES; idx++ )
+        while( uchar* block = cache->lists[idx] )
+        {
+            cache->lists[idx] = nextBlock(block);
+            releaseToGlobalPool(pool, block, idx);
+        }
+    {
+        AutoLock lock(pool.mutex);
+        pool.hits += cache->hits;
+        pool.misses += cache->misses;
+        if( cache->prev )
+            cache->prev->next = cache->next;
+        else
+            pool.caches = cache->next;
+        if( cache->next )
+            cache->next->prev = cache->prev;
+    }
+    delete cache;
+}
+
+#if defined WIN32 || defined _WIN32
+#ifdef WINCE
+#   define TLS_OUT_OF_INDEXES ((DWORD)0xFFFFFFFF)
+#endif
+static DWORD tlsPoolCacheKey = TLS_OUT_OF_INDEXES;
+static DWORD tlsAllocatorKey = TLS_OUT_OF_INDEXES;
+
+static PoolThreadCache* getThreadCache(bool create=true)
+{
+    if( tlsPoolCacheKey == TLS_OUT_OF_INDEXES )
+    {
+        tlsPoolCacheKey = TlsAlloc();
+        CV_Assert(tlsPoolCacheKey != TLS_OUT_OF_INDEXES);
+    }
+    PoolThreadCache* cache = (PoolThreadCache*)TlsGetValue( tlsPoolCacheKey );
+    if( !cache && create )
+    {
+        cache = createThreadCache();
+        TlsSetValue( tlsPoolCacheKey, cache );
+    }
+    return cache;
+}
+
+static MatAllocator* getThreadAllocator()
+{
+    if( tlsAllocatorKey == TLS_OUT_OF_INDEXES )
+        return 0;
+    return (MatAllocator*)TlsGetValue( tlsAllocatorKey );
+}
+
+static void setThreadAllocator(MatAllocator* allocator)
+{
+    if( tlsAllocatorKey == TLS_OUT_OF_INDEXES )
+    {
+        tlsAllocatorKey = TlsAlloc();
+        CV_Assert(tlsAllocatorKey != TLS_OUT_OF_INDEXES);
+    }
+    TlsSetValue( tlsAllocatorKey, allocator );
+}
+#else
+static pthread_key_t tlsPoolCacheKey = 0;
+static pthread_once_t tlsPoolCacheKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t tlsAllocatorKey = 0;
+static pthread_once_t tlsAllocatorKeyOnce = PTHREAD_ONCE_INIT;
+
+static void makePoolCacheKey()
+{
+    int errcode = pthread_key_create(&tlsPoolCacheKey, deleteThreadCache);
+    CV_Assert(errcode == 0);
+}
+
+static void makeAllocatorKey()
+{
+    int errcode = pthread_key_create(&tlsAllocatorKey, 0);
+    CV_Assert(errcode == 0);
+}
+
+static PoolThreadCache* getThreadCache(bool create=true)
+{
+    pthread_once(&tlsPoolCacheKeyOnce, makePoolCacheKey);
+    PoolThreadCache* cache = (PoolThreadCache*)pthread_getspecific(tlsPoolCacheKey);
+    if( !cache && create )
+    {
+        cache = createThreadCache();
+        pthread_setspecific(tlsPoolCacheKey, cache);
+    }
+    return cache;
+}
+
+static MatAllocator* getThreadAllocator()
+{
+    pthread_once(&tlsAllocatorKeyOnce, makeAllocatorKey);
+    return (MatAllocator*)pthread_getspecific(tlsAllocatorKey);
+}
+
+static void setThreadAllocator(MatAllocator* allocator)
+{
+    pthread_once(&tlsAllocatorKeyOnce, makeAllocatorKey);
+    pthread_setspecific(tlsAllocatorKey, allocator);
+}
+#endif
+
+static uchar* poolAlloc(size_t size)
+{
+    int idx = poolSizeClass(size);
+    PoolThreadCache* cache = getThreadCache();
+    uchar* block = 0;
+
+    if( idx < 0 )
+    {
+        block = (uchar*)fastMalloc(POOL_HEADER_SIZE + size);
+        cache->misses++;
+    }
+    else if( (block = cache->lists[idx]) != 0 )
+    {
+        cache->lists[idx] = nextBlock(block);
+        cache->counts[idx]--;
+        cache->bytes -= poolClassSize(idx);
+        cache->hits++;
+    }
+    else
+    {
+        GlobalPool& pool = getGlobalPool();
+        {
+            AutoLock lock(pool.mutex);
+            if( (block = pool.lists[idx]) != 0 )
+            {
+                pool.lists[idx] = nextBlock(block);
+                pool.blocks--;
+                pool.bytes -= poolClassSize(idx);
+            }
+        }
+        if( block )
+            cache->hits++;
+        else
+        {
+            block = (uchar*)fastMalloc(POOL_HEADER_SIZE + poolClassSize(idx));
+            cache->misses++;
+        }
+    }
+
+    *(int*)block = idx;
+    return block + POOL_HEADER_SIZE;
+}
+
+static void poolFree(uchar* ptr)
+{
+    uchar* block = ptr - POOL_HEADER_SIZE;
+    int idx = *(int*)block;
+    if( idx < 0 )
+    {
+        fastFree(block);
+        return;
+    }
+
+    PoolThreadCache* cache = getThreadCache();
+    size_t size = poolClassSize(idx);
+    if( cache->counts[idx] < POOL_THREAD_MAX_BLOCKS && cache->bytes + size <= POOL_THREAD_MAX_BYTES )
+    {
+        nextBlock(block) = cache->lists[idx];
+        cache->lists[idx] = block;
+        cache->counts[idx]++;
+        cache->bytes += size;
+    }
+    else
+        releaseToGlobalPool(getGlobalPool(), block, idx);
+}
+
+class PoolMatAllocator : public MatAllocator
+{
+public:
+    void allocate(int dims, const int* sizes, int type, int*& refcount,
+                  uchar*& datastart, uchar*& data, size_t* step)
+    {
+        size_t total = CV_ELEM_SIZE(type);
+        for( int i = dims-1; i >= 0; i-- )
+        {
+            step[i] = total;
+            total *= sizes[i];
+        }
+        size_t totalsize = alignSize(total, (int)sizeof(*refcount));
+        data = datastart = poolAlloc(totalsize + sizeof(*refcount));
+        refcount = (int*)(data + totalsize);
+        *refcount = 1;
+    }
+
+    void deallocate(int* refcount, uchar* datastart, uchar*)
+    {
+        CV_DbgAssert(refcount != 0);
+        (void)refcount;
+        poolFree(datastart);
+    }
+};
+
+static MatAllocator* defaultAllocator = 0;
+
+} // namespace
+
+#if defined WIN32 || defined _WIN32
+void deleteThreadMatPoolData()
+{
+    if( tlsPoolCacheKey != TLS_OUT_OF_INDEXES )
+    {
+        deleteThreadCache(TlsGetValue( tlsPoolCacheKey ));
+        TlsSetValue( tlsPoolCacheKey, 0 );
+    }
+}
+#endif
+
+MatAllocator* getPoolMatAllocator()
+{
+    static PoolMatAllocator allocator;
+    return &allocator;
+}
+
+MatPoolStats getMatPoolStats()
+{
+    GlobalPool& pool = getGlobalPool();
+    AutoLock lock(pool.mutex);
+    MatPoolStats stats;
+    stats.hits = pool.hits;
+    stats.misses = pool.misses;
+    stats.cachedBlocks = pool.blocks;
+    stats.cachedBytes = pool.bytes;
+    for( PoolThreadCache* cache = pool.caches; cache != 0; cache = cache->next )
+    {
+        stats.hits += cache->hits;
+        stats.misses += cache->misses;
+        for( int idx = 0; idx < POOL_CLASSES; idx++ )
+            stats.cachedBlocks += cache->counts[idx];
+        stats.cachedBytes += cache->bytes;
+    }
+    return stats;
+}
+
+void resetMatPoolStats()
+{
+    GlobalPool& pool = getGlobalPool();
+    AutoLock lock(pool.mutex);
+    pool.hits = pool.misses = 0;
+    for( PoolThreadCache* cache = pool.caches; cache != 0; cache = cache->next )
+        cache->hits = cache->misses = 0;
+}
+
+void trimMatPool()
+{
+    uchar* blocks = 0;
+    PoolThreadCache* cache = getThreadCache(false);
+    if( cache )
+    {
+        for( int idx = 0; idx < POOL_CLASSES; idx++ )
+            while( uchar* block = cache->lists[idx] )
+            {
+                cache->lists[idx] = nextBlock(block);
+                nextBlock(block) = blocks;
+                blocks = block;
+            }
+        memset(cache->counts, 0, sizeof(cache->counts));
+        cache->bytes = 0;
+    }
+
+    GlobalPool& pool = getGlobalPool();
+    {
+        AutoLock lock(pool.mutex);
+        for( int idx = 0; idx < POOL_CLASSES; idx++ )
+            while( uchar* block = pool.lists[idx] )
+            {
+                pool.lists[idx] = nextBlock(block);
+                nextBlock(block) = blocks;
+                blocks = block;
+            }
+        pool.blocks = pool.bytes = 0;
+    }
+
+    while( blocks )
+    {
+        uchar* block = blocks;
+        blocks = nextBlock(block);
+        fastFree(block);
+    }
+}
+
+MatAllocator* Mat::getDefaultAllocator()
+{
+    MatAllocator* allocator = getThreadAllocator();
+    return allocator ? allocator : defaultAllocator;
+}
+
+void Mat::setDefaultAllocator(MatAllocator* allocator)
+{
+    defaultAllocator = allocator;
+}
+
+MatAllocatorScope::MatAllocatorScope(MatAllocator* allocator)
+{
+    prevAllocator = getThreadAllocator();
+    setThreadAllocator(allocator);
+}
+
+MatAllocatorScope::~MatAllocatorScope()
+{
+    setThreadAllocator(prevAllocator);
+}
+
 }
 
 CV_IMPL void cvSetMemoryManager( CvAllocFunc, CvFreeFunc, void * )
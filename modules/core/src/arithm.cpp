@@ -47,6 +47,7 @@
 // */
 
 #include "precomp.hpp"
+#include "avx2.hpp"
 
 namespace cv
 {
@@ -532,6 +533,7 @@ static void add8u( const uchar* src1, size_t step1,
                    const uchar* src2, size_t step2,
                    uchar* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::add8u(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAdd_8u_C1RSfs(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz, 0),
            (vBinOp8<uchar, OpAdd<uchar>, IF_SIMD(_VAdd8u)>(src1, step1, src2, step2, dst, step, sz)));
@@ -541,6 +543,7 @@ static void add8s( const schar* src1, size_t step1,
                    const schar* src2, size_t step2,
                    schar* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::add8s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     vBinOp8<schar, OpAdd<schar>, IF_SIMD(_VAdd8s)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -548,6 +551,7 @@ static void add16u( const ushort* src1, size_t step1,
                     const ushort* src2, size_t step2,
                     ushort* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::add16u(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAdd_16u_C1RSfs(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz, 0),
             (vBinOp16<ushort, OpAdd<ushort>, IF_SIMD(_VAdd16u)>(src1, step1, src2, step2, dst, step, sz)));
@@ -557,6 +561,7 @@ static void add16s( const short* src1, size_t step1,
                     const short* src2, size_t step2,
                     short* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::add16s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAdd_16s_C1RSfs(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz, 0),
            (vBinOp16<short, OpAdd<short>, IF_SIMD(_VAdd16s)>(src1, step1, src2, step2, dst, step, sz)));
@@ -566,6 +571,7 @@ static void add32s( const int* src1, size_t step1,
                     const int* src2, size_t step2,
                     int* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::add32s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     vBinOp32s<OpAdd<int>, IF_SIMD(_VAdd32s)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -573,6 +579,7 @@ static void add32f( const float* src1, size_t step1,
                     const float* src2, size_t step2,
                     float* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::add32f(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAdd_32f_C1R(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz),
            (vBinOp32f<OpAdd<float>, IF_SIMD(_VAdd32f)>(src1, step1, src2, step2, dst, step, sz)));
@@ -589,6 +596,7 @@ static void sub8u( const uchar* src1, size_t step1,
                    const uchar* src2, size_t step2,
                    uchar* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::sub8u(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiSub_8u_C1RSfs(src2, (int)step2, src1, (int)step1, dst, (int)step, (IppiSize&)sz, 0),
            (vBinOp8<uchar, OpSub<uchar>, IF_SIMD(_VSub8u)>(src1, step1, src2, step2, dst, step, sz)));
@@ -598,6 +606,7 @@ static void sub8s( const schar* src1, size_t step1,
                    const schar* src2, size_t step2,
                    schar* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::sub8s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     vBinOp8<schar, OpSub<schar>, IF_SIMD(_VSub8s)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -605,6 +614,7 @@ static void sub16u( const ushort* src1, size_t step1,
                     const ushort* src2, size_t step2,
                     ushort* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::sub16u(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiSub_16u_C1RSfs(src2, (int)step2, src1, (int)step1, dst, (int)step, (IppiSize&)sz, 0),
            (vBinOp16<ushort, OpSub<ushort>, IF_SIMD(_VSub16u)>(src1, step1, src2, step2, dst, step, sz)));
@@ -614,6 +624,7 @@ static void sub16s( const short* src1, size_t step1,
                     const short* src2, size_t step2,
                     short* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::sub16s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiSub_16s_C1RSfs(src2, (int)step2, src1, (int)step1, dst, (int)step, (IppiSize&)sz, 0),
            (vBinOp16<short, OpSub<short>, IF_SIMD(_VSub16s)>(src1, step1, src2, step2, dst, step, sz)));
@@ -623,6 +634,7 @@ static void sub32s( const int* src1, size_t step1,
                     const int* src2, size_t step2,
                     int* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::sub32s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     vBinOp32s<OpSub<int>, IF_SIMD(_VSub32s)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -630,6 +642,7 @@ static void sub32f( const float* src1, size_t step1,
                    const float* src2, size_t step2,
                    float* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::sub32f(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiSub_32f_C1R(src2, (int)step2, src1, (int)step1, dst, (int)step, (IppiSize&)sz),
            (vBinOp32f<OpSub<float>, IF_SIMD(_VSub32f)>(src1, step1, src2, step2, dst, step, sz)));
@@ -865,6 +878,7 @@ static void absdiff8u( const uchar* src1, size_t step1,
                        const uchar* src2, size_t step2,
                        uchar* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::absdiff8u(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAbsDiff_8u_C1R(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz),
            (vBinOp8<uchar, OpAbsDiff<uchar>, IF_SIMD(_VAbsDiff8u)>(src1, step1, src2, step2, dst, step, sz)));
@@ -874,6 +888,7 @@ static void absdiff8s( const schar* src1, size_t step1,
                        const schar* src2, size_t step2,
                        schar* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::absdiff8s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     vBinOp8<schar, OpAbsDiff<schar>, IF_SIMD(_VAbsDiff8s)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -881,6 +896,7 @@ static void absdiff16u( const ushort* src1, size_t step1,
                         const ushort* src2, size_t step2,
                         ushort* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::absdiff16u(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAbsDiff_16u_C1R(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz),
            (vBinOp16<ushort, OpAbsDiff<ushort>, IF_SIMD(_VAbsDiff16u)>(src1, step1, src2, step2, dst, step, sz)));
@@ -890,6 +906,7 @@ static void absdiff16s( const short* src1, size_t step1,
                         const short* src2, size_t step2,
                         short* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::absdiff16s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     vBinOp16<short, OpAbsDiff<short>, IF_SIMD(_VAbsDiff16s)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -897,6 +914,7 @@ static void absdiff32s( const int* src1, size_t step1,
                         const int* src2, size_t step2,
                         int* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::absdiff32s(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     vBinOp32s<OpAbsDiff<int>, IF_SIMD(_VAbsDiff32s)>(src1, step1, src2, step2, dst, step, sz);
 }
 
@@ -904,6 +922,7 @@ static void absdiff32f( const float* src1, size_t step1,
                         const float* src2, size_t step2,
                         float* dst, size_t step, Size sz, void* )
 {
+    IF_AVX2(avx2::absdiff32f(src1, step1, src2, step2, dst, step, sz.width, sz.height));
     IF_IPP(fixSteps(sz, sizeof(dst[0]), step1, step2, step);
            ippiAbsDiff_32f_C1R(src1, (int)step1, src2, (int)step2, dst, (int)step, (IppiSize&)sz),
            (vBinOp32f<OpAbsDiff<float>, IF_SIMD(_VAbsDiff32f)>(src1, step1, src2, step2, dst, step, sz)));
@@ -1937,6 +1956,7 @@ addWeighted8u( const uchar* src1, size_t step1,
                uchar* dst, size_t step, Size size,
                void* _scalars )
 {
+    IF_AVX2(avx2::addWeighted8u(src1, step1, src2, step2, dst, step, size.width, size.height, (const double*)_scalars));
     const double* scalars = (const double*)_scalars;
     float alpha = (float)scalars[0], beta = (float)scalars[1], gamma = (float)scalars[2];
 
@@ -2024,6 +2044,7 @@ static void addWeighted32s( const int* src1, size_t step1, const int* src2, size
 static void addWeighted32f( const float* src1, size_t step1, const float* src2, size_t step2,
                             float* dst, size_t step, Size sz, void* scalars )
 {
+    IF_AVX2(avx2::addWeighted32f(src1, step1, src2, step2, dst, step, sz.width, sz.height, (const double*)scalars));
     addWeighted_<float, double>(src1, step1, src2, step2, dst, step, sz, scalars);
 }
 
@@ -2120,6 +2141,7 @@ cmp_(const T* src1, size_t step1, const T* src2, size_t step2,
 static void cmp8u(const uchar* src1, size_t step1, const uchar* src2, size_t step2,
                   uchar* dst, size_t step, Size size, void* _cmpop)
 {
+    IF_AVX2(avx2::cmp8u(src1, step1, src2, step2, dst, step, size.width, size.height, *(int*)_cmpop));
   //vz optimized  cmp_(src1, step1, src2, step2, dst, step, size, *(int*)_cmpop);
     int code = *(int*)_cmpop;
     step1 /= sizeof(src1[0]);
@@ -2188,18 +2210,21 @@ static void cmp8u(const uchar* src1, size_t step1, const uchar* src2, size_t ste
 static void cmp8s(const schar* src1, size_t step1, const schar* src2, size_t step2,
                   uchar* dst, size_t step, Size size, void* _cmpop)
 {
+    IF_AVX2(avx2::cmp8s(src1, step1, src2, step2, dst, step, size.width, size.height, *(int*)_cmpop));
     cmp_(src1, step1, src2, step2, dst, step, size, *(int*)_cmpop);
 }
 
 static void cmp16u(const ushort* src1, size_t step1, const ushort* src2, size_t step2,
                   uchar* dst, size_t step, Size size, void* _cmpop)
 {
+    IF_AVX2(avx2::cmp16u(src1, step1, src2, step2, dst, step, size.width, size.height, *(int*)_cmpop));
     cmp_(src1, step1, src2, step2, dst, step, size, *(int*)_cmpop);
 }
 
 static void cmp16s(const short* src1, size_t step1, const short* src2, size_t step2,
                   uchar* dst, size_t step, Size size, void* _cmpop)
 {
+    IF_AVX2(avx2::cmp16s(src1, step1, src2, step2, dst, step, size.width, size.height, *(int*)_cmpop));
    //vz optimized cmp_(src1, step1, src2, step2, dst, step, size, *(int*)_cmpop);
 
     int code = *(int*)_cmpop;
@@ -2291,12 +2316,14 @@ static void cmp16s(const short* src1, size_t step1, const short* src2, size_t st
 static void cmp32s(const int* src1, size_t step1, const int* src2, size_t step2,
                    uchar* dst, size_t step, Size size, void* _cmpop)
 {
+    IF_AVX2(avx2::cmp32s(src1, step1, src2, step2, dst, step, size.width, size.height, *(int*)_cmpop));
     cmp_(src1, step1, src2, step2, dst, step, size, *(int*)_cmpop);
 }
 
 static void cmp32f(const float* src1, size_t step1, const float* src2, size_t step2,
                   uchar* dst, size_t step, Size size, void* _cmpop)
 {
+    IF_AVX2(avx2::cmp32f(src1, step1, src2, step2, dst, step, size.width, size.height, *(int*)_cmpop));
     cmp_(src1, step1, src2, step2, dst, step, size, *(int*)_cmpop);
 }
 
@@ -0,0 +1,361 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* AVX2 variants of the element-wise arithmetic kernels from arithm.cpp (see avx2.hpp) */
+
+#ifdef HAVE_CVCONFIG_H
+#include "cvconfig.h"
+#endif
+
+#ifdef HAVE_AVX2_DISPATCH
+
+#include "avx2.hpp"
+#include <immintrin.h>
+
+namespace cv
+{
+namespace avx2
+{
+
+namespace
+{
+
+/*
+  Applies op to the rows; op processes Op::N elements at once.
+  The tail of each row goes through zero-padded buffers, so that
+  every element is computed by exactly the same instructions.
+*/
+template<typename T, typename DT, class Op> void
+binaryOp( const T* src1, size_t step1, const T* src2, size_t step2,
+          DT* dst, size_t step, int width, int height, const Op& op )
+{
+    for( ; height--; src1 = (const T*)((const uchar*)src1 + step1),
+                     src2 = (const T*)((const uchar*)src2 + step2),
+                     dst = (DT*)((uchar*)dst + step) )
+    {
+        int x = 0;
+        for( ; x <= width - Op::N; x += Op::N )
+            op(src1 + x, src2 + x, dst + x);
+
+        if( x < width )
+        {
+            T buf1[Op::N], buf2[Op::N];
+            DT dbuf[Op::N];
+            int i = 0, n = width - x;
+            for( ; i < n; i++ )
+            {
+                buf1[i] = src1[x + i];
+                buf2[i] = src2[x + i];
+            }
+            for( ; i < Op::N; i++ )
+                buf1[i] = buf2[i] = 0;
+            op(buf1, buf2, dbuf);
+            for( i = 0; i < n; i++ )
+                dst[x + i] = dbuf[i];
+        }
+    }
+}
+
+#define CV_AVX2_INT_OP(name, T, expr) \
+struct name \
+{ \
+    enum { N = 32/sizeof(T) }; \
+    void operator()(const T* a, const T* b, T* d) const \
+    { \
+        __m256i x = _mm256_loadu_si256((const __m256i*)a); \
+        __m256i y = _mm256_loadu_si256((const __m256i*)b); \
+        _mm256_storeu_si256((__m256i*)d, expr); \
+    } \
+}
+
+CV_AVX2_INT_OP(OpAdd8u, uchar, _mm256_adds_epu8(x, y));
+CV_AVX2_INT_OP(OpAdd8s, schar, _mm256_adds_epi8(x, y));
+CV_AVX2_INT_OP(OpAdd16u, ushort, _mm256_adds_epu16(x, y));
+CV_AVX2_INT_OP(OpAdd16s, short, _mm256_adds_epi16(x, y));
+CV_AVX2_INT_OP(OpAdd32s, int, _mm256_add_epi32(x, y));
+
+CV_AVX2_INT_OP(OpSub8u, uchar, _mm256_subs_epu8(x, y));
+CV_AVX2_INT_OP(OpSub8s, schar, _mm256_subs_epi8(x, y));
+CV_AVX2_INT_OP(OpSub16u, ushort, _mm256_subs_epu16(x, y));
+CV_AVX2_INT_OP(OpSub16s, short, _mm256_subs_epi16(x, y));
+CV_AVX2_INT_OP(OpSub32s, int, _mm256_sub_epi32(x, y));
+
+// signed absdiff saturates to the signed range, as saturate_cast<T>(std::abs(a - b)) does
+CV_AVX2_INT_OP(OpAbsDiff8u, uchar, _mm256_or_si256(_mm256_subs_epu8(x, y), _mm256_subs_epu8(y, x)));
+CV_AVX2_INT_OP(OpAbsDiff8s, schar, _mm256_subs_epi8(_mm256_max_epi8(x, y), _mm256_min_epi8(x, y)));
+CV_AVX2_INT_OP(OpAbsDiff16u, ushort, _mm256_or_si256(_mm256_subs_epu16(x, y), _mm256_subs_epu16(y, x)));
+CV_AVX2_INT_OP(OpAbsDiff16s, short, _mm256_subs_epi16(_mm256_max_epi16(x, y), _mm256_min_epi16(x, y)));
+CV_AVX2_INT_OP(OpAbsDiff32s, int, _mm256_abs_epi32(_mm256_sub_epi32(x, y)));
+
+#undef CV_AVX2_INT_OP
+
+#define CV_AVX2_FLOAT_OP(name, expr) \
+struct name \
+{ \
+    enum { N = 8 }; \
+    void operator()(const float* a, const float* b, float* d) const \
+    { \
+        __m256 x = _mm256_loadu_ps(a), y = _mm256_loadu_ps(b); \
+        _mm256_storeu_ps(d, expr); \
+    } \
+}
+
+CV_AVX2_FLOAT_OP(OpAdd32f, _mm256_add_ps(x, y));
+CV_AVX2_FLOAT_OP(OpSub32f, _mm256_sub_ps(x, y));
+CV_AVX2_FLOAT_OP(OpAbsDiff32f, _mm256_and_ps(_mm256_sub_ps(x, y),
+                 _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff))));
+
+#undef CV_AVX2_FLOAT_OP
+
+/*
+  Element comparisons; they return 0/-1 masks of the element size.
+  There are no unsigned comparisons, so unsigned values are shifted to the signed range.
+*/
+#define CV_AVX2_CMP(name, T, expr) \
+struct name \
+{ \
+    typedef T type; \
+    __m256i operator()(__m256i x, __m256i y) const { return expr; } \
+}
+
+CV_AVX2_CMP(CmpGT8u, uchar, _mm256_cmpgt_epi8(_mm256_xor_si256(x, _mm256_set1_epi8((char)0x80)),
+                                              _mm256_xor_si256(y, _mm256_set1_epi8((char)0x80))));
+CV_AVX2_CMP(CmpEQ8u, uchar, _mm256_cmpeq_epi8(x, y));
+CV_AVX2_CMP(CmpGT8s, schar, _mm256_cmpgt_epi8(x, y));
+CV_AVX2_CMP(CmpEQ8s, schar, _mm256_cmpeq_epi8(x, y));
+CV_AVX2_CMP(CmpGT16u, ushort, _mm256_cmpgt_epi16(_mm256_xor_si256(x, _mm256_set1_epi16((short)0x8000)),
+                                                 _mm256_xor_si256(y, _mm256_set1_epi16((short)0x8000))));
+CV_AVX2_CMP(CmpEQ16u, ushort, _mm256_cmpeq_epi16(x, y));
+CV_AVX2_CMP(CmpGT16s, short, _mm256_cmpgt_epi16(x, y));
+CV_AVX2_CMP(CmpEQ16s, short, _mm256_cmpeq_epi16(x, y));
+CV_AVX2_CMP(CmpGT32s, int, _mm256_cmpgt_epi32(x, y));
+CV_AVX2_CMP(CmpEQ32s, int, _mm256_cmpeq_epi32(x, y));
+// ordered predicates: comparisons with NaN are false, as in the generic code
+CV_AVX2_CMP(CmpGT32f, float, _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(x),
+                                                 _mm256_castsi256_ps(y), _CMP_GT_OQ)));
+CV_AVX2_CMP(CmpEQ32f, float, _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(x),
+                                                 _mm256_castsi256_ps(y), _CMP_EQ_OQ)));
+
+#undef CV_AVX2_CMP
+
+// The comparison masks are packed to bytes and optionally inverted (for CMP_LE and CMP_NE)
+template<class Cmp> struct CmpOp8
+{
+    typedef typename Cmp::type T;
+    enum { N = 32 };
+    CmpOp8(__m256i _m) : m(_m) {}
+    void operator()(const T* a, const T* b, uchar* d) const
+    {
+        __m256i r = cmp(_mm256_loadu_si256((const __m256i*)a), _mm256_loadu_si256((const __m256i*)b));
+        _mm256_storeu_si256((__m256i*)d, _mm256_xor_si256(r, m));
+    }
+    __m256i m;
+    Cmp cmp;
+};
+
+template<class Cmp> struct CmpOp16
+{
+    typedef typename Cmp::type T;
+    enum { N = 32 };
+    CmpOp16(__m256i _m) : m(_m) {}
+    void operator()(const T* a, const T* b, uchar* d) const
+    {
+        __m256i r0 = cmp(_mm256_loadu_si256((const __m256i*)a), _mm256_loadu_si256((const __m256i*)b));
+        __m256i r1 = cmp(_mm256_loadu_si256((const __m256i*)(a + 16)), _mm256_loadu_si256((const __m256i*)(b + 16)));
+        // packs works within 128-bit lanes, restore the order of the 64-bit chunks
+        __m256i r = _mm256_permute4x64_epi64(_mm256_packs_epi16(r0, r1), 0xD8);
+        _mm256_storeu_si256((__m256i*)d, _mm256_xor_si256(r, m));
+    }
+    __m256i m;
+    Cmp cmp;
+};
+
+template<class Cmp> struct CmpOp32
+{
+    typedef typename Cmp::type T;
+    enum { N = 32 };
+    CmpOp32(__m256i _m) : m(_m) {}
+    void operator()(const T* a, const T* b, uchar* d) const
+    {
+        __m256i r0 = cmp(_mm256_loadu_si256((const __m256i*)a), _mm256_loadu_si256((const __m256i*)b));
+        __m256i r1 = cmp(_mm256_loadu_si256((const __m256i*)(a + 8)), _mm256_loadu_si256((const __m256i*)(b + 8)));
+        __m256i r2 = cmp(_mm256_loadu_si256((const __m256i*)(a + 16)), _mm256_loadu_si256((const __m256i*)(b + 16)));
+        __m256i r3 = cmp(_mm256_loadu_si256((const __m256i*)(a + 24)), _mm256_loadu_si256((const __m256i*)(b + 24)));
+        __m256i r = _mm256_packs_epi16(_mm256_packs_epi32(r0, r1), _mm256_packs_epi32(r2, r3));
+        // packs works within 128-bit lanes, restore the order of the 32-bit chunks
+        r = _mm256_permutevar8x32_epi32(r, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+        _mm256_storeu_si256((__m256i*)d, _mm256_xor_si256(r, m));
+    }
+    __m256i m;
+    Cmp cmp;
+};
+
+template<template<class> class CmpOp, class CmpGT, class CmpEQ> void
+cmp_( const typename CmpGT::type* src1, size_t step1, const typename CmpGT::type* src2, size_t step2,
+      uchar* dst, size_t step, int width, int height, int code )
+{
+    if( code == CMP_GE || code == CMP_LT )
+    {
+        const typename CmpGT::type* t = src1; src1 = src2; src2 = t;
+        size_t tstep = step1; step1 = step2; step2 = tstep;
+        code = code == CMP_GE ? CMP_LE : CMP_GT;
+    }
+
+    __m256i m = code == CMP_GT || code == CMP_EQ ? _mm256_setzero_si256() : _mm256_set1_epi8(-1);
+    if( code == CMP_GT || code == CMP_LE )
+        binaryOp(src1, step1, src2, step2, dst, step, width, height, CmpOp<CmpGT>(m));
+    else
+        binaryOp(src1, step1, src2, step2, dst, step, width, height, CmpOp<CmpEQ>(m));
+}
+
+// the same single precision arithmetic and rounding as the generic addWeighted8u
+struct OpAddWeighted8u
+{
+    enum { N = 16 };
+    OpAddWeighted8u(float alpha, float beta, float gamma)
+        : a(_mm256_set1_ps(alpha)), b(_mm256_set1_ps(beta)), g(_mm256_set1_ps(gamma)) {}
+    void operator()(const uchar* s1, const uchar* s2, uchar* d) const
+    {
+        __m128i u = _mm_loadu_si128((const __m128i*)s1), v = _mm_loadu_si128((const __m128i*)s2);
+        __m256 u0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(u));
+        __m256 u1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(u, 8)));
+        __m256 v0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+        __m256 v1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+
+        u0 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(u0, a), _mm256_mul_ps(v0, b)), g);
+        u1 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(u1, a), _mm256_mul_ps(v1, b)), g);
+
+        __m256i r = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cvtps_epi32(u0), _mm256_cvtps_epi32(u1)), 0xD8);
+        _mm_storeu_si128((__m128i*)d, _mm_packus_epi16(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1)));
+    }
+    __m256 a, b, g;
+};
+
+// computed in double precision, as the generic addWeighted32f
+struct OpAddWeighted32f
+{
+    enum { N = 8 };
+    OpAddWeighted32f(double alpha, double beta, double gamma)
+        : a(_mm256_set1_pd(alpha)), b(_mm256_set1_pd(beta)), g(_mm256_set1_pd(gamma)) {}
+    void operator()(const float* s1, const float* s2, float* d) const
+    {
+        __m256 u = _mm256_loadu_ps(s1), v = _mm256_loadu_ps(s2);
+        __m256d u0 = _mm256_cvtps_pd(_mm256_castps256_ps128(u));
+        __m256d u1 = _mm256_cvtps_pd(_mm256_extractf128_ps(u, 1));
+        __m256d v0 = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+        __m256d v1 = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+
+        u0 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(u0, a), _mm256_mul_pd(v0, b)), g);
+        u1 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(u1, a), _mm256_mul_pd(v1, b)), g);
+
+        _mm_storeu_ps(d, _mm256_cvtpd_ps(u0));
+        _mm_storeu_ps(d + 4, _mm256_cvtpd_ps(u1));
+    }
+    __m256d a, b, g;
+};
+
+}
+
+#define CV_AVX2_DEF_BIN_FUNC(name, type, op) \
+void name(const type* src1, size_t step1, const type* src2, size_t step2, \
+          type* dst, size_t step, int width, int height) \
+{ \
+    binaryOp(src1, step1, src2, step2, dst, step, width, height, op()); \
+}
+
+CV_AVX2_DEF_BIN_FUNC(add8u, uchar, OpAdd8u)
+CV_AVX2_DEF_BIN_FUNC(add8s, schar, OpAdd8s)
+CV_AVX2_DEF_BIN_FUNC(add16u, ushort, OpAdd16u)
+CV_AVX2_DEF_BIN_FUNC(add16s, short, OpAdd16s)
+CV_AVX2_DEF_BIN_FUNC(add32s, int, OpAdd32s)
+CV_AVX2_DEF_BIN_FUNC(add32f, float, OpAdd32f)
+
+CV_AVX2_DEF_BIN_FUNC(sub8u, uchar, OpSub8u)
+CV_AVX2_DEF_BIN_FUNC(sub8s, schar, OpSub8s)
+CV_AVX2_DEF_BIN_FUNC(sub16u, ushort, OpSub16u)
+CV_AVX2_DEF_BIN_FUNC(sub16s, short, OpSub16s)
+CV_AVX2_DEF_BIN_FUNC(sub32s, int, OpSub32s)
+CV_AVX2_DEF_BIN_FUNC(sub32f, float, OpSub32f)
+
+CV_AVX2_DEF_BIN_FUNC(absdiff8u, uchar, OpAbsDiff8u)
+CV_AVX2_DEF_BIN_FUNC(absdiff8s, schar, OpAbsDiff8s)
+CV_AVX2_DEF_BIN_FUNC(absdiff16u, ushort, OpAbsDiff16u)
+CV_AVX2_DEF_BIN_FUNC(absdiff16s, short, OpAbsDiff16s)
+CV_AVX2_DEF_BIN_FUNC(absdiff32s, int, OpAbsDiff32s)
+CV_AVX2_DEF_BIN_FUNC(absdiff32f, float, OpAbsDiff32f)
+
+#undef CV_AVX2_DEF_BIN_FUNC
+
+#define CV_AVX2_DEF_CMP_FUNC(name, type, pack, suffix) \
+void name(const type* src1, size_t step1, const type* src2, size_t step2, \
+          uchar* dst, size_t step, int width, int height, int code) \
+{ \
+    cmp_<pack, CmpGT##suffix, CmpEQ##suffix>(src1, step1, src2, step2, dst, step, width, height, code); \
+}
+
+CV_AVX2_DEF_CMP_FUNC(cmp8u, uchar, CmpOp8, 8u)
+CV_AVX2_DEF_CMP_FUNC(cmp8s, schar, CmpOp8, 8s)
+CV_AVX2_DEF_CMP_FUNC(cmp16u, ushort, CmpOp16, 16u)
+CV_AVX2_DEF_CMP_FUNC(cmp16s, short, CmpOp16, 16s)
+CV_AVX2_DEF_CMP_FUNC(cmp32s, int, CmpOp32, 32s)
+CV_AVX2_DEF_CMP_FUNC(cmp32f, float, CmpOp32, 32f)
+
+#undef CV_AVX2_DEF_CMP_FUNC
+
+void addWeighted8u(const uchar* src1, size_t step1, const uchar* src2, size_t step2,
+                   uchar* dst, size_t step, int width, int height, const double* scalars)
+{
+    binaryOp(src1, step1, src2, step2, dst, step, width, height,
+             OpAddWeighted8u((float)scalars[0], (float)scalars[1], (float)scalars[2]));
+}
+
+void addWeighted32f(const float* src1, size_t step1, const float* src2, size_t step2,
+                    float* dst, size_t step, int width, int height, const double* scalars)
+{
+    binaryOp(src1, step1, src2, step2, dst, step, width, height,
+             OpAddWeighted32f(scalars[0], scalars[1], scalars[2]));
+}
+
+}
+}
+
+#endif
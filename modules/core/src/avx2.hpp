@@ -0,0 +1,167 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __OPENCV_CORE_AVX2_HPP__
+#define __OPENCV_CORE_AVX2_HPP__
+
+/*
+  AVX2 variants of the core arithmetic and conversion kernels.
+
+  The functions are implemented in *_avx2.cpp files that are compiled with AVX2 code
+  generation (-mavx2) and called only when USE_AVX2 is set (see IF_AVX2 in precomp.hpp).
+  Such a file must not include precomp.hpp or any other header with inline functions
+  or templates that are also used by the rest of the library: the linker may keep the
+  AVX2 copy of such a function and the library would then crash on older CPUs.
+  That's why this header depends on types_c.h only and the kernels take plain
+  pointers, byte steps and sizes. The results are bit-exact with the generic code.
+*/
+
+#include "opencv2/core/types_c.h"
+
+namespace cv
+{
+namespace avx2
+{
+
+#define CV_AVX2_BIN_FUNC(name, type) \
+void name(const type* src1, size_t step1, const type* src2, size_t step2, \
+          type* dst, size_t step, int width, int height)
+
+CV_AVX2_BIN_FUNC(add8u, uchar);
+CV_AVX2_BIN_FUNC(add8s, schar);
+CV_AVX2_BIN_FUNC(add16u, ushort);
+CV_AVX2_BIN_FUNC(add16s, short);
+CV_AVX2_BIN_FUNC(add32s, int);
+CV_AVX2_BIN_FUNC(add32f, float);
+
+CV_AVX2_BIN_FUNC(sub8u, uchar);
+CV_AVX2_BIN_FUNC(sub8s, schar);
+CV_AVX2_BIN_FUNC(sub16u, ushort);
+CV_AVX2_BIN_FUNC(sub16s, short);
+CV_AVX2_BIN_FUNC(sub32s, int);
+CV_AVX2_BIN_FUNC(sub32f, float);
+
+CV_AVX2_BIN_FUNC(absdiff8u, uchar);
+CV_AVX2_BIN_FUNC(absdiff8s, schar);
+CV_AVX2_BIN_FUNC(absdiff16u, ushort);
+CV_AVX2_BIN_FUNC(absdiff16s, short);
+CV_AVX2_BIN_FUNC(absdiff32s, int);
+CV_AVX2_BIN_FUNC(absdiff32f, float);
+
+#undef CV_AVX2_BIN_FUNC
+
+// the comparison codes, the same values as CV_CMP_EQ, CV_CMP_GT, ... and cv::CMP_EQ, cv::CMP_GT, ...
+enum { CMP_EQ=0, CMP_GT=1, CMP_GE=2, CMP_LT=3, CMP_LE=4, CMP_NE=5 };
+
+// code is one of the comparison codes above
+#define CV_AVX2_CMP_FUNC(name, type) \
+void name(const type* src1, size_t step1, const type* src2, size_t step2, \
+          uchar* dst, size_t step, int width, int height, int code)
+
+CV_AVX2_CMP_FUNC(cmp8u, uchar);
+CV_AVX2_CMP_FUNC(cmp8s, schar);
+CV_AVX2_CMP_FUNC(cmp16u, ushort);
+CV_AVX2_CMP_FUNC(cmp16s, short);
+CV_AVX2_CMP_FUNC(cmp32s, int);
+CV_AVX2_CMP_FUNC(cmp32f, float);
+
+#undef CV_AVX2_CMP_FUNC
+
+// scalars are alpha, beta and gamma, as in the generic addWeighted kernels
+void addWeighted8u(const uchar* src1, size_t step1, const uchar* src2, size_t step2,
+                   uchar* dst, size_t step, int width, int height, const double* scalars);
+void addWeighted32f(const float* src1, size_t step1, const float* src2, size_t step2,
+                    float* dst, size_t step, int width, int height, const double* scalars);
+
+// dst = saturate_cast<dtype>(src), for the conversions from/to 32f
+#define CV_AVX2_CVT_FUNC(suffix, stype, dtype) \
+void cvt##suffix(const stype* src, size_t sstep, dtype* dst, size_t dstep, int width, int height)
+
+CV_AVX2_CVT_FUNC(8u32f, uchar, float);
+CV_AVX2_CVT_FUNC(16u32f, ushort, float);
+CV_AVX2_CVT_FUNC(16s32f, short, float);
+CV_AVX2_CVT_FUNC(32s32f, int, float);
+CV_AVX2_CVT_FUNC(32f8u, float, uchar);
+CV_AVX2_CVT_FUNC(32f16u, float, ushort);
+CV_AVX2_CVT_FUNC(32f16s, float, short);
+CV_AVX2_CVT_FUNC(32f32s, float, int);
+
+#undef CV_AVX2_CVT_FUNC
+
+// dst = saturate_cast<dtype>(src*scale + shift), for the conversions done in single precision
+#define CV_AVX2_CVT_SCALE_FUNC(suffix, stype, dtype) \
+void cvtScale##suffix(const stype* src, size_t sstep, dtype* dst, size_t dstep, \
+                      int width, int height, float scale, float shift)
+
+CV_AVX2_CVT_SCALE_FUNC(8u, uchar, uchar);
+CV_AVX2_CVT_SCALE_FUNC(8u16u, uchar, ushort);
+CV_AVX2_CVT_SCALE_FUNC(8u16s, uchar, short);
+CV_AVX2_CVT_SCALE_FUNC(8u32s, uchar, int);
+CV_AVX2_CVT_SCALE_FUNC(8u32f, uchar, float);
+
+CV_AVX2_CVT_SCALE_FUNC(16u8u, ushort, uchar);
+CV_AVX2_CVT_SCALE_FUNC(16u, ushort, ushort);
+CV_AVX2_CVT_SCALE_FUNC(16u16s, ushort, short);
+CV_AVX2_CVT_SCALE_FUNC(16u32s, ushort, int);
+CV_AVX2_CVT_SCALE_FUNC(16u32f, ushort, float);
+
+CV_AVX2_CVT_SCALE_FUNC(16s8u, short, uchar);
+CV_AVX2_CVT_SCALE_FUNC(16s16u, short, ushort);
+CV_AVX2_CVT_SCALE_FUNC(16s, short, short);
+CV_AVX2_CVT_SCALE_FUNC(16s32s, short, int);
+CV_AVX2_CVT_SCALE_FUNC(16s32f, short, float);
+
+CV_AVX2_CVT_SCALE_FUNC(32f8u, float, uchar);
+CV_AVX2_CVT_SCALE_FUNC(32f16u, float, ushort);
+CV_AVX2_CVT_SCALE_FUNC(32f16s, float, short);
+CV_AVX2_CVT_SCALE_FUNC(32f32s, float, int);
+CV_AVX2_CVT_SCALE_FUNC(32f, float, float);
+
+#undef CV_AVX2_CVT_SCALE_FUNC
+
+// LUT with a 32-bit table (lut is int or float data); uses gather instructions
+void LUT8u_32s(const uchar* src, const int* lut, int* dst, int len, int cn, int lutcn);
+
+}
+}
+
+#endif
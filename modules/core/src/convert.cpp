@@ -41,6 +41,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "avx2.hpp"
 
 namespace cv
 {
@@ -806,6 +807,23 @@ static void cvt##suffix( const stype* src, size_t sstep, const uchar*, size_t, \
     cvt_(src, sstep, dst, dstep, size); \
 }
 
+#define DEF_CVT_SCALE_FUNC_AVX2(suffix, stype, dtype) \
+static void cvtScale##suffix( const stype* src, size_t sstep, const uchar*, size_t, \
+dtype* dst, size_t dstep, Size size, double* scale) \
+{ \
+    IF_AVX2(avx2::cvtScale##suffix(src, sstep, dst, dstep, size.width, size.height, \
+                                   (float)scale[0], (float)scale[1])); \
+    cvtScale_(src, sstep, dst, dstep, size, (float)scale[0], (float)scale[1]); \
+}
+
+#define DEF_CVT_FUNC_AVX2(suffix, stype, dtype) \
+static void cvt##suffix( const stype* src, size_t sstep, const uchar*, size_t, \
+                         dtype* dst, size_t dstep, Size size, double*) \
+{ \
+    IF_AVX2(avx2::cvt##suffix(src, sstep, dst, dstep, size.width, size.height)); \
+    cvt_(src, sstep, dst, dstep, size); \
+}
+
 #define DEF_CPY_FUNC(suffix, stype) \
 static void cvt##suffix( const stype* src, size_t sstep, const uchar*, size_t, \
 stype* dst, size_t dstep, Size size, double*) \
@@ -822,12 +840,12 @@ DEF_CVT_SCALE_ABS_FUNC(32s8u, cvtScaleAbs_, int, uchar, float);
 DEF_CVT_SCALE_ABS_FUNC(32f8u, cvtScaleAbs_, float, uchar, float);
 DEF_CVT_SCALE_ABS_FUNC(64f8u, cvtScaleAbs_, double, uchar, float);
 
-DEF_CVT_SCALE_FUNC(8u,     uchar, uchar, float);
+DEF_CVT_SCALE_FUNC_AVX2(8u,     uchar, uchar);
 DEF_CVT_SCALE_FUNC(8s8u,   schar, uchar, float);
-DEF_CVT_SCALE_FUNC(16u8u,  ushort, uchar, float);
-DEF_CVT_SCALE_FUNC(16s8u,  short, uchar, float);
+DEF_CVT_SCALE_FUNC_AVX2(16u8u,  ushort, uchar);
+DEF_CVT_SCALE_FUNC_AVX2(16s8u,  short, uchar);
 DEF_CVT_SCALE_FUNC(32s8u,  int, uchar, float);
-DEF_CVT_SCALE_FUNC(32f8u,  float, uchar, float);
+DEF_CVT_SCALE_FUNC_AVX2(32f8u,  float, uchar);
 DEF_CVT_SCALE_FUNC(64f8u,  double, uchar, float);
 
 DEF_CVT_SCALE_FUNC(8u8s,   uchar, schar, float);
@@ -838,36 +856,36 @@ DEF_CVT_SCALE_FUNC(32s8s,  int, schar, float);
 DEF_CVT_SCALE_FUNC(32f8s,  float, schar, float);
 DEF_CVT_SCALE_FUNC(64f8s,  double, schar, float);
 
-DEF_CVT_SCALE_FUNC(8u16u,  uchar, ushort, float);
+DEF_CVT_SCALE_FUNC_AVX2(8u16u,  uchar, ushort);
 DEF_CVT_SCALE_FUNC(8s16u,  schar, ushort, float);
-DEF_CVT_SCALE_FUNC(16u,    ushort, ushort, float);
-DEF_CVT_SCALE_FUNC(16s16u, short, ushort, float);
+DEF_CVT_SCALE_FUNC_AVX2(16u,    ushort, ushort);
+DEF_CVT_SCALE_FUNC_AVX2(16s16u, short, ushort);
 DEF_CVT_SCALE_FUNC(32s16u, int, ushort, float);
-DEF_CVT_SCALE_FUNC(32f16u, float, ushort, float);
+DEF_CVT_SCALE_FUNC_AVX2(32f16u, float, ushort);
 DEF_CVT_SCALE_FUNC(64f16u, double, ushort, float);
 
-DEF_CVT_SCALE_FUNC(8u16s,  uchar, short, float);
+DEF_CVT_SCALE_FUNC_AVX2(8u16s,  uchar, short);
 DEF_CVT_SCALE_FUNC(8s16s,  schar, short, float);
-DEF_CVT_SCALE_FUNC(16u16s, ushort, short, float);
-DEF_CVT_SCALE_FUNC(16s,    short, short, float);
+DEF_CVT_SCALE_FUNC_AVX2(16u16s, ushort, short);
+DEF_CVT_SCALE_FUNC_AVX2(16s,    short, short);
 DEF_CVT_SCALE_FUNC(32s16s, int, short, float);
-DEF_CVT_SCALE_FUNC(32f16s, float, short, float);
+DEF_CVT_SCALE_FUNC_AVX2(32f16s, float, short);
 DEF_CVT_SCALE_FUNC(64f16s, double, short, float);
 
-DEF_CVT_SCALE_FUNC(8u32s,  uchar, int, float);
+DEF_CVT_SCALE_FUNC_AVX2(8u32s,  uchar, int);
 DEF_CVT_SCALE_FUNC(8s32s,  schar, int, float);
-DEF_CVT_SCALE_FUNC(16u32s, ushort, int, float);
-DEF_CVT_SCALE_FUNC(16s32s, short, int, float);
+DEF_CVT_SCALE_FUNC_AVX2(16u32s, ushort, int);
+DEF_CVT_SCALE_FUNC_AVX2(16s32s, short, int);
 DEF_CVT_SCALE_FUNC(32s,    int, int, double);
-DEF_CVT_SCALE_FUNC(32f32s, float, int, float);
+DEF_CVT_SCALE_FUNC_AVX2(32f32s, float, int);
 DEF_CVT_SCALE_FUNC(64f32s, double, int, double);
 
-DEF_CVT_SCALE_FUNC(8u32f,  uchar, float, float);
+DEF_CVT_SCALE_FUNC_AVX2(8u32f,  uchar, float);
 DEF_CVT_SCALE_FUNC(8s32f,  schar, float, float);
-DEF_CVT_SCALE_FUNC(16u32f, ushort, float, float);
-DEF_CVT_SCALE_FUNC(16s32f, short, float, float);
+DEF_CVT_SCALE_FUNC_AVX2(16u32f, ushort, float);
+DEF_CVT_SCALE_FUNC_AVX2(16s32f, short, float);
 DEF_CVT_SCALE_FUNC(32s32f, int, float, double);
-DEF_CVT_SCALE_FUNC(32f,    float, float, float);
+DEF_CVT_SCALE_FUNC_AVX2(32f,    float, float);
 DEF_CVT_SCALE_FUNC(64f32f, double, float, double);
 
 DEF_CVT_SCALE_FUNC(8u64f,  uchar, double, double);
@@ -883,7 +901,7 @@ DEF_CVT_FUNC(8s8u,   schar, uchar);
 DEF_CVT_FUNC(16u8u,  ushort, uchar);
 DEF_CVT_FUNC(16s8u,  short, uchar);
 DEF_CVT_FUNC(32s8u,  int, uchar);
-DEF_CVT_FUNC(32f8u,  float, uchar);
+DEF_CVT_FUNC_AVX2(32f8u,  float, uchar);
 DEF_CVT_FUNC(64f8u,  double, uchar);
 
 DEF_CVT_FUNC(8u8s,   uchar, schar);
@@ -898,14 +916,14 @@ DEF_CVT_FUNC(8s16u,  schar, ushort);
 DEF_CPY_FUNC(16u,    ushort);
 DEF_CVT_FUNC(16s16u, short, ushort);
 DEF_CVT_FUNC(32s16u, int, ushort);
-DEF_CVT_FUNC(32f16u, float, ushort);
+DEF_CVT_FUNC_AVX2(32f16u, float, ushort);
 DEF_CVT_FUNC(64f16u, double, ushort);
 
 DEF_CVT_FUNC(8u16s,  uchar, short);
 DEF_CVT_FUNC(8s16s,  schar, short);
 DEF_CVT_FUNC(16u16s, ushort, short);
 DEF_CVT_FUNC(32s16s, int, short);
-DEF_CVT_FUNC(32f16s, float, short);
+DEF_CVT_FUNC_AVX2(32f16s, float, short);
 DEF_CVT_FUNC(64f16s, double, short);
 
 DEF_CVT_FUNC(8u32s,  uchar, int);
@@ -913,14 +931,14 @@ DEF_CVT_FUNC(8s32s,  schar, int);
 DEF_CVT_FUNC(16u32s, ushort, int);
 DEF_CVT_FUNC(16s32s, short, int);
 DEF_CPY_FUNC(32s,    int);
-DEF_CVT_FUNC(32f32s, float, int);
+DEF_CVT_FUNC_AVX2(32f32s, float, int);
 DEF_CVT_FUNC(64f32s, double, int);
 
-DEF_CVT_FUNC(8u32f,  uchar, float);
+DEF_CVT_FUNC_AVX2(8u32f,  uchar, float);
 DEF_CVT_FUNC(8s32f,  schar, float);
-DEF_CVT_FUNC(16u32f, ushort, float);
-DEF_CVT_FUNC(16s32f, short, float);
-DEF_CVT_FUNC(32s32f, int, float);
+DEF_CVT_FUNC_AVX2(16u32f, ushort, float);
+DEF_CVT_FUNC_AVX2(16s32f, short, float);
+DEF_CVT_FUNC_AVX2(32s32f, int, float);
 DEF_CVT_FUNC(64f32f, double, float);
 
 DEF_CVT_FUNC(8u64f,  uchar, double);
@@ -1150,11 +1168,13 @@ static void LUT8u_16s( const uchar* src, const short* lut, short* dst, int len,
 
 static void LUT8u_32s( const uchar* src, const int* lut, int* dst, int len, int cn, int lutcn )
 {
+    IF_AVX2(avx2::LUT8u_32s(src, lut, dst, len, cn, lutcn));
     LUT8u_( src, lut, dst, len, cn, lutcn );
 }
 
 static void LUT8u_32f( const uchar* src, const float* lut, float* dst, int len, int cn, int lutcn )
 {
+    IF_AVX2(avx2::LUT8u_32s(src, (const int*)lut, (int*)dst, len, cn, lutcn));
     LUT8u_( src, lut, dst, len, cn, lutcn );
 }
 
@@ -0,0 +1,232 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* AVX2 variants of the convertTo and LUT kernels from convert.cpp (see avx2.hpp) */
+
+#ifdef HAVE_CVCONFIG_H
+#include "cvconfig.h"
+#endif
+
+#ifdef HAVE_AVX2_DISPATCH
+
+#include "avx2.hpp"
+#include <immintrin.h>
+
+namespace cv
+{
+namespace avx2
+{
+
+namespace
+{
+
+// loads 8 elements converted to float
+inline __m256 load8f(const uchar* p)
+{ return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)p))); }
+inline __m256 load8f(const ushort* p)
+{ return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)p))); }
+inline __m256 load8f(const short* p)
+{ return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p))); }
+inline __m256 load8f(const int* p)
+{ return _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)p)); }
+inline __m256 load8f(const float* p)
+{ return _mm256_loadu_ps(p); }
+
+// stores 8 floats rounded to the nearest and saturated, as saturate_cast<> does
+inline void store8f(uchar* p, __m256 v)
+{
+    __m256i i = _mm256_cvtps_epi32(v);
+    __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1));
+    _mm_storel_epi64((__m128i*)p, _mm_packus_epi16(w, w));
+}
+inline void store8f(ushort* p, __m256 v)
+{
+    __m256i i = _mm256_cvtps_epi32(v);
+    _mm_storeu_si128((__m128i*)p, _mm_packus_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+}
+inline void store8f(short* p, __m256 v)
+{
+    __m256i i = _mm256_cvtps_epi32(v);
+    _mm_storeu_si128((__m128i*)p, _mm_packs_epi32(_mm256_castsi256_si128(i), _mm256_extracti128_si256(i, 1)));
+}
+inline void store8f(int* p, __m256 v)
+{ _mm256_storeu_si256((__m256i*)p, _mm256_cvtps_epi32(v)); }
+inline void store8f(float* p, __m256 v)
+{ _mm256_storeu_ps(p, v); }
+
+// see binaryOp in arithm_avx2.cpp
+template<typename T, typename DT, class Op> void
+unaryOp( const T* src, size_t sstep, DT* dst, size_t dstep, int width, int height, const Op& op )
+{
+    for( ; height--; src = (const T*)((const uchar*)src + sstep), dst = (DT*)((uchar*)dst + dstep) )
+    {
+        int x = 0;
+        for( ; x <= width - Op::N; x += Op::N )
+            op(src + x, dst + x);
+
+        if( x < width )
+        {
+            T buf[Op::N];
+            DT dbuf[Op::N];
+            int i = 0, n = width - x;
+            for( ; i < n; i++ )
+                buf[i] = src[x + i];
+            for( ; i < Op::N; i++ )
+                buf[i] = 0;
+            op(buf, dbuf);
+            for( i = 0; i < n; i++ )
+                dst[x + i] = dbuf[i];
+        }
+    }
+}
+
+template<typename T, typename DT> struct OpCvt
+{
+    enum { N = 16 };
+    void operator()(const T* src, DT* dst) const
+    {
+        store8f(dst, load8f(src));
+        store8f(dst + 8, load8f(src + 8));
+    }
+};
+
+// the multiplication and the addition are not fused to match the generic code bit-exactly
+template<typename T, typename DT> struct OpCvtScale
+{
+    enum { N = 16 };
+    OpCvtScale(float scale, float shift) : a(_mm256_set1_ps(scale)), b(_mm256_set1_ps(shift)) {}
+    void operator()(const T* src, DT* dst) const
+    {
+        store8f(dst, _mm256_add_ps(_mm256_mul_ps(load8f(src), a), b));
+        store8f(dst + 8, _mm256_add_ps(_mm256_mul_ps(load8f(src + 8), a), b));
+    }
+    __m256 a, b;
+};
+
+}
+
+#define CV_AVX2_DEF_CVT_FUNC(suffix, stype, dtype) \
+void cvt##suffix(const stype* src, size_t sstep, dtype* dst, size_t dstep, int width, int height) \
+{ \
+    unaryOp(src, sstep, dst, dstep, width, height, OpCvt<stype, dtype>()); \
+}
+
+CV_AVX2_DEF_CVT_FUNC(8u32f, uchar, float)
+CV_AVX2_DEF_CVT_FUNC(16u32f, ushort, float)
+CV_AVX2_DEF_CVT_FUNC(16s32f, short, float)
+CV_AVX2_DEF_CVT_FUNC(32s32f, int, float)
+CV_AVX2_DEF_CVT_FUNC(32f8u, float, uchar)
+CV_AVX2_DEF_CVT_FUNC(32f16u, float, ushort)
+CV_AVX2_DEF_CVT_FUNC(32f16s, float, short)
+CV_AVX2_DEF_CVT_FUNC(32f32s, float, int)
+
+#undef CV_AVX2_DEF_CVT_FUNC
+
+#define CV_AVX2_DEF_CVT_SCALE_FUNC(suffix, stype, dtype) \
+void cvtScale##suffix(const stype* src, size_t sstep, dtype* dst, size_t dstep, \
+                      int width, int height, float scale, float shift) \
+{ \
+    unaryOp(src, sstep, dst, dstep, width, height, OpCvtScale<stype, dtype>(scale, shift)); \
+}
+
+CV_AVX2_DEF_CVT_SCALE_FUNC(8u, uchar, uchar)
+CV_AVX2_DEF_CVT_SCALE_FUNC(8u16u, uchar, ushort)
+CV_AVX2_DEF_CVT_SCALE_FUNC(8u16s, uchar, short)
+CV_AVX2_DEF_CVT_SCALE_FUNC(8u32s, uchar, int)
+CV_AVX2_DEF_CVT_SCALE_FUNC(8u32f, uchar, float)
+
+CV_AVX2_DEF_CVT_SCALE_FUNC(16u8u, ushort, uchar)
+CV_AVX2_DEF_CVT_SCALE_FUNC(16u, ushort, ushort)
+CV_AVX2_DEF_CVT_SCALE_FUNC(16u16s, ushort, short)
+CV_AVX2_DEF_CVT_SCALE_FUNC(16u32s, ushort, int)
+CV_AVX2_DEF_CVT_SCALE_FUNC(16u32f, ushort, float)
+
+CV_AVX2_DEF_CVT_SCALE_FUNC(16s8u, short, uchar)
+CV_AVX2_DEF_CVT_SCALE_FUNC(16s16u, short, ushort)
+CV_AVX2_DEF_CVT_SCALE_FUNC(16s, short, short)
+CV_AVX2_DEF_CVT_SCALE_FUNC(16s32s, short, int)
+CV_AVX2_DEF_CVT_SCALE_FUNC(16s32f, short, float)
+
+CV_AVX2_DEF_CVT_SCALE_FUNC(32f8u, float, uchar)
+CV_AVX2_DEF_CVT_SCALE_FUNC(32f16u, float, ushort)
+CV_AVX2_DEF_CVT_SCALE_FUNC(32f16s, float, short)
+CV_AVX2_DEF_CVT_SCALE_FUNC(32f32s, float, int)
+CV_AVX2_DEF_CVT_SCALE_FUNC(32f, float, float)
+
+#undef CV_AVX2_DEF_CVT_SCALE_FUNC
+
+void LUT8u_32s(const uchar* src, const int* lut, int* dst, int len, int cn, int lutcn)
+{
+    int i = 0;
+    len *= cn;
+
+    if( lutcn == 1 || 8 % cn == 0 )
+    {
+        // with per-channel tables element i takes its value from lut[src[i]*cn + i % cn];
+        // it works for the vectors when 8 elements hold whole pixels
+        int k = lutcn == 1 ? 1 : cn;
+        int delta[8];
+        for( int j = 0; j < 8; j++ )
+            delta[j] = j % k;
+        __m256i vdelta = _mm256_loadu_si256((const __m256i*)delta), vk = _mm256_set1_epi32(k);
+
+        for( ; i <= len - 8; i += 8 )
+        {
+            __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+            idx = _mm256_add_epi32(_mm256_mullo_epi32(idx, vk), vdelta);
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_i32gather_epi32(lut, idx, 4));
+        }
+        for( ; i < len; i++ )
+            dst[i] = lut[src[i]*k + i % k];
+    }
+    else
+    {
+        for( ; i < len; i += cn )
+            for( int j = 0; j < cn; j++ )
+                dst[i+j] = lut[src[i+j]*cn + j];
+    }
+}
+
+}
+}
+
+#endif
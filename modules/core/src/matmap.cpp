@@ -0,0 +1,288 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+/* ////////////////////////////////////////////////////////////////////
+//
+//  Matrices mapped to files
+//
+// */
+
+#include "precomp.hpp"
+
+#if defined WIN32 || defined _WIN32 || defined WINCE
+    #include <windows.h>
+    #undef small
+    #undef min
+    #undef max
+    #undef abs
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace cv
+{
+
+/*
+   The layout written by writeMappedMat():
+   magic (8 bytes), header size, type, dims, sizes[dims] (32-bit integers in the native byte order),
+   zero padding up to the header size (a multiple of MAPPED_MAT_ALIGN), the continuous matrix data.
+*/
+static const char mappedMatMagic[8] = { 'C', 'V', 'M', 'A', 'T', '\0', '\0', '\1' };
+enum { MAPPED_MAT_ALIGN = 64 };
+
+namespace
+{
+
+struct MappedRegion
+{
+    int refcount; // Mat::refcount points here, so it goes first
+    void* addr;
+    size_t len;
+};
+
+static void unmapRegion(void* addr, size_t len)
+{
+#if defined WIN32 || defined _WIN32 || defined WINCE
+    (void)len;
+    UnmapViewOfFile(addr);
+#else
+    munmap(addr, len);
+#endif
+}
+
+static void* mapRegion(const string& filename, int mode, size_t& len)
+{
+    CV_Assert( mode == MAP_READ_ONLY || mode == MAP_COPY_ON_WRITE || mode == MAP_READ_WRITE );
+    void* addr = 0;
+    len = 0;
+#if defined WIN32 || defined _WIN32 || defined WINCE
+    HANDLE file = CreateFileA(filename.c_str(), mode == MAP_READ_WRITE ? GENERIC_READ|GENERIC_WRITE : GENERIC_READ,
+                              FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if( file == INVALID_HANDLE_VALUE )
+        return 0;
+    LARGE_INTEGER fsize;
+    if( GetFileSizeEx(file, &fsize) && fsize.QuadPart > 0 && (unsigned long long)fsize.QuadPart <= (size_t)-1 )
+    {
+        DWORD protect = mode == MAP_READ_ONLY ? PAGE_READONLY : mode == MAP_COPY_ON_WRITE ? PAGE_WRITECOPY : PAGE_READWRITE;
+        DWORD access = mode == MAP_READ_ONLY ? FILE_MAP_READ : mode == MAP_COPY_ON_WRITE ? FILE_MAP_COPY : FILE_MAP_WRITE;
+        HANDLE mapping = CreateFileMappingA(file, 0, protect, 0, 0, 0);
+        if( mapping )
+        {
+            // the view keeps the mapping object alive
+            addr = MapViewOfFile(mapping, access, 0, 0, 0);
+            CloseHandle(mapping);
+            len = (size_t)fsize.QuadPart;
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(filename.c_str(), mode == MAP_READ_WRITE ? O_RDWR : O_RDONLY);
+    if( fd < 0 )
+        return 0;
+    struct stat st;
+    if( fstat(fd, &st) == 0 && st.st_size > 0 )
+    {
+        len = (size_t)st.st_size;
+        addr = mmap(0, len, mode == MAP_READ_ONLY ? PROT_READ : PROT_READ|PROT_WRITE,
+                    mode == MAP_COPY_ON_WRITE ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+        if( addr == MAP_FAILED )
+            addr = 0;
+    }
+    close(fd);
+#endif
+    if( !addr )
+        CV_Error_(CV_StsError, ("Can not map %s", filename.c_str()));
+    return addr;
+}
+
+/*
+   The allocator of the mapped matrices. Deallocation unmaps the file; if such a matrix is
+   re-created with another size or type, the new buffer is allocated on the heap.
+*/
+class MappedMatAllocator : public MatAllocator
+{
+public:
+    void allocate(int dims, const int* sizes, int type, int*& refcount,
+                  uchar*& datastart, uchar*& data, size_t* step)
+    {
+        size_t total = CV_ELEM_SIZE(type);
+        for( int i = dims-1; i >= 0; i-- )
+        {
+            step[i] = total;
+            total *= sizes[i];
+        }
+        MappedRegion* r = new MappedRegion;
+        r->refcount = 1;
+        r->addr = 0;
+        r->len = 0;
+        data = datastart = (uchar*)fastMalloc(total);
+        refcount = &r->refcount;
+    }
+
+    void deallocate(int* refcount, uchar* datastart, uchar*)
+    {
+        MappedRegion* r = (MappedRegion*)refcount;
+        if( r->addr )
+            unmapRegion(r->addr, r->len);
+        else
+            fastFree(datastart);
+        delete r;
+    }
+};
+
+static MappedMatAllocator mappedMatAllocator;
+
+static Mat mapRegionAsMat(const string& filename, int ndims, const int* sizes, int type,
+                          size_t offset, void* addr, size_t len)
+{
+    Mat m;
+    try
+    {
+        m = Mat(ndims, sizes, type, (uchar*)addr + offset);
+        if( offset > len || m.total()*m.elemSize() > len - offset )
+            CV_Error_(CV_StsOutOfRange, ("%s is too small for the matrix", filename.c_str()));
+    }
+    catch(...)
+    {
+        unmapRegion(addr, len);
+        throw;
+    }
+
+    MappedRegion* r = new MappedRegion;
+    r->refcount = 1;
+    r->addr = addr;
+    r->len = len;
+    m.refcount = &r->refcount;
+    m.allocator = &mappedMatAllocator;
+    return m;
+}
+
+}
+
+Mat mapMat(const string& filename, int ndims, const int* sizes, int type, size_t offset, int mode)
+{
+    size_t len = 0;
+    void* addr = mapRegion(filename, mode, len);
+    if( !addr )
+        return Mat();
+    return mapRegionAsMat(filename, ndims, sizes, type, offset, addr, len);
+}
+
+Mat mapMat(const string& filename, Size size, int type, size_t offset, int mode)
+{
+    int sizes[] = { size.height, size.width };
+    return mapMat(filename, 2, sizes, type, offset, mode);
+}
+
+Mat mapMat(const string& filename, int mode)
+{
+    size_t len = 0;
+    void* addr = mapRegion(filename, mode, len);
+    if( !addr )
+        return Mat();
+    const int* hdr = (const int*)((const uchar*)addr + sizeof(mappedMatMagic));
+    const size_t hdrmin = sizeof(mappedMatMagic) + 3*sizeof(int);
+    int sizes[CV_MAX_DIM], ndims = 0, type = 0;
+    size_t offset = 0;
+
+    bool ok = len >= hdrmin && memcmp(addr, mappedMatMagic, sizeof(mappedMatMagic)) == 0;
+    if( ok )
+    {
+        offset = (size_t)hdr[0];
+        type = hdr[1];
+        ndims = hdr[2];
+        ok = ndims >= 1 && ndims <= CV_MAX_DIM && type == CV_MAT_TYPE(type) &&
+             offset >= hdrmin + ndims*sizeof(int) && offset <= len;
+    }
+    for( int i = 0; ok && i < ndims; i++ )
+    {
+        sizes[i] = hdr[3 + i];
+        ok = sizes[i] >= 0;
+    }
+    if( !ok )
+    {
+        unmapRegion(addr, len);
+        CV_Error_(CV_StsParseError, ("%s is not a mapped matrix file", filename.c_str()));
+    }
+    return mapRegionAsMat(filename, ndims, sizes, type, offset, addr, len);
+}
+
+void writeMappedMat(const string& filename, const Mat& m)
+{
+    CV_Assert( m.data && m.dims <= CV_MAX_DIM );
+
+    int ndims = m.dims;
+    size_t hdrsize = alignSize(sizeof(mappedMatMagic) + (3 + ndims)*sizeof(int), MAPPED_MAT_ALIGN);
+    AutoBuffer<uchar> _hdr(hdrsize);
+    uchar* hdr = _hdr;
+    memset(hdr, 0, hdrsize);
+    memcpy(hdr, mappedMatMagic, sizeof(mappedMatMagic));
+    int* ihdr = (int*)(hdr + sizeof(mappedMatMagic));
+    ihdr[0] = (int)hdrsize;
+    ihdr[1] = m.type();
+    ihdr[2] = ndims;
+    for( int i = 0; i < ndims; i++ )
+        ihdr[3 + i] = m.size[i];
+
+    FILE* f = fopen(filename.c_str(), "wb");
+    if( !f )
+        CV_Error_(CV_StsError, ("Can not open %s for writing", filename.c_str()));
+
+    const Mat* arrays[] = { &m, 0 };
+    uchar* ptrs[1];
+    NAryMatIterator it(arrays, ptrs);
+    size_t planesize = it.size*m.elemSize();
+    bool ok = fwrite(hdr, 1, hdrsize, f) == hdrsize;
+
+    for( size_t p = 0; ok && p < it.nplanes; p++, ++it )
+        ok = fwrite(ptrs[0], 1, planesize, f) == planesize;
+    ok = fclose(f) == 0 && ok;
+    if( !ok )
+        CV_Error_(CV_StsError, ("Can not write %s", filename.c_str()));
+}
+
+}
+
+/* End of file. */
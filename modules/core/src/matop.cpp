@@ -47,6 +47,7 @@
 // */
 
 #include "precomp.hpp"
+#include "opencv2/core/intrin.hpp"
 
 namespace cv
 {
@@ -204,6 +205,89 @@ public:
 
 static MatOp_Initializer g_MatOp_Initializer;
 
+/*
+   A chain of element-wise operations whose arguments are element-wise expressions themselves.
+   The arguments are kept in a FusedArgs object referenced by expr.c (see fusedArgs() below);
+   expr.flags is one of '+' (alpha*A + beta*B + s), '*' (alpha*A*B), 'm', 'M' (min/max with B or s[0]),
+   'a' (|A - B| or |A - s|) or FUSED_CMP + CMP_* (A cmp B or A cmp alpha).
+   The whole tree is computed in one pass over the data, without temporary matrices.
+   Division is not fused: cv::divide() rounds the quotient depending on the neighbour elements.
+*/
+class MatOp_Fused : public MatOp
+{
+public:
+    MatOp_Fused() {}
+    virtual ~MatOp_Fused() {}
+
+    bool elementWise(const MatExpr& /*expr*/) const { return true; }
+    void assign(const MatExpr& expr, Mat& m, int type=-1) const;
+
+    void roi(const MatExpr& expr, const Range& rowRange, const Range& colRange, MatExpr& res) const;
+    void diag(const MatExpr& expr, int d, MatExpr& res) const;
+
+    void add(const MatExpr& e1, const Scalar& s, MatExpr& res) const;
+    void subtract(const Scalar& s, const MatExpr& expr, MatExpr& res) const;
+    void multiply(const MatExpr& e1, double s, MatExpr& res) const;
+
+    Size size(const MatExpr& expr) const;
+    int type(const MatExpr& expr) const;
+
+    enum { FUSED_CMP = 256 };
+
+    static bool canFuse(const MatExpr& e);
+    static void makeExpr(MatExpr& res, int op, const MatExpr& e1, const MatExpr* e2,
+                         double alpha=1, double beta=1, const Scalar& s=Scalar());
+};
+
+static MatOp_Fused g_MatOp_Fused;
+
+// the argument expressions of a fused operation; b.op is 0 for the operations with a scalar
+struct FusedArgs
+{
+    MatExpr a, b;
+};
+
+/*
+   FusedArgs is stored in expr.c as a 1 x sizeof(FusedArgs) byte matrix allocated by
+   FusedArgsAllocator, which destroys the arguments together with the last reference.
+   So the copies of an expression share its arguments like they share the matrices,
+   and MatExpr itself keeps its layout.
+*/
+class FusedArgsAllocator : public MatAllocator
+{
+public:
+    void allocate(int dims, const int* sizes, int type, int*& refcount,
+                  uchar*& datastart, uchar*& data, size_t* step)
+    {
+        CV_Assert( dims == 2 && sizes[0] == 1 && sizes[1] == (int)sizeof(FusedArgs) && type == CV_8U );
+        datastart = data = (uchar*)fastMalloc(sizeof(FusedArgs) + sizeof(*refcount));
+        new(data) FusedArgs;
+        refcount = (int*)(data + sizeof(FusedArgs));
+        *refcount = 1;
+        step[0] = sizeof(FusedArgs);
+        step[1] = 1;
+    }
+
+    void deallocate(int* /*refcount*/, uchar* datastart, uchar* data)
+    {
+        ((FusedArgs*)data)->~FusedArgs();
+        fastFree(datastart);
+    }
+};
+
+static FusedArgsAllocator g_FusedArgsAllocator;
+
+static Mat createFusedArgs()
+{
+    Mat m;
+    m.allocator = &g_FusedArgsAllocator;
+    m.create(1, (int)sizeof(FusedArgs), CV_8U);
+    return m;
+}
+
+static inline const FusedArgs& fusedArgs(const MatExpr& e) { return *(const FusedArgs*)e.c.data; }
+static inline FusedArgs& fusedArgs(MatExpr& e) { return *(FusedArgs*)e.c.data; }
+
 static inline bool isIdentity(const MatExpr& e) { return e.op == &g_MatOp_Identity; }
 static inline bool isAddEx(const MatExpr& e) { return e.op == &g_MatOp_AddEx; }
 static inline bool isScaled(const MatExpr& e) { return isAddEx(e) && (!e.b.data || e.beta == 0) && e.s == Scalar(); }
@@ -216,6 +300,9 @@ static inline bool isSolve(const MatExpr& e) { return e.op == &g_MatOp_Solve; }
 static inline bool isGEMM(const MatExpr& e) { return e.op == &g_MatOp_GEMM; }
 static inline bool isMatProd(const MatExpr& e) { return e.op == &g_MatOp_GEMM && (!e.c.data || e.beta == 0); }
 static inline bool isInitializer(const MatExpr& e) { return e.op == &g_MatOp_Initializer; }
+static inline bool isFused(const MatExpr& e) { return e.op == &g_MatOp_Fused; }
+static inline bool isLinearTerm(const MatExpr& e) { return isIdentity(e) || (isAddEx(e) && (!e.b.data || e.beta == 0)); }
+static inline bool isProductTerm(const MatExpr& e) { return isIdentity(e) || isScaled(e) || isReciprocal(e); }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -327,6 +414,13 @@ void MatOp::add(const MatExpr& e1, const MatExpr& e2, MatExpr& res) const
 {
     if( this == e2.op )
     {
+        if( (!isLinearTerm(e1) || !isLinearTerm(e2)) &&
+            MatOp_Fused::canFuse(e1) && MatOp_Fused::canFuse(e2) )
+        {
+            MatOp_Fused::makeExpr(res, '+', e1, &e2, 1, 1);
+            return;
+        }
+
         double alpha = 1, beta = 1;
         Scalar s;
         Mat m1, m2;
@@ -356,6 +450,12 @@ void MatOp::add(const MatExpr& e1, const MatExpr& e2, MatExpr& res) const
 
 void MatOp::add(const MatExpr& expr1, const Scalar& s, MatExpr& res) const
 {
+    if( MatOp_Fused::canFuse(expr1) )
+    {
+        MatOp_Fused::makeExpr(res, '+', expr1, 0, 1, 0, s);
+        return;
+    }
+
     Mat m1;
     expr1.op->assign(expr1, m1);
     MatOp_AddEx::makeExpr(res, m1, Mat(), 1, 0, s);
@@ -366,6 +466,13 @@ void MatOp::subtract(const MatExpr& e1, const MatExpr& e2, MatExpr& res) const
 {
     if( this == e2.op )
     {
+        if( (!isLinearTerm(e1) || !isLinearTerm(e2)) &&
+            MatOp_Fused::canFuse(e1) && MatOp_Fused::canFuse(e2) )
+        {
+            MatOp_Fused::makeExpr(res, '+', e1, &e2, 1, -1);
+            return;
+        }
+
         double alpha = 1, beta = -1;
         Scalar s;
         Mat m1, m2;
@@ -395,6 +502,12 @@ void MatOp::subtract(const MatExpr& e1, const MatExpr& e2, MatExpr& res) const
 
 void MatOp::subtract(const Scalar& s, const MatExpr& expr, MatExpr& res) const
 {
+    if( MatOp_Fused::canFuse(expr) )
+    {
+        MatOp_Fused::makeExpr(res, '+', expr, 0, -1, 0, s);
+        return;
+    }
+
     Mat m;
     expr.op->assign(expr, m);
     MatOp_AddEx::makeExpr(res, m, Mat(), -1, 0, s);
@@ -405,6 +518,13 @@ void MatOp::multiply(const MatExpr& e1, const MatExpr& e2, MatExpr& res, double
 {
     if( this == e2.op )
     {
+        if( (!isProductTerm(e1) || !isProductTerm(e2)) &&
+            MatOp_Fused::canFuse(e1) && MatOp_Fused::canFuse(e2) )
+        {
+            MatOp_Fused::makeExpr(res, '*', e1, &e2, scale);
+            return;
+        }
+
         Mat m1, m2;
 
         if( isReciprocal(e1) )
@@ -454,6 +574,12 @@ void MatOp::multiply(const MatExpr& e1, const MatExpr& e2, MatExpr& res, double
 
 void MatOp::multiply(const MatExpr& expr, double s, MatExpr& res) const
 {
+    if( MatOp_Fused::canFuse(expr) )
+    {
+        MatOp_Fused::makeExpr(res, '+', expr, 0, s, 0);
+        return;
+    }
+
     Mat m;
     expr.op->assign(expr, m);
     MatOp_AddEx::makeExpr(res, m, Mat(), s, 0);
@@ -510,6 +636,12 @@ void MatOp::divide(double s, const MatExpr& expr, MatExpr& res) const
 
 void MatOp::abs(const MatExpr& expr, MatExpr& res) const
 {
+    if( MatOp_Fused::canFuse(expr) )
+    {
+        MatOp_Fused::makeExpr(res, 'a', expr, 0);
+        return;
+    }
+
     Mat m;
     expr.op->assign(expr, m);
     MatOp_Bin::makeExpr(res, 'a', m, Mat());
@@ -1070,6 +1202,80 @@ MatExpr max(double s, const Mat& a)
     return e;
 }
 
+#define CV_MATEXPR_CMP_OPERATORS(op, cmpop, rcmpop) \
+MatExpr operator op (const MatExpr& e1, const MatExpr& e2) \
+{ \
+    MatExpr en; \
+    MatOp_Fused::makeExpr(en, MatOp_Fused::FUSED_CMP + cmpop, e1, &e2); \
+    return en; \
+} \
+MatExpr operator op (const MatExpr& e, const Mat& m) \
+{ \
+    MatExpr en, em(m); \
+    MatOp_Fused::makeExpr(en, MatOp_Fused::FUSED_CMP + cmpop, e, &em); \
+    return en; \
+} \
+MatExpr operator op (const Mat& m, const MatExpr& e) \
+{ \
+    MatExpr en; \
+    MatOp_Fused::makeExpr(en, MatOp_Fused::FUSED_CMP + cmpop, MatExpr(m), &e); \
+    return en; \
+} \
+MatExpr operator op (const MatExpr& e, double s) \
+{ \
+    MatExpr en; \
+    MatOp_Fused::makeExpr(en, MatOp_Fused::FUSED_CMP + cmpop, e, 0, s); \
+    return en; \
+} \
+MatExpr operator op (double s, const MatExpr& e) \
+{ \
+    MatExpr en; \
+    MatOp_Fused::makeExpr(en, MatOp_Fused::FUSED_CMP + rcmpop, e, 0, s); \
+    return en; \
+}
+
+CV_MATEXPR_CMP_OPERATORS(<, CV_CMP_LT, CV_CMP_GT)
+CV_MATEXPR_CMP_OPERATORS(<=, CV_CMP_LE, CV_CMP_GE)
+CV_MATEXPR_CMP_OPERATORS(==, CV_CMP_EQ, CV_CMP_EQ)
+CV_MATEXPR_CMP_OPERATORS(!=, CV_CMP_NE, CV_CMP_NE)
+CV_MATEXPR_CMP_OPERATORS(>=, CV_CMP_GE, CV_CMP_LE)
+CV_MATEXPR_CMP_OPERATORS(>, CV_CMP_GT, CV_CMP_LT)
+
+#define CV_MATEXPR_MINMAX_FUNCS(func, op) \
+MatExpr func(const MatExpr& e1, const MatExpr& e2) \
+{ \
+    MatExpr en; \
+    MatOp_Fused::makeExpr(en, op, e1, &e2); \
+    return en; \
+} \
+MatExpr func(const MatExpr& e, const Mat& m) \
+{ \
+    MatExpr en, em(m); \
+    MatOp_Fused::makeExpr(en, op, e, &em); \
+    return en; \
+} \
+MatExpr func(const Mat& m, const MatExpr& e) \
+{ \
+    MatExpr en; \
+    MatOp_Fused::makeExpr(en, op, MatExpr(m), &e); \
+    return en; \
+} \
+MatExpr func(const MatExpr& e, double s) \
+{ \
+    MatExpr en; \
+    MatOp_Fused::makeExpr(en, op, e, 0, 1, 0, Scalar(s)); \
+    return en; \
+} \
+MatExpr func(double s, const MatExpr& e) \
+{ \
+    MatExpr en; \
+    MatOp_Fused::makeExpr(en, op, e, 0, 1, 0, Scalar(s)); \
+    return en; \
+}
+
+CV_MATEXPR_MINMAX_FUNCS(min, 'm')
+CV_MATEXPR_MINMAX_FUNCS(max, 'M')
+
 MatExpr operator & (const Mat& a, const Mat& b)
 {
     MatExpr e;
@@ -1574,6 +1780,654 @@ inline void MatOp_Initializer::makeExpr(MatExpr& res, int method, Size sz, int t
 }
 
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static inline int fusedType(const MatExpr& e)
+{
+    // MatExpr::type() reports CV_8U for any comparison, the channels are needed here
+    return isCmp(e) ? CV_8UC(e.a.channels()) : e.type();
+}
+
+bool MatOp_Fused::canFuse(const MatExpr& e)
+{
+    if( isFused(e) )
+        return true;
+    if( !e.a.data || e.a.dims > 2 )
+        return false;
+    if( !isIdentity(e) && !isAddEx(e) && !isCmp(e) &&
+        !(e.op == &g_MatOp_Bin && e.flags != 0 && strchr("*mMa", e.flags) != 0) )
+        return false;
+    // leave the incompatible operands to the regular evaluation, it reports the error
+    return !e.b.data || (e.b.size == e.a.size && e.b.type() == e.a.type());
+}
+
+void MatOp_Fused::makeExpr(MatExpr& res, int op, const MatExpr& e1, const MatExpr* e2,
+                           double alpha, double beta, const Scalar& s)
+{
+    if( canFuse(e1) && (!e2 || (canFuse(*e2) && e2->size() == e1.size() && fusedType(*e2) == fusedType(e1))) &&
+        (!isIdentity(e1) || (e2 && !isIdentity(*e2))) )
+    {
+        Mat args = createFusedArgs();
+        FusedArgs& fa = *(FusedArgs*)args.data;
+        fa.a = e1;
+        if( e2 )
+            fa.b = *e2;
+        res = MatExpr(&g_MatOp_Fused, op, Mat(), Mat(), args, alpha, beta, s);
+        return;
+    }
+
+    Mat m1, m2;
+    e1.op->assign(e1, m1);
+    if( e2 )
+        e2->op->assign(*e2, m2);
+
+    if( op == '+' )
+        MatOp_AddEx::makeExpr(res, m1, m2, alpha, m2.data ? beta : 0, s);
+    else if( op >= FUSED_CMP )
+        res = MatExpr(&g_MatOp_Cmp, op - FUSED_CMP, m1, m2, Mat(), alpha, 1);
+    else
+        res = MatExpr(&g_MatOp_Bin, op, m1, m2, Mat(), alpha, m2.data ? 1 : 0, s);
+}
+
+void MatOp_Fused::roi(const MatExpr& e, const Range& rowRange, const Range& colRange, MatExpr& res) const
+{
+    const FusedArgs& ea = fusedArgs(e);
+    MatExpr r = e;
+    r.c = createFusedArgs();
+    FusedArgs& ra = fusedArgs(r);
+    ea.a.op->roi(ea.a, rowRange, colRange, ra.a);
+    if( ea.b.op )
+        ea.b.op->roi(ea.b, rowRange, colRange, ra.b);
+    res = r;
+}
+
+void MatOp_Fused::diag(const MatExpr& e, int d, MatExpr& res) const
+{
+    const FusedArgs& ea = fusedArgs(e);
+    MatExpr r = e;
+    r.c = createFusedArgs();
+    FusedArgs& ra = fusedArgs(r);
+    ea.a.op->diag(ea.a, d, ra.a);
+    if( ea.b.op )
+        ea.b.op->diag(ea.b, d, ra.b);
+    res = r;
+}
+
+void MatOp_Fused::add(const MatExpr& e, const Scalar& s, MatExpr& res) const
+{
+    if( e.flags == '+' )
+    {
+        res = e;
+        res.s += s;
+    }
+    else
+        MatOp::add(e, s, res);
+}
+
+void MatOp_Fused::subtract(const Scalar& s, const MatExpr& e, MatExpr& res) const
+{
+    if( e.flags == '+' )
+    {
+        res = e;
+        res.alpha = -res.alpha;
+        res.beta = -res.beta;
+        res.s = s - res.s;
+    }
+    else
+        MatOp::subtract(s, e, res);
+}
+
+void MatOp_Fused::multiply(const MatExpr& e, double s, MatExpr& res) const
+{
+    if( e.flags == '+' )
+    {
+        res = e;
+        res.alpha *= s;
+        res.beta *= s;
+        res.s *= s;
+    }
+    else if( e.flags == '*' )
+    {
+        res = e;
+        res.alpha *= s;
+    }
+    else
+        MatOp::multiply(e, s, res);
+}
+
+Size MatOp_Fused::size(const MatExpr& e) const
+{
+    return fusedArgs(e).a.size();
+}
+
+int MatOp_Fused::type(const MatExpr& e) const
+{
+    int t = fusedType(fusedArgs(e).a);
+    return e.flags >= FUSED_CMP ? CV_8UC(CV_MAT_CN(t)) : t;
+}
+
+namespace
+{
+
+enum { FUSED_BLOCK_SIZE = 1024 };
+
+struct FusedNode
+{
+    int op;         // 0 for loading a leaf matrix, otherwise the MatOp_Fused operation
+    int depth;      // the depth the step-by-step evaluation would store the node value with
+    int arg0, arg1; // the argument nodes (-1 if absent); the leaf index for the loads
+    double alpha, beta;
+    Scalar s;
+};
+
+// the expression tree flattened into the list of nodes, each node follows its arguments
+class FusedProgram
+{
+public:
+    FusedProgram(const MatExpr& e) { root = compile(e); }
+
+    vector<FusedNode> nodes;
+    vector<Mat> leaves;
+    int root;
+
+protected:
+    int compile(const MatExpr& e);
+    int load(const Mat& m);
+    int node(int op, int depth, int arg0, int arg1, double alpha, double beta, const Scalar& s);
+    int addNode(int depth, int arg0, int arg1, double alpha, double beta, const Scalar& s);
+};
+
+// the scalar converted the way cv::add(), cv::min() etc. convert it for a matrix of the given depth
+static Scalar fusedScalar(const Scalar& s, int depth)
+{
+    Scalar r;
+    for( int i = 0; i < 4; i++ )
+        r[i] = depth <= CV_32S ? (double)saturate_cast<int>(s[i]) : depth == CV_32F ? (double)(float)s[i] : s[i];
+    return r;
+}
+
+int FusedProgram::node(int op, int depth, int arg0, int arg1, double alpha, double beta, const Scalar& s)
+{
+    FusedNode n;
+    n.op = op;
+    n.depth = depth;
+    n.arg0 = arg0;
+    n.arg1 = arg1;
+    n.alpha = alpha;
+    n.beta = beta;
+    n.s = s;
+    nodes.push_back(n);
+    return (int)nodes.size() - 1;
+}
+
+int FusedProgram::load(const Mat& m)
+{
+    for( size_t i = 0; i < nodes.size(); i++ )
+    {
+        const Mat& l = leaves[nodes[i].arg0];
+        if( nodes[i].op == 0 && l.data == m.data && l.step[0] == m.step[0] &&
+            l.size == m.size && l.type() == m.type() )
+            return (int)i;
+    }
+    leaves.push_back(m);
+    return node(0, m.depth(), (int)leaves.size() - 1, -1, 1, 0, Scalar());
+}
+
+/*
+   alpha*A + beta*B + s, split into the same steps as MatOp_AddEx::assign() does it:
+   cv::addWeighted() and Mat::convertTo() take a real scalar as is and saturate the result once,
+   while cv::add() and cv::subtract() first convert the scalar to the matrix depth.
+*/
+int FusedProgram::addNode(int depth, int arg0, int arg1, double alpha, double beta, const Scalar& s)
+{
+    if( s.isReal() && (arg1 >= 0 || fabs(alpha) != 1) )
+        return node('+', depth, arg0, arg1, alpha, beta, s);
+    if( arg1 < 0 && fabs(alpha) == 1 )
+        return node('+', depth, arg0, -1, alpha, 0, fusedScalar(s, depth));
+    int t = node('+', depth, arg0, arg1, alpha, beta, Scalar());
+    return node('+', depth, t, -1, 1, 0, fusedScalar(s, depth));
+}
+
+int FusedProgram::compile(const MatExpr& e)
+{
+    if( isFused(e) )
+    {
+        const FusedArgs& args = fusedArgs(e);
+        int a0 = compile(args.a), a1 = args.b.op ? compile(args.b) : -1;
+        if( e.flags >= MatOp_Fused::FUSED_CMP )
+            return node(e.flags, CV_8U, a0, a1, e.alpha, e.beta, e.s);
+        int depth = nodes[a0].depth;
+        if( e.flags == '+' )
+            return addNode(depth, a0, a1, e.alpha, e.beta, e.s);
+        return node(e.flags, depth, a0, a1, e.alpha, e.beta, fusedScalar(e.s, depth));
+    }
+
+    int a0 = load(e.a), depth = e.a.depth();
+    if( isIdentity(e) )
+        return a0;
+    if( isAddEx(e) )
+        return addNode(depth, a0, e.b.data ? load(e.b) : -1, e.alpha, e.beta, e.s);
+
+    int a1 = e.b.data ? load(e.b) : -1;
+    if( isCmp(e) )
+        return node(MatOp_Fused::FUSED_CMP + e.flags, CV_8U, a0, a1, e.alpha, 1, Scalar());
+    CV_Assert( e.op == &g_MatOp_Bin );
+    return node(e.flags, depth, a0, a1, e.alpha, 1, fusedScalar(e.s, depth));
+}
+
+//////////////////////////////// the block operations ///////////////////////////////
+
+// x, y are the argument blocks; y is the block of scalars when the node has a single argument
+template<typename WT> struct FusedAdd
+{
+    FusedAdd(double _alpha, double _beta) : alpha((WT)_alpha), beta((WT)_beta) {}
+    WT operator()(WT x, WT y, WT c) const { return x*alpha + y*beta + c; }
+#if CV_SIMD128
+    v_float32x4 operator()(const v_float32x4& x, const v_float32x4& y, const v_float32x4& c) const
+    { return x*v_setall_f32((float)alpha) + y*v_setall_f32((float)beta) + c; }
+#endif
+    WT alpha, beta;
+};
+
+template<typename WT> struct FusedMul
+{
+    FusedMul(double _alpha) : alpha((WT)_alpha) {}
+    WT operator()(WT x, WT y, WT) const { return alpha*x*y; }
+#if CV_SIMD128
+    v_float32x4 operator()(const v_float32x4& x, const v_float32x4& y, const v_float32x4&) const
+    { return v_setall_f32((float)alpha)*x*y; }
+#endif
+    WT alpha;
+};
+
+template<typename WT> struct FusedMin
+{
+    WT operator()(WT x, WT y, WT) const { return std::min(x, y); }
+#if CV_SIMD128
+    v_float32x4 operator()(const v_float32x4& x, const v_float32x4& y, const v_float32x4&) const
+    { return v_min(x, y); }
+#endif
+};
+
+template<typename WT> struct FusedMax
+{
+    WT operator()(WT x, WT y, WT) const { return std::max(x, y); }
+#if CV_SIMD128
+    v_float32x4 operator()(const v_float32x4& x, const v_float32x4& y, const v_float32x4&) const
+    { return v_max(x, y); }
+#endif
+};
+
+template<typename WT> struct FusedAbsDiff
+{
+    WT operator()(WT x, WT y, WT) const { return std::abs(x - y); }
+#if CV_SIMD128
+    v_float32x4 operator()(const v_float32x4& x, const v_float32x4& y, const v_float32x4&) const
+    { return v_absdiff(x, y); }
+#endif
+};
+
+template<typename WT> struct FusedCmp
+{
+    FusedCmp(int _cmpop) : cmpop(_cmpop) {}
+    WT operator()(WT x, WT y, WT) const
+    {
+        bool r = cmpop == CMP_EQ ? x == y : cmpop == CMP_GT ? x > y : cmpop == CMP_GE ? x >= y :
+                 cmpop == CMP_LT ? x < y : cmpop == CMP_LE ? x <= y : x != y;
+        return r ? (WT)255 : (WT)0;
+    }
+#if CV_SIMD128
+    v_float32x4 operator()(const v_float32x4& x, const v_float32x4& y, const v_float32x4&) const
+    {
+        v_float32x4 m = cmpop == CMP_EQ ? x == y : cmpop == CMP_GT ? x > y : cmpop == CMP_GE ? x >= y :
+                        cmpop == CMP_LT ? x < y : cmpop == CMP_LE ? x <= y : x != y;
+        return m & v_setall_f32(255.f);
+    }
+#endif
+    int cmpop;
+};
+
+// rounds and clips the values to the range of an integer depth
+template<typename WT> struct FusedSaturate
+{
+    FusedSaturate(double _lo, double _hi) : lo((WT)_lo), hi((WT)_hi) {}
+    WT operator()(WT x, WT, WT) const { return (WT)cvRound(std::min(std::max(x, lo), hi)); }
+#if CV_SIMD128
+    v_float32x4 operator()(const v_float32x4& x, const v_float32x4&, const v_float32x4&) const
+    { return v_cvt_f32(v_round(v_min(v_max(x, v_setall_f32((float)lo)), v_setall_f32((float)hi)))); }
+#endif
+    WT lo, hi;
+};
+
+template<typename WT, class Op> static int
+fusedVecOp(const Op&, const WT*, const WT*, const WT*, WT*, int)
+{
+    return 0;
+}
+
+#if CV_SIMD128
+template<class Op> static int
+fusedVecOp(const Op& op, const float* x, const float* y, const float* c, float* d, int len)
+{
+    int i = 0;
+    if( hasSIMD128() )
+    {
+        for( ; i <= len - 4; i += 4 )
+            v_store(d + i, op(v_load(x + i), v_load(y + i), v_load(c + i)));
+    }
+    return i;
+}
+#endif
+
+template<typename WT, class Op> static void
+fusedOp(const Op& op, const WT* x, const WT* y, const WT* c, WT* d, int len)
+{
+    int i = fusedVecOp(op, x, y, c, d, len);
+    for( ; i < len; i++ )
+        d[i] = op(x[i], y[i], c[i]);
+}
+
+//////////////////////////////// loads and stores ///////////////////////////////
+
+template<typename T, typename WT> static void
+fusedLoad_(const uchar* src, WT* dst, int len)
+{
+    const T* s = (const T*)src;
+    for( int i = 0; i < len; i++ )
+        dst[i] = (WT)s[i];
+}
+
+#if CV_SIMD128
+template<> void fusedLoad_<uchar, float>(const uchar* src, float* dst, int len)
+{
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 8; i += 8 )
+        {
+            v_uint32x4 a, b;
+            v_expand(v_load_expand(src + i), a, b);
+            v_store(dst + i, v_cvt_f32(v_reinterpret_as_s32(a)));
+            v_store(dst + i + 4, v_cvt_f32(v_reinterpret_as_s32(b)));
+        }
+    for( ; i < len; i++ )
+        dst[i] = (float)src[i];
+}
+
+template<> void fusedLoad_<schar, float>(const uchar* _src, float* dst, int len)
+{
+    const schar* src = (const schar*)_src;
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 8; i += 8 )
+        {
+            v_int32x4 a, b;
+            v_expand(v_load_expand(src + i), a, b);
+            v_store(dst + i, v_cvt_f32(a));
+            v_store(dst + i + 4, v_cvt_f32(b));
+        }
+    for( ; i < len; i++ )
+        dst[i] = (float)src[i];
+}
+
+template<> void fusedLoad_<ushort, float>(const uchar* _src, float* dst, int len)
+{
+    const ushort* src = (const ushort*)_src;
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 4; i += 4 )
+            v_store(dst + i, v_cvt_f32(v_reinterpret_as_s32(v_load_expand(src + i))));
+    for( ; i < len; i++ )
+        dst[i] = (float)src[i];
+}
+
+template<> void fusedLoad_<short, float>(const uchar* _src, float* dst, int len)
+{
+    const short* src = (const short*)_src;
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 4; i += 4 )
+            v_store(dst + i, v_cvt_f32(v_load_expand(src + i)));
+    for( ; i < len; i++ )
+        dst[i] = (float)src[i];
+}
+#endif
+
+template<typename T, typename WT> static void
+fusedStore_(const WT* src, uchar* _dst, int len)
+{
+    T* dst = (T*)_dst;
+    for( int i = 0; i < len; i++ )
+        dst[i] = saturate_cast<T>(src[i]);
+}
+
+#if CV_SIMD128
+template<> void fusedStore_<uchar, float>(const float* src, uchar* dst, int len)
+{
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 8; i += 8 )
+        {
+            v_int16x8 w = v_pack(v_round(v_load(src + i)), v_round(v_load(src + i + 4)));
+            v_store_low(dst + i, v_pack_u(w, w));
+        }
+    for( ; i < len; i++ )
+        dst[i] = saturate_cast<uchar>(src[i]);
+}
+
+template<> void fusedStore_<schar, float>(const float* src, uchar* _dst, int len)
+{
+    schar* dst = (schar*)_dst;
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 8; i += 8 )
+        {
+            v_int16x8 w = v_pack(v_round(v_load(src + i)), v_round(v_load(src + i + 4)));
+            v_store_low(dst + i, v_pack(w, w));
+        }
+    for( ; i < len; i++ )
+        dst[i] = saturate_cast<schar>(src[i]);
+}
+
+template<> void fusedStore_<ushort, float>(const float* src, uchar* _dst, int len)
+{
+    ushort* dst = (ushort*)_dst;
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 8; i += 8 )
+            v_store(dst + i, v_pack_u(v_round(v_load(src + i)), v_round(v_load(src + i + 4))));
+    for( ; i < len; i++ )
+        dst[i] = saturate_cast<ushort>(src[i]);
+}
+
+template<> void fusedStore_<short, float>(const float* src, uchar* _dst, int len)
+{
+    short* dst = (short*)_dst;
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 8; i += 8 )
+            v_store(dst + i, v_pack(v_round(v_load(src + i)), v_round(v_load(src + i + 4))));
+    for( ; i < len; i++ )
+        dst[i] = saturate_cast<short>(src[i]);
+}
+
+template<> void fusedStore_<int, float>(const float* src, uchar* _dst, int len)
+{
+    int* dst = (int*)_dst;
+    int i = 0;
+    if( hasSIMD128() )
+        for( ; i <= len - 4; i += 4 )
+            v_store(dst + i, v_round(v_load(src + i)));
+    for( ; i < len; i++ )
+        dst[i] = saturate_cast<int>(src[i]);
+}
+
+template<> void fusedStore_<float, float>(const float* src, uchar* dst, int len)
+{
+    memcpy(dst, src, len*sizeof(float));
+}
+#endif
+
+template<typename WT> static void
+fusedLoad(const uchar* src, int depth, WT* dst, int len)
+{
+    switch( depth )
+    {
+    case CV_8U: fusedLoad_<uchar, WT>(src, dst, len); break;
+    case CV_8S: fusedLoad_<schar, WT>(src, dst, len); break;
+    case CV_16U: fusedLoad_<ushort, WT>(src, dst, len); break;
+    case CV_16S: fusedLoad_<short, WT>(src, dst, len); break;
+    case CV_32S: fusedLoad_<int, WT>(src, dst, len); break;
+    case CV_32F: fusedLoad_<float, WT>(src, dst, len); break;
+    default: fusedLoad_<double, WT>(src, dst, len);
+    }
+}
+
+template<typename WT> static void
+fusedStore(const WT* src, uchar* dst, int depth, int len)
+{
+    switch( depth )
+    {
+    case CV_8U: fusedStore_<uchar, WT>(src, dst, len); break;
+    case CV_8S: fusedStore_<schar, WT>(src, dst, len); break;
+    case CV_16U: fusedStore_<ushort, WT>(src, dst, len); break;
+    case CV_16S: fusedStore_<short, WT>(src, dst, len); break;
+    case CV_32S: fusedStore_<int, WT>(src, dst, len); break;
+    case CV_32F: fusedStore_<float, WT>(src, dst, len); break;
+    default: fusedStore_<double, WT>(src, dst, len);
+    }
+}
+
+static const double fusedDepthMin[] = { 0, SCHAR_MIN, 0, SHRT_MIN, INT_MIN };
+static const double fusedDepthMax[] = { UCHAR_MAX, SCHAR_MAX, USHRT_MAX, SHRT_MAX, INT_MAX };
+
+/*
+   Evaluates the program over a range of blocks. The rows (or the whole matrices when all of them
+   are continuous) are split into blocks of FUSED_BLOCK_SIZE scalars; every node computes its block
+   into a small buffer that stays in the cache, and the root block is converted to the destination.
+*/
+template<typename WT> class FusedInvoker : public ParallelLoopBody
+{
+public:
+    FusedInvoker(const FusedProgram& _prog, Mat& _dst) : prog(&_prog), dst(&_dst)
+    {
+        int cn = dst->channels(), nnodes = (int)prog->nodes.size();
+        continuous = dst->isContinuous();
+        for( size_t i = 0; i < prog->leaves.size(); i++ )
+            continuous = continuous && prog->leaves[i].isContinuous();
+        rows = continuous ? 1 : dst->rows;
+        width = continuous ? (int)dst->total() : dst->cols;
+        blockWidth = std::max(FUSED_BLOCK_SIZE/cn, 1);
+        blocksPerRow = (width + blockWidth - 1)/blockWidth;
+        blockLen = blockWidth*cn;
+
+        // the scalar arguments expanded to blocks, and a block of zeros
+        consts.resize((nnodes + 1)*blockLen, (WT)0);
+        for( int k = 0; k < nnodes; k++ )
+        {
+            const FusedNode& n = prog->nodes[k];
+            WT* c = &consts[k*blockLen];
+            for( int i = 0; i < blockLen; i++ )
+                c[i] = (WT)(n.op >= MatOp_Fused::FUSED_CMP ? n.alpha :
+                            n.op == 'm' || n.op == 'M' ? n.s[0] : n.s[i % cn]);
+        }
+    }
+
+    int blocks() const { return rows*blocksPerRow; }
+
+    void operator()(const Range& range) const
+    {
+        int nnodes = (int)prog->nodes.size();
+        AutoBuffer<WT> _buf(nnodes*blockLen);
+        WT* buf = _buf;
+        const WT* zeros = &consts[nnodes*blockLen];
+        int cn = dst->channels();
+
+        for( int b = range.start; b < range.end; b++ )
+        {
+            int y = b / blocksPerRow, x = (b % blocksPerRow)*blockWidth;
+            int len = std::min(blockWidth, width - x)*cn;
+
+            for( int k = 0; k < nnodes; k++ )
+            {
+                const FusedNode& n = prog->nodes[k];
+                WT* d = buf + k*blockLen;
+                const WT* a = n.op != 0 ? buf + n.arg0*blockLen : 0;
+                const WT* c = &consts[k*blockLen];
+                const WT* bb = n.arg1 >= 0 ? buf + n.arg1*blockLen : n.op == '+' ? zeros : c;
+
+                if( n.op == 0 )
+                {
+                    const Mat& m = prog->leaves[n.arg0];
+                    const uchar* src = (continuous ? m.data : m.ptr(y)) + x*m.elemSize();
+                    fusedLoad(src, n.depth, d, len);
+                    continue;
+                }
+                if( n.op == '+' )
+                    fusedOp(FusedAdd<WT>(n.alpha, n.beta), a, bb, c, d, len);
+                else if( n.op == '*' )
+                    fusedOp(FusedMul<WT>(n.alpha), a, bb, c, d, len);
+                else if( n.op == 'm' )
+                    fusedOp(FusedMin<WT>(), a, bb, c, d, len);
+                else if( n.op == 'M' )
+                    fusedOp(FusedMax<WT>(), a, bb, c, d, len);
+                else if( n.op == 'a' )
+                    fusedOp(FusedAbsDiff<WT>(), a, bb, c, d, len);
+                else
+                {
+                    fusedOp(FusedCmp<WT>(n.op - MatOp_Fused::FUSED_CMP), a, bb, c, d, len);
+                    continue;
+                }
+
+                // store the value with the precision the temporary matrix would have
+                if( n.depth <= CV_32S )
+                    fusedOp(FusedSaturate<WT>(fusedDepthMin[n.depth], fusedDepthMax[n.depth]), d, d, d, d, len);
+                else if( n.depth == CV_32F && sizeof(WT) > sizeof(float) )
+                    for( int i = 0; i < len; i++ )
+                        d[i] = (WT)(float)d[i];
+            }
+
+            uchar* dptr = (continuous ? dst->data : dst->ptr(y)) + x*dst->elemSize();
+            fusedStore(buf + prog->root*blockLen, dptr, dst->depth(), len);
+        }
+    }
+
+protected:
+    const FusedProgram* prog;
+    Mat* dst;
+    int rows, width, blockWidth, blocksPerRow, blockLen;
+    bool continuous;
+    vector<WT> consts;
+};
+
+template<typename WT> static void
+runFusedProgram(const FusedProgram& prog, Mat& dst)
+{
+    FusedInvoker<WT> invoker(prog, dst);
+    parallel_for_(Range(0, invoker.blocks()), invoker, dst.total()*dst.channels()/(double)(1 << 16));
+}
+
+}
+
+void MatOp_Fused::assign(const MatExpr& e, Mat& m, int _type) const
+{
+    FusedProgram prog(e);
+    int stype = type(e);
+    if( _type == -1 )
+        _type = stype;
+    CV_Assert( CV_MAT_CN(_type) == CV_MAT_CN(stype) );
+
+    // 32-bit integers and doubles need double precision, the rest is computed with floats
+    bool useDouble = CV_MAT_DEPTH(_type) == CV_32S || CV_MAT_DEPTH(_type) == CV_64F;
+    for( size_t i = 0; i < prog.nodes.size(); i++ )
+        useDouble = useDouble || prog.nodes[i].depth == CV_32S || prog.nodes[i].depth == CV_64F;
+
+    m.create(size(e), _type);
+    if( useDouble )
+        runFusedProgram<double>(prog, m);
+    else
+        runFusedProgram<float>(prog, m);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 MatExpr Mat::t() const
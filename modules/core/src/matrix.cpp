@@ -205,6 +205,8 @@ void Mat::create(int d, const int* _sizes, int _type)
 
     if( total() > 0 )
     {
+        if( !allocator )
+            allocator = getDefaultAllocator();
 #ifdef HAVE_TGPU
         if( !allocator || allocator == tegra::getAllocator() ) allocator = tegra::getAllocator(d, _sizes, _type);
 #endif
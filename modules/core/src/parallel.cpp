@@ -48,6 +48,8 @@
     #undef min
     #undef max
     #undef abs
+#else
+    #include <pthread.h>
 #endif
 
 #if defined __linux__ || defined __APPLE__
@@ -79,6 +81,7 @@
    3. HAVE_OPENMP      - integrated to compiler, should be explicitly enabled
    4. HAVE_GCD         - system wide, used automatically        (APPLE only)
    5. HAVE_CONCURRENCY - part of runtime, used automatically    (Windows only - MSVS 10, MSVS 11)
+   6. HAVE_PTHREADS_PF - built-in pthreads thread pool, used automatically (UNIX only, see parallel_pthreads.cpp)
 */
 
 #if defined HAVE_TBB
@@ -107,22 +110,27 @@
         #include <pthread.h>
     #elif defined HAVE_CONCURRENCY
         #include <ppl.h>
+    #elif defined HAVE_PTHREADS_PF
+        // see parallel_pthreads.cpp
     #endif
 #endif
 
-#if defined HAVE_TBB || defined HAVE_CSTRIPES || defined HAVE_OPENMP || defined HAVE_GCD || defined HAVE_CONCURRENCY
+#if defined HAVE_TBB || defined HAVE_CSTRIPES || defined HAVE_OPENMP || defined HAVE_GCD || defined HAVE_CONCURRENCY || \
+    defined HAVE_PTHREADS_PF
    #define HAVE_PARALLEL_FRAMEWORK
 #endif
 
+
 namespace cv
 {
     ParallelLoopBody::~ParallelLoopBody() {}
+    ParallelForBackend::~ParallelForBackend() {}
 }
 
 namespace
 {
-#ifdef HAVE_PARALLEL_FRAMEWORK
-    class ParallelLoopBodyWrapper
+    // maps the stripes [0, nstripes) to the subranges of the whole range
+    class ParallelLoopBodyWrapper : public cv::ParallelLoopBody
     {
     public:
         ParallelLoopBodyWrapper(const cv::ParallelLoopBody& _body, const cv::Range& _r, double _nstripes)
@@ -134,6 +142,7 @@ namespace
         }
         void operator()(const cv::Range& sr) const
         {
+            CV_TRACE_REGION("parallel_for_ stripes");
             cv::Range r;
             r.start = (int)(wholeRange.start +
                             ((size_t)sr.start*(wholeRange.end - wholeRange.start) + nstripes/2)/nstripes);
@@ -149,43 +158,63 @@ namespace
         int nstripes;
     };
 
-#if defined HAVE_TBB
-    class ProxyLoopBody : public ParallelLoopBodyWrapper
+    // joins the stripes into ngroups groups, so that at most ngroups threads
+    // can process them concurrently
+    class StripeGroupsBody : public cv::ParallelLoopBody
     {
     public:
-        ProxyLoopBody(const cv::ParallelLoopBody& _body, const cv::Range& _r, double _nstripes)
-        : ParallelLoopBodyWrapper(_body, _r, _nstripes)
+        StripeGroupsBody(const cv::ParallelLoopBody& _body, const cv::Range& _stripes, int _ngroups)
+            : body(&_body), stripes(_stripes), ngroups(_ngroups)
         {}
+        void operator()(const cv::Range& gr) const
+        {
+            int64 len = stripes.end - stripes.start;
+            (*body)(cv::Range(stripes.start + (int)(len*gr.start/ngroups),
+                              stripes.start + (int)(len*gr.end/ngroups)));
+        }
+        cv::Range groupRange() const { return cv::Range(0, ngroups); }
+
+    protected:
+        const cv::ParallelLoopBody* body;
+        cv::Range stripes;
+        int ngroups;
+    };
+
+#ifdef HAVE_PARALLEL_FRAMEWORK
+#if defined HAVE_TBB
+    class ProxyLoopBody
+    {
+    public:
+        ProxyLoopBody(const cv::ParallelLoopBody& _body) : body(&_body) {}
 
         void operator ()(const tbb::blocked_range<int>& range) const
         {
-            this->ParallelLoopBodyWrapper::operator()(cv::Range(range.begin(), range.end()));
+            (*body)(cv::Range(range.begin(), range.end()));
         }
+
+    protected:
+        const cv::ParallelLoopBody* body;
     };
-#elif defined HAVE_CSTRIPES || defined HAVE_OPENMP
-    typedef ParallelLoopBodyWrapper ProxyLoopBody;
 #elif defined HAVE_GCD
-    typedef ParallelLoopBodyWrapper ProxyLoopBody;
     static void block_function(void* context, size_t index)
     {
-        ProxyLoopBody* ptr_body = static_cast<ProxyLoopBody*>(context);
-        (*ptr_body)(cv::Range(index, index + 1));
+        const cv::ParallelLoopBody* body = static_cast<const cv::ParallelLoopBody*>(context);
+        (*body)(cv::Range((int)index, (int)index + 1));
     }
 #elif defined HAVE_CONCURRENCY
-    class ProxyLoopBody : public ParallelLoopBodyWrapper
+    class ProxyLoopBody
     {
     public:
-        ProxyLoopBody(const cv::ParallelLoopBody& _body, const cv::Range& _r, double _nstripes)
-        : ParallelLoopBodyWrapper(_body, _r, _nstripes)
-        {}
+        ProxyLoopBody(const cv::ParallelLoopBody& _body) : body(&_body) {}
 
         void operator ()(int i) const
         {
-            this->ParallelLoopBodyWrapper::operator()(cv::Range(i, i + 1));
+            (*body)(cv::Range(i, i + 1));
         }
+
+    protected:
+        const cv::ParallelLoopBody* body;
     };
-#else
-    typedef ParallelLoopBodyWrapper ProxyLoopBody;
 #endif
 
 static int numThreads = -1;
@@ -216,26 +245,73 @@ public:
     ~SchedPtr() { *this = 0; }
 };
 static SchedPtr pplScheduler;
+#elif defined HAVE_PTHREADS_PF
+// the thread pool is created on the first call of parallel_for_
 #endif
 
 #endif // HAVE_PARALLEL_FRAMEWORK
 
-} //namespace
+/* ================================   backends  ================================ */
 
-/* ================================   parallel_for_  ================================ */
+// the framework OpenCV has been built with
+class BuiltinParallelForBackend : public cv::ParallelForBackend
+{
+public:
+    void parallel_for(const cv::Range& stripes, const cv::ParallelLoopBody& body, int maxThreads);
+    int getNumThreads() const;
+    void setNumThreads(int threads);
+    int getThreadNum() const;
+};
 
-void cv::parallel_for_(const cv::Range& range, const cv::ParallelLoopBody& body, double nstripes)
+class SerialParallelForBackend : public cv::ParallelForBackend
+{
+public:
+    void parallel_for(const cv::Range& stripes, const cv::ParallelLoopBody& body, int)
+    {
+        body(stripes);
+    }
+    int getNumThreads() const { return 1; }
+    void setNumThreads(int) {}
+    int getThreadNum() const { return 0; }
+};
+
+#if defined HAVE_TBB
+static const char* builtinBackendName = "tbb";
+#elif defined HAVE_CSTRIPES
+static const char* builtinBackendName = "cstripes";
+#elif defined HAVE_OPENMP
+static const char* builtinBackendName = "openmp";
+#elif defined HAVE_GCD
+static const char* builtinBackendName = "gcd";
+#elif defined HAVE_CONCURRENCY
+static const char* builtinBackendName = "concurrency";
+#elif defined HAVE_PTHREADS_PF
+static const char* builtinBackendName = "pthreads";
+#endif
+
+void BuiltinParallelForBackend::parallel_for(const cv::Range& _stripes, const cv::ParallelLoopBody& _body, int maxThreads)
 {
 #ifdef HAVE_PARALLEL_FRAMEWORK
 
     if(numThreads != 0)
     {
-        ProxyLoopBody pbody(body, range, nstripes);
-        cv::Range stripeRange = pbody.stripeRange();
+#if defined HAVE_PTHREADS_PF
+
+        // the pool applies the thread budget itself
+        cv::parallel_for_pthreads(_stripes, _body, maxThreads);
+
+#else
+
+        // other frameworks can not limit the number of threads of a single loop,
+        // so the stripes are joined into maxThreads groups instead
+        StripeGroupsBody groups(_body, _stripes, maxThreads);
+        bool grouped = maxThreads > 0 && maxThreads < _stripes.end - _stripes.start;
+        const cv::ParallelLoopBody& body = grouped ? (const cv::ParallelLoopBody&)groups : _body;
+        cv::Range stripeRange = grouped ? groups.groupRange() : _stripes;
 
 #if defined HAVE_TBB
 
-        tbb::parallel_for(tbb::blocked_range<int>(stripeRange.start, stripeRange.end), pbody);
+        tbb::parallel_for(tbb::blocked_range<int>(stripeRange.start, stripeRange.end), ProxyLoopBody(body));
 
 #elif defined HAVE_CSTRIPES
 
@@ -244,7 +320,7 @@ void cv::parallel_for_(const cv::Range& range, const cv::ParallelLoopBody& body,
             int offset = stripeRange.start;
             int len = stripeRange.end - offset;
             Range r(offset + CPX_RANGE_START(len), offset + CPX_RANGE_END(len));
-            pbody(r);
+            body(r);
             barrier();
         }
 
@@ -252,15 +328,17 @@ void cv::parallel_for_(const cv::Range& range, const cv::ParallelLoopBody& body,
 
         #pragma omp parallel for schedule(dynamic)
         for (int i = stripeRange.start; i < stripeRange.end; ++i)
-            pbody(Range(i, i + 1));
+            body(cv::Range(i, i + 1));
 
 #elif defined HAVE_GCD
 
         dispatch_queue_t concurrent_queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
-        dispatch_apply_f(stripeRange.end - stripeRange.start, concurrent_queue, &pbody, block_function);
+        dispatch_apply_f(stripeRange.end - stripeRange.start, concurrent_queue,
+                         (void*)&body, block_function);
 
 #elif defined HAVE_CONCURRENCY
 
+        ProxyLoopBody pbody(body);
         if(!pplScheduler || pplScheduler->Id() == Concurrency::CurrentScheduler::Id())
         {
             Concurrency::parallel_for(stripeRange.start, stripeRange.end, pbody);
@@ -277,18 +355,19 @@ void cv::parallel_for_(const cv::Range& range, const cv::ParallelLoopBody& body,
 #error You have hacked and compiling with unsupported parallel framework
 
 #endif
+#endif // HAVE_PTHREADS_PF
 
     }
     else
 
 #endif // HAVE_PARALLEL_FRAMEWORK
     {
-        (void)nstripes;
-        body(range);
+        (void)maxThreads;
+        _body(_stripes);
     }
 }
 
-int cv::getNumThreads(void)
+int BuiltinParallelForBackend::getNumThreads() const
 {
 #ifdef HAVE_PARALLEL_FRAMEWORK
 
@@ -321,6 +400,10 @@ int cv::getNumThreads(void)
                 ? Concurrency::CurrentScheduler::Get()->GetNumberOfVirtualProcessors()
                 : pplScheduler->GetNumberOfVirtualProcessors());
 
+#elif defined HAVE_PTHREADS_PF
+
+    return cv::parallel_pthreads_get_threads_num();
+
 #else
 
     return 1;
@@ -328,7 +411,7 @@ int cv::getNumThreads(void)
 #endif
 }
 
-void cv::setNumThreads( int threads )
+void BuiltinParallelForBackend::setNumThreads( int threads )
 {
     (void)threads;
 #ifdef HAVE_PARALLEL_FRAMEWORK
@@ -374,11 +457,14 @@ void cv::setNumThreads( int threads )
                        Concurrency::MaxConcurrency, threads-1));
     }
 
+#elif defined HAVE_PTHREADS_PF
+
+    cv::parallel_pthreads_set_threads_num(threads);
+
 #endif
 }
 
-
-int cv::getThreadNum(void)
+int BuiltinParallelForBackend::getThreadNum() const
 {
 #if defined HAVE_TBB
     #if TBB_INTERFACE_VERSION >= 6100 && defined TBB_PREVIEW_TASK_ARENA && TBB_PREVIEW_TASK_ARENA
@@ -394,11 +480,187 @@ int cv::getThreadNum(void)
     return (int)(size_t)(void*)pthread_self(); // no zero-based indexing
 #elif defined HAVE_CONCURRENCY
     return std::max(0, (int)Concurrency::Context::VirtualProcessorId()); // zero for master thread, unique number for others but not necessary 1,2,3,...
+#elif defined HAVE_PTHREADS_PF
+    return cv::parallel_pthreads_get_thread_num(); // zero for the calling thread, 1..getNumThreads()-1 for the pool workers
 #else
     return 0;
 #endif
 }
 
+class ParallelForBackendRegistry
+{
+public:
+    ParallelForBackendRegistry()
+    {
+        backends["serial"] = new SerialParallelForBackend;
+        currentName = "serial";
+#ifdef HAVE_PARALLEL_FRAMEWORK
+        backends[builtinBackendName] = new BuiltinParallelForBackend;
+        currentName = builtinBackendName;
+#endif
+        current = backends[currentName];
+    }
+
+    cv::Ptr<cv::ParallelForBackend> getCurrent()
+    {
+        cv::AutoLock lock(mutex);
+        return current;
+    }
+
+    cv::Mutex mutex;
+    std::map<std::string, cv::Ptr<cv::ParallelForBackend> > backends;
+    std::string currentName;
+    cv::Ptr<cv::ParallelForBackend> current;
+};
+
+static ParallelForBackendRegistry& getBackendRegistry()
+{
+    static ParallelForBackendRegistry registry;
+    return registry;
+}
+
+/* ================================   thread budget  ================================ */
+
+#if defined WIN32 || defined _WIN32
+#ifdef WINCE
+#   define TLS_OUT_OF_INDEXES ((DWORD)0xFFFFFFFF)
+#endif
+static DWORD tlsBudgetKey = TLS_OUT_OF_INDEXES;
+
+static int getThreadBudget()
+{
+    if( tlsBudgetKey == TLS_OUT_OF_INDEXES )
+        return 0;
+    return (int)(size_t)TlsGetValue( tlsBudgetKey );
+}
+
+static void setThreadBudget(int budget)
+{
+    if( tlsBudgetKey == TLS_OUT_OF_INDEXES )
+    {
+        tlsBudgetKey = TlsAlloc();
+        CV_Assert(tlsBudgetKey != TLS_OUT_OF_INDEXES);
+    }
+    TlsSetValue( tlsBudgetKey, (void*)(size_t)budget );
+}
+#else
+static pthread_key_t tlsBudgetKey = 0;
+static pthread_once_t tlsBudgetKeyOnce = PTHREAD_ONCE_INIT;
+
+static void makeBudgetKey()
+{
+    int errcode = pthread_key_create(&tlsBudgetKey, 0);
+    CV_Assert(errcode == 0);
+}
+
+static int getThreadBudget()
+{
+    pthread_once(&tlsBudgetKeyOnce, makeBudgetKey);
+    return (int)(size_t)pthread_getspecific(tlsBudgetKey);
+}
+
+static void setThreadBudget(int budget)
+{
+    pthread_once(&tlsBudgetKeyOnce, makeBudgetKey);
+    pthread_setspecific(tlsBudgetKey, (void*)(size_t)budget);
+}
+#endif
+
+} //namespace
+
+/* ================================   parallel_for_  ================================ */
+
+void cv::parallel_for_(const cv::Range& range, const cv::ParallelLoopBody& body, double nstripes)
+{
+    CV_TRACE_REGION("parallel_for_");
+    int budget = getThreadBudget();
+    if( budget == 1 || range.end - range.start <= 1 )
+    {
+        body(range);
+        return;
+    }
+
+    ParallelLoopBodyWrapper pbody(body, range, nstripes);
+    getBackendRegistry().getCurrent()->parallel_for(pbody.stripeRange(), pbody, budget);
+}
+
+int cv::getNumThreads(void)
+{
+    int nthreads = getBackendRegistry().getCurrent()->getNumThreads();
+    int budget = getThreadBudget();
+    return budget > 0 ? std::min(budget, nthreads) : nthreads;
+}
+
+void cv::setNumThreads( int threads )
+{
+    getBackendRegistry().getCurrent()->setNumThreads(threads);
+}
+
+int cv::getThreadNum(void)
+{
+    return getBackendRegistry().getCurrent()->getThreadNum();
+}
+
+void cv::registerParallelForBackend(const std::string& name, const Ptr<ParallelForBackend>& backend)
+{
+    CV_Assert( !name.empty() && !backend.empty() );
+    ParallelForBackendRegistry& registry = getBackendRegistry();
+    AutoLock lock(registry.mutex);
+    registry.backends[name] = backend;
+    if( registry.currentName == name )
+        registry.current = backend;
+}
+
+bool cv::setParallelForBackend(const std::string& name, bool propagateNumThreads)
+{
+    ParallelForBackendRegistry& registry = getBackendRegistry();
+    Ptr<ParallelForBackend> prev, backend;
+    {
+        AutoLock lock(registry.mutex);
+        std::map<std::string, Ptr<ParallelForBackend> >::const_iterator it = registry.backends.find(name);
+        if( it == registry.backends.end() )
+            return false;
+        prev = registry.current;
+        backend = it->second;
+        registry.current = backend;
+        registry.currentName = name;
+    }
+    if( propagateNumThreads && prev != backend )
+        backend->setNumThreads(prev->getNumThreads());
+    return true;
+}
+
+std::string cv::getParallelForBackend()
+{
+    ParallelForBackendRegistry& registry = getBackendRegistry();
+    AutoLock lock(registry.mutex);
+    return registry.currentName;
+}
+
+void cv::getParallelForBackends(std::vector<std::string>& names)
+{
+    ParallelForBackendRegistry& registry = getBackendRegistry();
+    AutoLock lock(registry.mutex);
+    names.clear();
+    std::map<std::string, Ptr<ParallelForBackend> >::const_iterator it = registry.backends.begin();
+    for( ; it != registry.backends.end(); ++it )
+        names.push_back(it->first);
+}
+
+cv::ParallelScope::ParallelScope(int maxThreads)
+{
+    prevMaxThreads = getThreadBudget();
+    int budget = std::max(maxThreads, 1);
+    if( prevMaxThreads > 0 )
+        budget = std::min(budget, prevMaxThreads);
+    setThreadBudget(budget);
+}
+
+cv::ParallelScope::~ParallelScope()
+{
+    setThreadBudget(prevMaxThreads);
+}
+
 #ifdef ANDROID
 static inline int getNumberOfCPUsImpl()
 {
@@ -0,0 +1,434 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009-2011, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+
+#ifdef HAVE_PTHREADS_PF
+
+#include <pthread.h>
+
+/*
+   Work-stealing thread pool used by cv::parallel_for_ when no other parallel
+   framework is available.
+
+   The calling thread and the pool workers are the participants of a job.
+   The stripe range of the job is split into equal contiguous pieces, one per
+   participant, each kept in its own queue. A participant takes chunks from
+   the front of its own queue (large chunks first, single stripes at the end);
+   when its queue runs dry it steals the back half of another participant's
+   queue. Only one job runs at a time: parallel_for_ called from inside a
+   running job (nested call) or from another thread while the pool is busy
+   is executed serially by the calling thread. A job can be limited to fewer
+   participants than the pool has (see cv::ParallelScope), the rest of the
+   workers then stay asleep.
+*/
+
+namespace cv
+{
+
+namespace
+{
+
+class WorkQueue
+{
+public:
+    WorkQueue() : begin(0), end(0) { pthread_mutex_init(&mutex, 0); }
+    ~WorkQueue() { pthread_mutex_destroy(&mutex); }
+
+    void reset(const Range& r)
+    {
+        pthread_mutex_lock(&mutex);
+        begin = r.start;
+        end = r.end;
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // called by the owner of the queue
+    bool pop(Range& r)
+    {
+        pthread_mutex_lock(&mutex);
+        int len = end - begin;
+        if( len > 0 )
+        {
+            int chunk = std::max(len/4, 1);
+            r = Range(begin, begin + chunk);
+            begin += chunk;
+        }
+        pthread_mutex_unlock(&mutex);
+        return len > 0;
+    }
+
+    // called by the other participants
+    bool steal(Range& r)
+    {
+        pthread_mutex_lock(&mutex);
+        int len = end - begin;
+        if( len > 0 )
+        {
+            int chunk = (len + 1)/2;
+            r = Range(end - chunk, end);
+            end -= chunk;
+        }
+        pthread_mutex_unlock(&mutex);
+        return len > 0;
+    }
+
+protected:
+    pthread_mutex_t mutex;
+    int begin, end;
+    // keep the queues of different participants in different cache lines
+    char pad[64];
+
+private:
+    WorkQueue(const WorkQueue&);
+    WorkQueue& operator = (const WorkQueue&);
+};
+
+
+class ThreadPool
+{
+public:
+    ThreadPool();
+    ~ThreadPool();
+
+    void run(const Range& stripes, const ParallelLoopBody& body, int maxThreads);
+
+    void setNumThreads(int n);
+    int getNumThreads() const { return numThreads; }
+    int getThreadNum() const;
+
+protected:
+    struct WorkerArg
+    {
+        ThreadPool* pool;
+        int idx;
+    };
+
+    static void* workerMain(void* arg);
+    void workerLoop(int idx);
+    void process(int idx);
+    bool stealWork(int idx);
+    void startWorkers(int n);
+    void stopWorkers();
+
+    int numThreads;               // requested number of participants, including the caller
+    int numParticipants;          // number of participants of the running pool
+    std::vector<pthread_t> threads;
+    std::vector<WorkerArg> args;
+    WorkQueue* queues;
+
+    pthread_mutex_t jobMutex;     // serializes jobs, held by the caller for the whole job
+    pthread_mutex_t mutex;        // protects the fields below
+    pthread_cond_t jobCond;
+    pthread_cond_t doneCond;
+    const ParallelLoopBody* body;
+    int jobParticipants;          // number of participants of the current job
+    unsigned generation;
+    int active;                   // workers participating in the current job
+    bool stopping;
+
+    int remaining;                // stripes of the current job not processed yet
+    bool failed;
+    bool failedWithCvException;
+    Exception error;
+
+    pthread_key_t tlsKey;         // 1-based index of the worker thread
+};
+
+
+ThreadPool::ThreadPool()
+{
+    numThreads = std::max(getNumberOfCPUs(), 1);
+    numParticipants = 1;
+    queues = 0;
+    body = 0;
+    jobParticipants = 0;
+    generation = 0;
+    active = 0;
+    stopping = false;
+    remaining = 0;
+    failed = failedWithCvException = false;
+
+    pthread_mutex_init(&jobMutex, 0);
+    pthread_mutex_init(&mutex, 0);
+    pthread_cond_init(&jobCond, 0);
+    pthread_cond_init(&doneCond, 0);
+    pthread_key_create(&tlsKey, 0);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopWorkers();
+    pthread_key_delete(tlsKey);
+    pthread_cond_destroy(&doneCond);
+    pthread_cond_destroy(&jobCond);
+    pthread_mutex_destroy(&mutex);
+    pthread_mutex_destroy(&jobMutex);
+}
+
+void ThreadPool::startWorkers(int n)
+{
+    numParticipants = n;
+    queues = new WorkQueue[n];
+    stopping = false;
+    threads.resize(n - 1);
+    args.resize(n - 1);
+
+    for( int i = 1; i < n; i++ )
+    {
+        args[i-1].pool = this;
+        args[i-1].idx = i;
+        if( pthread_create(&threads[i-1], 0, workerMain, &args[i-1]) != 0 )
+        {
+            // run with the workers started so far
+            threads.resize(i - 1);
+            numParticipants = i;
+            break;
+        }
+    }
+}
+
+void ThreadPool::stopWorkers()
+{
+    pthread_mutex_lock(&mutex);
+    stopping = true;
+    pthread_cond_broadcast(&jobCond);
+    pthread_mutex_unlock(&mutex);
+
+    for( size_t i = 0; i < threads.size(); i++ )
+        pthread_join(threads[i], 0);
+
+    threads.clear();
+    args.clear();
+    delete[] queues;
+    queues = 0;
+    numParticipants = 1;
+}
+
+void ThreadPool::setNumThreads(int n)
+{
+    // the pool is resized lazily by the next job, so that the function
+    // can safely be called from inside a parallel region
+    numThreads = n > 0 ? n : std::max(getNumberOfCPUs(), 1);
+}
+
+int ThreadPool::getThreadNum() const
+{
+    return (int)(size_t)pthread_getspecific(tlsKey);
+}
+
+void* ThreadPool::workerMain(void* arg)
+{
+    WorkerArg* warg = (WorkerArg*)arg;
+    pthread_setspecific(warg->pool->tlsKey, (void*)(size_t)warg->idx);
+    warg->pool->workerLoop(warg->idx);
+    return 0;
+}
+
+void ThreadPool::workerLoop(int idx)
+{
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&mutex);
+    for(;;)
+    {
+        while( !stopping && (!body || generation == seen) )
+            pthread_cond_wait(&jobCond, &mutex);
+        if( stopping )
+            break;
+
+        seen = generation;
+        if( idx >= jobParticipants )
+            continue;
+        active++;
+        pthread_mutex_unlock(&mutex);
+
+        process(idx);
+
+        pthread_mutex_lock(&mutex);
+        if( --active == 0 )
+            pthread_cond_signal(&doneCond);
+    }
+    pthread_mutex_unlock(&mutex);
+}
+
+bool ThreadPool::stealWork(int idx)
+{
+    Range r;
+    for( int k = 1; k < jobParticipants; k++ )
+    {
+        int victim = (idx + k) % jobParticipants;
+        if( queues[victim].steal(r) )
+        {
+            queues[idx].reset(r);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::process(int idx)
+{
+    Range r;
+    for(;;)
+    {
+        if( !queues[idx].pop(r) )
+        {
+            if( !stealWork(idx) )
+                break;
+            continue;
+        }
+
+        if( !failed )
+        {
+            try
+            {
+                (*body)(r);
+            }
+            catch(const Exception& e)
+            {
+                pthread_mutex_lock(&mutex);
+                if( !failed )
+                {
+                    failed = failedWithCvException = true;
+                    error = e;
+                }
+                pthread_mutex_unlock(&mutex);
+            }
+            catch(...)
+            {
+                pthread_mutex_lock(&mutex);
+                failed = true;
+                pthread_mutex_unlock(&mutex);
+            }
+        }
+
+        int len = r.end - r.start;
+        if( CV_XADD(&remaining, -len) == len )
+        {
+            pthread_mutex_lock(&mutex);
+            pthread_cond_signal(&doneCond);
+            pthread_mutex_unlock(&mutex);
+        }
+    }
+}
+
+void ThreadPool::run(const Range& stripes, const ParallelLoopBody& _body, int maxThreads)
+{
+    if( numThreads <= 1 || maxThreads == 1 || stripes.end - stripes.start <= 1 ||
+        getThreadNum() != 0 || pthread_mutex_trylock(&jobMutex) != 0 )
+    {
+        _body(stripes);
+        return;
+    }
+
+    if( numParticipants != numThreads )
+    {
+        stopWorkers();
+        startWorkers(numThreads);
+    }
+
+    int n = maxThreads > 0 ? std::min(maxThreads, numParticipants) : numParticipants;
+    int len = stripes.end - stripes.start;
+    for( int i = 0; i < n; i++ )
+        queues[i].reset(Range(stripes.start + (int)((int64)len*i/n),
+                              stripes.start + (int)((int64)len*(i+1)/n)));
+    remaining = len;
+    failed = failedWithCvException = false;
+
+    pthread_mutex_lock(&mutex);
+    body = &_body;
+    jobParticipants = n;
+    generation++;
+    pthread_cond_broadcast(&jobCond);
+    pthread_mutex_unlock(&mutex);
+
+    process(0);
+
+    pthread_mutex_lock(&mutex);
+    while( CV_XADD(&remaining, 0) > 0 || active > 0 )
+        pthread_cond_wait(&doneCond, &mutex);
+    body = 0;
+    pthread_mutex_unlock(&mutex);
+
+    bool _failed = failed, _failedWithCvException = failedWithCvException;
+    Exception _error = error;
+    pthread_mutex_unlock(&jobMutex);
+
+    if( _failedWithCvException )
+        throw _error;
+    if( _failed )
+        CV_Error(CV_StsError, "Unknown exception in the parallel_for_ body");
+}
+
+ThreadPool& getThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace
+
+
+void parallel_for_pthreads(const Range& stripes, const ParallelLoopBody& body, int maxThreads)
+{
+    getThreadPool().run(stripes, body, maxThreads);
+}
+
+void parallel_pthreads_set_threads_num(int nthreads)
+{
+    getThreadPool().setNumThreads(nthreads);
+}
+
+int parallel_pthreads_get_threads_num()
+{
+    return getThreadPool().getNumThreads();
+}
+
+int parallel_pthreads_get_thread_num()
+{
+    return getThreadPool().getThreadNum();
+}
+
+} // namespace cv
+
+#endif // HAVE_PTHREADS_PF
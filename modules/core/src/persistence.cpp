@@ -45,6 +45,7 @@
 #include <ctype.h>
 #include <deque>
 #include <iterator>
+#include <map>
 
 #define USE_ZLIB 1
 
@@ -173,6 +174,17 @@ typedef struct CvFileMapNode
 }
 CvFileMapNode;
 
+/* the sequence of numbers stored as a contiguous block in the binary storage;
+   it is converted to the regular sequence of file nodes on the first access to the elements */
+typedef struct CvFileRawSeq
+{
+    CV_SEQUENCE_FIELDS()
+    const uchar* raw_data; // the block in the storage buffer, 0 after the conversion
+    const char* raw_dt;    // the format of the block records
+    int raw_len;           // the number of records
+}
+CvFileRawSeq;
+
 typedef struct CvXMLStackRecord
 {
     CvMemStoragePos pos;
@@ -239,6 +251,10 @@ typedef struct CvFileStorage
     size_t strbufsize, strbufpos;
     std::deque<char>* outbuf;
 
+    size_t binpos;                       // the number of bytes written to the binary storage
+    std::map<std::string, int>* binkeys; // the indices of the keys written to the binary storage
+    cv::Mat* binbuf;                     // the content of the binary storage being read
+
     bool is_opened;
 }
 CvFileStorage;
@@ -330,6 +346,7 @@ static void icvRewind( CvFileStorage* fs )
 #define CV_XML_INDENT  2
 #define CV_YML_INDENT_FLOW  1
 #define CV_FS_MAX_LEN 4096
+#define CV_FS_MAX_FMT_PAIRS  128
 
 #define CV_FILE_STORAGE ('Y' + ('A' << 8) + ('M' << 16) + ('L' << 24))
 #define CV_IS_FILE_STORAGE(fs) ((fs) != 0 && (fs)->flags == CV_FILE_STORAGE)
@@ -515,6 +532,9 @@ icvFSFlush( CvFileStorage* fs )
 }
 
 
+static void
+icvBinWriteEnd( CvFileStorage* fs );
+
 static void
 icvClose( CvFileStorage* fs, std::string* out )
 {
@@ -536,6 +556,8 @@ icvClose( CvFileStorage* fs, std::string* out )
             icvFSFlush(fs);
             if( fs->fmt == CV_STORAGE_FORMAT_XML )
                 icvPuts( fs, "</opencv_storage>\n" );
+            else if( fs->fmt == CV_STORAGE_FORMAT_BINARY )
+                icvBinWriteEnd( fs );
         }
 
         icvCloseFile(fs);
@@ -569,6 +591,8 @@ cvReleaseFileStorage( CvFileStorage** p_fs )
 
         if( fs->outbuf )
             delete fs->outbuf;
+        delete fs->binkeys;
+        delete fs->binbuf;
 
         memset( fs, 0, sizeof(*fs) );
         cvFree( &fs );
@@ -2650,12 +2674,671 @@ icvXMLWriteComment( CvFileStorage* fs, const char* comment, int eol_comment )
 }
 
 
+/****************************************************************************************\
+*                                     Binary Parser                                      *
+\****************************************************************************************/
+
+/*
+   The binary storage starts with the header: the signature, the byte order mark, the format
+   version (32-bit integers) and the total size of the storage (64-bit integer, 0 if it is unknown).
+   It is followed by the top-level mappings (one per stream) stored without the tag and type name:
+
+   node := tag [key] value
+   tag := CV_NODE_INT | CV_NODE_REAL | CV_NODE_STR | CV_NODE_SEQ | CV_NODE_MAP, optionally + CV_NODE_FLOW
+   key := index [string] - only in mappings. The keys are numbered in the order of appearance,
+          the key string follows its first index.
+   value := int32 | float64 | string | string(type_name) element* CV_FS_BIN_END
+   element := node | raw
+   raw := CV_FS_BIN_RAW string(format) int32(number of records) padding data - only in sequences.
+          The data is aligned to CV_FS_BIN_ALIGN bytes from the beginning of the storage.
+   string := int32(length) characters
+
+   All the numbers are stored in the native byte order.
+*/
+static const char icvBinSignature[] = { 'C', 'V', 'F', 'S', 'B', 'I', 'N', '1' };
+#define CV_FS_BIN_BOM          0x01020304
+#define CV_FS_BIN_VERSION      1
+#define CV_FS_BIN_HEADER_SIZE  24
+#define CV_FS_BIN_RAW          0x40
+#define CV_FS_BIN_END          0x7f
+#define CV_FS_BIN_ALIGN        64
+
+static int icvDecodeFormat( const char* dt, int* fmt_pairs, int max_len );
+static int icvCalcElemSize( const char* dt, int initial_size );
+
+typedef struct CvBinParser
+{
+    CvFileStorage* fs;
+    const uchar* start;
+    const uchar* ptr;
+    const uchar* end;
+    std::vector<CvStringHashNode*> keys;
+}
+CvBinParser;
+
+static cv::Mutex icvRawSeqMutex;
+
+// raw_data of such a sequence is read and reset under icvRawSeqMutex only
+static inline bool icvIsRawSeq( const CvSeq* seq )
+{
+    return seq->header_size == (int)sizeof(CvFileRawSeq);
+}
+
+// appends the records of the raw block to the sequence of file nodes
+static void
+icvBinPushRawData( CvSeq* seq, const uchar* data0, int len, const char* dt )
+{
+    int fmt_pairs[CV_FS_MAX_FMT_PAIRS*2], k, fmt_pair_count;
+    int offset = 0;
+
+    fmt_pair_count = icvDecodeFormat( dt, fmt_pairs, CV_FS_MAX_FMT_PAIRS );
+
+    for( ; len > 0; len-- )
+    {
+        for( k = 0; k < fmt_pair_count; k++ )
+        {
+            int i, count = fmt_pairs[k*2];
+            int elem_type = fmt_pairs[k*2+1];
+            int elem_size = CV_ELEM_SIZE(elem_type);
+            const uchar* data;
+
+            offset = cvAlign( offset, elem_size );
+            data = data0 + offset;
+
+            for( i = 0; i < count; i++, data += elem_size )
+            {
+                CvFileNode* node = (CvFileNode*)cvSeqPush( seq, 0 );
+                memset( node, 0, sizeof(*node) );
+                node->tag = CV_NODE_INT;
+
+                switch( elem_type )
+                {
+                case CV_8U:
+                    node->data.i = *(const uchar*)data;
+                    break;
+                case CV_8S:
+                    node->data.i = *(const schar*)data;
+                    break;
+                case CV_16U:
+                    node->data.i = *(const ushort*)data;
+                    break;
+                case CV_16S:
+                    node->data.i = *(const short*)data;
+                    break;
+                case CV_32S:
+                    node->data.i = *(const int*)data;
+                    break;
+                case CV_32F:
+                    node->tag = CV_NODE_REAL;
+                    node->data.f = *(const float*)data;
+                    break;
+                case CV_64F:
+                    node->tag = CV_NODE_REAL;
+                    node->data.f = *(const double*)data;
+                    break;
+                default: /* reference */
+                    node->data.i = (int)*(const size_t*)data;
+                }
+            }
+
+            offset = (int)(data - data0);
+        }
+    }
+}
+
+// converts the sequence created from a raw block to the regular sequence of file nodes
+static void
+icvFSFillRawSeq( CvSeq* seq )
+{
+    if( !icvIsRawSeq(seq) )
+        return;
+
+    cv::AutoLock lock(icvRawSeqMutex);
+    CvFileRawSeq* raw = (CvFileRawSeq*)seq;
+    if( raw->raw_data )
+    {
+        seq->total = 0;
+        icvBinPushRawData( seq, raw->raw_data, raw->raw_len, raw->raw_dt );
+        raw->raw_data = 0;
+    }
+}
+
+static const uchar*
+icvBinGet( CvBinParser& p, size_t len )
+{
+    if( (size_t)(p.end - p.ptr) < len )
+        CV_Error( CV_StsParseError, "The binary storage is truncated" );
+    const uchar* ptr = p.ptr;
+    p.ptr += len;
+    return ptr;
+}
+
+static int
+icvBinGetInt( CvBinParser& p )
+{
+    int value;
+    memcpy( &value, icvBinGet( p, sizeof(value) ), sizeof(value) );
+    return value;
+}
+
+static const char*
+icvBinGetString( CvBinParser& p, int& len )
+{
+    len = icvBinGetInt( p );
+    if( len < 0 )
+        CV_Error( CV_StsParseError, "Invalid string length in the binary storage" );
+    return (const char*)icvBinGet( p, len );
+}
+
+static const uchar*
+icvBinParseRaw( CvBinParser& p, const char*& dt, int& len )
+{
+    int dt_len;
+    const char* dt_str = icvBinGetString( p, dt_len );
+    if( dt_len == 0 || dt_len > 255 )
+        CV_Error( CV_StsParseError, "Invalid format of the raw data in the binary storage" );
+    dt = cvMemStorageAllocString( p.fs->memstorage, dt_str, dt_len ).ptr;
+
+    len = icvBinGetInt( p );
+    size_t elem_size = icvCalcElemSize( dt, 0 );
+    if( len < 0 || (len > 0 && (size_t)(p.end - p.start)/len < elem_size) )
+        CV_Error( CV_StsParseError, "Invalid size of the raw data in the binary storage" );
+
+    size_t pos = p.ptr - p.start;
+    icvBinGet( p, cv::alignSize(pos, CV_FS_BIN_ALIGN) - pos );
+    return icvBinGet( p, len*elem_size );
+}
+
+static CvStringHashNode*
+icvBinParseKey( CvBinParser& p )
+{
+    int idx = icvBinGetInt( p );
+    if( idx == (int)p.keys.size() )
+    {
+        int len;
+        const char* str = icvBinGetString( p, len );
+        if( len == 0 || len > CV_FS_MAX_LEN )
+            CV_Error( CV_StsParseError, "Invalid key in the binary storage" );
+        p.keys.push_back( cvGetHashedKey( p.fs, str, len, 1 ));
+    }
+    else if( idx < 0 || idx > (int)p.keys.size() )
+        CV_Error( CV_StsParseError, "Invalid key index in the binary storage" );
+    return p.keys[idx];
+}
+
+static void
+icvBinParseValue( CvBinParser& p, CvFileNode* node, int tag, bool is_matrix_data );
+
+static void
+icvBinParseElements( CvBinParser& p, CvFileNode* node, bool is_matrix )
+{
+    int is_simple = 1;
+
+    for(;;)
+    {
+        int tag = *icvBinGet( p, 1 );
+        CvFileNode* elem;
+
+        if( tag == CV_FS_BIN_END )
+            break;
+
+        if( CV_NODE_IS_MAP(node->tag) )
+        {
+            CvStringHashNode* key = icvBinParseKey( p );
+            elem = cvGetFileNode( p.fs, node, key, 1 );
+            icvBinParseValue( p, elem, tag, is_matrix && strcmp( key->str.ptr, "data" ) == 0 );
+            elem->tag |= CV_NODE_NAMED;
+        }
+        else if( tag == CV_FS_BIN_RAW )
+        {
+            const char* dt;
+            int len;
+            const uchar* data = icvBinParseRaw( p, dt, len );
+            icvBinPushRawData( node->data.seq, data, len, dt );
+            continue;
+        }
+        else
+        {
+            elem = (CvFileNode*)cvSeqPush( node->data.seq, 0 );
+            icvBinParseValue( p, elem, tag, false );
+        }
+        is_simple &= !CV_NODE_IS_COLLECTION(elem->tag);
+    }
+
+    node->data.seq->flags |= is_simple ? CV_NODE_SEQ_SIMPLE : 0;
+}
+
+// tries to keep the matrix elements stored as a single raw block without converting them to file nodes
+static bool
+icvBinParseRawSeq( CvBinParser& p, CvFileNode* node )
+{
+    const uchar* pos = p.ptr;
+    if( *icvBinGet( p, 1 ) == CV_FS_BIN_RAW )
+    {
+        int fmt_pairs[CV_FS_MAX_FMT_PAIRS*2], k, fmt_pair_count, count = 0;
+        const char* dt;
+        int len;
+        const uchar* data = icvBinParseRaw( p, dt, len );
+
+        fmt_pair_count = icvDecodeFormat( dt, fmt_pairs, CV_FS_MAX_FMT_PAIRS );
+        for( k = 0; k < fmt_pair_count; k++ )
+            count += fmt_pairs[k*2];
+
+        if( p.ptr < p.end && *p.ptr == CV_FS_BIN_END && (double)count*len <= INT_MAX )
+        {
+            p.ptr++;
+            CvFileRawSeq* seq = (CvFileRawSeq*)cvCreateSeq( 0, sizeof(CvFileRawSeq),
+                                                            sizeof(CvFileNode), p.fs->memstorage );
+            seq->flags |= CV_NODE_SEQ_SIMPLE;
+            seq->raw_data = data;
+            seq->raw_dt = dt;
+            seq->raw_len = len;
+            seq->total = count*len;
+            node->tag = CV_NODE_SEQ;
+            node->data.seq = (CvSeq*)seq;
+            return true;
+        }
+    }
+    p.ptr = pos;
+    return false;
+}
+
+static void
+icvBinParseValue( CvBinParser& p, CvFileNode* node, int tag, bool is_matrix_data )
+{
+    int len;
+    const char* str;
+
+    memset( node, 0, sizeof(*node) );
+
+    switch( CV_NODE_TYPE(tag) )
+    {
+    case CV_NODE_INT:
+        node->tag = CV_NODE_INT;
+        node->data.i = icvBinGetInt( p );
+        break;
+    case CV_NODE_REAL:
+        node->tag = CV_NODE_REAL;
+        memcpy( &node->data.f, icvBinGet( p, sizeof(double) ), sizeof(double) );
+        break;
+    case CV_NODE_STR:
+        str = icvBinGetString( p, len );
+        node->tag = CV_NODE_STR;
+        node->data.str = cvMemStorageAllocString( p.fs->memstorage, str, len );
+        break;
+    case CV_NODE_SEQ:
+    case CV_NODE_MAP:
+        {
+        bool is_matrix = false;
+        str = icvBinGetString( p, len );
+        if( len > 0 )
+        {
+            char type_name[CV_FS_MAX_LEN + 1];
+            if( len > CV_FS_MAX_LEN )
+                CV_Error( CV_StsParseError, "Too long type name in the binary storage" );
+            memcpy( type_name, str, len );
+            type_name[len] = '\0';
+            node->info = cvFindType( type_name );
+            is_matrix = strcmp( type_name, CV_TYPE_NAME_MAT ) == 0 ||
+                        strcmp( type_name, CV_TYPE_NAME_MATND ) == 0;
+        }
+
+        if( is_matrix_data && CV_NODE_IS_SEQ(tag) && icvBinParseRawSeq( p, node ))
+            break;
+
+        icvFSCreateCollection( p.fs, CV_NODE_TYPE(tag) + (node->info ? CV_NODE_USER : 0), node );
+        icvBinParseElements( p, node, is_matrix );
+        }
+        break;
+    default:
+        CV_Error( CV_StsParseError, "Invalid node tag in the binary storage" );
+    }
+}
+
+static bool
+icvBinCheckSignature( CvFileStorage* fs )
+{
+    char buf[sizeof(icvBinSignature)];
+    size_t len = 0;
+
+    if( fs->strbuf )
+    {
+        len = MIN( fs->strbufsize, sizeof(buf) );
+        memcpy( buf, fs->strbuf, len );
+    }
+    else if( fs->file )
+        len = fread( buf, 1, sizeof(buf), fs->file );
+#if USE_ZLIB
+    else if( fs->gzfile )
+    {
+        int count = gzread( fs->gzfile, buf, sizeof(buf) );
+        len = count > 0 ? (size_t)count : 0;
+    }
+#endif
+    icvRewind( fs );
+
+    return len == sizeof(buf) && memcmp( buf, icvBinSignature, len ) == 0;
+}
+
+// loads (or maps) the whole binary storage to fs->binbuf
+static void
+icvBinLoad( CvFileStorage* fs )
+{
+    fs->binbuf = new cv::Mat;
+    cv::Mat& buf = *fs->binbuf;
+    size_t size = 0;
+
+    if( fs->strbuf )
+    {
+        // strbufsize is the real length of the buffer only when it is passed with
+        // FileStorage::open(); strlen() of a binary storage stops inside the header
+        uint64 total;
+        if( fs->strbufsize < CV_FS_BIN_HEADER_SIZE )
+            CV_Error( CV_StsParseError, "The binary storage is truncated" );
+        memcpy( &total, fs->strbuf + 16, sizeof(total) );
+        if( total < CV_FS_BIN_HEADER_SIZE || total > INT_MAX )
+            CV_Error( CV_StsParseError, "Invalid size of the binary storage" );
+        if( total > fs->strbufsize )
+            CV_Error( CV_StsParseError, "The binary storage is truncated" );
+        size = (size_t)total;
+        buf.create( 1, (int)size, CV_8U );
+        memcpy( buf.data, fs->strbuf, size );
+    }
+    else if( fs->file )
+    {
+        fseek( fs->file, 0, SEEK_END );
+        size = (size_t)ftell( fs->file );
+        if( size > INT_MAX )
+            CV_Error( CV_StsOutOfRange, "The binary storage is too large" );
+        buf = cv::mapMat( fs->filename, cv::Size((int)size, 1), CV_8U );
+        if( buf.empty() )
+            CV_Error_( CV_StsError, ("Can not map %s", fs->filename) );
+    }
+#if USE_ZLIB
+    else if( fs->gzfile )
+    {
+        std::vector<uchar> data;
+        for(;;)
+        {
+            size_t ofs = data.size();
+            data.resize( ofs + (1 << 20) );
+            int count = gzread( fs->gzfile, &data[ofs], 1 << 20 );
+            data.resize( ofs + MAX(count, 0) );
+            if( count <= 0 )
+                break;
+        }
+        if( data.size() > INT_MAX )
+            CV_Error( CV_StsOutOfRange, "The binary storage is too large" );
+        cv::Mat(data, true).reshape(1, 1).copyTo( buf );
+    }
+#endif
+}
+
+static void
+icvBinParse( CvFileStorage* fs )
+{
+    CvBinParser p;
+    int header[2];
+    uint64 total;
+
+    p.fs = fs;
+    p.start = p.ptr = fs->binbuf->data;
+    p.end = p.start + fs->binbuf->total();
+
+    icvBinGet( p, sizeof(icvBinSignature) );
+    memcpy( header, icvBinGet( p, sizeof(header) ), sizeof(header) );
+    memcpy( &total, icvBinGet( p, sizeof(total) ), sizeof(total) );
+    if( header[0] != CV_FS_BIN_BOM )
+        CV_Error( CV_StsNotImplemented, "The binary storage was written on a machine with another byte order" );
+    if( header[1] != CV_FS_BIN_VERSION )
+        CV_Error( CV_StsNotImplemented, "Unsupported version of the binary storage" );
+    if( total != 0 && total != (uint64)(p.end - p.start) )
+        CV_Error( CV_StsParseError, "The binary storage is truncated" );
+
+    while( p.ptr < p.end )
+    {
+        CvFileNode* root_node = (CvFileNode*)cvSeqPush( fs->roots, 0 );
+        memset( root_node, 0, sizeof(*root_node) );
+        icvFSCreateCollection( fs, CV_NODE_MAP, root_node );
+        icvBinParseElements( p, root_node, false );
+    }
+}
+
+
+/****************************************************************************************\
+*                                     Binary Emitter                                     *
+\****************************************************************************************/
+
+static void
+icvBinPut( CvFileStorage* fs, const void* data, size_t len )
+{
+    const char* ptr = (const char*)data;
+
+    if( fs->outbuf )
+        fs->outbuf->insert( fs->outbuf->end(), ptr, ptr + len );
+    else if( fs->file )
+    {
+        if( fwrite( ptr, 1, len, fs->file ) != len )
+            CV_Error( CV_StsError, "Can not write to the file storage" );
+    }
+#if USE_ZLIB
+    else if( fs->gzfile )
+    {
+        for( size_t ofs = 0; ofs < len; ofs += INT_MAX )
+            if( gzwrite( fs->gzfile, ptr + ofs, (unsigned)MIN(len - ofs, (size_t)INT_MAX) ) <= 0 )
+                CV_Error( CV_StsError, "Can not write to the file storage" );
+    }
+#endif
+    else
+        CV_Error( CV_StsError, "The storage is not opened" );
+
+    fs->binpos += len;
+}
+
+static void
+icvBinPutTag( CvFileStorage* fs, int tag )
+{
+    uchar c = (uchar)tag;
+    icvBinPut( fs, &c, 1 );
+}
+
+static void
+icvBinPutInt( CvFileStorage* fs, int value )
+{
+    icvBinPut( fs, &value, sizeof(value) );
+}
+
+static void
+icvBinPutString( CvFileStorage* fs, const char* str )
+{
+    int len = str ? (int)strlen(str) : 0;
+    icvBinPutInt( fs, len );
+    icvBinPut( fs, str, len );
+}
+
+static void
+icvBinWrite( CvFileStorage* fs, const char* key, int tag )
+{
+    int struct_flags = fs->struct_flags;
+
+    if( key && key[0] == '\0' )
+        key = 0;
+
+    if( CV_NODE_IS_MAP(struct_flags) ^ (key != 0) )
+        CV_Error( CV_StsBadArg, "An attempt to add element without a key to a map, "
+                                "or add element with key to sequence" );
+
+    icvBinPutTag( fs, tag );
+
+    if( key )
+    {
+        if( strlen(key) > CV_FS_MAX_LEN )
+            CV_Error( CV_StsBadArg, "The key is too long" );
+
+        std::map<std::string, int>::const_iterator it = fs->binkeys->find(key);
+        if( it != fs->binkeys->end() )
+            icvBinPutInt( fs, it->second );
+        else
+        {
+            int idx = (int)fs->binkeys->size();
+            (*fs->binkeys)[key] = idx;
+            icvBinPutInt( fs, idx );
+            icvBinPutString( fs, key );
+        }
+    }
+
+    fs->is_first = 0;
+    fs->struct_flags = struct_flags & ~CV_NODE_EMPTY;
+}
+
+static void
+icvBinWriteHeader( CvFileStorage* fs )
+{
+    int header[] = { CV_FS_BIN_BOM, CV_FS_BIN_VERSION };
+    uint64 total = 0; // it is written by icvBinWriteEnd()
+
+    icvBinPut( fs, icvBinSignature, sizeof(icvBinSignature) );
+    icvBinPut( fs, header, sizeof(header) );
+    icvBinPut( fs, &total, sizeof(total) );
+    fs->struct_flags = CV_NODE_MAP + CV_NODE_EMPTY;
+}
+
+static void
+icvBinStartWriteStruct( CvFileStorage* fs, const char* key, int struct_flags,
+                        const char* type_name CV_DEFAULT(0))
+{
+    int parent_flags;
+
+    struct_flags = (struct_flags & (CV_NODE_TYPE_MASK|CV_NODE_FLOW)) | CV_NODE_EMPTY;
+    if( !CV_NODE_IS_COLLECTION(struct_flags))
+        CV_Error( CV_StsBadArg,
+        "Some collection type - CV_NODE_SEQ or CV_NODE_MAP, must be specified" );
+
+    icvBinWrite( fs, key, struct_flags & ~CV_NODE_EMPTY );
+    icvBinPutString( fs, type_name );
+
+    parent_flags = fs->struct_flags;
+    cvSeqPush( fs->write_stack, &parent_flags );
+    fs->struct_flags = struct_flags;
+}
+
+static void
+icvBinEndWriteStruct( CvFileStorage* fs )
+{
+    int parent_flags = 0;
+
+    if( fs->write_stack->total == 0 )
+        CV_Error( CV_StsError, "EndWriteStruct w/o matching StartWriteStruct" );
+
+    cvSeqPop( fs->write_stack, &parent_flags );
+    icvBinPutTag( fs, CV_FS_BIN_END );
+    fs->struct_flags = parent_flags;
+}
+
+static void
+icvBinStartNextStream( CvFileStorage* fs )
+{
+    if( !fs->is_first )
+    {
+        while( fs->write_stack->total > 0 )
+            icvBinEndWriteStruct(fs);
+
+        icvBinPutTag( fs, CV_FS_BIN_END );
+        fs->struct_flags = CV_NODE_MAP + CV_NODE_EMPTY;
+    }
+}
+
+static void
+icvBinWriteInt( CvFileStorage* fs, const char* key, int value )
+{
+    icvBinWrite( fs, key, CV_NODE_INT );
+    icvBinPutInt( fs, value );
+}
+
+static void
+icvBinWriteReal( CvFileStorage* fs, const char* key, double value )
+{
+    icvBinWrite( fs, key, CV_NODE_REAL );
+    icvBinPut( fs, &value, sizeof(value) );
+}
+
+static void
+icvBinWriteString( CvFileStorage* fs, const char* key, const char* str, int /*quote*/ )
+{
+    if( !str )
+        CV_Error( CV_StsNullPtr, "Null string pointer" );
+    if( strlen(str) > CV_FS_MAX_LEN )
+        CV_Error( CV_StsBadArg, "The written string is too long" );
+
+    icvBinWrite( fs, key, CV_NODE_STR );
+    icvBinPutString( fs, str );
+}
+
+static void
+icvBinWriteComment( CvFileStorage*, const char*, int )
+{
+    // the comments are not stored in the binary format
+}
+
+static void
+icvBinWriteRawData( CvFileStorage* fs, const void* data, int len, const char* dt )
+{
+    static const uchar zeros[CV_FS_BIN_ALIGN] = {0};
+
+    icvBinWrite( fs, 0, CV_FS_BIN_RAW );
+    icvBinPutString( fs, dt );
+    icvBinPutInt( fs, len );
+    icvBinPut( fs, zeros, cv::alignSize(fs->binpos, CV_FS_BIN_ALIGN) - fs->binpos );
+    icvBinPut( fs, data, (size_t)len*icvCalcElemSize( dt, 0 ));
+}
+
+// closes the top-level mapping and stores the total size to the header
+static void
+icvBinWriteEnd( CvFileStorage* fs )
+{
+    icvBinPutTag( fs, CV_FS_BIN_END );
+
+    uint64 total = fs->binpos;
+    const char* ptr = (const char*)&total;
+    if( fs->outbuf )
+        std::copy( ptr, ptr + sizeof(total), fs->outbuf->begin() + 16 );
+    else if( fs->file )
+    {
+        fseek( fs->file, 16, SEEK_SET );
+        fwrite( ptr, 1, sizeof(total), fs->file );
+        fseek( fs->file, 0, SEEK_END );
+    }
+    // the size of the compressed storage remains unknown
+}
+
+
 /****************************************************************************************\
 *                              Common High-Level Functions                               *
 \****************************************************************************************/
 
-CV_IMPL CvFileStorage*
-cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, const char* encoding )
+// returns the format of the written storage: the specified one or the one determined by the file extension
+static int
+icvGetWriteFormat( int flags, const char* filename, size_t fnamelen, bool isGZ )
+{
+    int fmt = flags & CV_STORAGE_FORMAT_MASK;
+    if( fmt != CV_STORAGE_FORMAT_AUTO || !filename )
+        return fmt != CV_STORAGE_FORMAT_AUTO ? fmt : CV_STORAGE_FORMAT_XML;
+
+    const char* dot_pos = filename + fnamelen - (isGZ ? 7 : 4);
+    if( dot_pos < filename )
+        return CV_STORAGE_FORMAT_YAML;
+    if( memcmp( dot_pos, ".xml", 4) == 0 || memcmp(dot_pos, ".XML", 4) == 0 || memcmp(dot_pos, ".Xml", 4) == 0 )
+        return CV_STORAGE_FORMAT_XML;
+    if( memcmp( dot_pos, ".bin", 4) == 0 || memcmp(dot_pos, ".BIN", 4) == 0 )
+        return CV_STORAGE_FORMAT_BINARY;
+    return CV_STORAGE_FORMAT_YAML;
+}
+
+// buflen is the length of the buffer read with CV_STORAGE_MEMORY; binary storages contain
+// zeros, so it can not be taken from strlen(filename)
+static CvFileStorage*
+icvOpenFileStorage( const char* filename, size_t buflen, CvMemStorage* dststorage,
+                    int flags, const char* encoding )
 {
     CvFileStorage* fs = 0;
     char* xml_buf = 0;
@@ -2673,7 +3356,7 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
         mem = true;
     }
     else
-        fnamelen = strlen(filename);
+        fnamelen = mem && !write_mode ? buflen : strlen(filename);
 
     if( mem && append )
         CV_Error( CV_StsBadFlag, "CV_STORAGE_APPEND and CV_STORAGE_MEMORY are not currently compatible" );
@@ -2708,7 +3391,8 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
 
         if( !isGZ )
         {
-            fs->file = fopen(fs->filename, !fs->write_mode ? "rt" : !append ? "wt" : "a+t" );
+            fs->file = fopen(fs->filename, !fs->write_mode ? "rt" : append ? "a+t" :
+                             icvGetWriteFormat(flags, filename, fnamelen, false) == CV_STORAGE_FORMAT_BINARY ? "wb" : "wt" );
             if( !fs->file )
                 goto _exit_;
         }
@@ -2732,20 +3416,12 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
 
     if( fs->write_mode )
     {
-        int fmt = flags & CV_STORAGE_FORMAT_MASK;
-
         if( mem )
             fs->outbuf = new std::deque<char>;
 
-        if( fmt == CV_STORAGE_FORMAT_AUTO && filename )
-        {
-            const char* dot_pos = filename + fnamelen - (isGZ ? 7 : 4);
-            fs->fmt = (dot_pos >= filename && (memcmp( dot_pos, ".xml", 4) == 0 ||
-                    memcmp(dot_pos, ".XML", 4) == 0 || memcmp(dot_pos, ".Xml", 4) == 0)) ?
-                CV_STORAGE_FORMAT_XML : CV_STORAGE_FORMAT_YAML;
-        }
-        else
-            fs->fmt = fmt != CV_STORAGE_FORMAT_AUTO ? fmt : CV_STORAGE_FORMAT_XML;
+        fs->fmt = icvGetWriteFormat( flags, filename, fnamelen, isGZ );
+        if( fs->fmt == CV_STORAGE_FORMAT_BINARY && append )
+            CV_Error( CV_StsNotImplemented, "Appending data to binary file storage is not implemented" );
 
         // we use factor=6 for XML (the longest characters (' and ") are encoded with 6 bytes (&apos; and &quot;)
         // and factor=4 for YAML ( as we use 4 bytes for non ASCII characters (e.g. \xAB))
@@ -2826,6 +3502,18 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
             fs->write_comment = icvXMLWriteComment;
             fs->start_next_stream = icvXMLStartNextStream;
         }
+        else if( fs->fmt == CV_STORAGE_FORMAT_BINARY )
+        {
+            fs->binkeys = new std::map<std::string, int>;
+            icvBinWriteHeader( fs );
+            fs->start_write_struct = icvBinStartWriteStruct;
+            fs->end_write_struct = icvBinEndWriteStruct;
+            fs->write_int = icvBinWriteInt;
+            fs->write_real = icvBinWriteReal;
+            fs->write_string = icvBinWriteString;
+            fs->write_comment = icvBinWriteComment;
+            fs->start_next_stream = icvBinStartNextStream;
+        }
         else
         {
             if( !append )
@@ -2852,11 +3540,16 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
         size_t buf_size = 1 << 20;
         const char* yaml_signature = "%YAML:";
         char buf[16];
-        icvGets( fs, buf, sizeof(buf)-2 );
-        fs->fmt = strncmp( buf, yaml_signature, strlen(yaml_signature) ) == 0 ?
-            CV_STORAGE_FORMAT_YAML : CV_STORAGE_FORMAT_XML;
+        if( icvBinCheckSignature( fs ))
+            fs->fmt = CV_STORAGE_FORMAT_BINARY;
+        else
+        {
+            icvGets( fs, buf, sizeof(buf)-2 );
+            fs->fmt = strncmp( buf, yaml_signature, strlen(yaml_signature) ) == 0 ?
+                CV_STORAGE_FORMAT_YAML : CV_STORAGE_FORMAT_XML;
+        }
 
-        if( !isGZ )
+        if( !isGZ && fs->fmt != CV_STORAGE_FORMAT_BINARY )
         {
             if( !mem )
             {
@@ -2876,22 +3569,30 @@ cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, co
         fs->roots = cvCreateSeq( 0, sizeof(CvSeq),
                         sizeof(CvFileNode), fs->memstorage );
 
-        fs->buffer = fs->buffer_start = (char*)cvAlloc( buf_size + 256 );
-        fs->buffer_end = fs->buffer_start + buf_size;
-        fs->buffer[0] = '\n';
-        fs->buffer[1] = '\0';
-
-        //mode = cvGetErrMode();
-        //cvSetErrMode( CV_ErrModeSilent );
-        if( fs->fmt == CV_STORAGE_FORMAT_XML )
-            icvXMLParse( fs );
+        if( fs->fmt == CV_STORAGE_FORMAT_BINARY )
+        {
+            icvBinLoad( fs );
+            icvBinParse( fs );
+        }
         else
-            icvYMLParse( fs );
-        //cvSetErrMode( mode );
+        {
+            fs->buffer = fs->buffer_start = (char*)cvAlloc( buf_size + 256 );
+            fs->buffer_end = fs->buffer_start + buf_size;
+            fs->buffer[0] = '\n';
+            fs->buffer[1] = '\0';
 
-        // release resources that we do not need anymore
-        cvFree( &fs->buffer_start );
-        fs->buffer = fs->buffer_end = 0;
+            //mode = cvGetErrMode();
+            //cvSetErrMode( CV_ErrModeSilent );
+            if( fs->fmt == CV_STORAGE_FORMAT_XML )
+                icvXMLParse( fs );
+            else
+                icvYMLParse( fs );
+            //cvSetErrMode( mode );
+
+            // release resources that we do not need anymore
+            cvFree( &fs->buffer_start );
+            fs->buffer = fs->buffer_end = 0;
+        }
     }
     fs->is_opened = true;
 
@@ -2915,6 +3616,12 @@ _exit_:
     return  fs;
 }
 
+CV_IMPL CvFileStorage*
+cvOpenFileStorage( const char* filename, CvMemStorage* dststorage, int flags, const char* encoding )
+{
+    return icvOpenFileStorage( filename, filename ? strlen(filename) : 0, dststorage, flags, encoding );
+}
+
 
 CV_IMPL void
 cvStartWriteStruct( CvFileStorage* fs, const char* key, int struct_flags,
@@ -2974,7 +3681,6 @@ cvStartNextStream( CvFileStorage* fs )
 
 
 static const char icvTypeSymbol[] = "ucwsifdr";
-#define CV_FS_MAX_FMT_PAIRS  128
 
 static char*
 icvEncodeFormat( int elem_type, char* dt )
@@ -3101,6 +3807,12 @@ cvWriteRawData( CvFileStorage* fs, const void* _data, int len, const char* dt )
     if( !data0 )
         CV_Error( CV_StsNullPtr, "Null data pointer" );
 
+    if( fs->fmt == CV_STORAGE_FORMAT_BINARY )
+    {
+        icvBinWriteRawData( fs, data0, len, dt );
+        return;
+    }
+
     if( fmt_pair_count == 1 )
     {
         fmt_pairs[0] *= len;
@@ -3195,6 +3907,7 @@ cvStartReadRawData( const CvFileStorage* fs, const CvFileNode* src, CvSeqReader*
     }
     else if( node_type == CV_NODE_SEQ )
     {
+        icvFSFillRawSeq( src->data.seq );
         cvStartReadSeq( src->data.seq, reader, 0 );
     }
     else if( node_type == CV_NODE_NONE )
@@ -3364,6 +4077,31 @@ cvReadRawData( const CvFileStorage* fs, const CvFileNode* src,
     if( !src || !data )
         CV_Error( CV_StsNullPtr, "Null pointers to source file node or destination array" );
 
+    if( CV_NODE_IS_SEQ(src->tag) && icvIsRawSeq(src->data.seq) )
+    {
+        // the raw block from the binary storage is copied directly if it has the same format
+        const CvFileRawSeq* raw = (const CvFileRawSeq*)src->data.seq;
+        int fmt_pairs[CV_FS_MAX_FMT_PAIRS*2], raw_fmt_pairs[CV_FS_MAX_FMT_PAIRS*2];
+        int fmt_pair_count = icvDecodeFormat( dt, fmt_pairs, CV_FS_MAX_FMT_PAIRS );
+        int raw_fmt_pair_count = icvDecodeFormat( raw->raw_dt, raw_fmt_pairs, CV_FS_MAX_FMT_PAIRS );
+        bool same_format = fmt_pair_count == raw_fmt_pair_count;
+
+        if( fmt_pair_count == 1 && same_format )
+            same_format = fmt_pairs[1] == raw_fmt_pairs[1];
+        else if( same_format )
+            same_format = memcmp( fmt_pairs, raw_fmt_pairs, fmt_pair_count*2*sizeof(int) ) == 0;
+
+        if( same_format )
+        {
+            cv::AutoLock lock(icvRawSeqMutex);
+            if( raw->raw_data )
+            {
+                memcpy( data, raw->raw_data, (size_t)raw->raw_len*icvCalcElemSize( raw->raw_dt, 0 ));
+                return;
+            }
+        }
+    }
+
     cvStartReadRawData( fs, src, &reader );
     cvReadRawDataSlice( fs, &reader, CV_NODE_IS_SEQ(src->tag) ?
                         src->data.seq->total : 1, data, dt );
@@ -3376,6 +4114,8 @@ icvWriteFileNode( CvFileStorage* fs, const char* name, const CvFileNode* node );
 static void
 icvWriteCollection( CvFileStorage* fs, const CvFileNode* node )
 {
+    icvFSFillRawSeq( node->data.seq );
+
     int i, total = node->data.seq->total;
     int elem_size = node->data.seq->elem_size;
     int is_map = CV_NODE_IS_MAP(node->tag);
@@ -5148,8 +5888,8 @@ FileStorage::~FileStorage()
 bool FileStorage::open(const string& filename, int flags, const string& encoding)
 {
     release();
-    fs = Ptr<CvFileStorage>(cvOpenFileStorage( filename.c_str(), 0, flags,
-                                               !encoding.empty() ? encoding.c_str() : 0));
+    fs = Ptr<CvFileStorage>(icvOpenFileStorage( filename.c_str(), filename.size(), 0, flags,
+                                                !encoding.empty() ? encoding.c_str() : 0));
     bool ok = isOpened();
     state = ok ? NAME_EXPECTED + INSIDE_MAP : UNDEFINED;
     return ok;
@@ -5283,8 +6023,10 @@ FileNode FileNode::operator[](const char* nodename) const
 
 FileNode FileNode::operator[](int i) const
 {
-    return isSeq() ? FileNode(fs, (CvFileNode*)cvGetSeqElem(node->data.seq, i)) :
-        i == 0 ? *this : FileNode();
+    if( !isSeq() )
+        return i == 0 ? *this : FileNode();
+    icvFSFillRawSeq( node->data.seq );
+    return FileNode(fs, (CvFileNode*)cvGetSeqElem(node->data.seq, i));
 }
 
 string FileNode::name() const
@@ -5318,6 +6060,7 @@ FileNodeIterator::FileNodeIterator(const CvFileStorage* _fs,
         container = _node;
         if( !(_node->tag & FileNode::USER) && (node_type == FileNode::SEQ || node_type == FileNode::MAP) )
         {
+            icvFSFillRawSeq( _node->data.seq );
             cvStartReadSeq( _node->data.seq, &reader );
             remaining = FileNode(_fs, _node).size();
         }
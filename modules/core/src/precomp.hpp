@@ -87,6 +87,14 @@ extern const uchar g_Saturate8u[];
 #if defined WIN32 || defined _WIN32
 void deleteThreadAllocData();
 void deleteThreadRNGData();
+void deleteThreadMatPoolData();
+#endif
+
+#ifdef HAVE_PTHREADS_PF
+void parallel_for_pthreads(const Range& stripes, const ParallelLoopBody& body, int maxThreads);
+void parallel_pthreads_set_threads_num(int nthreads);
+int parallel_pthreads_get_threads_num();
+int parallel_pthreads_get_thread_num();
 #endif
 
 template<typename T1, typename T2=T1, typename T3=T1> struct OpAdd
@@ -172,6 +180,7 @@ struct NoVec
 extern volatile bool USE_SSE2;
 extern volatile bool USE_SSE4_2;
 extern volatile bool USE_AVX;
+extern volatile bool USE_AVX2;
 
 enum { BLOCK_SIZE = 1024 };
 
@@ -188,6 +197,14 @@ static inline IppiSize ippiSize(Size _sz)              { IppiSize sz = { _sz.wid
 #define IF_IPP(then_call, else_call) else_call
 #endif
 
+// The AVX2 kernels live in separate translation units built with AVX2 code generation
+// (see avx2.hpp); they are only entered when the CPU reports AVX2 support.
+#ifdef HAVE_AVX2_DISPATCH
+#define IF_AVX2(call) if( USE_AVX2 ) { call; return; }
+#else
+#define IF_AVX2(call)
+#endif
+
 inline bool checkScalar(const Mat& sc, int atype, int sckind, int akind)
 {
     if( sc.dims > 2 || (sc.cols != 1 && sc.rows != 1) || !sc.isContinuous() )
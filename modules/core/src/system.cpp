@@ -189,9 +189,60 @@ struct HWFeatures
             f.have[CV_CPU_AVX]    = (((cpuid_data[2] & (1<<28)) != 0)&&((cpuid_data[2] & (1<<27)) != 0));//OS uses XSAVE_XRSTORE and CPU support AVX
         }
 
+        // AVX2 is reported in the extended feature flags (leaf 7, sub-leaf 0, EBX bit 5)
+        if( f.have[CV_CPU_AVX] && maxLeaf() >= 7 )
+        {
+            int cpuid_data7[4] = { 0, 0, 0, 0 };
+            cpuid7(cpuid_data7);
+            f.have[CV_CPU_AVX2]   = (cpuid_data7[1] & (1<<5)) != 0;
+        }
+
+        // OPENCV_CPU_DISABLE=AVX2 turns the AVX2 code paths off, e.g. to compare them against SSE2 ones
+        const char* disabled = getenv("OPENCV_CPU_DISABLE");
+        if( disabled && strstr(disabled, "AVX2") )
+            f.have[CV_CPU_AVX2] = false;
+
         return f;
     }
 
+    static int maxLeaf(void)
+    {
+        int cpuid_data[4] = { 0, 0, 0, 0 };
+    #if defined _MSC_VER && (defined _M_IX86 || defined _M_X64)
+        __cpuid(cpuid_data, 0);
+    #elif defined __GNUC__ && (defined __i386__ || defined __x86_64__)
+        asm volatile
+        (
+         "movl %%ebx, %%esi\n\t"
+         "cpuid\n\t"
+         "xchgl %%ebx, %%esi\n\t"
+         : "=a"(cpuid_data[0]), "=S"(cpuid_data[1]), "=c"(cpuid_data[2]), "=d"(cpuid_data[3])
+         : "a"(0)
+         : "cc"
+        );
+    #endif
+        return cpuid_data[0];
+    }
+
+    static void cpuid7(int* cpuid_data)
+    {
+    #if defined _MSC_VER && (defined _M_IX86 || defined _M_X64) && _MSC_VER >= 1600
+        __cpuidex(cpuid_data, 7, 0);
+    #elif defined __GNUC__ && (defined __i386__ || defined __x86_64__)
+        asm volatile
+        (
+         "movl %%ebx, %%esi\n\t"
+         "cpuid\n\t"
+         "xchgl %%ebx, %%esi\n\t"
+         : "=a"(cpuid_data[0]), "=S"(cpuid_data[1]), "=c"(cpuid_data[2]), "=d"(cpuid_data[3])
+         : "a"(7), "c"(0)
+         : "cc"
+        );
+    #else
+        (void)cpuid_data;
+    #endif
+    }
+
     int x86_family;
     bool have[MAX_FEATURE+1];
 };
@@ -219,12 +270,14 @@ IPPInitializer ippInitializer;
 volatile bool USE_SSE2 = featuresEnabled.have[CV_CPU_SSE2];
 volatile bool USE_SSE4_2 = featuresEnabled.have[CV_CPU_SSE4_2];
 volatile bool USE_AVX = featuresEnabled.have[CV_CPU_AVX];
+volatile bool USE_AVX2 = featuresEnabled.have[CV_CPU_AVX2];
 
 void setUseOptimized( bool flag )
 {
     useOptimizedFlag = flag;
     currentFeatures = flag ? &featuresEnabled : &featuresDisabled;
     USE_SSE2 = currentFeatures->have[CV_CPU_SSE2];
+    USE_AVX2 = currentFeatures->have[CV_CPU_AVX2];
 }
 
 bool useOptimized(void)
@@ -788,6 +841,7 @@ BOOL WINAPI DllMain( HINSTANCE, DWORD  fdwReason, LPVOID )
     {
         cv::deleteThreadAllocData();
         cv::deleteThreadRNGData();
+        cv::deleteThreadMatPoolData();
     }
     return TRUE;
 }
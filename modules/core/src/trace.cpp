@@ -0,0 +1,271 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009-2011, Willow Garage Inc., all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+
+#if defined WIN32 || defined WINCE
+    #include <windows.h>
+    #undef small
+    #undef min
+    #undef max
+    #undef abs
+#endif
+
+namespace cv
+{
+
+namespace
+{
+
+struct TraceEvent
+{
+    const char* name;
+    int64 start, end;
+};
+
+// events of a single thread; the mutex is taken by the owner to add an event
+// and by writeTrace() and clearTrace() to access the events of the other threads
+struct TraceBuffer
+{
+    TraceBuffer(int _tid) : tid(_tid), alive(true) {}
+
+    Mutex mutex;
+    vector<TraceEvent> events;
+    int tid;
+    bool alive;
+};
+
+struct TraceRegistry
+{
+    TraceRegistry() : nextTid(0), startTick(getTickCount()) {}
+
+    Mutex mutex;
+    vector<TraceBuffer*> buffers;
+    int nextTid;
+    int64 startTick;
+};
+
+// the registry is never destroyed, since the threads can finish during the static deinitialization
+static TraceRegistry& getTraceRegistry()
+{
+    static TraceRegistry* registry = new TraceRegistry;
+    return *registry;
+}
+
+static volatile bool tracing = false;
+
+static TraceBuffer* createTraceBuffer()
+{
+    TraceRegistry& registry = getTraceRegistry();
+    AutoLock lock(registry.mutex);
+    TraceBuffer* buffer = new TraceBuffer(registry.nextTid++);
+    registry.buffers.push_back(buffer);
+    return buffer;
+}
+
+// the events of the finished threads are kept until clearTrace()
+static void releaseTraceBuffer(void* data)
+{
+    TraceBuffer* buffer = (TraceBuffer*)data;
+    TraceRegistry& registry = getTraceRegistry();
+    AutoLock lock(registry.mutex);
+    buffer->alive = false;
+}
+
+#if defined WIN32 || defined _WIN32
+#ifdef WINCE
+#   define TLS_OUT_OF_INDEXES ((DWORD)0xFFFFFFFF)
+#endif
+static DWORD tlsTraceKey = TLS_OUT_OF_INDEXES;
+
+static TraceBuffer* getThreadTraceBuffer()
+{
+    if( tlsTraceKey == TLS_OUT_OF_INDEXES )
+    {
+        tlsTraceKey = TlsAlloc();
+        CV_Assert(tlsTraceKey != TLS_OUT_OF_INDEXES);
+    }
+    TraceBuffer* buffer = (TraceBuffer*)TlsGetValue( tlsTraceKey );
+    if( !buffer )
+    {
+        buffer = createTraceBuffer();
+        TlsSetValue( tlsTraceKey, buffer );
+    }
+    return buffer;
+}
+#else
+static pthread_key_t tlsTraceKey = 0;
+static pthread_once_t tlsTraceKeyOnce = PTHREAD_ONCE_INIT;
+
+static void makeTraceKey()
+{
+    int errcode = pthread_key_create(&tlsTraceKey, releaseTraceBuffer);
+    CV_Assert(errcode == 0);
+}
+
+static TraceBuffer* getThreadTraceBuffer()
+{
+    pthread_once(&tlsTraceKeyOnce, makeTraceKey);
+    TraceBuffer* buffer = (TraceBuffer*)pthread_getspecific(tlsTraceKey);
+    if( !buffer )
+    {
+        buffer = createTraceBuffer();
+        pthread_setspecific(tlsTraceKey, buffer);
+    }
+    return buffer;
+}
+#endif
+
+static void writeJsonString(FILE* f, const char* str)
+{
+    fputc('\"', f);
+    for( ; *str; str++ )
+    {
+        if( *str == '\"' || *str == '\\' )
+            fputc('\\', f);
+        if( (uchar)*str >= ' ' )
+            fputc(*str, f);
+    }
+    fputc('\"', f);
+}
+
+} // namespace
+
+void setTracing(bool enabled)
+{
+    tracing = enabled;
+}
+
+bool isTracingEnabled()
+{
+    return tracing;
+}
+
+void clearTrace()
+{
+    TraceRegistry& registry = getTraceRegistry();
+    AutoLock lock(registry.mutex);
+    size_t i, j = 0;
+    for( i = 0; i < registry.buffers.size(); i++ )
+    {
+        TraceBuffer* buffer = registry.buffers[i];
+        if( !buffer->alive )
+        {
+            delete buffer;
+            continue;
+        }
+        {
+            AutoLock block(buffer->mutex);
+            buffer->events.clear();
+        }
+        registry.buffers[j++] = buffer;
+    }
+    registry.buffers.resize(j);
+    registry.startTick = getTickCount();
+}
+
+bool writeTrace(const string& filename)
+{
+    FILE* f = fopen(filename.c_str(), "wt");
+    if( !f )
+        return false;
+
+    TraceRegistry& registry = getTraceRegistry();
+    AutoLock lock(registry.mutex);
+    double scale = 1e6/getTickFrequency();
+    bool first = true;
+
+    fprintf(f, "{\"traceEvents\":[\n");
+    for( size_t i = 0; i < registry.buffers.size(); i++ )
+    {
+        TraceBuffer* buffer = registry.buffers[i];
+        AutoLock block(buffer->mutex);
+        if( buffer->events.empty() )
+            continue;
+
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", buffer->tid, buffer->tid);
+        first = false;
+
+        for( size_t j = 0; j < buffer->events.size(); j++ )
+        {
+            const TraceEvent& e = buffer->events[j];
+            fprintf(f, ",\n{\"name\":");
+            writeJsonString(f, e.name);
+            fprintf(f, ",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    buffer->tid, (e.start - registry.startTick)*scale, (e.end - e.start)*scale);
+        }
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    bool ok = ferror(f) == 0;
+    fclose(f);
+    return ok;
+}
+
+TraceRegion::TraceRegion(const char* _name) : name(0), start(0)
+{
+    if( tracing )
+    {
+        name = _name;
+        start = getTickCount();
+    }
+}
+
+TraceRegion::~TraceRegion()
+{
+    if( name )
+    {
+        TraceEvent e;
+        e.name = name;
+        e.start = start;
+        e.end = getTickCount();
+
+        TraceBuffer* buffer = getThreadTraceBuffer();
+        AutoLock lock(buffer->mutex);
+        buffer->events.push_back(e);
+    }
+}
+
+}
+
+/* End of file. */
@@ -1530,4 +1530,123 @@ TEST(Multiply, FloatingPointRounding)
     cv::multiply(src, s, dst, 1, CV_16U);
     // with CV_32F this produce result 16202
     ASSERT_EQ(dst.at<ushort>(0,0), 16201);
-}
\ No newline at end of file
+}
+
+namespace
+{
+
+class UseOptimizedScope
+{
+public:
+    UseOptimizedScope(bool flag) : prev(useOptimized()) { setUseOptimized(flag); }
+    ~UseOptimizedScope() { setUseOptimized(prev); }
+protected:
+    bool prev;
+};
+
+// runs the operations with and without the optimized (SSE2, AVX2, ...) code paths
+struct OptimizedPathsCheck
+{
+    OptimizedPathsCheck() : rng(0x12345) {}
+
+    Mat randomMat(Size size, int type)
+    {
+        // the ROI makes the rows non-continuous
+        Mat big(size.height + 2, size.width + 3, type), m = big(Rect(1, 1, size.width, size.height));
+        int depth = CV_MAT_DEPTH(type);
+        double a = depth == CV_8U ? 0 : depth == CV_8S ? -128 : depth == CV_16U ? 0 : depth == CV_16S ? -32768 : -1e6;
+        double b = depth == CV_8U ? 256 : depth == CV_8S ? 128 : depth == CV_16U ? 65536 : depth == CV_16S ? 32768 : 1e6;
+        rng.fill(m, RNG::UNIFORM, a, b);
+        return m;
+    }
+
+    template<class Func> void run(const Func& f, const Mat& a, const Mat& b, const char* what)
+    {
+        Mat ref, dst;
+        {
+            UseOptimizedScope scope(false);
+            f(a, b, ref);
+        }
+        {
+            UseOptimizedScope scope(true);
+            f(a, b, dst);
+        }
+        ASSERT_EQ(ref.type(), dst.type()) << what;
+        ASSERT_EQ(0, countNonZero(ref.reshape(1) != dst.reshape(1)))
+            << what << ", type=" << a.type() << ", size=" << a.size();
+    }
+
+    RNG rng;
+};
+
+struct AddFunc { void operator()(const Mat& a, const Mat& b, Mat& c) const { add(a, b, c); } };
+struct SubFunc { void operator()(const Mat& a, const Mat& b, Mat& c) const { subtract(a, b, c); } };
+struct AbsDiffFunc { void operator()(const Mat& a, const Mat& b, Mat& c) const { absdiff(a, b, c); } };
+struct CmpFunc
+{
+    CmpFunc(int _op) : op(_op) {}
+    void operator()(const Mat& a, const Mat& b, Mat& c) const { compare(a, b, c, op); }
+    int op;
+};
+struct AddWeightedFunc
+{
+    void operator()(const Mat& a, const Mat& b, Mat& c) const { addWeighted(a, 0.3, b, 0.7, 12.5, c); }
+};
+struct ConvertFunc
+{
+    ConvertFunc(int _depth, double _alpha, double _beta) : depth(_depth), alpha(_alpha), beta(_beta) {}
+    void operator()(const Mat& a, const Mat&, Mat& c) const { a.convertTo(c, depth, alpha, beta); }
+    int depth;
+    double alpha, beta;
+};
+struct LUTFunc
+{
+    LUTFunc(const Mat& _lut) : lut(_lut) {}
+    void operator()(const Mat& a, const Mat&, Mat& c) const { LUT(a, lut, c); }
+    Mat lut;
+};
+
+}
+
+TEST(Core_Arithm, optimized_paths_are_bitexact)
+{
+    OptimizedPathsCheck check;
+    const int depths[] = { CV_8U, CV_8S, CV_16U, CV_16S, CV_32S, CV_32F };
+    const Size sizes[] = { Size(1, 3), Size(37, 5), Size(127, 4), Size(320, 2) };
+
+    for( int si = 0; si < 4; si++ )
+        for( int di = 0; di < 6; di++ )
+            for( int cn = 1; cn <= 4; cn += 3 )
+            {
+                int type = CV_MAKETYPE(depths[di], cn);
+                Mat a = check.randomMat(sizes[si], type), b = check.randomMat(sizes[si], type);
+                a.row(0).copyTo(b.row(0)); // some equal elements for the comparisons
+
+                check.run(AddFunc(), a, b, "add");
+                check.run(SubFunc(), a, b, "subtract");
+                check.run(AbsDiffFunc(), a, b, "absdiff");
+                for( int op = CMP_EQ; op <= CMP_NE; op++ )
+                    check.run(CmpFunc(op), a, b, "compare");
+                if( depths[di] == CV_8U || depths[di] == CV_32F )
+                    check.run(AddWeightedFunc(), a, b, "addWeighted");
+
+                for( int ddi = 0; ddi < 6; ddi++ )
+                {
+                    check.run(ConvertFunc(depths[ddi], 1, 0), a, b, "convertTo");
+                    check.run(ConvertFunc(depths[ddi], 0.37, -5.5), a, b, "convertTo");
+                }
+            }
+
+    for( int cn = 1; cn <= 4; cn++ )
+    {
+        Mat a = check.randomMat(Size(61, 3), CV_8UC(cn));
+        for( int lutcn = 1; lutcn <= cn; lutcn += std::max(cn - 1, 1) )
+        {
+            Mat lut32s(1, 256, CV_32SC(lutcn)), lut32f(1, 256, CV_32FC(lutcn));
+            check.rng.fill(lut32s, RNG::UNIFORM, INT_MIN, INT_MAX);
+            check.rng.fill(lut32f, RNG::UNIFORM, -1e6, 1e6);
+            check.run(LUTFunc(lut32s), a, a, "LUT");
+            check.run(LUTFunc(lut32f), a, a, "LUT");
+        }
+    }
+}
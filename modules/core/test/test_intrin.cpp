@@ -0,0 +1,225 @@
+#include "test_precomp.hpp"
+#include "opencv2/core/intrin.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+
+template<typename _Tpvec> struct Data
+{
+    typedef typename _Tpvec::lane_type LaneType;
+    enum { n = _Tpvec::nlanes };
+
+    Data() { memset(d, 0, sizeof(d)); }
+    Data(const _Tpvec& v) { v_store(d, v); }
+    _Tpvec load() const { return v_load(d); }
+    void fill(RNG& rng, double a, double b)
+    {
+        for( int i = 0; i < n; i++ )
+            d[i] = saturate_cast<LaneType>(rng.uniform(a, b));
+    }
+    LaneType& operator[](int i) { return d[i]; }
+    LaneType operator[](int i) const { return d[i]; }
+
+    LaneType d[n];
+};
+
+template<typename _Tp> bool isMask(_Tp v, bool expected)
+{
+    uchar bytes[sizeof(_Tp)];
+    memcpy(bytes, &v, sizeof(v));
+    for( size_t i = 0; i < sizeof(_Tp); i++ )
+        if( bytes[i] != (expected ? 255 : 0) )
+            return false;
+    return true;
+}
+
+template<typename _Tpvec> void testIntOps(double a, double b)
+{
+    typedef typename _Tpvec::lane_type T;
+    RNG& rng = theRNG();
+    for( int iter = 0; iter < 100; iter++ )
+    {
+        Data<_Tpvec> x, y;
+        x.fill(rng, a, b);
+        y.fill(rng, a, b);
+        if( iter == 0 )
+            y = x;
+        _Tpvec vx = x.load(), vy = y.load();
+
+        Data<_Tpvec> add(vx + vy), sub(vx - vy), mn(v_min(vx, vy)), mx(v_max(vx, vy));
+        Data<_Tpvec> band(vx & vy), bxor(vx ^ vy), bnot(~vx);
+        Data<_Tpvec> eq(vx == vy), ne(vx != vy), lt(vx < vy), gt(vx > vy), le(vx <= vy), ge(vx >= vy);
+        Data<_Tpvec> sel(v_select(vx > vy, vx, vy));
+
+        for( int i = 0; i < _Tpvec::nlanes; i++ )
+        {
+            if( sizeof(T) <= 2 )
+            {
+                ASSERT_EQ(saturate_cast<T>((double)x[i] + y[i]), add[i]);
+                ASSERT_EQ(saturate_cast<T>((double)x[i] - y[i]), sub[i]);
+            }
+            else
+            {
+                ASSERT_EQ((T)((unsigned)x[i] + (unsigned)y[i]), add[i]);
+                ASSERT_EQ((T)((unsigned)x[i] - (unsigned)y[i]), sub[i]);
+            }
+            ASSERT_EQ(std::min(x[i], y[i]), mn[i]);
+            ASSERT_EQ(std::max(x[i], y[i]), mx[i]);
+            ASSERT_EQ((T)(x[i] & y[i]), band[i]);
+            ASSERT_EQ((T)(x[i] ^ y[i]), bxor[i]);
+            ASSERT_EQ((T)~x[i], bnot[i]);
+            ASSERT_TRUE(isMask(eq[i], x[i] == y[i]));
+            ASSERT_TRUE(isMask(ne[i], x[i] != y[i]));
+            ASSERT_TRUE(isMask(lt[i], x[i] < y[i]));
+            ASSERT_TRUE(isMask(gt[i], x[i] > y[i]));
+            ASSERT_TRUE(isMask(le[i], x[i] <= y[i]));
+            ASSERT_TRUE(isMask(ge[i], x[i] >= y[i]));
+            ASSERT_EQ(std::max(x[i], y[i]), sel[i]);
+        }
+        ASSERT_EQ(x[0], vx.get0());
+    }
+}
+
+template<typename _Tpvec, typename _Tpuvec> void testAbsDiff(double a, double b)
+{
+    RNG& rng = theRNG();
+    for( int iter = 0; iter < 100; iter++ )
+    {
+        Data<_Tpvec> x, y;
+        x.fill(rng, a, b);
+        y.fill(rng, a, b);
+        Data<_Tpuvec> d(v_absdiff(x.load(), y.load()));
+        for( int i = 0; i < _Tpvec::nlanes; i++ )
+            ASSERT_EQ((typename _Tpuvec::lane_type)std::abs((double)x[i] - y[i]), d[i]);
+    }
+}
+
+template<typename _Tpvec, typename _Tpwvec> void testPackExpand(double a, double b)
+{
+    typedef typename _Tpvec::lane_type T;
+    RNG& rng = theRNG();
+    for( int iter = 0; iter < 100; iter++ )
+    {
+        Data<_Tpwvec> x, y;
+        x.fill(rng, a, b);
+        y.fill(rng, a, b);
+        Data<_Tpvec> p(v_pack(x.load(), y.load()));
+        for( int i = 0; i < _Tpwvec::nlanes; i++ )
+        {
+            ASSERT_EQ(saturate_cast<T>(x[i]), p[i]);
+            ASSERT_EQ(saturate_cast<T>(y[i]), p[i + _Tpwvec::nlanes]);
+        }
+
+        _Tpwvec w0, w1;
+        v_expand(p.load(), w0, w1);
+        Data<_Tpwvec> e0(w0), e1(w1), le(v_load_expand(&p[0]));
+        for( int i = 0; i < _Tpwvec::nlanes; i++ )
+        {
+            ASSERT_EQ(p[i], e0[i]);
+            ASSERT_EQ(p[i + _Tpwvec::nlanes], e1[i]);
+            ASSERT_EQ(p[i], le[i]);
+        }
+    }
+}
+
+}
+
+TEST(Core_Intrin, integer_ops)
+{
+    testIntOps<v_uint8x16>(0, 256);
+    testIntOps<v_int8x16>(-128, 128);
+    testIntOps<v_uint16x8>(0, 65536);
+    testIntOps<v_int16x8>(-32768, 32768);
+    testIntOps<v_uint32x4>(0, 4294967295.);
+    testIntOps<v_int32x4>(INT_MIN, INT_MAX);
+}
+
+TEST(Core_Intrin, absdiff)
+{
+    testAbsDiff<v_uint8x16, v_uint8x16>(0, 256);
+    testAbsDiff<v_int8x16, v_uint8x16>(-128, 128);
+    testAbsDiff<v_uint16x8, v_uint16x8>(0, 65536);
+    testAbsDiff<v_int16x8, v_uint16x8>(-32768, 32768);
+    testAbsDiff<v_int32x4, v_uint32x4>(-1000000, 1000000);
+    testAbsDiff<v_float32x4, v_float32x4>(-1000, 1000);
+}
+
+TEST(Core_Intrin, pack_expand)
+{
+    testPackExpand<v_uint8x16, v_uint16x8>(0, 1000);
+    testPackExpand<v_int8x16, v_int16x8>(-1000, 1000);
+    testPackExpand<v_uint16x8, v_uint32x4>(0, 100000);
+    testPackExpand<v_int16x8, v_int32x4>(-100000, 100000);
+
+    RNG& rng = theRNG();
+    Data<v_int32x4> x, y;
+    x.fill(rng, -100000, 100000);
+    y.fill(rng, -100000, 100000);
+    Data<v_uint16x8> p(v_pack_u(x.load(), y.load()));
+    Data<v_uint8x16> p8(v_pack_u(v_pack(x.load(), y.load()), v_pack(y.load(), x.load())));
+    Data<v_int16x8> s0, s1;
+    s0.fill(rng, -32768, 32768);
+    s1.fill(rng, -32768, 32768);
+    v_int32x4 m0, m1;
+    v_mul_expand(s0.load(), s1.load(), m0, m1);
+    Data<v_int32x4> mlo(m0), mhi(m1);
+    for( int i = 0; i < 4; i++ )
+    {
+        ASSERT_EQ((int)s0[i]*s1[i], mlo[i]);
+        ASSERT_EQ((int)s0[i + 4]*s1[i + 4], mhi[i]);
+    }
+
+    for( int i = 0; i < 4; i++ )
+    {
+        ASSERT_EQ(saturate_cast<ushort>(x[i]), p[i]);
+        ASSERT_EQ(saturate_cast<ushort>(y[i]), p[i + 4]);
+        ASSERT_EQ(saturate_cast<uchar>(x[i]), p8[i]);
+        ASSERT_EQ(saturate_cast<uchar>(y[i]), p8[i + 4]);
+    }
+}
+
+TEST(Core_Intrin, float_ops)
+{
+    RNG& rng = theRNG();
+    for( int iter = 0; iter < 100; iter++ )
+    {
+        Data<v_float32x4> x, y;
+        x.fill(rng, -100, 100);
+        y.fill(rng, 1, 100);
+        v_float32x4 vx = x.load(), vy = y.load();
+        Data<v_float32x4> add(vx + vy), mul(vx * vy), div(vx / vy), mn(v_min(vx, vy));
+        Data<v_float32x4> sq(v_sqrt(vy)), ab(v_abs(vx)), gt(vx > vy), mad(v_muladd(vx, vy, vy));
+        Data<v_int32x4> r(v_round(vx)), t(v_trunc(vx));
+        Data<v_float32x4> c(v_cvt_f32(r.load()));
+
+        for( int i = 0; i < 4; i++ )
+        {
+            ASSERT_EQ(x[i] + y[i], add[i]);
+            ASSERT_EQ(x[i] * y[i], mul[i]);
+            ASSERT_NEAR(x[i] / y[i], div[i], 1e-5*std::abs(x[i] / y[i]));
+            ASSERT_EQ(std::min(x[i], y[i]), mn[i]);
+            ASSERT_NEAR(std::sqrt(y[i]), sq[i], 1e-5*std::sqrt(y[i]));
+            ASSERT_EQ(std::abs(x[i]), ab[i]);
+            ASSERT_TRUE(isMask(gt[i], x[i] > y[i]));
+            ASSERT_NEAR(x[i]*y[i] + y[i], mad[i], 1e-4);
+            ASSERT_EQ(cvRound(x[i]), r[i]);
+            ASSERT_EQ((int)x[i], t[i]);
+            ASSERT_EQ((float)r[i], c[i]);
+        }
+        ASSERT_NEAR(x[0] + x[1] + x[2] + x[3], v_reduce_sum(vx), 1e-3);
+    }
+
+    Data<v_int32x4> i32;
+    for( int i = 0; i < 4; i++ )
+        i32[i] = i*1000 - 1000;
+    ASSERT_EQ(2000, v_reduce_sum(i32.load()));
+    Data<v_int32x4> shl(i32.load() << 3), shr(i32.load() >> 2);
+    for( int i = 0; i < 4; i++ )
+    {
+        ASSERT_EQ(i32[i] * 8, shl[i]);
+        ASSERT_EQ(i32[i] >> 2, shr[i]);
+    }
+}
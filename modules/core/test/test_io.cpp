@@ -91,7 +91,7 @@ protected:
             {-1000000, 1000000}, {-10, 10}, {-10, 10}};
         RNG& rng = ts->get_rng();
         RNG rng0;
-        test_case_count = 4;
+        test_case_count = 6;
         int progress = 0;
         MemStorage storage(cvCreateMemStorage(0));
 
@@ -102,8 +102,8 @@ protected:
 
             cvClearMemStorage(storage);
 
-            bool mem = (idx % 4) >= 2;
-            string filename = tempfile(idx % 2 ? ".yml" : ".xml");
+            bool mem = idx >= 3;
+            string filename = tempfile(idx % 3 == 0 ? ".xml" : idx % 3 == 1 ? ".yml" : ".bin");
 
             FileStorage fs(filename, FileStorage::WRITE + (mem ? FileStorage::MEMORY : 0));
 
@@ -454,3 +454,102 @@ protected:
 TEST(Core_InputOutput, huge) { CV_BigMatrixIOTest test; test.safe_run(); }
 */
 
+
+TEST(Core_InputOutput, binary_storage)
+{
+    const char* names[] = { ".bin", ".bin.gz" };
+    for( int k = 0; k < 3; k++ )
+    {
+        bool mem = k == 2;
+        string filename = tempfile(names[k % 2]);
+        Mat m(300, 200, CV_32FC3), roi, big(1, 1000000, CV_8U), m2, big2, roi2;
+        randu(m, Scalar::all(-100), Scalar::all(100));
+        randu(big, Scalar::all(0), Scalar::all(256));
+        roi = m(Rect(10, 20, 30, 40));
+        vector<int> v(100), v2;
+        for( size_t i = 0; i < v.size(); i++ )
+            v[i] = (int)(i*i) - 1000;
+
+        FileStorage fs(filename, FileStorage::WRITE + (mem ? FileStorage::MEMORY : 0));
+        fs << "m" << m << "roi" << roi << "big" << big << "v" << v;
+        fs << "info" << "{" << "name" << "model" << "scale" << 0.5 << "ids" << "[:" << 3 << 4 << "]" << "}";
+        string content = fs.releaseAndGetString();
+        if( mem )
+        {
+            ASSERT_EQ(0, memcmp(content.c_str(), "CVFSBIN1", 8));
+        }
+
+        ASSERT_TRUE(fs.open(mem ? content : filename, FileStorage::READ + (mem ? FileStorage::MEMORY : 0)));
+        fs["m"] >> m2;
+        fs["roi"] >> roi2;
+        fs["big"] >> big2;
+        fs["v"] >> v2;
+        EXPECT_EQ(0, norm(m, m2, NORM_INF));
+        EXPECT_EQ(0, norm(roi, roi2, NORM_INF));
+        EXPECT_EQ(0, norm(big, big2, NORM_INF));
+        EXPECT_EQ(v, v2);
+
+        FileNode info = fs["info"];
+        EXPECT_EQ("model", (string)info["name"]);
+        EXPECT_EQ(0.5, (double)info["scale"]);
+        EXPECT_EQ(2, (int)info["ids"].size());
+        EXPECT_EQ(4, (int)info["ids"][1]);
+
+        // the matrix elements are still accessible as nodes
+        FileNode data = fs["m"]["data"];
+        ASSERT_EQ(m.total()*3, data.size());
+        EXPECT_EQ(m.at<Vec3f>(0, 1)[2], (float)data[5]);
+        vector<float> row;
+        data >> row;
+        ASSERT_EQ(m.total()*3, row.size());
+        EXPECT_EQ(0, norm(m.reshape(1, 1), Mat(row).reshape(1, 1), NORM_INF));
+
+        fs.release();
+        if( !mem )
+            remove(filename.c_str());
+    }
+}
+
+TEST(Core_InputOutput, binary_storage_errors)
+{
+    string filename = tempfile(".bin");
+    {
+        FileStorage fs(filename, FileStorage::WRITE);
+        fs << "a" << 1 << "b" << Mat::eye(4, 4, CV_64F);
+    }
+    FILE* f = fopen(filename.c_str(), "r+b");
+    ASSERT_TRUE(f != 0);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+
+    // the same content is written to memory
+    string content;
+    {
+        FileStorage fs(filename, FileStorage::WRITE + FileStorage::MEMORY);
+        fs << "a" << 1 << "b" << Mat::eye(4, 4, CV_64F);
+        content = fs.releaseAndGetString();
+    }
+    ASSERT_EQ((size_t)size, content.size());
+    {
+        FileStorage fs(content, FileStorage::READ + FileStorage::MEMORY);
+        ASSERT_TRUE(fs.isOpened());
+        EXPECT_EQ(1, (int)fs["a"]);
+    }
+
+    // truncated storage
+    f = fopen(filename.c_str(), "wb");
+    fwrite(content.data(), 1, content.size() - 10, f);
+    fclose(f);
+    EXPECT_THROW(FileStorage(filename, FileStorage::READ), cv::Exception);
+
+    // truncated in-memory storage, also shorter than the header;
+    // the C API takes the length of the buffer from strlen(), which stops inside the header
+    EXPECT_THROW(FileStorage(content.substr(0, content.size() - 10), FileStorage::READ + FileStorage::MEMORY), cv::Exception);
+    EXPECT_THROW(FileStorage(content.substr(0, 12), FileStorage::READ + FileStorage::MEMORY), cv::Exception);
+    EXPECT_THROW(cvOpenFileStorage(content.c_str(), 0, CV_STORAGE_READ + CV_STORAGE_MEMORY), cv::Exception);
+
+    // appending is not supported
+    EXPECT_THROW(FileStorage(filename, FileStorage::APPEND), cv::Exception);
+    remove(filename.c_str());
+}
@@ -1111,3 +1111,129 @@ TEST(Core_Mat, reshape_1942)
     );
     ASSERT_EQ(1, cn);
 }
+
+TEST(Core_MatPool, reuse_and_trim)
+{
+    trimMatPool();
+    resetMatPoolStats();
+    {
+        MatAllocatorScope scope(getPoolMatAllocator());
+        for( int i = 0; i < 10; i++ )
+        {
+            Mat m(480, 640, CV_8UC3);
+            ASSERT_EQ(getPoolMatAllocator(), m.allocator);
+            m.setTo(Scalar::all(i));
+            ASSERT_EQ(i, m.at<Vec3b>(479, 639)[2]);
+        }
+        Mat m1(Size(640, 470), CV_8UC3), m2(Size(640, 480), CV_8UC3); // same size class
+    }
+    MatPoolStats stats = getMatPoolStats();
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(10u, stats.hits);
+    EXPECT_EQ(2u, stats.cachedBlocks);
+    EXPECT_LE((size_t)640*480*3*2, stats.cachedBytes);
+
+    Mat m(480, 640, CV_8UC3);
+    EXPECT_TRUE(m.allocator == 0);
+
+    trimMatPool();
+    stats = getMatPoolStats();
+    EXPECT_EQ(0u, stats.cachedBlocks);
+    EXPECT_EQ(0u, stats.cachedBytes);
+}
+
+TEST(Core_MatPool, default_allocator)
+{
+    Mat::setDefaultAllocator(getPoolMatAllocator());
+    Mat a(100, 100, CV_32FC2, Scalar::all(1)), b;
+    Mat::setDefaultAllocator(0);
+    ASSERT_EQ(getPoolMatAllocator(), a.allocator);
+
+    // matrices allocated by the pool keep using it
+    a.create(200, 50, CV_64F);
+    ASSERT_EQ(getPoolMatAllocator(), a.allocator);
+    ASSERT_TRUE(a.isContinuous());
+
+    b.create(100, 100, CV_8U);
+    ASSERT_TRUE(b.allocator == 0);
+    trimMatPool();
+}
+
+TEST(Core_MappedMat, write_and_map)
+{
+    string filename = tempfile(".cvmat");
+    Mat src(480, 640, CV_16SC3);
+    randu(src, Scalar::all(-1000), Scalar::all(1000));
+    writeMappedMat(filename, src(Rect(10, 20, 300, 200)));
+    {
+        Mat m = mapMat(filename);
+        ASSERT_EQ(CV_16SC3, m.type());
+        ASSERT_EQ(Size(300, 200), m.size());
+        ASSERT_TRUE(m.isContinuous());
+        ASSERT_EQ(0, (int)((size_t)m.data % 64));
+        ASSERT_EQ(0, norm(src(Rect(10, 20, 300, 200)), m, NORM_INF));
+
+        // ROIs keep the mapping alive
+        Mat roi = m(Rect(5, 5, 50, 50));
+        m.release();
+        ASSERT_EQ(0, norm(src(Rect(15, 25, 50, 50)), roi, NORM_INF));
+
+        // re-allocating the matrix drops the mapping
+        roi.create(10, 10, CV_8U);
+        roi.setTo(Scalar::all(1));
+        ASSERT_EQ(100, countNonZero(roi));
+    }
+
+    int sizes[] = { 4, 5, 6 };
+    Mat nd(3, sizes, CV_32F);
+    randu(nd, Scalar::all(0), Scalar::all(1));
+    writeMappedMat(filename, nd);
+    Mat m = mapMat(filename);
+    ASSERT_EQ(3, m.dims);
+    ASSERT_EQ(0, norm(nd, m, NORM_INF));
+    m.release();
+
+    remove(filename.c_str());
+    ASSERT_TRUE(mapMat(filename).empty());
+}
+
+TEST(Core_MappedMat, modes)
+{
+    string filename = tempfile(".cvmat");
+    Mat src(100, 100, CV_8U, Scalar::all(7));
+    writeMappedMat(filename, src);
+    {
+        Mat m = mapMat(filename, MAP_COPY_ON_WRITE);
+        m.setTo(Scalar::all(1));
+        ASSERT_EQ(0, norm(m, Mat(100, 100, CV_8U, Scalar::all(1)), NORM_INF));
+    }
+    {
+        Mat m = mapMat(filename, MAP_READ_WRITE);
+        ASSERT_EQ(0, norm(src, m, NORM_INF)); // the private copy was not written back
+        m(Rect(0, 0, 10, 10)).setTo(Scalar::all(3));
+    }
+    Mat m = mapMat(filename);
+    ASSERT_EQ(100, countNonZero(m == 3));
+    ASSERT_EQ(9900, countNonZero(m == 7));
+    m.release();
+    remove(filename.c_str());
+}
+
+TEST(Core_MappedMat, raw_data)
+{
+    string filename = tempfile(".raw");
+    Mat src(50, 40, CV_32SC2);
+    randu(src, Scalar::all(-100), Scalar::all(100));
+    FILE* f = fopen(filename.c_str(), "wb");
+    ASSERT_TRUE(f != 0);
+    fputs("header", f);
+    fwrite(src.data, 1, src.total()*src.elemSize(), f);
+    fclose(f);
+
+    Mat m = mapMat(filename, Size(40, 50), CV_32SC2, 6);
+    ASSERT_EQ(0, norm(src, m, NORM_INF));
+    m.release();
+    EXPECT_THROW(mapMat(filename, Size(41, 50), CV_32SC2, 6), cv::Exception);
+    EXPECT_THROW(mapMat(filename), cv::Exception);
+    remove(filename.c_str());
+}
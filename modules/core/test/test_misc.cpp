@@ -39,4 +39,78 @@ TEST(Core_OutputArraySreate, _1997)
     Size submatSize = Size(256, 256);
 
     ASSERT_NO_THROW(local::create( mat(Rect(Point(), submatSize)), submatSize, mat.type() ));
-}
\ No newline at end of file
+}
+
+TEST(Core_MemoryUsage, tracking)
+{
+    setMemoryTracking(true);
+    resetMemoryUsage();
+    MemoryUsage before = getMemoryUsage();
+    {
+        MemoryTagScope tag("Core_MemoryUsage");
+        Mat a(100, 100, CV_8U), b(1000, 1000, CV_32F);
+        MemoryUsage usage = getMemoryUsage();
+        EXPECT_LE(before.currentBytes + 100*100 + 1000*1000*4, usage.currentBytes);
+        EXPECT_LE(2, usage.allocations);
+        EXPECT_LE(1, usage.sizeHistogram[21]); // 4000000 bytes are in [2^21, 2^22)
+    }
+    MemoryUsage usage = getMemoryUsage();
+    setMemoryTracking(false);
+
+    EXPECT_EQ(before.currentBytes, usage.currentBytes);
+    EXPECT_LE(before.currentBytes + 100*100 + 1000*1000*4, usage.peakBytes);
+
+    vector<string> tags;
+    vector<MemoryUsage> tagUsage;
+    getMemoryUsage(tags, tagUsage);
+    ASSERT_EQ(tags.size(), tagUsage.size());
+    size_t idx = std::find(tags.begin(), tags.end(), "Core_MemoryUsage") - tags.begin();
+    ASSERT_LT(idx, tags.size());
+    EXPECT_EQ(0, tagUsage[idx].currentBytes);
+    EXPECT_EQ(2, tagUsage[idx].allocations);
+    EXPECT_EQ(2, tagUsage[idx].deallocations);
+    EXPECT_EQ(1, tagUsage[idx].sizeHistogram[13]); // 10000 bytes
+    EXPECT_EQ(1, tagUsage[idx].sizeHistogram[21]);
+
+    FileStorage fs(".yml", FileStorage::WRITE + FileStorage::MEMORY);
+    writeMemoryUsage(fs, "memory_usage");
+    string buf = fs.releaseAndGetString();
+
+    fs.open(buf, FileStorage::READ + FileStorage::MEMORY);
+    FileNode node = fs["memory_usage"]["tags"][(int)idx];
+    EXPECT_EQ("Core_MemoryUsage", (string)node["tag"]);
+    EXPECT_EQ(2, (int)node["usage"]["allocations"]);
+    EXPECT_EQ(MemoryUsage::MEMORY_HISTOGRAM_SIZE, (int)node["usage"]["size_histogram"].size());
+}
+
+TEST(Core_Trace, chrome_trace_export)
+{
+    clearTrace();
+    setTracing(true);
+    {
+        TraceRegion region("Core_Trace \"region\"");
+        Mat m(100, 100, CV_8U, Scalar::all(1));
+    }
+    setTracing(false);
+    {
+        TraceRegion region("Core_Trace disabled");
+    }
+
+    string filename = tempfile(".json");
+    ASSERT_TRUE(writeTrace(filename));
+    clearTrace();
+
+    string json;
+    FILE* f = fopen(filename.c_str(), "rt");
+    ASSERT_TRUE(f != 0);
+    char buf[1024];
+    for( size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0; )
+        json.append(buf, n);
+    fclose(f);
+    remove(filename.c_str());
+
+    EXPECT_EQ(0u, json.find("{\"traceEvents\":["));
+    EXPECT_NE(string::npos, json.find("\"name\":\"Core_Trace \\\"region\\\"\",\"ph\":\"X\""));
+    EXPECT_EQ(string::npos, json.find("Core_Trace disabled"));
+    EXPECT_NE(string::npos, json.find("\"thread_name\""));
+}
@@ -1197,3 +1197,154 @@ protected:
 };
 
 TEST(Core_SparseMat, iterations) { CV_SparseMatTest test; test.safe_run(); }
+
+namespace
+{
+
+Mat randomMat(RNG& rng, Size sz, int type, double a, double b, bool roi)
+{
+    Mat m(sz.height + (roi ? 2 : 0), sz.width + (roi ? 3 : 0), type);
+    rng.fill(m, RNG::UNIFORM, Scalar::all(a), Scalar::all(b));
+    return roi ? m(Rect(1, 1, sz.width, sz.height)) : m;
+}
+
+double maxDiff(const Mat& a, const Mat& b)
+{
+    EXPECT_EQ(a.type(), b.type());
+    EXPECT_EQ(a.size(), b.size());
+    return a.type() == b.type() && a.size() == b.size() ? norm(a, b, NORM_INF) : DBL_MAX;
+}
+
+}
+
+TEST(Core_MatExpr, fused_elementwise)
+{
+    RNG& rng = theRNG();
+    Size sizes[] = { Size(1, 1), Size(7, 3), Size(1030, 2), Size(320, 240) };
+
+    for( int si = 0; si < (int)(sizeof(sizes)/sizeof(sizes[0])); si++ )
+    for( int roi = 0; roi < 2; roi++ )
+    {
+        Size sz = sizes[si];
+        {
+            Mat a = randomMat(rng, sz, CV_8UC3, 0, 256, roi != 0);
+            Mat b = randomMat(rng, sz, CV_8UC3, 0, 256, roi != 0);
+            Mat c = randomMat(rng, sz, CV_8UC3, 0, 256, roi != 0);
+
+            MatExpr e = a*0.7 + b*0.4 - c;
+            ASSERT_TRUE(e.a.empty() && !e.c.empty());
+            Mat t, ref, r = e;
+            addWeighted(a, 0.7, b, 0.4, 0, t);
+            subtract(t, c, ref);
+            ASSERT_EQ(0., maxDiff(ref, r));
+
+            // intermediate values are saturated like the temporary matrices would be
+            r = (a + b) - (b + c) + Scalar(1, 2, 3);
+            Mat u, w;
+            add(a, b, t);
+            add(b, c, u);
+            subtract(t, u, w);
+            add(w, Scalar(1, 2, 3), ref);
+            ASSERT_EQ(0., maxDiff(ref, r));
+
+            // the scalar is rounded like cv::add() rounds it
+            r = abs(a - b) + Scalar(0.5, 1.5, 2.5);
+            absdiff(a, b, t);
+            add(t, Scalar(0.5, 1.5, 2.5), ref);
+            ASSERT_EQ(0., maxDiff(ref, r));
+
+            r = max(abs(a - b), c) * 2;
+            absdiff(a, b, t);
+            max(t, c, t);
+            t.convertTo(ref, t.type(), 2);
+            ASSERT_EQ(0., maxDiff(ref, r));
+
+            Mat_<Vec3s> rs = a*2 - b.mul(c, 1./255) - Scalar(300, 0, -300);
+            multiply(b, c, t, 1./255);
+            subtract(Mat(a*2), t, w);
+            subtract(w, Scalar(300, 0, -300), w);
+            w.convertTo(ref, CV_16S);
+            ASSERT_EQ(0., maxDiff(ref, rs));
+        }
+        {
+            Mat a = randomMat(rng, sz, CV_16SC1, -1000, 1000, roi != 0);
+            Mat b = randomMat(rng, sz, CV_16SC1, -1000, 1000, roi != 0);
+            Mat c = randomMat(rng, sz, CV_16SC1, 0, 2000, roi != 0);
+
+            Mat r = abs(a - b*2) > c, ref, t;
+            t = Mat(a - b*2);
+            ref = abs(t) > c;
+            ASSERT_EQ(0., maxDiff(ref, r));
+
+            r = min(a + b, 100) <= max(a - c, -100);
+            ref = Mat(min(Mat(a + b), 100)) <= Mat(max(Mat(a - c), -100));
+            ASSERT_EQ(0., maxDiff(ref, r));
+
+            r = 500 < a.mul(b, 0.001) + c;
+            ref = 500 < Mat(Mat(a.mul(b, 0.001)) + c);
+            ASSERT_EQ(0., maxDiff(ref, r));
+
+            // the division itself is computed by cv::divide()
+            Mat_<int> ri = (a - b) / (c + 1) + 10;
+            add(c, Scalar(1), t);
+            divide(Mat(a - b), t, t);
+            add(t, Scalar(10), t);
+            t.convertTo(ref, CV_32S);
+            ASSERT_EQ(0., maxDiff(ref, ri));
+        }
+        {
+            Mat a = randomMat(rng, sz, CV_32FC2, -10, 10, roi != 0);
+            Mat b = randomMat(rng, sz, CV_32FC2, -10, 10, roi != 0);
+            Mat c = randomMat(rng, sz, CV_32FC2, 1, 10, roi != 0);
+
+            Mat r = min(a.mul(b) + c, 0.5) / (abs(a) + 1), ref, t, u;
+            multiply(a, b, t);
+            add(t, c, t);
+            min(t, 0.5, t);
+            u = abs(a);
+            add(u, Scalar(1), u);
+            divide(t, u, ref);
+            ASSERT_EQ(0., maxDiff(ref, r));
+
+            r = 3./(a - c) + a.mul(c)*0.5;
+            divide(3., Mat(a - c), t);
+            multiply(a, c, u, 0.5);
+            add(t, u, ref);
+            ASSERT_EQ(ref.type(), r.type());
+            ASSERT_EQ(0., maxDiff(ref, r));
+        }
+        {
+            Mat a = randomMat(rng, sz, CV_64FC1, -1e6, 1e6, roi != 0);
+            Mat b = randomMat(rng, sz, CV_64FC1, -1e6, 1e6, roi != 0);
+            Mat r = abs(a.mul(b, 1e-3) - a) - 0.25*b, ref;
+            ref = Mat(abs(Mat(Mat(a.mul(b, 1e-3)) - a))) - 0.25*b;
+            ASSERT_EQ(ref.type(), r.type());
+            ASSERT_EQ(0., maxDiff(ref, r));
+        }
+    }
+}
+
+TEST(Core_MatExpr, fused_roi_and_inplace)
+{
+    RNG& rng = theRNG();
+    Mat a = randomMat(rng, Size(50, 40), CV_32FC1, -10, 10, false);
+    Mat b = randomMat(rng, Size(50, 40), CV_32FC1, -10, 10, false);
+    Mat c = randomMat(rng, Size(50, 40), CV_32FC1, -10, 10, false);
+
+    MatExpr e = max(a + b, c) - a.mul(b);
+    Mat full = e;
+    Rect rc(3, 5, 20, 11);
+    ASSERT_EQ(0., maxDiff(full(rc), e(rc)));
+    ASSERT_EQ(0., maxDiff(full.row(7), e.row(7)));
+    ASSERT_EQ(0., maxDiff(full.col(9), e.col(9)));
+    ASSERT_EQ(0., maxDiff(full.diag(), e.diag()));
+    ASSERT_EQ(Size(20, 11), e(rc).size());
+
+    Mat ref = Mat(max(Mat(a + b), c)) - Mat(a.mul(b));
+    a = max(a + b, c) - a.mul(b);
+    ASSERT_EQ(0., maxDiff(ref, a));
+
+    // operands of different types are not fused, the usual error is reported
+    Mat d(a.size(), CV_8U, Scalar(1));
+    EXPECT_THROW(Mat(max(a + b, c) + abs(d - 1)), cv::Exception);
+}
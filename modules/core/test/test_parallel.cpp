@@ -0,0 +1,189 @@
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace
+{
+
+class CountingBody : public ParallelLoopBody
+{
+public:
+    CountingBody(Mat& _counts) : counts(&_counts) {}
+
+    void operator()(const Range& r) const
+    {
+        for( int i = r.start; i < r.end; i++ )
+            CV_XADD(counts->ptr<int>(i), 1);
+    }
+
+protected:
+    Mat* counts;
+};
+
+class NestedBody : public ParallelLoopBody
+{
+public:
+    NestedBody(Mat& _counts) : counts(&_counts) {}
+
+    void operator()(const Range& r) const
+    {
+        for( int i = r.start; i < r.end; i++ )
+        {
+            Mat row = counts->row(i).reshape(1, counts->cols);
+            parallel_for_(Range(0, row.rows), CountingBody(row));
+        }
+    }
+
+protected:
+    Mat* counts;
+};
+
+class ThrowingBody : public ParallelLoopBody
+{
+public:
+    void operator()(const Range& r) const
+    {
+        if( r.start <= 50 && 50 < r.end )
+            CV_Error(CV_StsBadArg, "stripe 50");
+    }
+};
+
+class RecordingBackend : public ParallelForBackend
+{
+public:
+    RecordingBackend() : calls(0), lastMaxThreads(-1), nthreads(3) {}
+
+    void parallel_for(const Range& stripes, const ParallelLoopBody& body, int maxThreads)
+    {
+        calls++;
+        lastMaxThreads = maxThreads;
+        body(stripes);
+    }
+    int getNumThreads() const { return nthreads; }
+    void setNumThreads(int n) { nthreads = n; }
+    int getThreadNum() const { return 0; }
+
+    int calls, lastMaxThreads, nthreads;
+};
+
+class ParallelBackendScope
+{
+public:
+    ParallelBackendScope(const string& name) : prev(getParallelForBackend())
+    {
+        EXPECT_TRUE(setParallelForBackend(name, false));
+    }
+    ~ParallelBackendScope() { setParallelForBackend(prev, false); }
+protected:
+    string prev;
+};
+
+class ParallelThreadsScope
+{
+public:
+    ParallelThreadsScope(int n) : prev(getNumThreads()) { setNumThreads(n); }
+    ~ParallelThreadsScope() { setNumThreads(prev); }
+protected:
+    int prev;
+};
+
+}
+
+TEST(Core_Parallel, each_index_is_processed_once)
+{
+    ParallelThreadsScope scope(4);
+    const int N = 10007;
+    double nstripes[] = { -1., 1., 3., 64., (double)N };
+
+    for( size_t k = 0; k < sizeof(nstripes)/sizeof(nstripes[0]); k++ )
+    {
+        Mat counts(N, 1, CV_32S, Scalar::all(0));
+        parallel_for_(Range(0, N), CountingBody(counts), nstripes[k]);
+        ASSERT_EQ(N, countNonZero(counts == 1)) << "nstripes=" << nstripes[k];
+    }
+}
+
+TEST(Core_Parallel, nested_calls)
+{
+    ParallelThreadsScope scope(4);
+    Mat counts(64, 64, CV_32S, Scalar::all(0));
+    parallel_for_(Range(0, counts.rows), NestedBody(counts));
+    ASSERT_EQ((int)counts.total(), countNonZero(counts == 1));
+}
+
+TEST(Core_Parallel, exception_is_propagated)
+{
+    ParallelThreadsScope scope(4);
+    EXPECT_THROW(parallel_for_(Range(0, 100), ThrowingBody()), cv::Exception);
+
+    Mat counts(100, 1, CV_32S, Scalar::all(0));
+    parallel_for_(Range(0, 100), CountingBody(counts));
+    ASSERT_EQ(100, countNonZero(counts == 1));
+}
+
+TEST(Core_Parallel, backends)
+{
+    vector<string> names;
+    getParallelForBackends(names);
+    ASSERT_NE(names.end(), std::find(names.begin(), names.end(), "serial"));
+    ASSERT_NE(names.end(), std::find(names.begin(), names.end(), getParallelForBackend()));
+    ASSERT_FALSE(setParallelForBackend("no such backend"));
+
+    Ptr<RecordingBackend> backend = new RecordingBackend;
+    registerParallelForBackend("test_recording", backend);
+    {
+        ParallelBackendScope scope("test_recording");
+        ASSERT_EQ("test_recording", getParallelForBackend());
+        ASSERT_EQ(3, getNumThreads());
+
+        Mat counts(100, 1, CV_32S, Scalar::all(0));
+        parallel_for_(Range(0, 100), CountingBody(counts));
+        ASSERT_EQ(1, backend->calls);
+        ASSERT_EQ(0, backend->lastMaxThreads);
+        ASSERT_EQ(100, countNonZero(counts == 1));
+    }
+    {
+        ParallelBackendScope scope("serial");
+        ASSERT_EQ(1, getNumThreads());
+        Mat counts(100, 1, CV_32S, Scalar::all(0));
+        parallel_for_(Range(0, 100), CountingBody(counts));
+        ASSERT_EQ(100, countNonZero(counts == 1));
+    }
+    ASSERT_EQ(1, backend->calls);
+}
+
+TEST(Core_Parallel, thread_budget)
+{
+    Ptr<RecordingBackend> backend = new RecordingBackend;
+    registerParallelForBackend("test_recording", backend);
+    ParallelBackendScope bscope("test_recording");
+    Mat counts(100, 1, CV_32S, Scalar::all(0));
+    {
+        ParallelScope scope(2);
+        ASSERT_EQ(2, getNumThreads());
+        parallel_for_(Range(0, 100), CountingBody(counts));
+        ASSERT_EQ(2, backend->lastMaxThreads);
+        {
+            ParallelScope inner(8); // can't exceed the outer budget
+            parallel_for_(Range(0, 100), CountingBody(counts));
+            ASSERT_EQ(2, backend->lastMaxThreads);
+        }
+        {
+            ParallelScope inner(1); // runs serially without calling the backend
+            parallel_for_(Range(0, 100), CountingBody(counts));
+            ASSERT_EQ(2, backend->calls);
+        }
+    }
+    ASSERT_EQ(3, getNumThreads());
+    ASSERT_EQ(100, countNonZero(counts == 3));
+}
+
+TEST(Core_Parallel, thread_budget_builtin)
+{
+    ParallelThreadsScope tscope(4);
+    ParallelScope scope(2);
+    Mat counts(1000, 1, CV_32S, Scalar::all(0));
+    parallel_for_(Range(0, 1000), CountingBody(counts));
+    ASSERT_EQ(1000, countNonZero(counts == 1));
+}
@@ -340,6 +340,7 @@ Ptr<DescriptorMatcher> BFMatcher::clone( bool emptyTrainData ) const
 void BFMatcher::knnMatchImpl( const Mat& queryDescriptors, vector<vector<DMatch> >& matches, int knn,
                               const vector<Mat>& masks, bool compactResult )
 {
+    CV_TRACE_REGION("BFMatcher::knnMatch");
     const int IMGIDX_SHIFT = 18;
     const int IMGIDX_ONE = (1 << IMGIDX_SHIFT);
 
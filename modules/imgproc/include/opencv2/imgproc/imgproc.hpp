@@ -394,6 +394,9 @@ CV_EXPORTS_W void GaussianBlur( InputArray src,
                                                OutputArray dst, Size ksize,
                                                double sigmaX, double sigmaY=0,
                                                int borderType=BORDER_DEFAULT );
+//! the flag of bilateralFilter(), combined with borderType: approximates the filter in constant time per pixel
+enum { BILATERAL_APPROX=32 };
+
 //! smooths the image using bilateral filter
 CV_EXPORTS_W void bilateralFilter( InputArray src, OutputArray dst, int d,
                                    double sigmaColor, double sigmaSpace,
@@ -561,6 +564,12 @@ CV_EXPORTS_W void resize( InputArray src, OutputArray dst,
                           Size dsize, double fx=0, double fy=0,
                           int interpolation=INTER_LINEAR );
 
+//! converts the color space, resizes the image and scales its values in a single pass over memory:
+//! dst = resize(cvtColor(src, code), dsize)*alpha + beta, optionally with the channels stored as planes
+CV_EXPORTS_W void preprocess( InputArray src, OutputArray dst, Size dsize, int code=-1,
+                              int interpolation=INTER_LINEAR, int dtype=-1,
+                              double alpha=1, double beta=0, bool planar=false );
+
 //! warps the image using affine transformation
 CV_EXPORTS_W void warpAffine( InputArray src, OutputArray dst,
                               InputArray M, Size dsize,
@@ -593,6 +602,31 @@ CV_EXPORTS_W void convertMaps( InputArray map1, InputArray map2,
                                OutputArray dstmap1, OutputArray dstmap2,
                                int dstmap1type, bool nninterpolation=false );
 
+//! fixed-point maps of a geometric transformation, computed once and then applied to many images
+class CV_EXPORTS WarpPlan
+{
+public:
+    WarpPlan();
+    //! computes the maps of warpAffine() with the 2x3 matrix M, dsize and flags
+    void initAffine(InputArray M, Size dsize, int flags=INTER_LINEAR);
+    //! computes the maps of warpPerspective() with the 3x3 matrix M, dsize and flags
+    void initPerspective(InputArray M, Size dsize, int flags=INTER_LINEAR);
+    //! stores the maps of remap(), converting them to the fixed-point format if needed
+    void initRemap(InputArray map1, InputArray map2, int interpolation);
+    //! warps the image; the result is the same as of the corresponding warpAffine(), warpPerspective() or remap() call
+    void apply(InputArray src, OutputArray dst, int borderMode=BORDER_CONSTANT,
+               const Scalar& borderValue=Scalar()) const;
+    //! the size of the output images
+    Size size() const;
+    bool empty() const;
+
+protected:
+    void create(Size dsize, int flags);
+
+    Mat map1, map2;
+    int interpolation;
+};
+
 //! returns 2x3 affine transformation matrix for the planar rotation.
 CV_EXPORTS_W Mat getRotationMatrix2D( Point2f center, double angle, double scale );
 //! returns 3x3 perspective transformation for the corresponding 4 point pairs.
@@ -619,6 +653,9 @@ CV_EXPORTS_AS(integral2) void integral( InputArray src, OutputArray sum,
 CV_EXPORTS_AS(integral3) void integral( InputArray src, OutputArray sum,
                                         OutputArray sqsum, OutputArray tilted,
                                         int sdepth=-1 );
+//! computes the requested integral images; sqsum can be CV_32S for not too large 8-bit images
+CV_EXPORTS void integral( InputArray src, OutputArray sum, OutputArray sqsum,
+                          OutputArray tilted, int sdepth, int sqdepth );
 
 //! adds image to the accumulator (dst += src). Unlike cv::add, dst and src can have different types.
 CV_EXPORTS_W void accumulate( InputArray src, InputOutputArray dst,
@@ -757,6 +794,56 @@ CV_EXPORTS double compareHist( const SparseMat& H1, const SparseMat& H2, int met
 //! normalizes the grayscale image brightness and contrast by normalizing its histogram
 CV_EXPORTS_W void equalizeHist( InputArray src, OutputArray dst );
 
+/*!
+ Histogram, mean and standard deviation of a window sliding over an 8-bit single-channel image.
+
+ The window is moved in the raster order. Every image column keeps the histogram and the sums of
+ the pixels of the window rows (Huang's algorithm), so moving the window one pixel to the right
+ costs O(256) operations and moving it to the next row costs O(image width) operations,
+ independently of the window size. The pixels outside of the image are taken from the
+ replicated border.
+*/
+class CV_EXPORTS SlidingWindowStats
+{
+public:
+    //! the default constructor
+    SlidingWindowStats();
+    //! the full constructor, see init()
+    SlidingWindowStats(const Mat& image, Size winSize);
+    //! attaches the image (the data is not copied) and sets the window size; both dimensions must be odd
+    void init(const Mat& image, Size winSize);
+
+    //! places the window center at the beginning of the row y
+    void setRow(int y);
+    //! moves the window one pixel to the right
+    void moveRight();
+
+    //! the current window center
+    Point center() const;
+    //! the number of pixels in the window
+    int count() const;
+    //! the window histogram, 256 bins
+    const int* hist() const;
+    //! the median of the window pixels
+    int median() const;
+    //! the mean of the window pixels
+    double mean() const;
+    //! the standard deviation of the window pixels
+    double stddev() const;
+
+protected:
+    Mat image;
+    Size winSize;
+    Point pos;
+    vector<int> colHist;
+    vector<int> colSum;
+    vector<int64> colSqSum;
+    int H[256];
+    int64 sum, sqsum;
+
+    void addColumn(int x, int delta);
+};
+
 CV_EXPORTS float EMD( InputArray signature1, InputArray signature2,
                       int distType, InputArray cost=noArray(),
                       float* lowerBound=0, OutputArray flow=noArray() );
@@ -1102,6 +1189,36 @@ enum { TM_SQDIFF=0, TM_SQDIFF_NORMED=1, TM_CCORR=2, TM_CCORR_NORMED=3, TM_CCOEFF
 CV_EXPORTS_W void matchTemplate( InputArray image, InputArray templ,
                                  OutputArray result, int method );
 
+//! matches a fixed set of templates against a sequence of images of the same size and type
+class CV_EXPORTS TemplateMatcher
+{
+public:
+    //! the default constructor
+    TemplateMatcher();
+    //! the full constructor, see init()
+    TemplateMatcher(Size imageSize, int imageType, const vector<Mat>& templates, int method);
+    //! precomputes the spectra and the statistics of the templates for the given image size, type and method
+    void init(Size imageSize, int imageType, const vector<Mat>& templates, int method);
+    //! computes the proximity map of every template, the same as matchTemplate() does
+    void match(const Mat& image, vector<Mat>& results) const;
+
+protected:
+    struct Templ
+    {
+        Size size;
+        Mat data, coeffs, spectrum;
+        Scalar mean;
+        double norm, sum2;
+        bool constant;
+    };
+
+    Size imageSize;
+    int imageType;
+    int method;
+    Size maxTemplSize, corrSize, blockSize, dftSize;
+    vector<Templ> templs;
+};
+
 enum { CC_STAT_LEFT=0, CC_STAT_TOP=1, CC_STAT_WIDTH=2, CC_STAT_HEIGHT=3, CC_STAT_AREA=4, CC_STAT_MAX = 5};
 
 // computes the connected components labeled image of boolean image ``image``
@@ -1144,6 +1261,10 @@ CV_EXPORTS_W void findContours( InputOutputArray image, OutputArrayOfArrays cont
 CV_EXPORTS void findContours( InputOutputArray image, OutputArrayOfArrays contours,
                               int mode, int method, Point offset=Point());
 
+//! retrieves the contours of every connected component in parallel; only RETR_EXTERNAL and RETR_LIST are supported
+CV_EXPORTS void findContoursParallel( InputArray image, CV_OUT vector<vector<Point> >& contours,
+                                      int mode, int method, Point offset=Point());
+
 //! approximates contour or a curve using Douglas-Peucker algorithm
 CV_EXPORTS_W void approxPolyDP( InputArray curve,
                                 OutputArray approxCurve,
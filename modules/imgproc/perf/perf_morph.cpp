@@ -38,3 +38,46 @@ PERF_TEST_P(Size_MatType, dilate, TYPICAL_MATS_MORPH)
 
     SANITY_CHECK(dst);
 }
+
+typedef std::tr1::tuple<Size, MatType, int> Size_MatType_KSize_t;
+typedef perf::TestBaseWithParam<Size_MatType_KSize_t> Size_MatType_KSize;
+
+PERF_TEST_P(Size_MatType_KSize, erode_rect,
+            testing::Combine(testing::Values(szVGA, sz1080p),
+                             testing::Values(CV_8UC1, CV_8UC4, CV_32FC1),
+                             testing::Values(5, 15, 31, 63)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    int ksize = get<2>(GetParam());
+
+    Mat src(sz, type);
+    Mat dst(sz, type);
+    Mat kernel = getStructuringElement(MORPH_RECT, Size(ksize, ksize));
+
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE() erode(src, dst, kernel);
+
+    SANITY_CHECK(dst);
+}
+
+PERF_TEST_P(Size_MatType_KSize, dilate_line,
+            testing::Combine(testing::Values(szVGA, sz1080p),
+                             testing::Values(CV_8UC1, CV_32FC1),
+                             testing::Values(15, 63, 127)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+    int ksize = get<2>(GetParam());
+
+    Mat src(sz, type);
+    Mat dst(sz, type);
+    Mat kernel = getStructuringElement(MORPH_RECT, Size(ksize, 1));
+
+    declare.in(src, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE() dilate(src, dst, kernel);
+
+    SANITY_CHECK(dst);
+}
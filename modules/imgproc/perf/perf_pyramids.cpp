@@ -43,3 +43,24 @@ PERF_TEST_P(Size_MatType, pyrUp, testing::Combine(
 
     SANITY_CHECK(dst);
 }
+
+PERF_TEST_P(Size_MatType, buildPyramid, testing::Combine(
+                testing::Values(sz1080p, sz720p, szVGA),
+                testing::Values(CV_8UC1, CV_8UC3, CV_32FC1)
+                )
+            )
+{
+    Size sz = get<0>(GetParam());
+    int matType = get<1>(GetParam());
+    const int maxlevel = 4;
+
+    Mat src(sz, matType);
+    vector<Mat> pyr;
+
+    declare.in(src, WARMUP_RNG);
+
+    TEST_CYCLE() buildPyramid(src, pyr, maxlevel);
+
+    Mat dst = pyr[maxlevel];
+    SANITY_CHECK(dst);
+}
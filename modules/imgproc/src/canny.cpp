@@ -40,6 +40,330 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/intrin.hpp"
+
+namespace cv
+{
+
+/* sector numbers
+   (Top-Left Origin)
+
+    1   2   3
+     *  *  *
+      * * *
+    0*******0
+      * * *
+     *  *  *
+    3   2   1
+*/
+
+#define CANNY_SHIFT 15
+#define CANNY_PUSH(d)    *(d) = uchar(2), *stack_top++ = (d)
+#define CANNY_POP(d)     (d) = *--stack_top
+
+// Computes the gradient magnitude of the i-th row into _norm (_norm[-1] and _norm[cols]
+// are set to 0). For multi-channel images the channel with the largest magnitude is
+// selected and its derivatives are stored to _cdx/_cdy; the source rows are left intact,
+// since the neighbouring bands read them as well.
+static void cannyMagnitudeRow( const Mat& dx, const Mat& dy, int i, bool L2gradient,
+                               int* _norm, short* _cdx, short* _cdy )
+{
+    int cols = dx.cols, cn = dx.channels(), width = cols*cn, j = 0;
+    const short* _dx = dx.ptr<short>(i);
+    const short* _dy = dy.ptr<short>(i);
+
+#if CV_SIMD128
+    if( hasSIMD128() )
+    {
+        if( !L2gradient )
+        {
+            v_int16x8 z = v_setzero_s16();
+            for( ; j <= width - 8; j += 8 )
+            {
+                v_uint32x4 x0, x1, y0, y1;
+                v_expand(v_absdiff(v_load(_dx + j), z), x0, x1);
+                v_expand(v_absdiff(v_load(_dy + j), z), y0, y1);
+                v_store(_norm + j, v_reinterpret_as_s32(x0 + y0));
+                v_store(_norm + j + 4, v_reinterpret_as_s32(x1 + y1));
+            }
+        }
+        else
+        {
+            for( ; j <= width - 8; j += 8 )
+            {
+                v_int16x8 vdx = v_load(_dx + j), vdy = v_load(_dy + j);
+                v_int32x4 x0, x1, y0, y1;
+                v_mul_expand(vdx, vdx, x0, x1);
+                v_mul_expand(vdy, vdy, y0, y1);
+                v_store(_norm + j, x0 + y0);
+                v_store(_norm + j + 4, x1 + y1);
+            }
+        }
+    }
+#endif
+
+    if( !L2gradient )
+    {
+        for( ; j < width; j++ )
+            _norm[j] = std::abs(int(_dx[j])) + std::abs(int(_dy[j]));
+    }
+    else
+    {
+        for( ; j < width; j++ )
+            _norm[j] = int(_dx[j])*_dx[j] + int(_dy[j])*_dy[j];
+    }
+
+    if( cn > 1 )
+    {
+        for( j = 0; j < cols; j++ )
+        {
+            int jn = j*cn, maxIdx = jn;
+            for( int k = 1; k < cn; k++ )
+                if( _norm[jn + k] > _norm[maxIdx] ) maxIdx = jn + k;
+            _norm[j] = _norm[maxIdx];
+            _cdx[j] = _dx[maxIdx];
+            _cdy[j] = _dy[maxIdx];
+        }
+    }
+    _norm[-1] = _norm[cols] = 0;
+}
+
+// Runs the non-maxima suppression and the hysteresis tracking on a horizontal band of
+// rows. The band writes only its own rows of the map; the neighbours of its edge pixels
+// that lie in the adjacent bands are collected and handed to the caller, which completes
+// the tracking across the band boundaries once all the bands are done.
+class CannyBandInvoker : public ParallelLoopBody
+{
+public:
+    CannyBandInvoker( const Mat& _dx, const Mat& _dy, uchar* _map, ptrdiff_t _mapstep,
+                      int _low, int _high, bool _L2gradient,
+                      std::vector<uchar*>* _boundary, Mutex* _mutex )
+        : dx(_dx), dy(_dy), map(_map), mapstep(_mapstep), low(_low), high(_high),
+          L2gradient(_L2gradient), boundary(_boundary), mutex(_mutex)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int rows = dx.rows, cols = dx.cols, cn = dx.channels();
+        int r0 = range.start, r1 = range.end;
+        const int TG22 = (int)(0.4142135623730950488016887242097*(1<<CANNY_SHIFT) + 0.5);
+
+        AutoBuffer<int> magbuf(mapstep*cn*3);
+        AutoBuffer<short> dbuf(cols*6);
+        int* mag_buf[3];
+        short* dx_buf[3];
+        short* dy_buf[3];
+        for( int k = 0; k < 3; k++ )
+        {
+            mag_buf[k] = (int*)magbuf + mapstep*cn*k;
+            dx_buf[k] = (short*)dbuf + cols*k*2;
+            dy_buf[k] = dx_buf[k] + cols;
+        }
+
+        // the ring buffer starts with the rows r0-1 and r0
+        if( r0 > 0 )
+            cannyMagnitudeRow(dx, dy, r0-1, L2gradient, mag_buf[0] + 1, dx_buf[0], dy_buf[0]);
+        else
+            memset(mag_buf[0], 0, mapstep*sizeof(int));
+        cannyMagnitudeRow(dx, dy, r0, L2gradient, mag_buf[1] + 1, dx_buf[1], dy_buf[1]);
+
+        int maxsize = std::max(1 << 10, cols*(r1 - r0)/10);
+        std::vector<uchar*> stack(maxsize);
+        uchar **stack_top = &stack[0];
+        uchar **stack_bottom = &stack[0];
+
+        // calculate magnitude and angle of gradient, perform non-maxima supression.
+        // fill the map with one of the following values:
+        //   0 - the pixel might belong to an edge
+        //   1 - the pixel can not belong to an edge
+        //   2 - the pixel does belong to an edge
+        for( int i = r0 + 1; i <= r1; i++ )
+        {
+            if( i < rows )
+                cannyMagnitudeRow(dx, dy, i, L2gradient, mag_buf[2] + 1, dx_buf[2], dy_buf[2]);
+            else
+                memset(mag_buf[2], 0, mapstep*sizeof(int));
+
+            uchar* _map = map + mapstep*i + 1;
+            _map[-1] = _map[cols] = 1;
+
+            int* _mag = mag_buf[1] + 1; // take the central row
+            ptrdiff_t magstep1 = mag_buf[2] - mag_buf[1];
+            ptrdiff_t magstep2 = mag_buf[0] - mag_buf[1];
+
+            const short* _x = cn > 1 ? dx_buf[1] : dx.ptr<short>(i-1);
+            const short* _y = cn > 1 ? dy_buf[1] : dy.ptr<short>(i-1);
+
+            // the row above the band belongs to another band and may be modified concurrently
+            bool checkAbove = i > r0 + 1;
+
+            if( (stack_top - stack_bottom) + cols > maxsize )
+            {
+                int sz = (int)(stack_top - stack_bottom);
+                maxsize = maxsize * 3/2;
+                stack.resize(maxsize);
+                stack_bottom = &stack[0];
+                stack_top = stack_bottom + sz;
+            }
+
+            int prev_flag = 0;
+            for( int j = 0; j < cols; j++ )
+            {
+                int m = _mag[j];
+
+                if( m > low )
+                {
+                    int xs = _x[j];
+                    int ys = _y[j];
+                    int x = std::abs(xs);
+                    int y = std::abs(ys) << CANNY_SHIFT;
+
+                    int tg22x = x * TG22;
+
+                    if( y < tg22x )
+                    {
+                        if( m > _mag[j-1] && m >= _mag[j+1] ) goto __ocv_canny_push;
+                    }
+                    else
+                    {
+                        int tg67x = tg22x + (x << (CANNY_SHIFT+1));
+                        if( y > tg67x )
+                        {
+                            if( m > _mag[j+magstep2] && m >= _mag[j+magstep1] ) goto __ocv_canny_push;
+                        }
+                        else
+                        {
+                            int s = (xs ^ ys) < 0 ? -1 : 1;
+                            if( m > _mag[j+magstep2-s] && m > _mag[j+magstep1+s] ) goto __ocv_canny_push;
+                        }
+                    }
+                }
+                prev_flag = 0;
+                _map[j] = uchar(1);
+                continue;
+__ocv_canny_push:
+                if( !prev_flag && m > high && (!checkAbove || _map[j-mapstep] != 2) )
+                {
+                    CANNY_PUSH(_map + j);
+                    prev_flag = 1;
+                }
+                else
+                    _map[j] = 0;
+            }
+
+            // scroll the ring buffers
+            std::swap(mag_buf[0], mag_buf[1]);
+            std::swap(mag_buf[1], mag_buf[2]);
+            std::swap(dx_buf[0], dx_buf[1]);
+            std::swap(dx_buf[1], dx_buf[2]);
+            std::swap(dy_buf[0], dy_buf[1]);
+            std::swap(dy_buf[1], dy_buf[2]);
+        }
+
+        // now track the edges (hysteresis thresholding) inside the band
+        const uchar* top = map + mapstep*(r0 + 2);
+        const uchar* bottom = map + mapstep*r1;
+        bool crossTop = r0 > 0, crossBottom = r1 < rows;
+        std::vector<uchar*> outside;
+
+        while( stack_top > stack_bottom )
+        {
+            uchar* m;
+            if( (stack_top - stack_bottom) + 8 > maxsize )
+            {
+                int sz = (int)(stack_top - stack_bottom);
+                maxsize = maxsize * 3/2;
+                stack.resize(maxsize);
+                stack_bottom = &stack[0];
+                stack_top = stack_bottom + sz;
+            }
+
+            CANNY_POP(m);
+
+            if( !m[-1] )        CANNY_PUSH(m - 1);
+            if( !m[1] )         CANNY_PUSH(m + 1);
+            if( m >= top || !crossTop )
+            {
+                if( !m[-mapstep-1] ) CANNY_PUSH(m - mapstep - 1);
+                if( !m[-mapstep] )   CANNY_PUSH(m - mapstep);
+                if( !m[-mapstep+1] ) CANNY_PUSH(m - mapstep + 1);
+            }
+            else
+            {
+                outside.push_back(m - mapstep - 1);
+                outside.push_back(m - mapstep);
+                outside.push_back(m - mapstep + 1);
+            }
+            if( m < bottom || !crossBottom )
+            {
+                if( !m[mapstep-1] )  CANNY_PUSH(m + mapstep - 1);
+                if( !m[mapstep] )    CANNY_PUSH(m + mapstep);
+                if( !m[mapstep+1] )  CANNY_PUSH(m + mapstep + 1);
+            }
+            else
+            {
+                outside.push_back(m + mapstep - 1);
+                outside.push_back(m + mapstep);
+                outside.push_back(m + mapstep + 1);
+            }
+        }
+
+        if( !outside.empty() )
+        {
+            AutoLock lock(*mutex);
+            boundary->insert(boundary->end(), outside.begin(), outside.end());
+        }
+    }
+
+private:
+    Mat dx, dy;
+    uchar* map;
+    ptrdiff_t mapstep;
+    int low, high;
+    bool L2gradient;
+    std::vector<uchar*>* boundary;
+    Mutex* mutex;
+};
+
+// the final pass, form the final image
+class CannyFinalInvoker : public ParallelLoopBody
+{
+public:
+    CannyFinalInvoker( const uchar* _map, ptrdiff_t _mapstep, const Mat& _dst )
+        : map(_map), mapstep(_mapstep), dst(_dst)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        Mat _dst = dst;
+        int cols = _dst.cols;
+        for( int i = range.start; i < range.end; i++ )
+        {
+            const uchar* pmap = map + mapstep*(i + 1) + 1;
+            uchar* pdst = _dst.ptr(i);
+            int j = 0;
+#if CV_SIMD128
+            if( hasSIMD128() )
+            {
+                v_uint8x16 v2 = v_setall_u8(2);
+                for( ; j <= cols - 16; j += 16 )
+                    v_store(pdst + j, v_load(pmap + j) == v2);
+            }
+#endif
+            for( ; j < cols; j++ )
+                pdst[j] = (uchar)-(pmap[j] >> 1);
+        }
+    }
+
+private:
+    const uchar* map;
+    ptrdiff_t mapstep;
+    Mat dst;
+};
+
+}
 
 void cv::Canny( InputArray _src, OutputArray _dst,
                 double low_thresh, double high_thresh,
@@ -66,6 +390,9 @@ void cv::Canny( InputArray _src, OutputArray _dst,
         return;
 #endif
 
+    if (src.empty())
+        return;
+
     const int cn = src.channels();
     cv::Mat dx(src.rows, src.cols, CV_16SC(cn));
     cv::Mat dy(src.rows, src.cols, CV_16SC(cn));
@@ -88,191 +415,49 @@ void cv::Canny( InputArray _src, OutputArray _dst,
     int high = cvFloor(high_thresh);
 
     ptrdiff_t mapstep = src.cols + 2;
-    cv::AutoBuffer<uchar> buffer((src.cols+2)*(src.rows+2) + cn * mapstep * 3 * sizeof(int));
-
-    int* mag_buf[3];
-    mag_buf[0] = (int*)(uchar*)buffer;
-    mag_buf[1] = mag_buf[0] + mapstep*cn;
-    mag_buf[2] = mag_buf[1] + mapstep*cn;
-    memset(mag_buf[0], 0, /* cn* */mapstep*sizeof(int));
+    cv::AutoBuffer<uchar> buffer((src.cols+2)*(src.rows+2));
 
-    uchar* map = (uchar*)(mag_buf[2] + mapstep*cn);
+    uchar* map = (uchar*)buffer;
     memset(map, 1, mapstep);
     memset(map + mapstep*(src.rows + 1), 1, mapstep);
 
-    int maxsize = std::max(1 << 10, src.cols * src.rows / 10);
-    std::vector<uchar*> stack(maxsize);
-    uchar **stack_top = &stack[0];
-    uchar **stack_bottom = &stack[0];
-
-    /* sector numbers
-       (Top-Left Origin)
-
-        1   2   3
-         *  *  *
-          * * *
-        0*******0
-          * * *
-         *  *  *
-        3   2   1
-    */
-
-    #define CANNY_PUSH(d)    *(d) = uchar(2), *stack_top++ = (d)
-    #define CANNY_POP(d)     (d) = *--stack_top
-
-    // calculate magnitude and angle of gradient, perform non-maxima supression.
-    // fill the map with one of the following values:
-    //   0 - the pixel might belong to an edge
-    //   1 - the pixel can not belong to an edge
-    //   2 - the pixel does belong to an edge
-    for (int i = 0; i <= src.rows; i++)
-    {
-        int* _norm = mag_buf[(i > 0) + 1] + 1;
-        if (i < src.rows)
-        {
-            short* _dx = dx.ptr<short>(i);
-            short* _dy = dy.ptr<short>(i);
-
-            if (!L2gradient)
-            {
-                for (int j = 0; j < src.cols*cn; j++)
-                    _norm[j] = std::abs(int(_dx[j])) + std::abs(int(_dy[j]));
-            }
-            else
-            {
-                for (int j = 0; j < src.cols*cn; j++)
-                    _norm[j] = int(_dx[j])*_dx[j] + int(_dy[j])*_dy[j];
-            }
-
-            if (cn > 1)
-            {
-                for(int j = 0, jn = 0; j < src.cols; ++j, jn += cn)
-                {
-                    int maxIdx = jn;
-                    for(int k = 1; k < cn; ++k)
-                        if(_norm[jn + k] > _norm[maxIdx]) maxIdx = jn + k;
-                    _norm[j] = _norm[maxIdx];
-                    _dx[j] = _dx[maxIdx];
-                    _dy[j] = _dy[maxIdx];
-                }
-            }
-            _norm[-1] = _norm[src.cols] = 0;
-        }
-        else
-            memset(_norm-1, 0, /* cn* */mapstep*sizeof(int));
-
-        // at the very beginning we do not have a complete ring
-        // buffer of 3 magnitude rows for non-maxima suppression
-        if (i == 0)
-            continue;
-
-        uchar* _map = map + mapstep*i + 1;
-        _map[-1] = _map[src.cols] = 1;
-
-        int* _mag = mag_buf[1] + 1; // take the central row
-        ptrdiff_t magstep1 = mag_buf[2] - mag_buf[1];
-        ptrdiff_t magstep2 = mag_buf[0] - mag_buf[1];
-
-        const short* _x = dx.ptr<short>(i-1);
-        const short* _y = dy.ptr<short>(i-1);
-
-        if ((stack_top - stack_bottom) + src.cols > maxsize)
-        {
-            int sz = (int)(stack_top - stack_bottom);
-            maxsize = maxsize * 3/2;
-            stack.resize(maxsize);
-            stack_bottom = &stack[0];
-            stack_top = stack_bottom + sz;
-        }
-
-        int prev_flag = 0;
-        for (int j = 0; j < src.cols; j++)
-        {
-            #define CANNY_SHIFT 15
-            const int TG22 = (int)(0.4142135623730950488016887242097*(1<<CANNY_SHIFT) + 0.5);
-
-            int m = _mag[j];
-
-            if (m > low)
-            {
-                int xs = _x[j];
-                int ys = _y[j];
-                int x = std::abs(xs);
-                int y = std::abs(ys) << CANNY_SHIFT;
+    // the bands are processed independently; the edges that cross the band boundaries
+    // are traced further below, so the result does not depend on the band layout
+    const int minBandRows = 16;
+    int nstripes = std::min(src.rows/minBandRows, (int)(src.total()/(1 << 16)));
 
-                int tg22x = x * TG22;
+    std::vector<uchar*> boundary;
+    Mutex mutex;
+    parallel_for_(Range(0, src.rows),
+                  CannyBandInvoker(dx, dy, map, mapstep, low, high, L2gradient, &boundary, &mutex),
+                  std::max(nstripes, 1));
 
-                if (y < tg22x)
-                {
-                    if (m > _mag[j-1] && m >= _mag[j+1]) goto __ocv_canny_push;
-                }
-                else
-                {
-                    int tg67x = tg22x + (x << (CANNY_SHIFT+1));
-                    if (y > tg67x)
-                    {
-                        if (m > _mag[j+magstep2] && m >= _mag[j+magstep1]) goto __ocv_canny_push;
-                    }
-                    else
-                    {
-                        int s = (xs ^ ys) < 0 ? -1 : 1;
-                        if (m > _mag[j+magstep2-s] && m > _mag[j+magstep1+s]) goto __ocv_canny_push;
-                    }
-                }
-            }
-            prev_flag = 0;
-            _map[j] = uchar(1);
-            continue;
-__ocv_canny_push:
-            if (!prev_flag && m > high && _map[j-mapstep] != 2)
-            {
-                CANNY_PUSH(_map + j);
-                prev_flag = 1;
-            }
-            else
-                _map[j] = 0;
-        }
-
-        // scroll the ring buffer
-        _mag = mag_buf[0];
-        mag_buf[0] = mag_buf[1];
-        mag_buf[1] = mag_buf[2];
-        mag_buf[2] = _mag;
-    }
-
-    // now track the edges (hysteresis thresholding)
-    while (stack_top > stack_bottom)
+    std::vector<uchar*> stack;
+    stack.reserve(boundary.size() + 8);
+    for (size_t k = 0; k < boundary.size(); k++)
     {
-        uchar* m;
-        if ((stack_top - stack_bottom) + 8 > maxsize)
-        {
-            int sz = (int)(stack_top - stack_bottom);
-            maxsize = maxsize * 3/2;
-            stack.resize(maxsize);
-            stack_bottom = &stack[0];
-            stack_top = stack_bottom + sz;
-        }
-
-        CANNY_POP(m);
-
-        if (!m[-1])         CANNY_PUSH(m - 1);
-        if (!m[1])          CANNY_PUSH(m + 1);
-        if (!m[-mapstep-1]) CANNY_PUSH(m - mapstep - 1);
-        if (!m[-mapstep])   CANNY_PUSH(m - mapstep);
-        if (!m[-mapstep+1]) CANNY_PUSH(m - mapstep + 1);
-        if (!m[mapstep-1])  CANNY_PUSH(m + mapstep - 1);
-        if (!m[mapstep])    CANNY_PUSH(m + mapstep);
-        if (!m[mapstep+1])  CANNY_PUSH(m + mapstep + 1);
+        uchar* m = boundary[k];
+        if (!*m)
+            *m = uchar(2), stack.push_back(m);
     }
 
-    // the final pass, form the final image
-    const uchar* pmap = map + mapstep + 1;
-    uchar* pdst = dst.ptr();
-    for (int i = 0; i < src.rows; i++, pmap += mapstep, pdst += dst.step)
+    while (!stack.empty())
     {
-        for (int j = 0; j < src.cols; j++)
-            pdst[j] = (uchar)-(pmap[j] >> 1);
+        uchar* m = stack.back();
+        stack.pop_back();
+
+        if (!m[-1])         m[-1] = 2, stack.push_back(m - 1);
+        if (!m[1])          m[1] = 2, stack.push_back(m + 1);
+        if (!m[-mapstep-1]) m[-mapstep-1] = 2, stack.push_back(m - mapstep - 1);
+        if (!m[-mapstep])   m[-mapstep] = 2, stack.push_back(m - mapstep);
+        if (!m[-mapstep+1]) m[-mapstep+1] = 2, stack.push_back(m - mapstep + 1);
+        if (!m[mapstep-1])  m[mapstep-1] = 2, stack.push_back(m + mapstep - 1);
+        if (!m[mapstep])    m[mapstep] = 2, stack.push_back(m + mapstep);
+        if (!m[mapstep+1])  m[mapstep+1] = 2, stack.push_back(m + mapstep + 1);
     }
+
+    parallel_for_(Range(0, src.rows), CannyFinalInvoker(map, mapstep, dst),
+                  std::max(nstripes, 1));
 }
 
 void cvCanny( const CvArr* image, CvArr* edges, double threshold1,
@@ -47,15 +47,28 @@ namespace cv{
     namespace connectedcomponents{
 
     struct NoOp{
+        //accumulates nothing while a strip is scanned
+        struct StripOp{
+            inline
+            void newLabel(){
+            }
+            inline
+            void operator()(int r, int c, int i){
+                (void) r;
+                (void) c;
+                (void) i;
+            }
+        };
+
         NoOp(){
         }
         void init(int /*labels*/){
         }
         inline
-        void operator()(int r, int c, int l){
-            (void) r;
-            (void) c;
+        void merge(int l, const StripOp &sop, int i){
             (void) l;
+            (void) sop;
+            (void) i;
         }
         void finish(){}
     };
@@ -65,6 +78,35 @@ namespace cv{
     };
 
     struct CCStatsOp{
+        //statistics of the provisional labels of a strip, index 0 is the background
+        struct StripOp{
+            struct Stats{
+                int left, top, right, bottom, area;
+                uint64 x, y;
+            };
+            std::vector<Stats> stats;
+
+            StripOp(){
+                newLabel();
+            }
+            inline
+            void newLabel(){
+                Stats st = {INT_MAX, INT_MAX, INT_MIN, INT_MIN, 0, 0, 0};
+                stats.push_back(st);
+            }
+            inline
+            void operator()(int r, int c, int i){
+                Stats &st = stats[i];
+                st.left = std::min(st.left, c);
+                st.right = std::max(st.right, c);
+                st.top = std::min(st.top, r);
+                st.bottom = std::max(st.bottom, r);
+                st.area++;
+                st.x += c;
+                st.y += r;
+            }
+        };
+
         const _OutputArray* _mstatsv;
         cv::Mat statsv;
         const _OutputArray* _mcentroidsv;
@@ -90,26 +132,18 @@ namespace cv{
             }
             integrals.resize(nlabels, Point2ui64(0, 0));
         }
-        void operator()(int r, int c, int l){
+        //adds the statistics of the provisional label i of a strip to the final label l
+        void merge(int l, const StripOp &sop, int i){
+            const StripOp::Stats &st = sop.stats[i];
             int *row = &statsv.at<int>(l, 0);
-            if(c > row[CC_STAT_WIDTH]){
-                row[CC_STAT_WIDTH] = c;
-            }else{
-                if(c < row[CC_STAT_LEFT]){
-                    row[CC_STAT_LEFT] = c;
-                }
-            }
-            if(r > row[CC_STAT_HEIGHT]){
-                row[CC_STAT_HEIGHT] = r;
-            }else{
-                if(r < row[CC_STAT_TOP]){
-                    row[CC_STAT_TOP] = r;
-                }
-            }
-            row[CC_STAT_AREA]++;
+            row[CC_STAT_LEFT] = std::min(row[CC_STAT_LEFT], st.left);
+            row[CC_STAT_WIDTH] = std::max(row[CC_STAT_WIDTH], st.right);
+            row[CC_STAT_TOP] = std::min(row[CC_STAT_TOP], st.top);
+            row[CC_STAT_HEIGHT] = std::max(row[CC_STAT_HEIGHT], st.bottom);
+            row[CC_STAT_AREA] += st.area;
             Point2ui64 &integral = integrals[l];
-            integral.x += c;
-            integral.y += r;
+            integral.x += st.x;
+            integral.y += st.y;
         }
         void finish(){
             for(int l = 0; l < statsv.rows; ++l){
@@ -177,11 +211,11 @@ namespace cv{
     }
 
     //Flatten the Union Find tree and relabel the components
+    //the nodes [start, end) are processed, the new labels are numbered from k
     template<typename LabelT>
     inline static
-    LabelT flattenL(LabelT *P, LabelT length){
-        LabelT k = 1;
-        for(LabelT i = 1; i < length; ++i){
+    LabelT flattenL(LabelT *P, LabelT start, LabelT end, LabelT k){
+        for(LabelT i = start; i < end; ++i){
             if(P[i] < i){
                 P[i] = P[P[i]];
             }else{
@@ -199,24 +233,16 @@ namespace cv{
     const int G4[2][2] = {{1, 0}, {0, -1}};//b, d neighborhoods
     //reference for 8-way: {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}};//a, b, c, d neighborhoods
     const int G8[4][2] = {{1, -1}, {1, 0}, {1, 1}, {0, -1}};//a, b, c, d neighborhoods
-    template<typename LabelT, typename PixelT, typename StatsOp = NoOp >
-    struct LabelingImpl{
-    LabelT operator()(const cv::Mat &I, cv::Mat &L, int connectivity, StatsOp &sop){
-        CV_Assert(L.rows == I.rows);
-        CV_Assert(L.cols == I.cols);
-        CV_Assert(connectivity == 8 || connectivity == 4);
-        const int rows = L.rows;
+    //Scans the rows [r0, r1) as a separate image, the rows above r0 are not accessed.
+    //The new labels are numbered from firstLabel; returns the next unused label.
+    //sop accumulates the statistics of the provisional labels of the strip.
+    template<typename LabelT, typename PixelT, typename StripOp>
+    static
+    LabelT scanStrip(const cv::Mat &I, cv::Mat &L, int connectivity, LabelT *P,
+                     int r0, int r1, LabelT firstLabel, StripOp &sop){
         const int cols = L.cols;
-        size_t Plength = (size_t(rows + 3 - 1)/3) * (size_t(cols + 3 - 1)/3);
-        if(connectivity == 4){
-            Plength = 4 * Plength;//a quick and dirty upper bound, an exact answer exists if you want to find it
-            //the 4 comes from the fact that a 3x3 block can never have more than 4 unique labels
-        }
-        LabelT *P = (LabelT *) fastMalloc(sizeof(LabelT) * Plength);
-        P[0] = 0;
-        LabelT lunique = 1;
-        //scanning phase
-        for(int r_i = 0; r_i < rows; ++r_i){
+        LabelT lunique = firstLabel;
+        for(int r_i = r0; r_i < r1; ++r_i){
             LabelT *Lrow = (LabelT *)(L.data + L.step.p[0] * r_i);
             LabelT *Lrow_prev = (LabelT *)(((char *)Lrow) - L.step.p[0]);
             const PixelT *Irow = (PixelT *)(I.data + I.step.p[0] * r_i);
@@ -234,12 +260,13 @@ namespace cv{
                 const int b = 1;
                 const int c = 2;
                 const int d = 3;
-                const bool T_a_r = (r_i - G8[a][0]) >= 0;
-                const bool T_b_r = (r_i - G8[b][0]) >= 0;
-                const bool T_c_r = (r_i - G8[c][0]) >= 0;
+                const bool T_a_r = (r_i - G8[a][0]) >= r0;
+                const bool T_b_r = (r_i - G8[b][0]) >= r0;
+                const bool T_c_r = (r_i - G8[c][0]) >= r0;
                 for(int c_i = 0; Irows[0] != Irow + cols; ++Irows[0], c_i++){
                     if(!*Irows[0]){
                         Lrow[c_i] = 0;
+                        sop(r_i, c_i, 0);
                         continue;
                     }
                     Irows[1] = Irow_prev + c_i;
@@ -281,19 +308,22 @@ namespace cv{
                                     *Lrows[0] = lunique;
                                     P[lunique] = lunique;
                                     lunique = lunique + 1;
+                                    sop.newLabel();
                                 }
                             }
                         }
                     }
+                    sop(r_i, c_i, int(*Lrows[0] - firstLabel) + 1);
                 }
             }else{
                 //B & D only
                 const int b = 0;
                 const int d = 1;
-                const bool T_b_r = (r_i - G4[b][0]) >= 0;
+                const bool T_b_r = (r_i - G4[b][0]) >= r0;
                 for(int c_i = 0; Irows[0] != Irow + cols; ++Irows[0], c_i++){
                     if(!*Irows[0]){
                         Lrow[c_i] = 0;
+                        sop(r_i, c_i, 0);
                         continue;
                     }
                     Irows[1] = Irow_prev + c_i;
@@ -318,27 +348,159 @@ namespace cv{
                             *Lrows[0] = lunique;
                             P[lunique] = lunique;
                             lunique = lunique + 1;
+                            sop.newLabel();
+                        }
+                    }
+                    sop(r_i, c_i, int(*Lrows[0] - firstLabel) + 1);
+                }
+            }
+        }
+
+        return lunique;
+    }
+
+    //The upper bound of the number of labels created in a w x h strip
+    static size_t labelsBound(int h, int w, int connectivity){
+        if(connectivity == 8){
+            //a 2x2 block can not have more than one new label
+            return size_t((h + 1)/2) * size_t((w + 1)/2);
+        }
+        //4-connectivity: a checkerboard
+        return (size_t(h) * size_t(w) + 1)/2;
+    }
+
+    template<typename LabelT, typename PixelT, typename StripOp>
+    class FirstScanInvoker : public ParallelLoopBody{
+    public:
+        FirstScanInvoker(const cv::Mat &_I, cv::Mat &_L, int _connectivity, LabelT *_P,
+                         const int *_stripRows, const LabelT *_firstLabels,
+                         LabelT *_nextLabels, StripOp *_sops)
+            : I(_I), L(_L), connectivity(_connectivity), P(_P), stripRows(_stripRows),
+              firstLabels(_firstLabels), nextLabels(_nextLabels), sops(_sops){
+        }
+
+        void operator()(const cv::Range &range) const{
+            cv::Mat _L = L;
+            for(int k = range.start; k < range.end; ++k){
+                nextLabels[k] = scanStrip<LabelT, PixelT, StripOp>(I, _L, connectivity, P,
+                                    stripRows[k], stripRows[k + 1], firstLabels[k], sops[k]);
+            }
+        }
+
+    private:
+        cv::Mat I, L;
+        int connectivity;
+        LabelT *P;
+        const int *stripRows;
+        const LabelT *firstLabels;
+        LabelT *nextLabels;
+        StripOp *sops;
+    };
+
+    template<typename LabelT>
+    class RelabelInvoker : public ParallelLoopBody{
+    public:
+        RelabelInvoker(cv::Mat &_L, const LabelT *_P) : L(_L), P(_P){
+        }
+
+        void operator()(const cv::Range &range) const{
+            for(int r_i = range.start; r_i < range.end; ++r_i){
+                LabelT *Lrow = (LabelT *)(L.data + L.step.p[0] * r_i);
+                for(int c_i = 0; c_i < L.cols; ++c_i){
+                    Lrow[c_i] = P[Lrow[c_i]];
+                }
+            }
+        }
+
+    private:
+        cv::Mat L;
+        const LabelT *P;
+    };
+
+    //The image is split into horizontal strips that are labeled in parallel, every strip
+    //with its own range of provisional labels. The labels are then merged along the first
+    //rows of the strips, the union find trees are flattened in the order of the provisional
+    //labels, so the final labels follow the raster order of the first pixels of the components
+    //just like in the serial algorithm. The statistics are gathered per provisional label while
+    //scanning and are summed up for the final labels afterwards.
+    template<typename LabelT, typename PixelT, typename StatsOp = NoOp >
+    struct LabelingImpl{
+    LabelT operator()(const cv::Mat &I, cv::Mat &L, int connectivity, StatsOp &sop){
+        CV_Assert(L.rows == I.rows);
+        CV_Assert(L.cols == I.cols);
+        CV_Assert(connectivity == 8 || connectivity == 4);
+        typedef typename StatsOp::StripOp StripOp;
+        const int rows = L.rows;
+        const int cols = L.cols;
+
+        int nstripes = std::max(std::min(rows/64, (int)(L.total()/(1 << 16))), 1);
+        std::vector<int> stripRows;
+        std::vector<LabelT> firstLabels, nextLabels;
+        size_t Plength;
+        for(;;){
+            stripRows.resize(nstripes + 1);
+            firstLabels.resize(nstripes);
+            nextLabels.resize(nstripes);
+            Plength = 1;
+            for(int k = 0; k < nstripes; ++k){
+                stripRows[k] = (int)((int64)rows * k / nstripes);
+                stripRows[k + 1] = (int)((int64)rows * (k + 1) / nstripes);
+                firstLabels[k] = (LabelT)Plength;
+                Plength += labelsBound(stripRows[k + 1] - stripRows[k], cols, connectivity);
+            }
+            //the provisional labels of all the strips must fit the label type
+            if(nstripes == 1 || Plength - 1 <= (size_t)std::numeric_limits<LabelT>::max()){
+                break;
+            }
+            nstripes = 1;
+        }
+
+        LabelT *P = (LabelT *) fastMalloc(sizeof(LabelT) * Plength);
+        P[0] = 0;
+        std::vector<StripOp> sops(nstripes);
+
+        //scanning phase
+        FirstScanInvoker<LabelT, PixelT, StripOp> scanBody(I, L, connectivity, P, &stripRows[0],
+                                                           &firstLabels[0], &nextLabels[0], &sops[0]);
+        parallel_for_(cv::Range(0, nstripes), scanBody, nstripes);
+
+        //merging the strips
+        for(int k = 1; k < nstripes; ++k){
+            const LabelT *Lrow_prev = (const LabelT *)(L.data + L.step.p[0] * (stripRows[k] - 1));
+            const LabelT *Lrow = (const LabelT *)(L.data + L.step.p[0] * stripRows[k]);
+            for(int c_i = 0; c_i < cols; ++c_i){
+                if(!Lrow[c_i]){
+                    continue;
+                }
+                if(connectivity == 8){
+                    for(int dc = std::max(c_i - 1, 0); dc <= std::min(c_i + 1, cols - 1); ++dc){
+                        if(Lrow_prev[dc]){
+                            set_union(P, Lrow[c_i], Lrow_prev[dc]);
                         }
                     }
+                }else if(Lrow_prev[c_i]){
+                    set_union(P, Lrow[c_i], Lrow_prev[c_i]);
                 }
             }
         }
 
         //analysis
-        LabelT nLabels = flattenL(P, lunique);
+        LabelT nLabels = 1;
+        for(int k = 0; k < nstripes; ++k){
+            nLabels = flattenL(P, firstLabels[k], nextLabels[k], nLabels);
+        }
         sop.init(nLabels);
 
-        for(int r_i = 0; r_i < rows; ++r_i){
-            LabelT *Lrow_start = (LabelT *)(L.data + L.step.p[0] * r_i);
-            LabelT *Lrow_end = Lrow_start + cols;
-            LabelT *Lrow = Lrow_start;
-            for(int c_i = 0; Lrow != Lrow_end; ++Lrow, ++c_i){
-                const LabelT l = P[*Lrow];
-                *Lrow = l;
-                sop(r_i, c_i, l);
+        for(int k = 0; k < nstripes; ++k){
+            sop.merge(0, sops[k], 0);
+            for(LabelT i = firstLabels[k]; i < nextLabels[k]; ++i){
+                sop.merge(P[i], sops[k], int(i - firstLabels[k]) + 1);
             }
         }
 
+        RelabelInvoker<LabelT> relabelBody(L, P);
+        parallel_for_(cv::Range(0, rows), relabelBody, L.total()/(double)(1 << 16));
+
         sop.finish();
         fastFree(P);
 
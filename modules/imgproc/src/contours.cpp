@@ -1753,6 +1753,142 @@ void cv::findContours( InputOutputArray _image, OutputArrayOfArrays _contours,
     findContours(_image, _contours, noArray(), mode, method, offset);
 }
 
+namespace cv
+{
+
+// Traces the contours of the connected components [range.start, range.end) of the label image.
+// Every component is copied, with a zero frame, into a small buffer and traced separately;
+// the components do not touch each other, so the traced chains are the same as for the whole image.
+class ComponentContoursInvoker : public ParallelLoopBody
+{
+public:
+    ComponentContoursInvoker( const Mat& _labels, const Mat& _stats, const vector<int>& _comps,
+                              int _mode, int _method, Point _offset,
+                              vector<vector<vector<Point> > >& _result )
+        : labels(_labels), stats(_stats), comps(&_comps), mode(_mode), method(_method),
+          offset(_offset), result(&_result)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        MemStorage storage(cvCreateMemStorage());
+        vector<uchar> bufData;
+
+        for( int k = range.start; k < range.end; k++ )
+        {
+            int l = (*comps)[k];
+            const int* st = stats.ptr<int>(l);
+            Rect r(st[CC_STAT_LEFT], st[CC_STAT_TOP], st[CC_STAT_WIDTH], st[CC_STAT_HEIGHT]);
+
+            size_t bufSize = (size_t)(r.width + 2)*(r.height + 2);
+            if( bufData.size() < bufSize )
+                bufData.resize(bufSize);
+            Mat buf(r.height + 2, r.width + 2, CV_8U, &bufData[0]);
+            buf = Scalar::all(0);
+            for( int y = 0; y < r.height; y++ )
+            {
+                const int* lrow = labels.ptr<int>(r.y + y) + r.x;
+                uchar* brow = buf.ptr(y + 1) + 1;
+                for( int x = 0; x < r.width; x++ )
+                    brow[x] = (uchar)(lrow[x] == l);
+            }
+
+            cvClearMemStorage(storage);
+            CvMat _cbuf = buf;
+            CvSeq* first = 0;
+            cvFindContours(&_cbuf, storage, &first, sizeof(CvContour), mode, method,
+                           offset + r.tl() - Point(1, 1));
+            if( !first )
+                continue;
+
+            Seq<CvSeq*> all(cvTreeToNodeSeq( first, sizeof(CvSeq), storage ));
+            vector<vector<Point> >& dst = (*result)[k];
+            dst.resize(all.size());
+            SeqIterator<CvSeq*> it = all.begin();
+            for( size_t i = 0; i < dst.size(); i++, ++it )
+            {
+                CvSeq* c = *it;
+                dst[i].resize(c->total);
+                cvCvtSeqToArray(c, &dst[i][0]);
+            }
+        }
+    }
+
+private:
+    Mat labels, stats;
+    const vector<int>* comps;
+    int mode, method;
+    Point offset;
+    vector<vector<vector<Point> > >* result;
+};
+
+}
+
+void cv::findContoursParallel( InputArray _image, vector<vector<Point> >& contours,
+                               int mode, int method, Point offset )
+{
+    Mat image = _image.getMat();
+    CV_Assert( image.type() == CV_8UC1 );
+    CV_Assert( mode == RETR_EXTERNAL || mode == RETR_LIST );
+    CV_Assert( method == CHAIN_APPROX_NONE || method == CHAIN_APPROX_SIMPLE ||
+               method == CHAIN_APPROX_TC89_L1 || method == CHAIN_APPROX_TC89_KCOS );
+
+    contours.clear();
+    if( image.rows < 3 || image.cols < 3 )
+        return;
+
+    // findContours treats the 1-pixel frame of the image as background
+    Mat bin = image.clone();
+    bin.row(0) = Scalar::all(0);
+    bin.row(bin.rows - 1) = Scalar::all(0);
+    bin.col(0) = Scalar::all(0);
+    bin.col(bin.cols - 1) = Scalar::all(0);
+
+    Mat labels, stats, centroids;
+    int nlabels = connectedComponentsWithStats(bin, labels, stats, centroids, 8, CV_32S);
+
+    vector<int> comps;
+    comps.reserve(nlabels);
+    if( mode == RETR_EXTERNAL )
+    {
+        // a component is external if its first pixel in the raster order
+        // borders the background region that touches the image frame
+        Mat bg, bglabels;
+        compare(bin, Scalar::all(0), bg, CMP_EQ);
+        connectedComponents(bg, bglabels, 4, CV_32S);
+        int outer = bglabels.at<int>(0, 0);
+
+        for( int l = 1; l < nlabels; l++ )
+        {
+            int x = stats.at<int>(l, CC_STAT_LEFT), y = stats.at<int>(l, CC_STAT_TOP);
+            const int* lrow = labels.ptr<int>(y);
+            while( lrow[x] != l )
+                x++;
+            if( bglabels.at<int>(y, x - 1) == outer )
+                comps.push_back(l);
+        }
+    }
+    else
+    {
+        for( int l = 1; l < nlabels; l++ )
+            comps.push_back(l);
+    }
+
+    int ncomps = (int)comps.size();
+    vector<vector<vector<Point> > > result(ncomps);
+    ComponentContoursInvoker body(labels, stats, comps, mode, method, offset, result);
+    parallel_for_(Range(0, ncomps), body, std::min(ncomps, std::max(getNumThreads(), 1)*4));
+
+    size_t total = 0;
+    for( int k = 0; k < ncomps; k++ )
+        total += result[k].size();
+    contours.resize(total);
+    for( int k = 0, i = 0; k < ncomps; k++ )
+        for( size_t j = 0; j < result[k].size(); j++ )
+            contours[i++].swap(result[k][j]);
+}
+
 void cv::approxPolyDP( InputArray _curve, OutputArray _approxCurve,
                        double epsilon, bool closed )
 {
@@ -443,75 +443,107 @@ icvGetDistanceTransformMask( int maskType, float *metrics )
 namespace cv
 {
 
-struct DTColumnInvoker
+// the first stage of the precise transform: the squared distances to the nearest zero pixel
+// in the same column. The row of that pixel (-1 when the column has no zeros) goes to nearest,
+// if it is not empty. The columns are processed in blocks, row by row, to keep the memory
+// access sequential.
+struct DTColumnInvoker : ParallelLoopBody
 {
-    DTColumnInvoker( const CvMat* _src, CvMat* _dst, const int* _sat_tab, const float* _sqr_tab)
+    DTColumnInvoker( const Mat& _src, Mat& _dst, Mat& _nearest, const float* _sqr_tab )
     {
-        src = _src;
-        dst = _dst;
-        sat_tab = _sat_tab + src->rows*2 + 1;
+        src = &_src;
+        dst = &_dst;
+        nearest = &_nearest;
         sqr_tab = _sqr_tab;
     }
 
-    void operator()( const BlockedRange& range ) const
+    void operator()( const Range& range ) const
     {
-        int i, i1 = range.begin(), i2 = range.end();
+        const int BLOCK_SIZE = 64;
         int m = src->rows;
-        size_t sstep = src->step, dstep = dst->step/sizeof(float);
-        AutoBuffer<int> _d(m);
-        int* d = _d;
+        AutoBuffer<int> _buf(BLOCK_SIZE*(m + 1));
+        int* below = _buf;
+        int* above = below + BLOCK_SIZE*m;
 
-        for( i = i1; i < i2; i++ )
+        for( int i0 = range.start; i0 < range.end; i0 += BLOCK_SIZE )
         {
-            const uchar* sptr = src->data.ptr + i + (m-1)*sstep;
-            float* dptr = dst->data.fl + i;
-            int j, dist = m-1;
+            int i, j, bw = std::min(BLOCK_SIZE, range.end - i0);
 
-            for( j = m-1; j >= 0; j--, sptr -= sstep )
+            // bottom-up: the nearest zero row at or below each pixel
+            const int* b = above;
+            for( i = 0; i < bw; i++ )
+                above[i] = -1;
+            for( j = m - 1; j >= 0; j-- )
             {
-                dist = (dist + 1) & (sptr[0] == 0 ? 0 : -1);
-                d[j] = dist;
+                const uchar* sptr = src->ptr<uchar>(j) + i0;
+                int* bj = below + j*bw;
+                for( i = 0; i < bw; i++ )
+                    bj[i] = sptr[i] == 0 ? j : b[i];
+                b = bj;
             }
 
-            dist = m-1;
-            for( j = 0; j < m; j++, dptr += dstep )
+            // top-down: the nearest zero row at or above, compared with the one below
+            for( i = 0; i < bw; i++ )
+                above[i] = -1;
+            for( j = 0; j < m; j++ )
             {
-                dist = dist + 1 - sat_tab[dist - d[j]];
-                d[j] = dist;
-                dptr[0] = sqr_tab[dist];
+                const uchar* sptr = src->ptr<uchar>(j) + i0;
+                const int* bj = below + j*bw;
+                float* dptr = dst->ptr<float>(j) + i0;
+                int* nptr = nearest->data ? nearest->ptr<int>(j) + i0 : 0;
+
+                for( i = 0; i < bw; i++ )
+                {
+                    if( sptr[i] == 0 )
+                        above[i] = j;
+                    int a = above[i], da = a >= 0 ? j - a : m;
+                    int db = bj[i] >= 0 ? bj[i] - j : m;
+                    int r = da <= db ? a : bj[i];
+                    dptr[i] = sqr_tab[std::min(da, db)];
+                    if( nptr )
+                        nptr[i] = r;
+                }
             }
         }
     }
 
-    const CvMat* src;
-    CvMat* dst;
-    const int* sat_tab;
+    const Mat* src;
+    Mat* dst;
+    Mat* nearest;
     const float* sqr_tab;
 };
 
 
-struct DTRowInvoker
+// the second stage: the lower envelope of the parabolas centered at the pixels of each row,
+// with the heights set to the column distances. The center of the parabola that the envelope
+// takes at a pixel is the column of its nearest zero pixel, so the label of that pixel is copied
+// to the labels, which hold the rows of the nearest zero pixels after the first stage.
+struct DTRowInvoker : ParallelLoopBody
 {
-    DTRowInvoker( CvMat* _dst, const float* _sqr_tab, const float* _inv_tab )
+    DTRowInvoker( Mat& _dst, Mat& _labels, const Mat& _zeroLabels,
+                  const float* _sqr_tab, const float* _inv_tab )
     {
-        dst = _dst;
+        dst = &_dst;
+        labels = &_labels;
+        zeroLabels = &_zeroLabels;
         sqr_tab = _sqr_tab;
         inv_tab = _inv_tab;
     }
 
-    void operator()( const BlockedRange& range ) const
+    void operator()( const Range& range ) const
     {
         const float inf = 1e15f;
-        int i, i1 = range.begin(), i2 = range.end();
+        int i, i1 = range.start, i2 = range.end;
         int n = dst->cols;
-        AutoBuffer<uchar> _buf((n+2)*2*sizeof(float) + (n+2)*sizeof(int));
+        AutoBuffer<uchar> _buf((n+2)*2*sizeof(float) + (n+2)*2*sizeof(int));
         float* f = (float*)(uchar*)_buf;
         float* z = f + n;
         int* v = alignPtr((int*)(z + n + 1), sizeof(int));
+        int* rows = v + n + 1;
 
         for( i = i1; i < i2; i++ )
         {
-            float* d = (float*)(dst->data.ptr + i*dst->step);
+            float* d = dst->ptr<float>(i);
             int p, q, k;
 
             v[0] = 0;
@@ -539,17 +571,34 @@ struct DTRowInvoker
                 }
             }
 
+            if( !labels->data )
+            {
+                for( q = 0, k = 0; q < n; q++ )
+                {
+                    while( z[k+1] < q )
+                        k++;
+                    p = v[k];
+                    d[q] = std::sqrt(sqr_tab[std::abs(q - p)] + f[p]);
+                }
+                continue;
+            }
+
+            int* lptr = labels->ptr<int>(i);
+            memcpy(rows, lptr, n*sizeof(int));
             for( q = 0, k = 0; q < n; q++ )
             {
                 while( z[k+1] < q )
                     k++;
                 p = v[k];
                 d[q] = std::sqrt(sqr_tab[std::abs(q - p)] + f[p]);
+                lptr[q] = rows[p] >= 0 ? zeroLabels->at<int>(rows[p], p) : 0;
             }
         }
     }
 
-    CvMat* dst;
+    Mat* dst;
+    Mat* labels;
+    const Mat* zeroLabels;
     const float* sqr_tab;
     const float* inv_tab;
 };
@@ -557,36 +606,37 @@ struct DTRowInvoker
 }
 
 static void
-icvTrueDistTrans( const CvMat* src, CvMat* dst )
+icvTrueDistTrans( const CvMat* _src, CvMat* _dst, CvMat* _labels, const CvMat* _zeroLabels )
 {
     const float inf = 1e15f;
 
-    if( !CV_ARE_SIZES_EQ( src, dst ))
+    if( !CV_ARE_SIZES_EQ( _src, _dst ))
         CV_Error( CV_StsUnmatchedSizes, "" );
 
-    if( CV_MAT_TYPE(src->type) != CV_8UC1 ||
-        CV_MAT_TYPE(dst->type) != CV_32FC1 )
+    if( CV_MAT_TYPE(_src->type) != CV_8UC1 ||
+        CV_MAT_TYPE(_dst->type) != CV_32FC1 )
         CV_Error( CV_StsUnsupportedFormat,
         "The input image must have 8uC1 type and the output one must have 32fC1 type" );
 
-    int i, m = src->rows, n = src->cols;
+    cv::Mat src(_src), dst(_dst), labels, zeroLabels;
+    if( _labels )
+    {
+        labels = cv::Mat(_labels);
+        zeroLabels = cv::Mat(_zeroLabels);
+    }
+
+    int i, m = src.rows, n = src.cols;
 
-    cv::AutoBuffer<uchar> _buf(std::max(m*2*sizeof(float) + (m*3+1)*sizeof(int), n*2*sizeof(float)));
+    cv::AutoBuffer<float> _buf(std::max(m + 1, n*2));
     // stage 1: compute 1d distance transform of each column
-    float* sqr_tab = (float*)(uchar*)_buf;
-    int* sat_tab = cv::alignPtr((int*)(sqr_tab + m*2), sizeof(int));
-    int shift = m*2;
+    float* sqr_tab = _buf;
 
     for( i = 0; i < m; i++ )
         sqr_tab[i] = (float)(i*i);
-    for( i = m; i < m*2; i++ )
-        sqr_tab[i] = inf;
-    for( i = 0; i < shift; i++ )
-        sat_tab[i] = 0;
-    for( ; i <= m*3; i++ )
-        sat_tab[i] = i - shift;
+    sqr_tab[m] = inf;
 
-    cv::parallel_for(cv::BlockedRange(0, n), cv::DTColumnInvoker(src, dst, sat_tab, sqr_tab));
+    cv::parallel_for_(cv::Range(0, n), cv::DTColumnInvoker(src, dst, labels, sqr_tab),
+                      src.total()/(double)(1<<16));
 
     // stage 2: compute modified distance transform for each row
     float* inv_tab = sqr_tab + n;
@@ -598,7 +648,8 @@ icvTrueDistTrans( const CvMat* src, CvMat* dst )
         sqr_tab[i] = (float)(i*i);
     }
 
-    cv::parallel_for(cv::BlockedRange(0, m), cv::DTRowInvoker(dst, sqr_tab, inv_tab));
+    cv::parallel_for_(cv::Range(0, m), cv::DTRowInvoker(dst, labels, zeroLabels, sqr_tab, inv_tab),
+                      src.total()/(double)(1<<16));
 }
 
 
@@ -701,6 +752,46 @@ icvDistanceATS_L1_8u( const CvMat* src, CvMat* dst )
 //END ATS ADDITION
 
 
+/* labels the zero pixels: by their connected components or each one separately */
+static void
+icvInitDistLabels( const CvMat* src, CvMat* labels, int labelType, int border )
+{
+    CvSize size = cvGetMatSize(src);
+
+    cvZero( labels );
+
+    if( labelType == CV_DIST_LABEL_CCOMP )
+    {
+        CvSeq *contours = 0;
+        cv::Ptr<CvMemStorage> st = cvCreateMemStorage();
+        cv::Ptr<CvMat> src_copy = cvCreateMat( size.height+border*2, size.width+border*2, src->type );
+        cvCopyMakeBorder(src, src_copy, cvPoint(border, border), IPL_BORDER_CONSTANT, cvScalarAll(255));
+        cvCmpS( src_copy, 0, src_copy, CV_CMP_EQ );
+        cvFindContours( src_copy, st, &contours, sizeof(CvContour),
+                       CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE, cvPoint(-border, -border));
+
+        for( int label = 1; contours != 0; contours = contours->h_next, label++ )
+        {
+            CvScalar area_color = cvScalarAll(label);
+            cvDrawContours( labels, contours, area_color, area_color, -255, -1, 8 );
+        }
+    }
+    else
+    {
+        int k = 1;
+        for( int i = 0; i < src->rows; i++ )
+        {
+            const uchar* srcptr = src->data.ptr + src->step*i;
+            int* labelptr = (int*)(labels->data.ptr + labels->step*i);
+
+            for( int j = 0; j < src->cols; j++ )
+                if( srcptr[j] == 0 )
+                    labelptr[j] = k++;
+        }
+    }
+}
+
+
 /* Wrapper function for distance transform group */
 CV_IMPL void
 cvDistTransform( const void* srcarr, void* dstarr,
@@ -730,15 +821,9 @@ cvDistTransform( const void* srcarr, void* dstarr,
 
     if( distType == CV_DIST_C || distType == CV_DIST_L1 )
         maskSize = !labels ? CV_DIST_MASK_3 : CV_DIST_MASK_5;
-    else if( distType == CV_DIST_L2 && labels )
+    else if( distType == CV_DIST_L2 && labels && maskSize != CV_DIST_MASK_PRECISE )
         maskSize = CV_DIST_MASK_5;
 
-    if( maskSize == CV_DIST_MASK_PRECISE )
-    {
-        icvTrueDistTrans( src, dst );
-        return;
-    }
-
     if( labels )
     {
         labels = cvGetMat( labels, &lstub );
@@ -753,6 +838,18 @@ cvDistTransform( const void* srcarr, void* dstarr,
             "3x3 mask can not be used for \"labeled\" distance transform. Use 5x5 mask" );
     }
 
+    if( maskSize == CV_DIST_MASK_PRECISE )
+    {
+        cv::Ptr<CvMat> zeroLabels;
+        if( labels )
+        {
+            zeroLabels = cvCreateMat( src->rows, src->cols, CV_32SC1 );
+            icvInitDistLabels( src, zeroLabels, labelType, 1 );
+        }
+        icvTrueDistTrans( src, dst, labels, zeroLabels );
+        return;
+    }
+
     if( distType == CV_DIST_C || distType == CV_DIST_L1 || distType == CV_DIST_L2 )
     {
         icvGetDistanceTransformMask( (distType == CV_DIST_C ? 0 :
@@ -788,37 +885,7 @@ cvDistTransform( const void* srcarr, void* dstarr,
         }
         else
         {
-            cvZero( labels );
-
-            if( labelType == CV_DIST_LABEL_CCOMP )
-            {
-                CvSeq *contours = 0;
-                cv::Ptr<CvMemStorage> st = cvCreateMemStorage();
-                cv::Ptr<CvMat> src_copy = cvCreateMat( size.height+border*2, size.width+border*2, src->type );
-                cvCopyMakeBorder(src, src_copy, cvPoint(border, border), IPL_BORDER_CONSTANT, cvScalarAll(255));
-                cvCmpS( src_copy, 0, src_copy, CV_CMP_EQ );
-                cvFindContours( src_copy, st, &contours, sizeof(CvContour),
-                               CV_RETR_CCOMP, CV_CHAIN_APPROX_SIMPLE, cvPoint(-border, -border));
-
-                for( int label = 1; contours != 0; contours = contours->h_next, label++ )
-                {
-                    CvScalar area_color = cvScalarAll(label);
-                    cvDrawContours( labels, contours, area_color, area_color, -255, -1, 8 );
-                }
-            }
-            else
-            {
-                int k = 1;
-                for( int i = 0; i < src->rows; i++ )
-                {
-                    const uchar* srcptr = src->data.ptr + src->step*i;
-                    int* labelptr = (int*)(labels->data.ptr + labels->step*i);
-
-                    for( int j = 0; j < src->cols; j++ )
-                        if( srcptr[j] == 0 )
-                            labelptr[j] = k++;
-                }
-            }
+            icvInitDistLabels( src, labels, labelType, border );
 
             icvDistanceTransformEx_5x5_C1R( src->data.ptr, src->step, temp->data.i, temp->step,
                         dst->data.fl, dst->step, labels->data.i, labels->step, size, _mask );
@@ -430,6 +430,39 @@ int FilterEngine::proceed( const uchar* src, int srcstep, int count,
 }
 
 
+class FilterBandInvoker : public ParallelLoopBody
+{
+public:
+    FilterBandInvoker(const FilterEngine& _engine, const Mat& _src, Mat& _dst,
+                      const Rect& _srcRoi, Point _dstOfs, bool _isolated) :
+        ParallelLoopBody(), engine(&_engine), src(_src), dst(_dst),
+        srcRoi(_srcRoi), dstOfs(_dstOfs), isolated(_isolated)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        // the band engine shares the (stateless) filters, but has its own ring buffer.
+        // The rows above and below the band are taken from the source image, so
+        // the band borders do not depend on the border extrapolation mode
+        FilterEngine f(*engine);
+        Rect bandRoi(srcRoi.x, srcRoi.y + range.start, srcRoi.width, range.end - range.start);
+        int y = f.start(src, bandRoi, isolated);
+        f.proceed( src.data + y*src.step, (int)src.step, f.endY - f.startY,
+                   dst.data + (dstOfs.y + range.start)*dst.step + dstOfs.x*dst.elemSize(),
+                   (int)dst.step );
+    }
+
+private:
+    const FilterEngine* engine;
+    Mat src;
+    Mat dst;
+    Rect srcRoi;
+    Point dstOfs;
+    bool isolated;
+};
+
+
 void FilterEngine::apply(const Mat& src, Mat& dst,
     const Rect& _srcRoi, Point dstOfs, bool isolated)
 {
@@ -446,6 +479,19 @@ void FilterEngine::apply(const Mat& src, Mat& dst,
         dstOfs.x + srcRoi.width <= dst.cols &&
         dstOfs.y + srcRoi.height <= dst.rows );
 
+    // each band re-filters ksize.height-1 rows of its neighbours, so the bands should not be too thin
+    int minBandRows = std::max((ksize.height - 1)*4, 16);
+    double nstripes = std::min((double)srcRoi.height/minBandRows, srcRoi.area()/(double)(1 << 16));
+    bool stateless = isSeparable() ? dynamic_cast<const StatelessFilter*>(columnFilter.obj) != 0 :
+                                     dynamic_cast<const StatelessFilter*>(filter2D.obj) != 0;
+
+    if( nstripes >= 2 && stateless && !(src.datastart < dst.dataend && dst.datastart < src.dataend) )
+    {
+        parallel_for_(Range(0, srcRoi.height),
+                      FilterBandInvoker(*this, src, dst, srcRoi, dstOfs, isolated), nstripes);
+        return;
+    }
+
     int y = start(src, srcRoi, isolated);
     proceed( src.data + y*src.step, (int)src.step, endY - startY,
              dst.data + dstOfs.y*dst.step + dstOfs.x*dst.elemSize(), (int)dst.step );
@@ -2393,7 +2439,7 @@ template<typename ST, typename DT, class VecOp> struct SymmRowSmallFilter :
 };
 
 
-template<class CastOp, class VecOp> struct ColumnFilter : public BaseColumnFilter
+template<class CastOp, class VecOp> struct ColumnFilter : public BaseColumnFilter, public StatelessFilter
 {
     typedef typename CastOp::type1 ST;
     typedef typename CastOp::rtype DT;
@@ -3041,7 +3087,7 @@ void preprocess2DKernel( const Mat& kernel, vector<Point>& coords, vector<uchar>
 }
 
 
-template<typename ST, class CastOp, class VecOp> struct Filter2D : public BaseFilter
+template<typename ST, class CastOp, class VecOp> struct Filter2D : public BaseFilter, public StatelessFilter
 {
     typedef typename CastOp::type1 KT;
     typedef typename CastOp::rtype DT;
@@ -3057,7 +3103,6 @@ template<typename ST, class CastOp, class VecOp> struct Filter2D : public BaseFi
         vecOp = _vecOp;
         CV_Assert( _kernel.type() == DataType<KT>::type );
         preprocess2DKernel( _kernel, coords, coeffs );
-        ptrs.resize( coords.size() );
     }
 
     void operator()(const uchar** src, uchar* dst, int dststep, int count, int width, int cn)
@@ -3065,8 +3110,9 @@ template<typename ST, class CastOp, class VecOp> struct Filter2D : public BaseFi
         KT _delta = delta;
         const Point* pt = &coords[0];
         const KT* kf = (const KT*)&coeffs[0];
-        const ST** kp = (const ST**)&ptrs[0];
         int i, k, nz = (int)coords.size();
+        AutoBuffer<const ST*> _kp(nz);
+        const ST** kp = _kp;
         CastOp castOp = castOp0;
 
         width *= cn;
@@ -3109,7 +3155,6 @@ template<typename ST, class CastOp, class VecOp> struct Filter2D : public BaseFi
 
     vector<Point> coords;
     vector<uchar> coeffs;
-    vector<uchar*> ptrs;
     KT delta;
     CastOp castOp0;
     VecOp vecOp;
@@ -3232,6 +3277,7 @@ void cv::filter2D( InputArray _src, OutputArray _dst, int ddepth,
                    InputArray _kernel, Point anchor,
                    double delta, int borderType )
 {
+    CV_TRACE_REGION("filter2D");
     Mat src = _src.getMat(), kernel = _kernel.getMat();
 
     if( ddepth < 0 )
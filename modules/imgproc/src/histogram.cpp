@@ -125,7 +125,6 @@ static void histPrepareImages( const Mat* images, int nimages, const int* channe
 
     imsize = images[0].size();
     int depth = images[0].depth(), esz1 = (int)images[0].elemSize1();
-    bool isContinuous = true;
 
     ptrs.resize(dims + 1);
     deltas.resize((dims + 1)*2);
@@ -149,8 +148,6 @@ static void histPrepareImages( const Mat* images, int nimages, const int* channe
         }
 
         CV_Assert( images[j].size() == imsize && images[j].depth() == depth );
-        if( !images[j].isContinuous() )
-            isContinuous = false;
         ptrs[i] = images[j].data + c*esz1;
         deltas[i*2] = images[j].channels();
         deltas[i*2+1] = (int)(images[j].step/esz1 - imsize.width*deltas[i*2]);
@@ -159,20 +156,11 @@ static void histPrepareImages( const Mat* images, int nimages, const int* channe
     if( mask.data )
     {
         CV_Assert( mask.size() == imsize && mask.channels() == 1 );
-        isContinuous = isContinuous && mask.isContinuous();
         ptrs[dims] = mask.data;
         deltas[dims*2] = 1;
         deltas[dims*2 + 1] = (int)(mask.step/mask.elemSize1());
     }
 
-#ifndef HAVE_TBB
-    if( isContinuous )
-    {
-        imsize.width *= imsize.height;
-        imsize.height = 1;
-    }
-#endif
-
     if( !ranges )
     {
         CV_Assert( depth == CV_8U );
@@ -208,539 +196,34 @@ static void histPrepareImages( const Mat* images, int nimages, const int* channe
 }
 
 
-////////////////////////////////// C A L C U L A T E    H I S T O G R A M ////////////////////////////////////
-#ifdef HAVE_TBB
-enum {one = 1, two, three}; // array elements number
-
-template<typename T>
-class calcHist1D_Invoker
-{
-public:
-    calcHist1D_Invoker( const vector<uchar*>& _ptrs, const vector<int>& _deltas,
-                        Mat& hist, const double* _uniranges, int sz, int dims,
-                        Size& imageSize )
-        : mask_(_ptrs[dims]),
-          mstep_(_deltas[dims*2 + 1]),
-          imageWidth_(imageSize.width),
-          histogramSize_(hist.size()), histogramType_(hist.type()),
-          globalHistogram_((tbb::atomic<int>*)hist.data)
-    {
-        p_[0] = ((T**)&_ptrs[0])[0];
-        step_[0] = (&_deltas[0])[1];
-        d_[0] = (&_deltas[0])[0];
-        a_[0] = (&_uniranges[0])[0];
-        b_[0] = (&_uniranges[0])[1];
-        size_[0] = sz;
-    }
-
-    void operator()( const BlockedRange& range ) const
-    {
-        T* p0 = p_[0] + range.begin() * (step_[0] + imageWidth_*d_[0]);
-        uchar* mask = mask_ + range.begin()*mstep_;
-
-        for( int row = range.begin(); row < range.end(); row++, p0 += step_[0] )
-        {
-            if( !mask_ )
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0] )
-                {
-                    int idx = cvFloor(*p0*a_[0] + b_[0]);
-                    if( (unsigned)idx < (unsigned)size_[0] )
-                    {
-                        globalHistogram_[idx].fetch_and_add(1);
-                    }
-                }
-            }
-            else
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0] )
-                {
-                    if( mask[x] )
-                    {
-                        int idx = cvFloor(*p0*a_[0] + b_[0]);
-                        if( (unsigned)idx < (unsigned)size_[0] )
-                        {
-                            globalHistogram_[idx].fetch_and_add(1);
-                        }
-                    }
-                }
-                mask += mstep_;
-            }
-        }
-    }
-
-private:
-    T* p_[one];
-    uchar* mask_;
-    int step_[one];
-    int d_[one];
-    int mstep_;
-    double a_[one];
-    double b_[one];
-    int size_[one];
-    int imageWidth_;
-    Size histogramSize_;
-    int histogramType_;
-    tbb::atomic<int>* globalHistogram_;
-};
-
-template<typename T>
-class calcHist2D_Invoker
-{
-public:
-    calcHist2D_Invoker( const vector<uchar*>& _ptrs, const vector<int>& _deltas,
-                        Mat& hist, const double* _uniranges, const int* size,
-                        int dims, Size& imageSize, size_t* hstep )
-        : mask_(_ptrs[dims]),
-          mstep_(_deltas[dims*2 + 1]),
-          imageWidth_(imageSize.width),
-          histogramSize_(hist.size()), histogramType_(hist.type()),
-          globalHistogram_(hist.data)
-    {
-        p_[0] = ((T**)&_ptrs[0])[0]; p_[1] = ((T**)&_ptrs[0])[1];
-        step_[0] = (&_deltas[0])[1]; step_[1] = (&_deltas[0])[3];
-        d_[0] = (&_deltas[0])[0];    d_[1] = (&_deltas[0])[2];
-        a_[0] = (&_uniranges[0])[0]; a_[1] = (&_uniranges[0])[2];
-        b_[0] = (&_uniranges[0])[1]; b_[1] = (&_uniranges[0])[3];
-        size_[0] = size[0];          size_[1] = size[1];
-        hstep_[0] = hstep[0];
-    }
-
-    void operator()(const BlockedRange& range) const
-    {
-        T* p0 = p_[0] + range.begin()*(step_[0] + imageWidth_*d_[0]);
-        T* p1 = p_[1] + range.begin()*(step_[1] + imageWidth_*d_[1]);
-        uchar* mask = mask_ + range.begin()*mstep_;
-
-        for( int row = range.begin(); row < range.end(); row++, p0 += step_[0], p1 += step_[1] )
-        {
-            if( !mask_ )
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0], p1 += d_[1] )
-                {
-                    int idx0 = cvFloor(*p0*a_[0] + b_[0]);
-                    int idx1 = cvFloor(*p1*a_[1] + b_[1]);
-                    if( (unsigned)idx0 < (unsigned)size_[0] && (unsigned)idx1 < (unsigned)size_[1] )
-                        ( (tbb::atomic<int>*)(globalHistogram_ + hstep_[0]*idx0) )[idx1].fetch_and_add(1);
-                }
-            }
-            else
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0], p1 += d_[1] )
-                {
-                    if( mask[x] )
-                    {
-                        int idx0 = cvFloor(*p0*a_[0] + b_[0]);
-                        int idx1 = cvFloor(*p1*a_[1] + b_[1]);
-                        if( (unsigned)idx0 < (unsigned)size_[0] && (unsigned)idx1 < (unsigned)size_[1] )
-                            ((tbb::atomic<int>*)(globalHistogram_ + hstep_[0]*idx0))[idx1].fetch_and_add(1);
-                    }
-                }
-                mask += mstep_;
-            }
-        }
-    }
-
-private:
-    T* p_[two];
-    uchar* mask_;
-    int step_[two];
-    int d_[two];
-    int mstep_;
-    double a_[two];
-    double b_[two];
-    int size_[two];
-    const int imageWidth_;
-    size_t hstep_[one];
-    Size histogramSize_;
-    int histogramType_;
-    uchar* globalHistogram_;
-};
-
-
-template<typename T>
-class calcHist3D_Invoker
-{
-public:
-    calcHist3D_Invoker( const vector<uchar*>& _ptrs, const vector<int>& _deltas,
-                        Size imsize, Mat& hist, const double* uniranges, int _dims,
-                        size_t* hstep, int* size )
-        : mask_(_ptrs[_dims]),
-          mstep_(_deltas[_dims*2 + 1]),
-          imageWidth_(imsize.width),
-          globalHistogram_(hist.data)
-    {
-        p_[0] = ((T**)&_ptrs[0])[0]; p_[1] = ((T**)&_ptrs[0])[1]; p_[2] = ((T**)&_ptrs[0])[2];
-        step_[0] = (&_deltas[0])[1]; step_[1] = (&_deltas[0])[3]; step_[2] = (&_deltas[0])[5];
-        d_[0] = (&_deltas[0])[0];    d_[1] = (&_deltas[0])[2];    d_[2] = (&_deltas[0])[4];
-        a_[0] = uniranges[0];        a_[1] = uniranges[2];        a_[2] = uniranges[4];
-        b_[0] = uniranges[1];        b_[1] = uniranges[3];        b_[2] = uniranges[5];
-        size_[0] = size[0];          size_[1] = size[1];          size_[2] = size[2];
-        hstep_[0] = hstep[0];        hstep_[1] = hstep[1];
-    }
-
-    void operator()( const BlockedRange& range ) const
-    {
-        T* p0 = p_[0] + range.begin()*(imageWidth_*d_[0] + step_[0]);
-        T* p1 = p_[1] + range.begin()*(imageWidth_*d_[1] + step_[1]);
-        T* p2 = p_[2] + range.begin()*(imageWidth_*d_[2] + step_[2]);
-        uchar* mask = mask_ + range.begin()*mstep_;
-
-        for( int i = range.begin(); i < range.end(); i++, p0 += step_[0], p1 += step_[1], p2 += step_[2] )
-        {
-            if( !mask_ )
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0], p1 += d_[1], p2 += d_[2] )
-                {
-                    int idx0 = cvFloor(*p0*a_[0] + b_[0]);
-                    int idx1 = cvFloor(*p1*a_[1] + b_[1]);
-                    int idx2 = cvFloor(*p2*a_[2] + b_[2]);
-                    if( (unsigned)idx0 < (unsigned)size_[0] &&
-                            (unsigned)idx1 < (unsigned)size_[1] &&
-                            (unsigned)idx2 < (unsigned)size_[2] )
-                    {
-                        ( (tbb::atomic<int>*)(globalHistogram_ + hstep_[0]*idx0 + hstep_[1]*idx1) )[idx2].fetch_and_add(1);
-                    }
-                }
-            }
-            else
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0], p1 += d_[1], p2 += d_[2] )
-                {
-                    if( mask[x] )
-                    {
-                        int idx0 = cvFloor(*p0*a_[0] + b_[0]);
-                        int idx1 = cvFloor(*p1*a_[1] + b_[1]);
-                        int idx2 = cvFloor(*p2*a_[2] + b_[2]);
-                        if( (unsigned)idx0 < (unsigned)size_[0] &&
-                                (unsigned)idx1 < (unsigned)size_[1] &&
-                                (unsigned)idx2 < (unsigned)size_[2] )
-                        {
-                            ( (tbb::atomic<int>*)(globalHistogram_ + hstep_[0]*idx0 + hstep_[1]*idx1) )[idx2].fetch_and_add(1);
-                        }
-                    }
-                }
-                mask += mstep_;
-            }
-        }
-    }
-
-    static bool isFit( const Mat& histogram, const Size imageSize )
-    {
-        return ( imageSize.width * imageSize.height >= 320*240
-                 && histogram.total() >= 8*8*8 );
-    }
-
-private:
-    T* p_[three];
-    uchar* mask_;
-    int step_[three];
-    int d_[three];
-    const int mstep_;
-    double a_[three];
-    double b_[three];
-    int size_[three];
-    int imageWidth_;
-    size_t hstep_[two];
-    uchar* globalHistogram_;
-};
-
-class CalcHist1D_8uInvoker
+// Moves the pointers prepared by histPrepareImages() to the row y0 and returns the size of
+// the stripe [y0, y1). When all the arrays are continuous the stripe is processed as a single row.
+// esz is the element size of the images, esz2 is the element size of the mask/back projection.
+static Size histStripe( const vector<uchar*>& ptrs, const vector<int>& deltas, int dims,
+                        Size imsize, size_t esz, size_t esz2, int y0, int y1,
+                        vector<uchar*>& sptrs )
 {
-public:
-    CalcHist1D_8uInvoker( const vector<uchar*>& ptrs, const vector<int>& deltas,
-                          Size imsize, Mat& hist, int dims, const vector<size_t>& tab,
-                          tbb::mutex* lock )
-        : mask_(ptrs[dims]),
-          mstep_(deltas[dims*2 + 1]),
-          imageWidth_(imsize.width),
-          imageSize_(imsize),
-          histSize_(hist.size()), histType_(hist.type()),
-          tab_((size_t*)&tab[0]),
-          histogramWriteLock_(lock),
-          globalHistogram_(hist.data)
-    {
-        p_[0] = (&ptrs[0])[0];
-        step_[0] = (&deltas[0])[1];
-        d_[0] = (&deltas[0])[0];
-    }
-
-    void operator()( const BlockedRange& range ) const
-    {
-        int localHistogram[256] = { 0, };
-        uchar* mask = mask_;
-        uchar* p0 = p_[0];
-        int x;
-        tbb::mutex::scoped_lock lock;
-
-        if( !mask_ )
-        {
-            int n = (imageWidth_ - 4) / 4 + 1;
-            int tail = imageWidth_ - n*4;
-
-            int xN = 4*n;
-            p0 += (xN*d_[0] + tail*d_[0] + step_[0]) * range.begin();
-        }
-        else
-        {
-            p0 += (imageWidth_*d_[0] + step_[0]) * range.begin();
-            mask += mstep_*range.begin();
-        }
-
-        for( int i = range.begin(); i < range.end(); i++, p0 += step_[0] )
-        {
-            if( !mask_ )
-            {
-                if( d_[0] == 1 )
-                {
-                    for( x = 0; x <= imageWidth_ - 4; x += 4 )
-                    {
-                        int t0 = p0[x], t1 = p0[x+1];
-                        localHistogram[t0]++; localHistogram[t1]++;
-                        t0 = p0[x+2]; t1 = p0[x+3];
-                        localHistogram[t0]++; localHistogram[t1]++;
-                    }
-                    p0 += x;
-                }
-                else
-                {
-                    for( x = 0; x <= imageWidth_ - 4; x += 4 )
-                    {
-                        int t0 = p0[0], t1 = p0[d_[0]];
-                        localHistogram[t0]++; localHistogram[t1]++;
-                        p0 += d_[0]*2;
-                        t0 = p0[0]; t1 = p0[d_[0]];
-                        localHistogram[t0]++; localHistogram[t1]++;
-                        p0 += d_[0]*2;
-                    }
-                }
-
-                for( ; x < imageWidth_; x++, p0 += d_[0] )
-                {
-                    localHistogram[*p0]++;
-                }
-            }
-            else
-            {
-                for( x = 0; x < imageWidth_; x++, p0 += d_[0] )
-                {
-                    if( mask[x] )
-                    {
-                        localHistogram[*p0]++;
-                    }
-                }
-                mask += mstep_;
-            }
-        }
-
-        lock.acquire(*histogramWriteLock_);
-        for(int i = 0; i < 256; i++ )
-        {
-            size_t hidx = tab_[i];
-            if( hidx < OUT_OF_RANGE )
-            {
-                *(int*)((globalHistogram_ + hidx)) += localHistogram[i];
-            }
-        }
-        lock.release();
-    }
-
-    static bool isFit( const Mat& histogram, const Size imageSize )
-    {
-        return ( histogram.total() >= 8
-                && imageSize.width * imageSize.height >= 160*120 );
-    }
-
-private:
-    uchar* p_[one];
-    uchar* mask_;
-    int mstep_;
-    int step_[one];
-    int d_[one];
-    int imageWidth_;
-    Size imageSize_;
-    Size histSize_;
-    int histType_;
-    size_t* tab_;
-    tbb::mutex* histogramWriteLock_;
-    uchar* globalHistogram_;
-};
-
-class CalcHist2D_8uInvoker
-{
-public:
-    CalcHist2D_8uInvoker( const vector<uchar*>& _ptrs, const vector<int>& _deltas,
-                          Size imsize, Mat& hist, int dims, const vector<size_t>& _tab,
-                          tbb::mutex* lock )
-        : mask_(_ptrs[dims]),
-          mstep_(_deltas[dims*2 + 1]),
-          imageWidth_(imsize.width),
-          histSize_(hist.size()), histType_(hist.type()),
-          tab_((size_t*)&_tab[0]),
-          histogramWriteLock_(lock),
-          globalHistogram_(hist.data)
-    {
-        p_[0] = (uchar*)(&_ptrs[0])[0]; p_[1] = (uchar*)(&_ptrs[0])[1];
-        step_[0] = (&_deltas[0])[1];    step_[1] = (&_deltas[0])[3];
-        d_[0] = (&_deltas[0])[0];       d_[1] = (&_deltas[0])[2];
-    }
-
-    void operator()( const BlockedRange& range ) const
-    {
-        uchar* p0 = p_[0] + range.begin()*(step_[0] + imageWidth_*d_[0]);
-        uchar* p1 = p_[1] + range.begin()*(step_[1] + imageWidth_*d_[1]);
-        uchar* mask = mask_ + range.begin()*mstep_;
-
-        Mat localHist = Mat::zeros(histSize_, histType_);
-        uchar* localHistData = localHist.data;
-        tbb::mutex::scoped_lock lock;
-
-        for(int i = range.begin(); i < range.end(); i++, p0 += step_[0], p1 += step_[1])
-        {
-            if( !mask_ )
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0], p1 += d_[1] )
-                {
-                    size_t idx = tab_[*p0] + tab_[*p1 + 256];
-                    if( idx < OUT_OF_RANGE )
-                    {
-                        ++*(int*)(localHistData + idx);
-                    }
-                }
-            }
-            else
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0], p1 += d_[1] )
-                {
-                    size_t idx;
-                    if( mask[x] && (idx = tab_[*p0] + tab_[*p1 + 256]) < OUT_OF_RANGE )
-                    {
-                        ++*(int*)(localHistData + idx);
-                    }
-                }
-                mask += mstep_;
-            }
-        }
-
-        lock.acquire(*histogramWriteLock_);
-        for(int i = 0; i < histSize_.width*histSize_.height; i++)
-        {
-            ((int*)globalHistogram_)[i] += ((int*)localHistData)[i];
-        }
-        lock.release();
-    }
-
-    static bool isFit( const Mat& histogram, const Size imageSize )
-    {
-        return ( (histogram.total() > 4*4 &&  histogram.total() <= 116*116
-                  && imageSize.width * imageSize.height >= 320*240)
-                 || (histogram.total() > 116*116 && imageSize.width * imageSize.height >= 1280*720) );
-    }
-
-private:
-    uchar* p_[two];
-    uchar* mask_;
-    int step_[two];
-    int d_[two];
-    int mstep_;
-    int imageWidth_;
-    Size histSize_;
-    int histType_;
-    size_t* tab_;
-    tbb::mutex* histogramWriteLock_;
-    uchar* globalHistogram_;
-};
-
-class CalcHist3D_8uInvoker
-{
-public:
-    CalcHist3D_8uInvoker( const vector<uchar*>& _ptrs, const vector<int>& _deltas,
-                          Size imsize, Mat& hist, int dims, const vector<size_t>& tab )
-        : mask_(_ptrs[dims]),
-          mstep_(_deltas[dims*2 + 1]),
-          histogramSize_(hist.size.p), histogramType_(hist.type()),
-          imageWidth_(imsize.width),
-          tab_((size_t*)&tab[0]),
-          globalHistogram_(hist.data)
-    {
-        p_[0] = (uchar*)(&_ptrs[0])[0]; p_[1] = (uchar*)(&_ptrs[0])[1]; p_[2] = (uchar*)(&_ptrs[0])[2];
-        step_[0] = (&_deltas[0])[1];    step_[1] = (&_deltas[0])[3];    step_[2] = (&_deltas[0])[5];
-        d_[0] = (&_deltas[0])[0];       d_[1] = (&_deltas[0])[2];       d_[2] = (&_deltas[0])[4];
-    }
+    bool isContinuous = true;
+    sptrs.resize(dims + 1);
 
-    void operator()( const BlockedRange& range ) const
+    for( int i = 0; i < dims; i++ )
     {
-        uchar* p0 = p_[0] + range.begin()*(step_[0] + imageWidth_*d_[0]);
-        uchar* p1 = p_[1] + range.begin()*(step_[1] + imageWidth_*d_[1]);
-        uchar* p2 = p_[2] + range.begin()*(step_[2] + imageWidth_*d_[2]);
-        uchar* mask = mask_ + range.begin()*mstep_;
-
-        for(int i = range.begin(); i < range.end(); i++, p0 += step_[0], p1 += step_[1], p2 += step_[2] )
-        {
-            if( !mask_ )
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0], p1 += d_[1], p2 += d_[2] )
-                {
-                    size_t idx = tab_[*p0] + tab_[*p1 + 256] + tab_[*p2 + 512];
-                    if( idx < OUT_OF_RANGE )
-                    {
-                        ( *(tbb::atomic<int>*)(globalHistogram_ + idx) ).fetch_and_add(1);
-                    }
-                }
-            }
-            else
-            {
-                for( int x = 0; x < imageWidth_; x++, p0 += d_[0], p1 += d_[1], p2 += d_[2] )
-                {
-                    size_t idx;
-                    if( mask[x] && (idx = tab_[*p0] + tab_[*p1 + 256] + tab_[*p2 + 512]) < OUT_OF_RANGE )
-                    {
-                        (*(tbb::atomic<int>*)(globalHistogram_ + idx)).fetch_and_add(1);
-                    }
-                }
-                mask += mstep_;
-            }
-        }
+        sptrs[i] = ptrs[i] + (size_t)y0*(imsize.width*deltas[i*2] + deltas[i*2+1])*esz;
+        isContinuous = isContinuous && deltas[i*2+1] == 0;
     }
 
-    static bool isFit( const Mat& histogram, const Size imageSize )
+    if( ptrs[dims] )
     {
-        return ( histogram.total() >= 128*128*128
-                 && imageSize.width * imageSize.width >= 320*240 );
+        sptrs[dims] = ptrs[dims] + (size_t)y0*deltas[dims*2+1]*esz2;
+        isContinuous = isContinuous && deltas[dims*2+1] == imsize.width;
     }
+    else
+        sptrs[dims] = 0;
 
-private:
-    uchar* p_[three];
-    uchar* mask_;
-    int mstep_;
-    int step_[three];
-    int d_[three];
-    int* histogramSize_;
-    int histogramType_;
-    int imageWidth_;
-    size_t* tab_;
-    uchar* globalHistogram_;
-};
-
-static void
-callCalcHist2D_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
-                   Size imsize, Mat& hist, int dims,  vector<size_t>& _tab )
-{
-    int grainSize = imsize.height / tbb::task_scheduler_init::default_num_threads();
-    tbb::mutex histogramWriteLock;
-
-    CalcHist2D_8uInvoker body(_ptrs, _deltas, imsize, hist, dims, _tab, &histogramWriteLock);
-    parallel_for(BlockedRange(0, imsize.height, grainSize), body);
+    return isContinuous ? Size(imsize.width*(y1 - y0), 1) : Size(imsize.width, y1 - y0);
 }
 
-static void
-callCalcHist3D_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
-                   Size imsize, Mat& hist, int dims,  vector<size_t>& _tab )
-{
-    CalcHist3D_8uInvoker body(_ptrs, _deltas, imsize, hist, dims, _tab);
-    parallel_for(BlockedRange(0, imsize.height), body);
-}
-#endif
+////////////////////////////////// C A L C U L A T E    H I S T O G R A M ////////////////////////////////////
 
 template<typename T> static void
 calcHist_( vector<uchar*>& _ptrs, const vector<int>& _deltas,
@@ -768,11 +251,6 @@ calcHist_( vector<uchar*>& _ptrs, const vector<int>& _deltas,
 
         if( dims == 1 )
         {
-#ifdef HAVE_TBB
-            calcHist1D_Invoker<T> body(_ptrs, _deltas, hist, _uniranges, size[0], dims, imsize);
-            parallel_for(BlockedRange(0, imsize.height), body);
-            return;
-#endif
             double a = uniranges[0], b = uniranges[1];
             int sz = size[0], d0 = deltas[0], step0 = deltas[1];
             const T* p0 = (const T*)ptrs[0];
@@ -798,11 +276,6 @@ calcHist_( vector<uchar*>& _ptrs, const vector<int>& _deltas,
         }
         else if( dims == 2 )
         {
-#ifdef HAVE_TBB
-            calcHist2D_Invoker<T> body(_ptrs, _deltas, hist, _uniranges, size, dims, imsize, hstep);
-            parallel_for(BlockedRange(0, imsize.height), body);
-            return;
-#endif
             double a0 = uniranges[0], b0 = uniranges[1], a1 = uniranges[2], b1 = uniranges[3];
             int sz0 = size[0], sz1 = size[1];
             int d0 = deltas[0], step0 = deltas[1],
@@ -834,14 +307,6 @@ calcHist_( vector<uchar*>& _ptrs, const vector<int>& _deltas,
         }
         else if( dims == 3 )
         {
-#ifdef HAVE_TBB
-            if( calcHist3D_Invoker<T>::isFit(hist, imsize) )
-            {
-                calcHist3D_Invoker<T> body(_ptrs, _deltas, imsize, hist, uniranges, dims, hstep, size);
-                parallel_for(BlockedRange(0, imsize.height), body);
-                return;
-            }
-#endif
             double a0 = uniranges[0], b0 = uniranges[1],
                    a1 = uniranges[2], b1 = uniranges[3],
                    a2 = uniranges[4], b2 = uniranges[5];
@@ -977,8 +442,7 @@ calcHist_( vector<uchar*>& _ptrs, const vector<int>& _deltas,
 
 static void
 calcHist_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
-             Size imsize, Mat& hist, int dims, const float** _ranges,
-             const double* _uniranges, bool uniform )
+             Size imsize, Mat& hist, int dims, const size_t* tab )
 {
     uchar** ptrs = &_ptrs[0];
     const int* deltas = &_deltas[0];
@@ -986,29 +450,17 @@ calcHist_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
     int x;
     const uchar* mask = _ptrs[dims];
     int mstep = _deltas[dims*2 + 1];
-    vector<size_t> _tab;
-
-    calcHistLookupTables_8u( hist, SparseMat(), dims, _ranges, _uniranges, uniform, false, _tab );
-    const size_t* tab = &_tab[0];
 
     if( dims == 1 )
     {
-#ifdef HAVE_TBB
-        if( CalcHist1D_8uInvoker::isFit(hist, imsize) )
-        {
-            int treadsNumber = tbb::task_scheduler_init::default_num_threads();
-            int grainSize = imsize.height/treadsNumber;
-            tbb::mutex histogramWriteLock;
-
-            CalcHist1D_8uInvoker body(_ptrs, _deltas, imsize, hist, dims, _tab, &histogramWriteLock);
-            parallel_for(BlockedRange(0, imsize.height, grainSize), body);
-            return;
-        }
-#endif
         int d0 = deltas[0], step0 = deltas[1];
-        int matH[256] = { 0, };
+        // 4 interleaved partial histograms, so that runs of equal values
+        // do not serialize on a single counter
+        int matH[4][256];
         const uchar* p0 = (const uchar*)ptrs[0];
 
+        memset( matH, 0, sizeof(matH) );
+
         for( ; imsize.height--; p0 += step0, mask += mstep )
         {
             if( !mask )
@@ -1018,9 +470,9 @@ calcHist_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
                     for( x = 0; x <= imsize.width - 4; x += 4 )
                     {
                         int t0 = p0[x], t1 = p0[x+1];
-                        matH[t0]++; matH[t1]++;
+                        matH[0][t0]++; matH[1][t1]++;
                         t0 = p0[x+2]; t1 = p0[x+3];
-                        matH[t0]++; matH[t1]++;
+                        matH[2][t0]++; matH[3][t1]++;
                     }
                     p0 += x;
                 }
@@ -1028,38 +480,31 @@ calcHist_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
                     for( x = 0; x <= imsize.width - 4; x += 4 )
                     {
                         int t0 = p0[0], t1 = p0[d0];
-                        matH[t0]++; matH[t1]++;
+                        matH[0][t0]++; matH[1][t1]++;
                         p0 += d0*2;
                         t0 = p0[0]; t1 = p0[d0];
-                        matH[t0]++; matH[t1]++;
+                        matH[2][t0]++; matH[3][t1]++;
                         p0 += d0*2;
                     }
 
                 for( ; x < imsize.width; x++, p0 += d0 )
-                    matH[*p0]++;
+                    matH[0][*p0]++;
             }
             else
                 for( x = 0; x < imsize.width; x++, p0 += d0 )
                     if( mask[x] )
-                        matH[*p0]++;
+                        matH[x & 3][*p0]++;
         }
 
         for(int i = 0; i < 256; i++ )
         {
             size_t hidx = tab[i];
             if( hidx < OUT_OF_RANGE )
-                *(int*)(H + hidx) += matH[i];
+                *(int*)(H + hidx) += matH[0][i] + matH[1][i] + matH[2][i] + matH[3][i];
         }
     }
     else if( dims == 2 )
     {
-#ifdef HAVE_TBB
-        if( CalcHist2D_8uInvoker::isFit(hist, imsize) )
-        {
-            callCalcHist2D_8u(_ptrs, _deltas, imsize, hist, dims, _tab);
-            return;
-        }
-#endif
         int d0 = deltas[0], step0 = deltas[1],
             d1 = deltas[2], step1 = deltas[3];
         const uchar* p0 = (const uchar*)ptrs[0];
@@ -1085,13 +530,6 @@ calcHist_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
     }
     else if( dims == 3 )
     {
-#ifdef HAVE_TBB
-        if( CalcHist3D_8uInvoker::isFit(hist, imsize) )
-        {
-            callCalcHist3D_8u(_ptrs, _deltas, imsize, hist, dims, _tab);
-            return;
-        }
-#endif
         int d0 = deltas[0], step0 = deltas[1],
             d1 = deltas[2], step1 = deltas[3],
             d2 = deltas[4], step2 = deltas[5];
@@ -1169,6 +607,64 @@ calcHist_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
     }
 }
 
+
+class CalcHistInvoker : public ParallelLoopBody
+{
+public:
+    CalcHistInvoker( const vector<uchar*>& _ptrs, const vector<int>& _deltas, Size _imsize,
+                     const Mat& _hist, int _dims, int _depth, const float** _ranges,
+                     const double* _uniranges, bool _uniform, const size_t* _tab, Mutex* _mutex )
+        : ptrs(_ptrs), deltas(_deltas), imsize(_imsize), hist(_hist), dims(_dims), depth(_depth),
+          ranges(_ranges), uniranges(_uniranges), uniform(_uniform), tab(_tab), mutex(_mutex)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        vector<uchar*> sptrs;
+        Size ssize = histStripe( ptrs, deltas, dims, imsize, CV_ELEM_SIZE1(depth), 1,
+                                 range.start, range.end, sptrs );
+
+        // a stripe covering the whole image accumulates directly into the histogram,
+        // otherwise a private partial histogram is merged under the lock
+        bool whole = range.start == 0 && range.end == imsize.height;
+        Mat h;
+        if( whole )
+            h = hist;
+        else
+        {
+            h.create(hist.dims, hist.size, CV_32S);
+            h = Scalar::all(0);
+        }
+
+        if( depth == CV_8U )
+            calcHist_8u(sptrs, deltas, ssize, h, dims, tab);
+        else if( depth == CV_16U )
+            calcHist_<ushort>(sptrs, deltas, ssize, h, dims, ranges, uniranges, uniform);
+        else
+            calcHist_<float>(sptrs, deltas, ssize, h, dims, ranges, uniranges, uniform);
+
+        if( !whole )
+        {
+            AutoLock lock(*mutex);
+            Mat dst = hist;
+            dst += h;
+        }
+    }
+
+private:
+    const vector<uchar*>& ptrs;
+    const vector<int>& deltas;
+    Size imsize;
+    Mat hist;
+    int dims, depth;
+    const float** ranges;
+    const double* uniranges;
+    bool uniform;
+    const size_t* tab;
+    Mutex* mutex;
+};
+
 }
 
 void cv::calcHist( const Mat* images, int nimages, const int* channels,
@@ -1200,16 +696,28 @@ void cv::calcHist( const Mat* images, int nimages, const int* channels,
     const double* _uniranges = uniform ? &uniranges[0] : 0;
 
     int depth = images[0].depth();
+    vector<size_t> tab;
 
     if( depth == CV_8U )
-        calcHist_8u(ptrs, deltas, imsize, ihist, dims, ranges, _uniranges, uniform );
-    else if( depth == CV_16U )
-        calcHist_<ushort>(ptrs, deltas, imsize, ihist, dims, ranges, _uniranges, uniform );
-    else if( depth == CV_32F )
-        calcHist_<float>(ptrs, deltas, imsize, ihist, dims, ranges, _uniranges, uniform );
-    else
+        calcHistLookupTables_8u( ihist, SparseMat(), dims, ranges, _uniranges, uniform, false, tab );
+    else if( depth != CV_16U && depth != CV_32F )
         CV_Error(CV_StsUnsupportedFormat, "");
 
+    // every stripe owns a partial histogram, so the image is split only
+    // when it is large compared to the histogram
+    double npix = (double)imsize.width*imsize.height;
+    int nstripes = std::min(getNumThreads(),
+                            cvFloor(npix/std::max((double)ihist.total()*4, (double)(1 << 16))));
+    nstripes = std::min(nstripes, imsize.height);
+
+    Mutex mutex;
+    CalcHistInvoker body(ptrs, deltas, imsize, ihist, dims, depth, ranges, _uniranges,
+                         uniform, tab.empty() ? 0 : &tab[0], &mutex);
+    if( nstripes > 1 )
+        parallel_for_(Range(0, imsize.height), body, nstripes);
+    else
+        body(Range(0, imsize.height));
+
     ihist.convertTo(hist, CV_32F);
 }
 
@@ -1373,6 +881,8 @@ static void calcHist( const Mat* images, int nimages, const int* channels,
     const double* _uniranges = uniform ? &uniranges[0] : 0;
 
     int depth = images[0].depth();
+    imsize = histStripe( ptrs, deltas, dims, imsize, CV_ELEM_SIZE1(depth), 1,
+                         0, imsize.height, ptrs );
     if( depth == CV_8U )
         calcSparseHist_8u(ptrs, deltas, imsize, hist, dims, ranges, _uniranges, uniform );
     else if( depth == CV_16U )
@@ -1606,8 +1116,7 @@ calcBackProj_( vector<uchar*>& _ptrs, const vector<int>& _deltas,
 
 static void
 calcBackProj_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
-                 Size imsize, const Mat& hist, int dims, const float** _ranges,
-                 const double* _uniranges, float scale, bool uniform )
+                 Size imsize, const Mat& hist, int dims, const size_t* tab, float scale )
 {
     uchar** ptrs = &_ptrs[0];
     const int* deltas = &_deltas[0];
@@ -1615,10 +1124,6 @@ calcBackProj_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
     int i, x;
     uchar* bproj = _ptrs[dims];
     int bpstep = _deltas[dims*2 + 1];
-    vector<size_t> _tab;
-
-    calcHistLookupTables_8u( hist, SparseMat(), dims, _ranges, _uniranges, uniform, false, _tab );
-    const size_t* tab = &_tab[0];
 
     if( dims == 1 )
     {
@@ -1726,6 +1231,45 @@ calcBackProj_8u( vector<uchar*>& _ptrs, const vector<int>& _deltas,
     }
 }
 
+
+class CalcBackProjInvoker : public ParallelLoopBody
+{
+public:
+    CalcBackProjInvoker( const vector<uchar*>& _ptrs, const vector<int>& _deltas, Size _imsize,
+                         const Mat& _hist, int _dims, int _depth, const float** _ranges,
+                         const double* _uniranges, float _scale, bool _uniform, const size_t* _tab )
+        : ptrs(_ptrs), deltas(_deltas), imsize(_imsize), hist(_hist), dims(_dims), depth(_depth),
+          ranges(_ranges), uniranges(_uniranges), scale(_scale), uniform(_uniform), tab(_tab)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        vector<uchar*> sptrs;
+        size_t esz = CV_ELEM_SIZE1(depth);
+        Size ssize = histStripe( ptrs, deltas, dims, imsize, esz, esz, range.start, range.end, sptrs );
+
+        if( depth == CV_8U )
+            calcBackProj_8u(sptrs, deltas, ssize, hist, dims, tab, scale);
+        else if( depth == CV_16U )
+            calcBackProj_<ushort, ushort>(sptrs, deltas, ssize, hist, dims, ranges, uniranges, scale, uniform);
+        else
+            calcBackProj_<float, float>(sptrs, deltas, ssize, hist, dims, ranges, uniranges, scale, uniform);
+    }
+
+private:
+    const vector<uchar*>& ptrs;
+    const vector<int>& deltas;
+    Size imsize;
+    Mat hist;
+    int dims, depth;
+    const float** ranges;
+    const double* uniranges;
+    float scale;
+    bool uniform;
+    const size_t* tab;
+};
+
 }
 
 void cv::calcBackProject( const Mat* images, int nimages, const int* channels,
@@ -1747,14 +1291,22 @@ void cv::calcBackProject( const Mat* images, int nimages, const int* channels,
     const double* _uniranges = uniform ? &uniranges[0] : 0;
 
     int depth = images[0].depth();
+    vector<size_t> tab;
+
     if( depth == CV_8U )
-        calcBackProj_8u(ptrs, deltas, imsize, hist, dims, ranges, _uniranges, (float)scale, uniform);
-    else if( depth == CV_16U )
-        calcBackProj_<ushort, ushort>(ptrs, deltas, imsize, hist, dims, ranges, _uniranges, (float)scale, uniform );
-    else if( depth == CV_32F )
-        calcBackProj_<float, float>(ptrs, deltas, imsize, hist, dims, ranges, _uniranges, (float)scale, uniform );
-    else
+        calcHistLookupTables_8u( hist, SparseMat(), dims, ranges, _uniranges, uniform, false, tab );
+    else if( depth != CV_16U && depth != CV_32F )
         CV_Error(CV_StsUnsupportedFormat, "");
+
+    // the rows of the back projection are independent
+    int nstripes = std::min(imsize.height, cvFloor((double)imsize.width*imsize.height/(1 << 16)));
+
+    CalcBackProjInvoker body(ptrs, deltas, imsize, hist, dims, depth, ranges, _uniranges,
+                             (float)scale, uniform, tab.empty() ? 0 : &tab[0]);
+    if( nstripes > 1 )
+        parallel_for_(Range(0, imsize.height), body, nstripes);
+    else
+        body(Range(0, imsize.height));
 }
 
 
@@ -1910,6 +1462,8 @@ void cv::calcBackProject( const Mat* images, int nimages, const int* channels,
     const double* _uniranges = uniform ? &uniranges[0] : 0;
 
     int depth = images[0].depth();
+    imsize = histStripe( ptrs, deltas, dims, imsize, CV_ELEM_SIZE1(depth), CV_ELEM_SIZE1(depth),
+                         0, imsize.height, ptrs );
     if( depth == CV_8U )
         calcSparseBackProj_8u(ptrs, deltas, imsize, hist, dims, ranges,
                               _uniranges, (float)scale, uniform);
@@ -2982,29 +2536,26 @@ cvCalcProbDensity( const CvHistogram* hist, const CvHistogram* hist_mask,
     }
 }
 
-class EqualizeHistCalcHist_Invoker
+class EqualizeHistCalcHist_Invoker : public cv::ParallelLoopBody
 {
 public:
     enum {HIST_SZ = 256};
 
-#ifdef HAVE_TBB
-    typedef tbb::mutex* MutextPtr;
-#else
-    typedef void* MutextPtr;
-#endif
-
-    EqualizeHistCalcHist_Invoker(cv::Mat& src, int* histogram, MutextPtr histogramLock)
+    EqualizeHistCalcHist_Invoker(cv::Mat& src, int* histogram, cv::Mutex* histogramLock)
         : src_(src), globalHistogram_(histogram), histogramLock_(histogramLock)
     { }
 
-    void operator()( const cv::BlockedRange& rowRange ) const
+    void operator()( const cv::Range& rowRange ) const
     {
-        int localHistogram[HIST_SZ] = {0, };
+        // 4 interleaved partial histograms, so that runs of equal values
+        // do not serialize on a single counter
+        int localHistogram[4][HIST_SZ];
+        memset(localHistogram, 0, sizeof(localHistogram));
 
         const size_t sstep = src_.step;
 
         int width = src_.cols;
-        int height = rowRange.end() - rowRange.begin();
+        int height = rowRange.end - rowRange.start;
 
         if (src_.isContinuous())
         {
@@ -3012,37 +2563,31 @@ public:
             height = 1;
         }
 
-        for (const uchar* ptr = src_.ptr<uchar>(rowRange.begin()); height--; ptr += sstep)
+        for (const uchar* ptr = src_.ptr<uchar>(rowRange.start); height--; ptr += sstep)
         {
             int x = 0;
             for (; x <= width - 4; x += 4)
             {
                 int t0 = ptr[x], t1 = ptr[x+1];
-                localHistogram[t0]++; localHistogram[t1]++;
+                localHistogram[0][t0]++; localHistogram[1][t1]++;
                 t0 = ptr[x+2]; t1 = ptr[x+3];
-                localHistogram[t0]++; localHistogram[t1]++;
+                localHistogram[2][t0]++; localHistogram[3][t1]++;
             }
 
             for (; x < width; ++x)
-                localHistogram[ptr[x]]++;
+                localHistogram[0][ptr[x]]++;
         }
 
-#ifdef HAVE_TBB
-        tbb::mutex::scoped_lock lock(*histogramLock_);
-#endif
+        cv::AutoLock lock(*histogramLock_);
 
         for( int i = 0; i < HIST_SZ; i++ )
-            globalHistogram_[i] += localHistogram[i];
+            globalHistogram_[i] += localHistogram[0][i] + localHistogram[1][i] +
+                                   localHistogram[2][i] + localHistogram[3][i];
     }
 
     static bool isWorthParallel( const cv::Mat& src )
     {
-#ifdef HAVE_TBB
         return ( src.total() >= 640*480 );
-#else
-        (void)src;
-        return false;
-#endif
     }
 
 private:
@@ -3050,10 +2595,10 @@ private:
 
     cv::Mat& src_;
     int* globalHistogram_;
-    MutextPtr histogramLock_;
+    cv::Mutex* histogramLock_;
 };
 
-class EqualizeHistLut_Invoker
+class EqualizeHistLut_Invoker : public cv::ParallelLoopBody
 {
 public:
     EqualizeHistLut_Invoker( cv::Mat& src, cv::Mat& dst, int* lut )
@@ -3062,13 +2607,13 @@ public:
           lut_(lut)
     { }
 
-    void operator()( const cv::BlockedRange& rowRange ) const
+    void operator()( const cv::Range& rowRange ) const
     {
         const size_t sstep = src_.step;
         const size_t dstep = dst_.step;
 
         int width = src_.cols;
-        int height = rowRange.end() - rowRange.begin();
+        int height = rowRange.end - rowRange.start;
         int* lut = lut_;
 
         if (src_.isContinuous() && dst_.isContinuous())
@@ -3077,8 +2622,8 @@ public:
             height = 1;
         }
 
-        const uchar* sptr = src_.ptr<uchar>(rowRange.begin());
-        uchar* dptr = dst_.ptr<uchar>(rowRange.begin());
+        const uchar* sptr = src_.ptr<uchar>(rowRange.start);
+        uchar* dptr = dst_.ptr<uchar>(rowRange.start);
 
         for (; height--; sptr += sstep, dptr += dstep)
         {
@@ -3107,12 +2652,7 @@ public:
 
     static bool isWorthParallel( const cv::Mat& src )
     {
-#ifdef HAVE_TBB
         return ( src.total() >= 640*480 );
-#else
-        (void)src;
-        return false;
-#endif
     }
 
 private:
@@ -3139,23 +2679,18 @@ void cv::equalizeHist( InputArray _src, OutputArray _dst )
     if(src.empty())
         return;
 
-#ifdef HAVE_TBB
-    tbb::mutex histogramLockInstance;
-    EqualizeHistCalcHist_Invoker::MutextPtr histogramLock = &histogramLockInstance;
-#else
-    EqualizeHistCalcHist_Invoker::MutextPtr histogramLock = 0;
-#endif
+    cv::Mutex histogramLock;
 
     const int hist_sz = EqualizeHistCalcHist_Invoker::HIST_SZ;
     int hist[hist_sz] = {0,};
     int lut[hist_sz];
 
-    EqualizeHistCalcHist_Invoker calcBody(src, hist, histogramLock);
+    EqualizeHistCalcHist_Invoker calcBody(src, hist, &histogramLock);
     EqualizeHistLut_Invoker      lutBody(src, dst, lut);
-    cv::BlockedRange heightRange(0, src.rows);
+    cv::Range heightRange(0, src.rows);
 
     if(EqualizeHistCalcHist_Invoker::isWorthParallel(src))
-        parallel_for(heightRange, calcBody);
+        parallel_for_(heightRange, calcBody);
     else
         calcBody(heightRange);
 
@@ -3179,7 +2714,7 @@ void cv::equalizeHist( InputArray _src, OutputArray _dst )
     }
 
     if(EqualizeHistLut_Invoker::isWorthParallel(src))
-        parallel_for(heightRange, lutBody);
+        parallel_for_(heightRange, lutBody);
     else
         lutBody(heightRange);
 }
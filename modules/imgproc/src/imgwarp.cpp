@@ -1798,13 +1798,126 @@ static int computeResizeAreaTab( int ssize, int dsize, int cn, double scale, Dec
 }
 
 
-}
+// Computes the tables of the separable resize: the source offsets and the interpolation
+// coefficients of every destination column (xofs, alpha; cn entries per column) and row
+// (yofs, beta). The coefficients are shorts when fixpt is set and floats otherwise.
+// [xmin, xmax) is the range of the columns whose kernel lies inside the source image.
+static void computeResizeTabs( Size ssize, Size dsize, int cn, bool fixpt,
+                               int interpolation, int ksize, double inv_scale_x, double inv_scale_y,
+                               int* xofs, void* _alpha, int* yofs, void* _beta,
+                               int& xmin, int& xmax )
+{
+    double scale_x = 1./inv_scale_x, scale_y = 1./inv_scale_y;
+    bool area_mode = interpolation == INTER_AREA;
+    int k, sx, sy, dx, dy, ksize2 = ksize/2;
+    float* alpha = (float*)_alpha;
+    short* ialpha = (short*)_alpha;
+    float* beta = (float*)_beta;
+    short* ibeta = (short*)_beta;
+    float fx, fy, cbuf[MAX_ESIZE];
 
+    xmin = 0;
+    xmax = dsize.width;
 
-//////////////////////////////////////////////////////////////////////////////////////////
+    for( dx = 0; dx < dsize.width; dx++ )
+    {
+        if( !area_mode )
+        {
+            fx = (float)((dx+0.5)*scale_x - 0.5);
+            sx = cvFloor(fx);
+            fx -= sx;
+        }
+        else
+        {
+            sx = cvFloor(dx*scale_x);
+            fx = (float)((dx+1) - (sx+1)*inv_scale_x);
+            fx = fx <= 0 ? 0.f : fx - cvFloor(fx);
+        }
 
-void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
-                 double inv_scale_x, double inv_scale_y, int interpolation )
+        if( sx < ksize2-1 )
+        {
+            xmin = dx+1;
+            if( sx < 0 )
+                fx = 0, sx = 0;
+        }
+
+        if( sx + ksize2 >= ssize.width )
+        {
+            xmax = std::min( xmax, dx );
+            if( sx >= ssize.width-1 )
+                fx = 0, sx = ssize.width-1;
+        }
+
+        for( k = 0, sx *= cn; k < cn; k++ )
+            xofs[dx*cn + k] = sx + k;
+
+        if( interpolation == INTER_CUBIC )
+            interpolateCubic( fx, cbuf );
+        else if( interpolation == INTER_LANCZOS4 )
+            interpolateLanczos4( fx, cbuf );
+        else
+        {
+            cbuf[0] = 1.f - fx;
+            cbuf[1] = fx;
+        }
+        if( fixpt )
+        {
+            for( k = 0; k < ksize; k++ )
+                ialpha[dx*cn*ksize + k] = saturate_cast<short>(cbuf[k]*INTER_RESIZE_COEF_SCALE);
+            for( ; k < cn*ksize; k++ )
+                ialpha[dx*cn*ksize + k] = ialpha[dx*cn*ksize + k - ksize];
+        }
+        else
+        {
+            for( k = 0; k < ksize; k++ )
+                alpha[dx*cn*ksize + k] = cbuf[k];
+            for( ; k < cn*ksize; k++ )
+                alpha[dx*cn*ksize + k] = alpha[dx*cn*ksize + k - ksize];
+        }
+    }
+
+    for( dy = 0; dy < dsize.height; dy++ )
+    {
+        if( !area_mode )
+        {
+            fy = (float)((dy+0.5)*scale_y - 0.5);
+            sy = cvFloor(fy);
+            fy -= sy;
+        }
+        else
+        {
+            sy = cvFloor(dy*scale_y);
+            fy = (float)((dy+1) - (sy+1)*inv_scale_y);
+            fy = fy <= 0 ? 0.f : fy - cvFloor(fy);
+        }
+
+        yofs[dy] = sy;
+        if( interpolation == INTER_CUBIC )
+            interpolateCubic( fy, cbuf );
+        else if( interpolation == INTER_LANCZOS4 )
+            interpolateLanczos4( fy, cbuf );
+        else
+        {
+            cbuf[0] = 1.f - fy;
+            cbuf[1] = fy;
+        }
+
+        if( fixpt )
+        {
+            for( k = 0; k < ksize; k++ )
+                ibeta[dy*ksize + k] = saturate_cast<short>(cbuf[k]*INTER_RESIZE_COEF_SCALE);
+        }
+        else
+        {
+            for( k = 0; k < ksize; k++ )
+                beta[dy*ksize + k] = cbuf[k];
+        }
+    }
+}
+
+// Returns the separable resize function for the depth and the interpolation method
+// (INTER_AREA stands for its bilinear emulation) together with its kernel size.
+static ResizeFunc getResizeFunc( int interpolation, int depth, int& ksize )
 {
     static ResizeFunc linear_tab[] =
     {
@@ -1891,6 +2004,20 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
         0
     };
 
+    ResizeFunc func = 0;
+    if( interpolation == INTER_CUBIC )
+        ksize = 4, func = cubic_tab[depth];
+    else if( interpolation == INTER_LANCZOS4 )
+        ksize = 8, func = lanczos4_tab[depth];
+    else if( interpolation == INTER_LINEAR || interpolation == INTER_AREA )
+        ksize = 2, func = linear_tab[depth];
+    else
+        CV_Error( CV_StsBadArg, "Unknown interpolation method" );
+    return func;
+}
+
+static ResizeAreaFastFunc getResizeAreaFastFunc( int depth )
+{
     static ResizeAreaFastFunc areafast_tab[] =
     {
         resizeAreaFast_<uchar, int, ResizeAreaFastVec<uchar, ResizeAreaFastVec_SIMD_8u> >,
@@ -1903,6 +2030,18 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
         0
     };
 
+    return areafast_tab[depth];
+}
+
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
+                 double inv_scale_x, double inv_scale_y, int interpolation )
+{
+    CV_TRACE_REGION("resize");
     static ResizeAreaFunc area_tab[] =
     {
         resizeArea_<uchar, float>, 0, resizeArea_<ushort, float>,
@@ -1968,7 +2107,7 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
                 AutoBuffer<int> _ofs(area + dsize.width*cn);
                 int* ofs = _ofs;
                 int* xofs = ofs + area;
-                ResizeAreaFastFunc func = areafast_tab[depth];
+                ResizeAreaFastFunc func = getResizeAreaFastFunc(depth);
                 CV_Assert( func != 0 );
 
                 for( sy = 0, k = 0; sy < iscale_y; sy++ )
@@ -2014,20 +2153,9 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
     }
 
     int xmin = 0, xmax = dsize.width, width = dsize.width*cn;
-    bool area_mode = interpolation == INTER_AREA;
     bool fixpt = depth == CV_8U;
-    float fx, fy;
-    ResizeFunc func=0;
-    int ksize=0, ksize2;
-    if( interpolation == INTER_CUBIC )
-        ksize = 4, func = cubic_tab[depth];
-    else if( interpolation == INTER_LANCZOS4 )
-        ksize = 8, func = lanczos4_tab[depth];
-    else if( interpolation == INTER_LINEAR || interpolation == INTER_AREA )
-        ksize = 2, func = linear_tab[depth];
-    else
-        CV_Error( CV_StsBadArg, "Unknown interpolation method" );
-    ksize2 = ksize/2;
+    int ksize = 0;
+    ResizeFunc func = getResizeFunc(interpolation, depth, ksize);
 
     CV_Assert( func != 0 );
 
@@ -2038,105 +2166,328 @@ void cv::resize( InputArray _src, OutputArray _dst, Size dsize,
     short* ialpha = (short*)alpha;
     float* beta = alpha + width*ksize;
     short* ibeta = ialpha + width*ksize;
-    float cbuf[MAX_ESIZE];
 
-    for( dx = 0; dx < dsize.width; dx++ )
+    computeResizeTabs( ssize, dsize, cn, fixpt, interpolation, ksize, inv_scale_x, inv_scale_y,
+                       xofs, fixpt ? (void*)ialpha : (void*)alpha,
+                       yofs, fixpt ? (void*)ibeta : (void*)beta, xmin, xmax );
+
+    func( src, dst, xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs,
+          fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize );
+}
+
+
+/****************************************************************************************\
+*                  Fused color conversion, resize and value scaling                       *
+\****************************************************************************************/
+
+namespace cv
+{
+
+// Color conversions whose destination row i depends only on the source row i;
+// demosaicing and the YUV 4:2:0 formats read several rows (or planes) at once.
+static bool isRowwiseColorConversion( int code )
+{
+    return !((COLOR_BayerBG2BGR <= code && code <= COLOR_BayerGR2BGR) ||
+             (COLOR_BayerBG2BGR_VNG <= code && code <= COLOR_BayerGR2BGR_VNG) ||
+             (COLOR_BayerBG2GRAY <= code && code <= COLOR_YUV2GRAY_420) ||
+             (COLOR_BayerBG2BGR_EA <= code && code <= COLOR_BayerGR2BGR_EA));
+}
+
+// Scales the resized rows into the destination, splitting the channels into planes
+// if needed. A planar destination holds the planes one under another.
+static void storePreprocessedRows( const Mat& rows, Mat& dst, int y0, int dheight,
+                                   int ddepth, double alpha, double beta, bool planar,
+                                   Mat& fbuf )
+{
+    int cn = rows.channels();
+    if( !planar || cn == 1 )
     {
-        if( !area_mode )
-        {
-            fx = (float)((dx+0.5)*scale_x - 0.5);
-            sx = cvFloor(fx);
-            fx -= sx;
-        }
-        else
-        {
-            sx = cvFloor(dx*scale_x);
-            fx = (float)((dx+1) - (sx+1)*inv_scale_x);
-            fx = fx <= 0 ? 0.f : fx - cvFloor(fx);
-        }
+        Mat drows = dst.rowRange(y0, y0 + rows.rows);
+        rows.convertTo(drows, ddepth, alpha, beta);
+        return;
+    }
 
-        if( sx < ksize2-1 )
-        {
-            xmin = dx+1;
-            if( sx < 0 )
-                fx = 0, sx = 0;
-        }
+    Mat planes[4];
+    CV_Assert( cn <= 4 );
+    rows.convertTo(fbuf, ddepth, alpha, beta);
+    for( int c = 0; c < cn; c++ )
+        planes[c] = dst.rowRange(c*dheight + y0, c*dheight + y0 + rows.rows);
+    split(fbuf, planes);
+}
 
-        if( sx + ksize2 >= ssize.width )
-        {
-            xmax = std::min( xmax, dx );
-            if( sx >= ssize.width-1 )
-                fx = 0, sx = ssize.width-1;
-        }
+enum { PREPROCESS_NN = 0, PREPROCESS_AREA_FAST = 1, PREPROCESS_GENERIC = 2 };
 
-        for( k = 0, sx *= cn; k < cn; k++ )
-            xofs[dx*cn + k] = sx + k;
+// Produces bands of the destination rows. For every band the source rows it needs are
+// color-converted into a small buffer, resized with the tables computed for the whole
+// image and scaled into the destination, so the intermediate images never leave the cache.
+class PreprocessInvoker : public ParallelLoopBody
+{
+public:
+    PreprocessInvoker( const Mat& _src, Mat& _dst, Size _dsize, int _code, int _ctype,
+                       int _mode, int _bandRows, double _alpha, double _beta, bool _planar )
+        : src(_src), dst(_dst), dsize(_dsize), code(_code), ctype(_ctype), mode(_mode),
+          bandRows(_bandRows), alpha(_alpha), beta(_beta), planar(_planar)
+    {
+        func = 0;
+        areaFastFunc = 0;
+        xofs = yofs = 0;
+        ralpha = rbeta = 0;
+        ksize = xmin = xmax = iscale_x = iscale_y = 0;
+        ify = 0;
+    }
 
-        if( interpolation == INTER_CUBIC )
-            interpolateCubic( fx, cbuf );
-        else if( interpolation == INTER_LANCZOS4 )
-            interpolateLanczos4( fx, cbuf );
-        else
-        {
-            cbuf[0] = 1.f - fx;
-            cbuf[1] = fx;
-        }
-        if( fixpt )
-        {
-            for( k = 0; k < ksize; k++ )
-                ialpha[dx*cn*ksize + k] = saturate_cast<short>(cbuf[k]*INTER_RESIZE_COEF_SCALE);
-            for( ; k < cn*ksize; k++ )
-                ialpha[dx*cn*ksize + k] = ialpha[dx*cn*ksize + k - ksize];
-        }
-        else
-        {
-            for( k = 0; k < ksize; k++ )
-                alpha[dx*cn*ksize + k] = cbuf[k];
-            for( ; k < cn*ksize; k++ )
-                alpha[dx*cn*ksize + k] = alpha[dx*cn*ksize + k - ksize];
-        }
+    void setNearest( const int* _xofs, double _ify )
+    {
+        xofs = _xofs;
+        ify = _ify;
     }
 
-    for( dy = 0; dy < dsize.height; dy++ )
+    void setAreaFast( ResizeAreaFastFunc _func, const int* _xofs, int _iscale_x, int _iscale_y )
     {
-        if( !area_mode )
-        {
-            fy = (float)((dy+0.5)*scale_y - 0.5);
-            sy = cvFloor(fy);
-            fy -= sy;
-        }
-        else
-        {
-            sy = cvFloor(dy*scale_y);
-            fy = (float)((dy+1) - (sy+1)*inv_scale_y);
-            fy = fy <= 0 ? 0.f : fy - cvFloor(fy);
-        }
+        areaFastFunc = _func;
+        xofs = _xofs;
+        iscale_x = _iscale_x;
+        iscale_y = _iscale_y;
+    }
 
-        yofs[dy] = sy;
-        if( interpolation == INTER_CUBIC )
-            interpolateCubic( fy, cbuf );
-        else if( interpolation == INTER_LANCZOS4 )
-            interpolateLanczos4( fy, cbuf );
-        else
-        {
-            cbuf[0] = 1.f - fy;
-            cbuf[1] = fy;
-        }
+    void setGeneric( ResizeFunc _func, int _ksize, const int* _xofs, const void* _alpha,
+                     const int* _yofs, const void* _beta, int _xmin, int _xmax )
+    {
+        func = _func;
+        ksize = _ksize;
+        xofs = _xofs;
+        ralpha = _alpha;
+        yofs = _yofs;
+        rbeta = _beta;
+        xmin = _xmin;
+        xmax = _xmax;
+    }
 
-        if( fixpt )
+    void operator()( const Range& range ) const
+    {
+        int ddepth = dst.depth(), depth = CV_MAT_DEPTH(ctype), cn = CV_MAT_CN(ctype);
+        int pix_size = CV_ELEM_SIZE(ctype), ksize2 = ksize/2, H = src.rows;
+        bool direct = ddepth == depth && !planar && alpha == 1 && beta == 0;
+        size_t betaStep = (depth == CV_8U ? sizeof(short) : sizeof(float))*ksize;
+        Mat cbuf, rbuf, fbuf, _dst = dst;
+        AutoBuffer<int> _ofs(std::max(iscale_x*iscale_y, std::max(bandRows, 1)));
+
+        for( int y0 = range.start; y0 < range.end; y0 += bandRows )
         {
-            for( k = 0; k < ksize; k++ )
-                ibeta[dy*ksize + k] = saturate_cast<short>(cbuf[k]*INTER_RESIZE_COEF_SCALE);
+            int y1 = std::min(y0 + bandRows, range.end), r0, r1;
+
+            if( mode == PREPROCESS_NN )
+            {
+                r0 = std::min(cvFloor(y0*ify), H - 1);
+                r1 = std::min(cvFloor((y1 - 1)*ify), H - 1) + 1;
+            }
+            else if( mode == PREPROCESS_AREA_FAST )
+            {
+                r0 = y0*iscale_y;
+                r1 = std::min(y1*iscale_y, H);
+            }
+            else
+            {
+                r0 = clip(yofs[y0] - ksize2 + 1, 0, H);
+                r1 = clip(yofs[y1 - 1] + ksize2, 0, H) + 1;
+            }
+
+            Mat strip = src.rowRange(r0, r1);
+            if( code >= 0 )
+            {
+                cvtColor(strip, cbuf, code);
+                strip = cbuf;
+            }
+
+            Mat rows;
+            if( direct )
+                rows = _dst.rowRange(y0, y1);
+            else
+            {
+                rbuf.create(y1 - y0, dsize.width, ctype);
+                rows = rbuf;
+            }
+
+            if( mode == PREPROCESS_NN )
+            {
+                for( int y = y0; y < y1; y++ )
+                {
+                    const uchar* S = strip.ptr(std::min(cvFloor(y*ify), H - 1) - r0);
+                    uchar* D = rows.ptr(y - y0);
+                    for( int x = 0; x < dsize.width; x++, D += pix_size )
+                        memcpy(D, S + xofs[x], pix_size);
+                }
+            }
+            else if( mode == PREPROCESS_AREA_FAST )
+            {
+                // the offsets of the averaged pixels depend on the step of the strip
+                int* ofs = _ofs;
+                size_t srcstep = strip.step / strip.elemSize1();
+                for( int sy = 0, k = 0; sy < iscale_y; sy++ )
+                    for( int sx = 0; sx < iscale_x; sx++ )
+                        ofs[k++] = (int)(sy*srcstep + sx*cn);
+                areaFastFunc( strip, rows, ofs, xofs, iscale_x, iscale_y );
+            }
+            else
+            {
+                int* lyofs = _ofs;
+                for( int y = y0; y < y1; y++ )
+                    lyofs[y - y0] = yofs[y] - r0;
+                func( strip, rows, xofs, ralpha, lyofs,
+                      (const uchar*)rbeta + betaStep*y0, xmin, xmax, ksize );
+            }
+
+            if( !direct )
+                storePreprocessedRows( rows, _dst, y0, dsize.height, ddepth,
+                                       alpha, beta, planar, fbuf );
         }
+    }
+
+private:
+    Mat src;
+    Mat dst;
+    Size dsize;
+    int code, ctype, mode, bandRows;
+    double alpha, beta;
+    bool planar;
+
+    ResizeFunc func;
+    ResizeAreaFastFunc areaFastFunc;
+    const int *xofs, *yofs;
+    const void *ralpha, *rbeta;
+    int ksize, xmin, xmax, iscale_x, iscale_y;
+    double ify;
+};
+
+}
+
+void cv::preprocess( InputArray _src, OutputArray _dst, Size dsize, int code,
+                     int interpolation, int dtype, double alpha, double beta, bool planar )
+{
+    CV_TRACE_REGION("preprocess");
+
+    Mat src = _src.getMat();
+    CV_Assert( src.dims <= 2 && src.rows > 0 && src.cols > 0 && dsize.area() > 0 );
+
+    // the conversions that need several source rows per destination row go first
+    if( code >= 0 && !isRowwiseColorConversion(code) )
+    {
+        Mat converted;
+        cvtColor(src, converted, code);
+        src = converted;
+        code = -1;
+    }
+
+    // the type of the converted image; converting a single row also initializes the
+    // tables the conversion shares between the threads
+    int ctype = src.type();
+    if( code >= 0 )
+    {
+        Mat probe;
+        cvtColor(src.row(0), probe, code);
+        ctype = probe.type();
+    }
+
+    int depth = CV_MAT_DEPTH(ctype), cn = CV_MAT_CN(ctype);
+    int ddepth = dtype < 0 ? depth : CV_MAT_DEPTH(dtype);
+    CV_Assert( !planar || cn <= 4 );
+
+    Size ssize = src.size();
+    double inv_scale_x = (double)dsize.width/ssize.width;
+    double inv_scale_y = (double)dsize.height/ssize.height;
+    double scale_x = 1./inv_scale_x, scale_y = 1./inv_scale_y;
+    int iscale_x = saturate_cast<int>(scale_x);
+    int iscale_y = saturate_cast<int>(scale_y);
+    bool is_area_fast = std::abs(scale_x - iscale_x) < DBL_EPSILON &&
+                        std::abs(scale_y - iscale_y) < DBL_EPSILON;
+
+    // the same choice of the method as in resize()
+    if( interpolation == INTER_LINEAR && is_area_fast && iscale_x == 2 && iscale_y == 2 )
+        interpolation = INTER_AREA;
+
+    if( interpolation == INTER_AREA && scale_x >= 1 && scale_y >= 1 && !is_area_fast )
+    {
+        // the general area decimation is not split into bands; the steps run one by one
+        Mat converted, resized;
+        if( code >= 0 )
+            cvtColor(src, converted, code);
         else
+            converted = src;
+        resize(converted, resized, dsize, 0, 0, interpolation);
+        if( planar )
+            _dst.create(dsize.height*cn, dsize.width, ddepth);
+        else
+            _dst.create(dsize, CV_MAKETYPE(ddepth, cn));
+        Mat dst = _dst.getMat(), fbuf;
+        storePreprocessedRows( resized, dst, 0, dsize.height, ddepth, alpha, beta, planar, fbuf );
+        return;
+    }
+
+    if( planar )
+        _dst.create(dsize.height*cn, dsize.width, ddepth);
+    else
+        _dst.create(dsize, CV_MAKETYPE(ddepth, cn));
+    Mat dst = _dst.getMat();
+    if( dst.data == src.data )
+        src = src.clone();
+
+    // the bands are sized so that the source rows of a band take about 64K
+    double bandBytes = (double)ssize.width*CV_ELEM_SIZE(ctype)*std::max(scale_y, 1.);
+    int bandRows = std::min(std::max(cvRound((1 << 16)/bandBytes), 4), dsize.height);
+
+    int mode = interpolation == INTER_NEAREST ? PREPROCESS_NN :
+        interpolation == INTER_AREA && scale_x >= 1 && scale_y >= 1 ? PREPROCESS_AREA_FAST :
+        PREPROCESS_GENERIC;
+    PreprocessInvoker invoker(src, dst, dsize, code, ctype, mode, bandRows, alpha, beta, planar);
+
+    int width = dsize.width*cn, ksize = 0;
+    AutoBuffer<uchar> _buffer;
+
+    if( mode == PREPROCESS_NN )
+    {
+        int pix_size = CV_ELEM_SIZE(ctype);
+        _buffer.allocate(dsize.width*sizeof(int));
+        int* xofs = (int*)(uchar*)_buffer;
+        for( int x = 0; x < dsize.width; x++ )
+            xofs[x] = std::min(cvFloor(x*(1./inv_scale_x)), ssize.width - 1)*pix_size;
+        invoker.setNearest(xofs, 1./inv_scale_y);
+    }
+    else if( mode == PREPROCESS_AREA_FAST )
+    {
+        ResizeAreaFastFunc func = getResizeAreaFastFunc(depth);
+        CV_Assert( func != 0 );
+        _buffer.allocate(width*sizeof(int));
+        int* xofs = (int*)(uchar*)_buffer;
+        for( int dx = 0; dx < dsize.width; dx++ )
         {
-            for( k = 0; k < ksize; k++ )
-                beta[dy*ksize + k] = cbuf[k];
+            int j = dx * cn, sx = iscale_x * j;
+            for( int k = 0; k < cn; k++ )
+                xofs[j + k] = sx + k;
         }
+        invoker.setAreaFast(func, xofs, iscale_x, iscale_y);
+    }
+    else
+    {
+        bool fixpt = depth == CV_8U;
+        int xmin = 0, xmax = dsize.width;
+        ResizeFunc func = getResizeFunc(interpolation, depth, ksize);
+        CV_Assert( func != 0 );
+
+        _buffer.allocate((width + dsize.height)*(sizeof(int) + sizeof(float)*ksize));
+        int* xofs = (int*)(uchar*)_buffer;
+        int* yofs = xofs + width;
+        float* ralpha = (float*)(yofs + dsize.height);
+        float* rbeta = ralpha + width*ksize;
+        short* ibeta = (short*)ralpha + width*ksize;
+
+        computeResizeTabs( ssize, dsize, cn, fixpt, interpolation, ksize,
+                           inv_scale_x, inv_scale_y, xofs, ralpha, yofs,
+                           fixpt ? (void*)ibeta : (void*)rbeta, xmin, xmax );
+        invoker.setGeneric(func, ksize, xofs, ralpha, yofs,
+                           fixpt ? (void*)ibeta : (void*)rbeta, xmin, xmax);
     }
 
-    func( src, dst, xofs, fixpt ? (void*)ialpha : (void*)alpha, yofs,
-          fixpt ? (void*)ibeta : (void*)beta, xmin, xmax, ksize );
+    parallel_for_(Range(0, dsize.height), invoker, dsize.height/(double)bandRows);
 }
 
 
@@ -3327,6 +3678,150 @@ void cv::convertMaps( InputArray _map1, InputArray _map2,
 namespace cv
 {
 
+enum { WARP_AB_BITS = MAX(10, (int)INTER_BITS), WARP_AB_SCALE = 1 << WARP_AB_BITS };
+
+// the inverse of the 2x3 affine transformation, computed in place
+static void invertWarpAffineMatrix( double* M )
+{
+    double D = M[0]*M[4] - M[1]*M[3];
+    D = D != 0 ? 1./D : 0;
+    double A11 = M[4]*D, A22=M[0]*D;
+    M[0] = A11; M[1] *= -D;
+    M[3] *= -D; M[4] = A22;
+    double b1 = -M[0]*M[2] - M[1]*M[5];
+    double b2 = -M[3]*M[2] - M[4]*M[5];
+    M[2] = b1; M[5] = b2;
+}
+
+static void computeWarpAffineDeltas( const double* M, int width, int* adelta, int* bdelta )
+{
+    for( int x = 0; x < width; x++ )
+    {
+        adelta[x] = saturate_cast<int>(M[0]*x*WARP_AB_SCALE);
+        bdelta[x] = saturate_cast<int>(M[3]*x*WARP_AB_SCALE);
+    }
+}
+
+// computes the fixed-point remap() coordinates of the pixels (x..x+bw-1, y) of warpAffine() output:
+// xy gets the integer source coordinates, alpha (unused for INTER_NEAREST) the interpolation table indices
+static void computeWarpAffineRow( const double* M, const int* adelta, const int* bdelta,
+                                  int interpolation, int y, int x, int bw, short* xy, short* alpha )
+{
+    const int AB_BITS = WARP_AB_BITS;
+    const int AB_SCALE = WARP_AB_SCALE;
+    int round_delta = interpolation == INTER_NEAREST ? AB_SCALE/2 : AB_SCALE/INTER_TAB_SIZE/2, x1;
+    int X0 = saturate_cast<int>((M[1]*y + M[2])*AB_SCALE) + round_delta;
+    int Y0 = saturate_cast<int>((M[4]*y + M[5])*AB_SCALE) + round_delta;
+
+    if( interpolation == INTER_NEAREST )
+    {
+        for( x1 = 0; x1 < bw; x1++ )
+        {
+            int X = (X0 + adelta[x+x1]) >> AB_BITS;
+            int Y = (Y0 + bdelta[x+x1]) >> AB_BITS;
+            xy[x1*2] = saturate_cast<short>(X);
+            xy[x1*2+1] = saturate_cast<short>(Y);
+        }
+        return;
+    }
+
+    x1 = 0;
+#if CV_SSE2
+    if( checkHardwareSupport(CV_CPU_SSE2) )
+    {
+        __m128i fxy_mask = _mm_set1_epi32(INTER_TAB_SIZE - 1);
+        __m128i XX = _mm_set1_epi32(X0), YY = _mm_set1_epi32(Y0);
+        for( ; x1 <= bw - 8; x1 += 8 )
+        {
+            __m128i tx0, tx1, ty0, ty1;
+            tx0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1)), XX);
+            ty0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1)), YY);
+            tx1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1 + 4)), XX);
+            ty1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1 + 4)), YY);
+
+            tx0 = _mm_srai_epi32(tx0, AB_BITS - INTER_BITS);
+            ty0 = _mm_srai_epi32(ty0, AB_BITS - INTER_BITS);
+            tx1 = _mm_srai_epi32(tx1, AB_BITS - INTER_BITS);
+            ty1 = _mm_srai_epi32(ty1, AB_BITS - INTER_BITS);
+
+            __m128i fx_ = _mm_packs_epi32(_mm_and_si128(tx0, fxy_mask),
+                                        _mm_and_si128(tx1, fxy_mask));
+            __m128i fy_ = _mm_packs_epi32(_mm_and_si128(ty0, fxy_mask),
+                                        _mm_and_si128(ty1, fxy_mask));
+            tx0 = _mm_packs_epi32(_mm_srai_epi32(tx0, INTER_BITS),
+                                        _mm_srai_epi32(tx1, INTER_BITS));
+            ty0 = _mm_packs_epi32(_mm_srai_epi32(ty0, INTER_BITS),
+                                _mm_srai_epi32(ty1, INTER_BITS));
+            fx_ = _mm_adds_epi16(fx_, _mm_slli_epi16(fy_, INTER_BITS));
+
+            _mm_storeu_si128((__m128i*)(xy + x1*2), _mm_unpacklo_epi16(tx0, ty0));
+            _mm_storeu_si128((__m128i*)(xy + x1*2 + 8), _mm_unpackhi_epi16(tx0, ty0));
+            _mm_storeu_si128((__m128i*)(alpha + x1), fx_);
+        }
+    }
+#endif
+    for( ; x1 < bw; x1++ )
+    {
+        int X = (X0 + adelta[x+x1]) >> (AB_BITS - INTER_BITS);
+        int Y = (Y0 + bdelta[x+x1]) >> (AB_BITS - INTER_BITS);
+        xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
+        xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
+        alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
+                (X & (INTER_TAB_SIZE-1)));
+    }
+}
+
+enum { WARP_PERSPECTIVE_BLOCK_SZ = 32 };
+
+// warpPerspective() output is processed in column blocks of this width;
+// the coordinates are accumulated from the block origin, so the maps depend on it
+static int getWarpPerspectiveBlockWidth( Size dsize )
+{
+    const int BLOCK_SZ = WARP_PERSPECTIVE_BLOCK_SZ;
+    int bh0 = std::min(BLOCK_SZ/2, dsize.height);
+    return std::min(BLOCK_SZ*BLOCK_SZ/bh0, dsize.width);
+}
+
+// the same as computeWarpAffineRow(), for warpPerspective() output;
+// x must be the origin of one of the column blocks
+static void computeWarpPerspectiveRow( const double* M, int interpolation, int y, int x, int bw,
+                                       short* xy, short* alpha )
+{
+    double X0 = M[0]*x + M[1]*y + M[2];
+    double Y0 = M[3]*x + M[4]*y + M[5];
+    double W0 = M[6]*x + M[7]*y + M[8];
+    int x1;
+
+    if( interpolation == INTER_NEAREST )
+        for( x1 = 0; x1 < bw; x1++ )
+        {
+            double W = W0 + M[6]*x1;
+            W = W ? 1./W : 0;
+            double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
+            double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
+            int X = saturate_cast<int>(fX);
+            int Y = saturate_cast<int>(fY);
+
+            xy[x1*2] = saturate_cast<short>(X);
+            xy[x1*2+1] = saturate_cast<short>(Y);
+        }
+    else
+        for( x1 = 0; x1 < bw; x1++ )
+        {
+            double W = W0 + M[6]*x1;
+            W = W ? INTER_TAB_SIZE/W : 0;
+            double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
+            double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
+            int X = saturate_cast<int>(fX);
+            int Y = saturate_cast<int>(fY);
+
+            xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
+            xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
+            alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
+                                (X & (INTER_TAB_SIZE-1)));
+        }
+}
+
 class warpAffineInvoker :
     public ParallelLoopBody
 {
@@ -3343,12 +3838,7 @@ public:
     {
         const int BLOCK_SZ = 64;
         short XY[BLOCK_SZ*BLOCK_SZ*2], A[BLOCK_SZ*BLOCK_SZ];
-        const int AB_BITS = MAX(10, (int)INTER_BITS);
-        const int AB_SCALE = 1 << AB_BITS;
-        int round_delta = interpolation == INTER_NEAREST ? AB_SCALE/2 : AB_SCALE/INTER_TAB_SIZE/2, x, y, x1, y1;
-    #if CV_SSE2
-        bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
-    #endif
+        int x, y, y1;
 
         int bh0 = std::min(BLOCK_SZ/2, dst.rows);
         int bw0 = std::min(BLOCK_SZ*BLOCK_SZ/bh0, dst.cols);
@@ -3365,68 +3855,8 @@ public:
                 Mat dpart(dst, Rect(x, y, bw, bh));
 
                 for( y1 = 0; y1 < bh; y1++ )
-                {
-                    short* xy = XY + y1*bw*2;
-                    int X0 = saturate_cast<int>((M[1]*(y + y1) + M[2])*AB_SCALE) + round_delta;
-                    int Y0 = saturate_cast<int>((M[4]*(y + y1) + M[5])*AB_SCALE) + round_delta;
-
-                    if( interpolation == INTER_NEAREST )
-                        for( x1 = 0; x1 < bw; x1++ )
-                        {
-                            int X = (X0 + adelta[x+x1]) >> AB_BITS;
-                            int Y = (Y0 + bdelta[x+x1]) >> AB_BITS;
-                            xy[x1*2] = saturate_cast<short>(X);
-                            xy[x1*2+1] = saturate_cast<short>(Y);
-                        }
-                    else
-                    {
-                        short* alpha = A + y1*bw;
-                        x1 = 0;
-                    #if CV_SSE2
-                        if( useSIMD )
-                        {
-                            __m128i fxy_mask = _mm_set1_epi32(INTER_TAB_SIZE - 1);
-                            __m128i XX = _mm_set1_epi32(X0), YY = _mm_set1_epi32(Y0);
-                            for( ; x1 <= bw - 8; x1 += 8 )
-                            {
-                                __m128i tx0, tx1, ty0, ty1;
-                                tx0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1)), XX);
-                                ty0 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1)), YY);
-                                tx1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(adelta + x + x1 + 4)), XX);
-                                ty1 = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(bdelta + x + x1 + 4)), YY);
-
-                                tx0 = _mm_srai_epi32(tx0, AB_BITS - INTER_BITS);
-                                ty0 = _mm_srai_epi32(ty0, AB_BITS - INTER_BITS);
-                                tx1 = _mm_srai_epi32(tx1, AB_BITS - INTER_BITS);
-                                ty1 = _mm_srai_epi32(ty1, AB_BITS - INTER_BITS);
-
-                                __m128i fx_ = _mm_packs_epi32(_mm_and_si128(tx0, fxy_mask),
-                                                            _mm_and_si128(tx1, fxy_mask));
-                                __m128i fy_ = _mm_packs_epi32(_mm_and_si128(ty0, fxy_mask),
-                                                            _mm_and_si128(ty1, fxy_mask));
-                                tx0 = _mm_packs_epi32(_mm_srai_epi32(tx0, INTER_BITS),
-                                                            _mm_srai_epi32(tx1, INTER_BITS));
-                                ty0 = _mm_packs_epi32(_mm_srai_epi32(ty0, INTER_BITS),
-                                                    _mm_srai_epi32(ty1, INTER_BITS));
-                                fx_ = _mm_adds_epi16(fx_, _mm_slli_epi16(fy_, INTER_BITS));
-
-                                _mm_storeu_si128((__m128i*)(xy + x1*2), _mm_unpacklo_epi16(tx0, ty0));
-                                _mm_storeu_si128((__m128i*)(xy + x1*2 + 8), _mm_unpackhi_epi16(tx0, ty0));
-                                _mm_storeu_si128((__m128i*)(alpha + x1), fx_);
-                            }
-                        }
-                    #endif
-                        for( ; x1 < bw; x1++ )
-                        {
-                            int X = (X0 + adelta[x+x1]) >> (AB_BITS - INTER_BITS);
-                            int Y = (Y0 + bdelta[x+x1]) >> (AB_BITS - INTER_BITS);
-                            xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
-                            xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
-                            alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
-                                    (X & (INTER_TAB_SIZE-1)));
-                        }
-                    }
-                }
+                    computeWarpAffineRow( M, adelta, bdelta, interpolation, y + y1, x, bw,
+                                          XY + y1*bw*2, A + y1*bw );
 
                 if( interpolation == INTER_NEAREST )
                     remap( src, dpart, _XY, Mat(), interpolation, borderType, borderValue );
@@ -3477,28 +3907,11 @@ void cv::warpAffine( InputArray _src, OutputArray _dst,
 #endif
 
     if( !(flags & WARP_INVERSE_MAP) )
-    {
-        double D = M[0]*M[4] - M[1]*M[3];
-        D = D != 0 ? 1./D : 0;
-        double A11 = M[4]*D, A22=M[0]*D;
-        M[0] = A11; M[1] *= -D;
-        M[3] *= -D; M[4] = A22;
-        double b1 = -M[0]*M[2] - M[1]*M[5];
-        double b2 = -M[3]*M[2] - M[4]*M[5];
-        M[2] = b1; M[5] = b2;
-    }
+        invertWarpAffineMatrix(M);
 
-    int x;
     AutoBuffer<int> _abdelta(dst.cols*2);
     int* adelta = &_abdelta[0], *bdelta = adelta + dst.cols;
-    const int AB_BITS = MAX(10, (int)INTER_BITS);
-    const int AB_SCALE = 1 << AB_BITS;
-
-    for( x = 0; x < dst.cols; x++ )
-    {
-        adelta[x] = saturate_cast<int>(M[0]*x*AB_SCALE);
-        bdelta[x] = saturate_cast<int>(M[3]*x*AB_SCALE);
-    }
+    computeWarpAffineDeltas(M, dst.cols, adelta, bdelta);
 
     Range range(0, dst.rows);
     warpAffineInvoker invoker(src, dst, interpolation, borderType,
@@ -3524,13 +3937,12 @@ public:
 
     virtual void operator() (const Range& range) const
     {
-        const int BLOCK_SZ = 32;
+        const int BLOCK_SZ = WARP_PERSPECTIVE_BLOCK_SZ;
         short XY[BLOCK_SZ*BLOCK_SZ*2], A[BLOCK_SZ*BLOCK_SZ];
-        int x, y, x1, y1, width = dst.cols, height = dst.rows;
+        int x, y, y1, width = dst.cols, height = dst.rows;
 
-        int bh0 = std::min(BLOCK_SZ/2, height);
-        int bw0 = std::min(BLOCK_SZ*BLOCK_SZ/bh0, width);
-        bh0 = std::min(BLOCK_SZ*BLOCK_SZ/bw0, height);
+        int bw0 = getWarpPerspectiveBlockWidth(dst.size());
+        int bh0 = std::min(BLOCK_SZ*BLOCK_SZ/bw0, height);
 
         for( y = range.start; y < range.end; y += bh0 )
         {
@@ -3543,44 +3955,8 @@ public:
                 Mat dpart(dst, Rect(x, y, bw, bh));
 
                 for( y1 = 0; y1 < bh; y1++ )
-                {
-                    short* xy = XY + y1*bw*2;
-                    double X0 = M[0]*x + M[1]*(y + y1) + M[2];
-                    double Y0 = M[3]*x + M[4]*(y + y1) + M[5];
-                    double W0 = M[6]*x + M[7]*(y + y1) + M[8];
-
-                    if( interpolation == INTER_NEAREST )
-                        for( x1 = 0; x1 < bw; x1++ )
-                        {
-                            double W = W0 + M[6]*x1;
-                            W = W ? 1./W : 0;
-                            double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
-                            double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
-                            int X = saturate_cast<int>(fX);
-                            int Y = saturate_cast<int>(fY);
-
-                            xy[x1*2] = saturate_cast<short>(X);
-                            xy[x1*2+1] = saturate_cast<short>(Y);
-                        }
-                    else
-                    {
-                        short* alpha = A + y1*bw;
-                        for( x1 = 0; x1 < bw; x1++ )
-                        {
-                            double W = W0 + M[6]*x1;
-                            W = W ? INTER_TAB_SIZE/W : 0;
-                            double fX = std::max((double)INT_MIN, std::min((double)INT_MAX, (X0 + M[0]*x1)*W));
-                            double fY = std::max((double)INT_MIN, std::min((double)INT_MAX, (Y0 + M[3]*x1)*W));
-                            int X = saturate_cast<int>(fX);
-                            int Y = saturate_cast<int>(fY);
-
-                            xy[x1*2] = saturate_cast<short>(X >> INTER_BITS);
-                            xy[x1*2+1] = saturate_cast<short>(Y >> INTER_BITS);
-                            alpha[x1] = (short)((Y & (INTER_TAB_SIZE-1))*INTER_TAB_SIZE +
-                                                (X & (INTER_TAB_SIZE-1)));
-                        }
-                    }
-                }
+                    computeWarpPerspectiveRow( M, interpolation, y + y1, x, bw,
+                                               XY + y1*bw*2, A + y1*bw );
 
                 if( interpolation == INTER_NEAREST )
                     remap( src, dpart, _XY, Mat(), interpolation, borderType, borderValue );
@@ -3637,6 +4013,143 @@ void cv::warpPerspective( InputArray _src, OutputArray _dst, InputArray _M0,
 }
 
 
+namespace cv
+{
+
+class WarpPlanInvoker :
+    public ParallelLoopBody
+{
+public:
+    // adelta == 0 selects the perspective transformation
+    WarpPlanInvoker(const double* _M, const int* _adelta, const int* _bdelta, int _interpolation,
+                    Mat& _map1, Mat& _map2) :
+        ParallelLoopBody(), M(_M), adelta(_adelta), bdelta(_bdelta),
+        interpolation(_interpolation), map1(&_map1), map2(&_map2)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int width = map1->cols, bw0 = getWarpPerspectiveBlockWidth(map1->size());
+
+        for( int y = range.start; y < range.end; y++ )
+        {
+            short* xy = map1->ptr<short>(y);
+            short* alpha = map2->data ? map2->ptr<short>(y) : 0;
+
+            if( adelta )
+                computeWarpAffineRow( M, adelta, bdelta, interpolation, y, 0, width, xy, alpha );
+            else
+                for( int x = 0; x < width; x += bw0 )
+                    computeWarpPerspectiveRow( M, interpolation, y, x, std::min(bw0, width - x),
+                                               xy + x*2, alpha ? alpha + x : 0 );
+        }
+    }
+
+private:
+    const double* M;
+    const int *adelta, *bdelta;
+    int interpolation;
+    Mat *map1, *map2;
+};
+
+}
+
+cv::WarpPlan::WarpPlan() : interpolation(INTER_LINEAR)
+{
+}
+
+void cv::WarpPlan::create(Size dsize, int flags)
+{
+    CV_Assert( dsize.width > 0 && dsize.height > 0 );
+    interpolation = flags & INTER_MAX;
+    if( interpolation == INTER_AREA )
+        interpolation = INTER_LINEAR;
+
+    map1.create(dsize, CV_16SC2);
+    if( interpolation == INTER_NEAREST )
+        map2.release();
+    else
+        map2.create(dsize, CV_16UC1);
+}
+
+void cv::WarpPlan::initAffine(InputArray _M0, Size dsize, int flags)
+{
+    Mat M0 = _M0.getMat();
+    CV_Assert( (M0.type() == CV_32F || M0.type() == CV_64F) && M0.rows == 2 && M0.cols == 3 );
+
+    double M[6];
+    Mat matM(2, 3, CV_64F, M);
+    M0.convertTo(matM, matM.type());
+    if( !(flags & WARP_INVERSE_MAP) )
+        invertWarpAffineMatrix(M);
+
+    create(dsize, flags);
+    AutoBuffer<int> _abdelta(dsize.width*2);
+    int* adelta = &_abdelta[0], *bdelta = adelta + dsize.width;
+    computeWarpAffineDeltas(M, dsize.width, adelta, bdelta);
+
+    WarpPlanInvoker invoker(M, adelta, bdelta, interpolation, map1, map2);
+    parallel_for_(Range(0, dsize.height), invoker, dsize.area()/(double)(1<<16));
+}
+
+void cv::WarpPlan::initPerspective(InputArray _M0, Size dsize, int flags)
+{
+    Mat M0 = _M0.getMat();
+    CV_Assert( (M0.type() == CV_32F || M0.type() == CV_64F) && M0.rows == 3 && M0.cols == 3 );
+
+    double M[9];
+    Mat matM(3, 3, CV_64F, M);
+    M0.convertTo(matM, matM.type());
+    if( !(flags & WARP_INVERSE_MAP) )
+        invert(matM, matM);
+
+    create(dsize, flags);
+    WarpPlanInvoker invoker(M, 0, 0, interpolation, map1, map2);
+    parallel_for_(Range(0, dsize.height), invoker, dsize.area()/(double)(1<<16));
+}
+
+void cv::WarpPlan::initRemap(InputArray _map1, InputArray _map2, int _interpolation)
+{
+    Mat m1 = _map1.getMat(), m2 = _map2.getMat();
+    CV_Assert( m1.size().area() > 0 );
+
+    interpolation = _interpolation == INTER_AREA ? INTER_LINEAR : _interpolation;
+    bool nn = interpolation == INTER_NEAREST;
+
+    if( m1.type() == CV_16SC2 && (nn || m2.type() == CV_16UC1 || m2.type() == CV_16SC1) )
+    {
+        m1.copyTo(map1);
+        if( nn )
+            map2.release();
+        else
+            m2.copyTo(map2);
+    }
+    else
+    {
+        convertMaps(m1, m2, map1, map2, CV_16SC2, nn);
+        if( nn )
+            map2.release();
+    }
+}
+
+void cv::WarpPlan::apply(InputArray src, OutputArray dst, int borderMode, const Scalar& borderValue) const
+{
+    CV_Assert( !empty() );
+    remap(src, dst, map1, map2, interpolation, borderMode, borderValue);
+}
+
+cv::Size cv::WarpPlan::size() const
+{
+    return map1.size();
+}
+
+bool cv::WarpPlan::empty() const
+{
+    return map1.empty();
+}
+
+
 cv::Mat cv::getRotationMatrix2D( Point2f center, double angle, double scale )
 {
     angle *= CV_PI/180;
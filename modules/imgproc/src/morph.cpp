@@ -41,6 +41,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/intrin.hpp"
 #include <limits.h>
 #include <stdio.h>
 
@@ -92,306 +93,138 @@ struct MorphNoVec
     int operator()(uchar**, int, uchar*, int) const { return 0; }
 };
 
-#if CV_SSE2
+#if CV_SIMD128
 
-template<class VecUpdate> struct MorphRowIVec
+template<class VecUpdate> struct MorphRowVec
 {
-    enum { ESZ = VecUpdate::ESZ };
+    typedef typename VecUpdate::vtype vtype;
+    typedef typename vtype::lane_type stype;
 
-    MorphRowIVec(int _ksize, int _anchor) : ksize(_ksize), anchor(_anchor) {}
-    int operator()(const uchar* src, uchar* dst, int width, int cn) const
+    MorphRowVec(int _ksize, int _anchor) : ksize(_ksize), anchor(_anchor) {}
+    int operator()(const uchar* _src, uchar* _dst, int width, int cn) const
     {
-        if( !checkHardwareSupport(CV_CPU_SSE2) )
+        if( !hasSIMD128() )
             return 0;
 
-        cn *= ESZ;
         int i, k, _ksize = ksize*cn;
-        width = (width & -4)*cn;
+        const int nlanes = vtype::nlanes;
+        const stype* src = (const stype*)_src;
+        stype* dst = (stype*)_dst;
+        width *= cn;
         VecUpdate updateOp;
 
-        for( i = 0; i <= width - 16; i += 16 )
+        for( i = 0; i <= width - nlanes*2; i += nlanes*2 )
         {
-            __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+            vtype s0 = v_load(src + i), s1 = v_load(src + i + nlanes);
             for( k = cn; k < _ksize; k += cn )
             {
-                __m128i x = _mm_loadu_si128((const __m128i*)(src + i + k));
-                s = updateOp(s, x);
+                s0 = updateOp(s0, v_load(src + i + k));
+                s1 = updateOp(s1, v_load(src + i + k + nlanes));
             }
-            _mm_storeu_si128((__m128i*)(dst + i), s);
+            v_store(dst + i, s0);
+            v_store(dst + i + nlanes, s1);
         }
 
-        for( ; i < width; i += 4 )
+        for( ; i <= width - nlanes; i += nlanes )
         {
-            __m128i s = _mm_cvtsi32_si128(*(const int*)(src + i));
+            vtype s = v_load(src + i);
             for( k = cn; k < _ksize; k += cn )
-            {
-                __m128i x = _mm_cvtsi32_si128(*(const int*)(src + i + k));
-                s = updateOp(s, x);
-            }
-            *(int*)(dst + i) = _mm_cvtsi128_si32(s);
+                s = updateOp(s, v_load(src + i + k));
+            v_store(dst + i, s);
         }
 
-        return i/ESZ;
+        // the scalar part of MorphRowFilter processes the rest pixel by pixel
+        return i - i % cn;
     }
 
     int ksize, anchor;
 };
 
 
-template<class VecUpdate> struct MorphRowFVec
+template<class VecUpdate> struct MorphColumnVec
 {
-    MorphRowFVec(int _ksize, int _anchor) : ksize(_ksize), anchor(_anchor) {}
-    int operator()(const uchar* src, uchar* dst, int width, int cn) const
-    {
-        if( !checkHardwareSupport(CV_CPU_SSE) )
-            return 0;
-
-        int i, k, _ksize = ksize*cn;
-        width = (width & -4)*cn;
-        VecUpdate updateOp;
-
-        for( i = 0; i < width; i += 4 )
-        {
-            __m128 s = _mm_loadu_ps((const float*)src + i);
-            for( k = cn; k < _ksize; k += cn )
-            {
-                __m128 x = _mm_loadu_ps((const float*)src + i + k);
-                s = updateOp(s, x);
-            }
-            _mm_storeu_ps((float*)dst + i, s);
-        }
-
-        return i;
-    }
-
-    int ksize, anchor;
-};
-
-
-template<class VecUpdate> struct MorphColumnIVec
-{
-    enum { ESZ = VecUpdate::ESZ };
-
-    MorphColumnIVec(int _ksize, int _anchor) : ksize(_ksize), anchor(_anchor) {}
-    int operator()(const uchar** src, uchar* dst, int dststep, int count, int width) const
-    {
-        if( !checkHardwareSupport(CV_CPU_SSE2) )
-            return 0;
-
-        int i = 0, k, _ksize = ksize;
-        width *= ESZ;
-        VecUpdate updateOp;
-
-        for( i = 0; i < count + ksize - 1; i++ )
-            CV_Assert( ((size_t)src[i] & 15) == 0 );
-
-        for( ; _ksize > 1 && count > 1; count -= 2, dst += dststep*2, src += 2 )
-        {
-            for( i = 0; i <= width - 32; i += 32 )
-            {
-                const uchar* sptr = src[1] + i;
-                __m128i s0 = _mm_load_si128((const __m128i*)sptr);
-                __m128i s1 = _mm_load_si128((const __m128i*)(sptr + 16));
-                __m128i x0, x1;
-
-                for( k = 2; k < _ksize; k++ )
-                {
-                    sptr = src[k] + i;
-                    x0 = _mm_load_si128((const __m128i*)sptr);
-                    x1 = _mm_load_si128((const __m128i*)(sptr + 16));
-                    s0 = updateOp(s0, x0);
-                    s1 = updateOp(s1, x1);
-                }
-
-                sptr = src[0] + i;
-                x0 = _mm_load_si128((const __m128i*)sptr);
-                x1 = _mm_load_si128((const __m128i*)(sptr + 16));
-                _mm_storeu_si128((__m128i*)(dst + i), updateOp(s0, x0));
-                _mm_storeu_si128((__m128i*)(dst + i + 16), updateOp(s1, x1));
-
-                sptr = src[k] + i;
-                x0 = _mm_load_si128((const __m128i*)sptr);
-                x1 = _mm_load_si128((const __m128i*)(sptr + 16));
-                _mm_storeu_si128((__m128i*)(dst + dststep + i), updateOp(s0, x0));
-                _mm_storeu_si128((__m128i*)(dst + dststep + i + 16), updateOp(s1, x1));
-            }
-
-            for( ; i <= width - 8; i += 8 )
-            {
-                __m128i s0 = _mm_loadl_epi64((const __m128i*)(src[1] + i)), x0;
-
-                for( k = 2; k < _ksize; k++ )
-                {
-                    x0 = _mm_loadl_epi64((const __m128i*)(src[k] + i));
-                    s0 = updateOp(s0, x0);
-                }
-
-                x0 = _mm_loadl_epi64((const __m128i*)(src[0] + i));
-                _mm_storel_epi64((__m128i*)(dst + i), updateOp(s0, x0));
-                x0 = _mm_loadl_epi64((const __m128i*)(src[k] + i));
-                _mm_storel_epi64((__m128i*)(dst + dststep + i), updateOp(s0, x0));
-            }
-        }
-
-        for( ; count > 0; count--, dst += dststep, src++ )
-        {
-            for( i = 0; i <= width - 32; i += 32 )
-            {
-                const uchar* sptr = src[0] + i;
-                __m128i s0 = _mm_load_si128((const __m128i*)sptr);
-                __m128i s1 = _mm_load_si128((const __m128i*)(sptr + 16));
-                __m128i x0, x1;
-
-                for( k = 1; k < _ksize; k++ )
-                {
-                    sptr = src[k] + i;
-                    x0 = _mm_load_si128((const __m128i*)sptr);
-                    x1 = _mm_load_si128((const __m128i*)(sptr + 16));
-                    s0 = updateOp(s0, x0);
-                    s1 = updateOp(s1, x1);
-                }
-                _mm_storeu_si128((__m128i*)(dst + i), s0);
-                _mm_storeu_si128((__m128i*)(dst + i + 16), s1);
-            }
-
-            for( ; i <= width - 8; i += 8 )
-            {
-                __m128i s0 = _mm_loadl_epi64((const __m128i*)(src[0] + i)), x0;
-
-                for( k = 1; k < _ksize; k++ )
-                {
-                    x0 = _mm_loadl_epi64((const __m128i*)(src[k] + i));
-                    s0 = updateOp(s0, x0);
-                }
-                _mm_storel_epi64((__m128i*)(dst + i), s0);
-            }
-        }
-
-        return i/ESZ;
-    }
-
-    int ksize, anchor;
-};
+    typedef typename VecUpdate::vtype vtype;
+    typedef typename vtype::lane_type stype;
 
-
-template<class VecUpdate> struct MorphColumnFVec
-{
-    MorphColumnFVec(int _ksize, int _anchor) : ksize(_ksize), anchor(_anchor) {}
+    MorphColumnVec(int _ksize, int _anchor) : ksize(_ksize), anchor(_anchor) {}
     int operator()(const uchar** _src, uchar* _dst, int dststep, int count, int width) const
     {
-        if( !checkHardwareSupport(CV_CPU_SSE) )
+        if( !hasSIMD128() )
             return 0;
 
         int i = 0, k, _ksize = ksize;
+        const int nlanes = vtype::nlanes, halfnlanes = vtype::nlanes/2;
         VecUpdate updateOp;
 
         for( i = 0; i < count + ksize - 1; i++ )
             CV_Assert( ((size_t)_src[i] & 15) == 0 );
 
-        const float** src = (const float**)_src;
-        float* dst = (float*)_dst;
+        const stype** src = (const stype**)_src;
+        stype* dst = (stype*)_dst;
         dststep /= sizeof(dst[0]);
+        i = 0;
 
         for( ; _ksize > 1 && count > 1; count -= 2, dst += dststep*2, src += 2 )
         {
-            for( i = 0; i <= width - 16; i += 16 )
+            for( i = 0; i <= width - nlanes*2; i += nlanes*2 )
             {
-                const float* sptr = src[1] + i;
-                __m128 s0 = _mm_load_ps(sptr);
-                __m128 s1 = _mm_load_ps(sptr + 4);
-                __m128 s2 = _mm_load_ps(sptr + 8);
-                __m128 s3 = _mm_load_ps(sptr + 12);
-                __m128 x0, x1, x2, x3;
+                const stype* sptr = src[1] + i;
+                vtype s0 = v_load_aligned(sptr);
+                vtype s1 = v_load_aligned(sptr + nlanes);
 
                 for( k = 2; k < _ksize; k++ )
                 {
                     sptr = src[k] + i;
-                    x0 = _mm_load_ps(sptr);
-                    x1 = _mm_load_ps(sptr + 4);
-                    s0 = updateOp(s0, x0);
-                    s1 = updateOp(s1, x1);
-                    x2 = _mm_load_ps(sptr + 8);
-                    x3 = _mm_load_ps(sptr + 12);
-                    s2 = updateOp(s2, x2);
-                    s3 = updateOp(s3, x3);
+                    s0 = updateOp(s0, v_load_aligned(sptr));
+                    s1 = updateOp(s1, v_load_aligned(sptr + nlanes));
                 }
 
                 sptr = src[0] + i;
-                x0 = _mm_load_ps(sptr);
-                x1 = _mm_load_ps(sptr + 4);
-                x2 = _mm_load_ps(sptr + 8);
-                x3 = _mm_load_ps(sptr + 12);
-                _mm_storeu_ps(dst + i, updateOp(s0, x0));
-                _mm_storeu_ps(dst + i + 4, updateOp(s1, x1));
-                _mm_storeu_ps(dst + i + 8, updateOp(s2, x2));
-                _mm_storeu_ps(dst + i + 12, updateOp(s3, x3));
+                v_store(dst + i, updateOp(s0, v_load_aligned(sptr)));
+                v_store(dst + i + nlanes, updateOp(s1, v_load_aligned(sptr + nlanes)));
 
                 sptr = src[k] + i;
-                x0 = _mm_load_ps(sptr);
-                x1 = _mm_load_ps(sptr + 4);
-                x2 = _mm_load_ps(sptr + 8);
-                x3 = _mm_load_ps(sptr + 12);
-                _mm_storeu_ps(dst + dststep + i, updateOp(s0, x0));
-                _mm_storeu_ps(dst + dststep + i + 4, updateOp(s1, x1));
-                _mm_storeu_ps(dst + dststep + i + 8, updateOp(s2, x2));
-                _mm_storeu_ps(dst + dststep + i + 12, updateOp(s3, x3));
+                v_store(dst + dststep + i, updateOp(s0, v_load_aligned(sptr)));
+                v_store(dst + dststep + i + nlanes, updateOp(s1, v_load_aligned(sptr + nlanes)));
             }
 
-            for( ; i <= width - 4; i += 4 )
+            for( ; i <= width - halfnlanes; i += halfnlanes )
             {
-                __m128 s0 = _mm_load_ps(src[1] + i), x0;
+                vtype s0 = v_load_low(src[1] + i);
 
                 for( k = 2; k < _ksize; k++ )
-                {
-                    x0 = _mm_load_ps(src[k] + i);
-                    s0 = updateOp(s0, x0);
-                }
+                    s0 = updateOp(s0, v_load_low(src[k] + i));
 
-                x0 = _mm_load_ps(src[0] + i);
-                _mm_storeu_ps(dst + i, updateOp(s0, x0));
-                x0 = _mm_load_ps(src[k] + i);
-                _mm_storeu_ps(dst + dststep + i, updateOp(s0, x0));
+                v_store_low(dst + i, updateOp(s0, v_load_low(src[0] + i)));
+                v_store_low(dst + dststep + i, updateOp(s0, v_load_low(src[k] + i)));
             }
         }
 
         for( ; count > 0; count--, dst += dststep, src++ )
         {
-            for( i = 0; i <= width - 16; i += 16 )
+            for( i = 0; i <= width - nlanes*2; i += nlanes*2 )
             {
-                const float* sptr = src[0] + i;
-                __m128 s0 = _mm_load_ps(sptr);
-                __m128 s1 = _mm_load_ps(sptr + 4);
-                __m128 s2 = _mm_load_ps(sptr + 8);
-                __m128 s3 = _mm_load_ps(sptr + 12);
-                __m128 x0, x1, x2, x3;
+                const stype* sptr = src[0] + i;
+                vtype s0 = v_load_aligned(sptr);
+                vtype s1 = v_load_aligned(sptr + nlanes);
 
                 for( k = 1; k < _ksize; k++ )
                 {
                     sptr = src[k] + i;
-                    x0 = _mm_load_ps(sptr);
-                    x1 = _mm_load_ps(sptr + 4);
-                    s0 = updateOp(s0, x0);
-                    s1 = updateOp(s1, x1);
-                    x2 = _mm_load_ps(sptr + 8);
-                    x3 = _mm_load_ps(sptr + 12);
-                    s2 = updateOp(s2, x2);
-                    s3 = updateOp(s3, x3);
+                    s0 = updateOp(s0, v_load_aligned(sptr));
+                    s1 = updateOp(s1, v_load_aligned(sptr + nlanes));
                 }
-                _mm_storeu_ps(dst + i, s0);
-                _mm_storeu_ps(dst + i + 4, s1);
-                _mm_storeu_ps(dst + i + 8, s2);
-                _mm_storeu_ps(dst + i + 12, s3);
+                v_store(dst + i, s0);
+                v_store(dst + i + nlanes, s1);
             }
 
-            for( i = 0; i <= width - 4; i += 4 )
+            for( ; i <= width - halfnlanes; i += halfnlanes )
             {
-                __m128 s0 = _mm_load_ps(src[0] + i), x0;
+                vtype s0 = v_load_low(src[0] + i);
+
                 for( k = 1; k < _ksize; k++ )
-                {
-                    x0 = _mm_load_ps(src[k] + i);
-                    s0 = updateOp(s0, x0);
-                }
-                _mm_storeu_ps(dst + i, s0);
+                    s0 = updateOp(s0, v_load_low(src[k] + i));
+                v_store_low(dst + i, s0);
             }
         }
 
@@ -402,186 +235,99 @@ template<class VecUpdate> struct MorphColumnFVec
 };
 
 
-template<class VecUpdate> struct MorphIVec
+template<class VecUpdate> struct MorphVec
 {
-    enum { ESZ = VecUpdate::ESZ };
+    typedef typename VecUpdate::vtype vtype;
+    typedef typename vtype::lane_type stype;
 
-    int operator()(uchar** src, int nz, uchar* dst, int width) const
-    {
-        if( !checkHardwareSupport(CV_CPU_SSE2) )
-            return 0;
-
-        int i, k;
-        width *= ESZ;
-        VecUpdate updateOp;
-
-        for( i = 0; i <= width - 32; i += 32 )
-        {
-            const uchar* sptr = src[0] + i;
-            __m128i s0 = _mm_loadu_si128((const __m128i*)sptr);
-            __m128i s1 = _mm_loadu_si128((const __m128i*)(sptr + 16));
-            __m128i x0, x1;
-
-            for( k = 1; k < nz; k++ )
-            {
-                sptr = src[k] + i;
-                x0 = _mm_loadu_si128((const __m128i*)sptr);
-                x1 = _mm_loadu_si128((const __m128i*)(sptr + 16));
-                s0 = updateOp(s0, x0);
-                s1 = updateOp(s1, x1);
-            }
-            _mm_storeu_si128((__m128i*)(dst + i), s0);
-            _mm_storeu_si128((__m128i*)(dst + i + 16), s1);
-        }
-
-        for( ; i <= width - 8; i += 8 )
-        {
-            __m128i s0 = _mm_loadl_epi64((const __m128i*)(src[0] + i)), x0;
-
-            for( k = 1; k < nz; k++ )
-            {
-                x0 = _mm_loadl_epi64((const __m128i*)(src[k] + i));
-                s0 = updateOp(s0, x0);
-            }
-            _mm_storel_epi64((__m128i*)(dst + i), s0);
-        }
-
-        return i/ESZ;
-    }
-};
-
-
-template<class VecUpdate> struct MorphFVec
-{
     int operator()(uchar** _src, int nz, uchar* _dst, int width) const
     {
-        if( !checkHardwareSupport(CV_CPU_SSE) )
+        if( !hasSIMD128() )
             return 0;
 
-        const float** src = (const float**)_src;
-        float* dst = (float*)_dst;
+        const stype** src = (const stype**)_src;
+        stype* dst = (stype*)_dst;
+        const int nlanes = vtype::nlanes, halfnlanes = vtype::nlanes/2;
         int i, k;
         VecUpdate updateOp;
 
-        for( i = 0; i <= width - 16; i += 16 )
+        for( i = 0; i <= width - nlanes*2; i += nlanes*2 )
         {
-            const float* sptr = src[0] + i;
-            __m128 s0 = _mm_loadu_ps(sptr);
-            __m128 s1 = _mm_loadu_ps(sptr + 4);
-            __m128 s2 = _mm_loadu_ps(sptr + 8);
-            __m128 s3 = _mm_loadu_ps(sptr + 12);
-            __m128 x0, x1, x2, x3;
+            const stype* sptr = src[0] + i;
+            vtype s0 = v_load(sptr);
+            vtype s1 = v_load(sptr + nlanes);
 
             for( k = 1; k < nz; k++ )
             {
                 sptr = src[k] + i;
-                x0 = _mm_loadu_ps(sptr);
-                x1 = _mm_loadu_ps(sptr + 4);
-                x2 = _mm_loadu_ps(sptr + 8);
-                x3 = _mm_loadu_ps(sptr + 12);
-                s0 = updateOp(s0, x0);
-                s1 = updateOp(s1, x1);
-                s2 = updateOp(s2, x2);
-                s3 = updateOp(s3, x3);
+                s0 = updateOp(s0, v_load(sptr));
+                s1 = updateOp(s1, v_load(sptr + nlanes));
             }
-            _mm_storeu_ps(dst + i, s0);
-            _mm_storeu_ps(dst + i + 4, s1);
-            _mm_storeu_ps(dst + i + 8, s2);
-            _mm_storeu_ps(dst + i + 12, s3);
+            v_store(dst + i, s0);
+            v_store(dst + i + nlanes, s1);
         }
 
-        for( ; i <= width - 4; i += 4 )
+        for( ; i <= width - halfnlanes; i += halfnlanes )
         {
-            __m128 s0 = _mm_loadu_ps(src[0] + i), x0;
+            vtype s0 = v_load_low(src[0] + i);
 
             for( k = 1; k < nz; k++ )
-            {
-                x0 = _mm_loadu_ps(src[k] + i);
-                s0 = updateOp(s0, x0);
-            }
-            _mm_storeu_ps(dst + i, s0);
-        }
-
-        for( ; i < width; i++ )
-        {
-            __m128 s0 = _mm_load_ss(src[0] + i), x0;
-
-            for( k = 1; k < nz; k++ )
-            {
-                x0 = _mm_load_ss(src[k] + i);
-                s0 = updateOp(s0, x0);
-            }
-            _mm_store_ss(dst + i, s0);
+                s0 = updateOp(s0, v_load_low(src[k] + i));
+            v_store_low(dst + i, s0);
         }
 
         return i;
     }
 };
 
-struct VMin8u
+template<typename _Tpvec> struct VMin
 {
-    enum { ESZ = 1 };
-    __m128i operator()(const __m128i& a, const __m128i& b) const { return _mm_min_epu8(a,b); }
+    typedef _Tpvec vtype;
+    vtype operator()(const vtype& a, const vtype& b) const { return v_min(a, b); }
 };
-struct VMax8u
-{
-    enum { ESZ = 1 };
-    __m128i operator()(const __m128i& a, const __m128i& b) const { return _mm_max_epu8(a,b); }
-};
-struct VMin16u
-{
-    enum { ESZ = 2 };
-    __m128i operator()(const __m128i& a, const __m128i& b) const
-    { return _mm_subs_epu16(a,_mm_subs_epu16(a,b)); }
-};
-struct VMax16u
-{
-    enum { ESZ = 2 };
-    __m128i operator()(const __m128i& a, const __m128i& b) const
-    { return _mm_adds_epu16(_mm_subs_epu16(a,b), b); }
-};
-struct VMin16s
-{
-    enum { ESZ = 2 };
-    __m128i operator()(const __m128i& a, const __m128i& b) const
-    { return _mm_min_epi16(a, b); }
-};
-struct VMax16s
+
+template<typename _Tpvec> struct VMax
 {
-    enum { ESZ = 2 };
-    __m128i operator()(const __m128i& a, const __m128i& b) const
-    { return _mm_max_epi16(a, b); }
+    typedef _Tpvec vtype;
+    vtype operator()(const vtype& a, const vtype& b) const { return v_max(a, b); }
 };
-struct VMin32f { __m128 operator()(const __m128& a, const __m128& b) const { return _mm_min_ps(a,b); }};
-struct VMax32f { __m128 operator()(const __m128& a, const __m128& b) const { return _mm_max_ps(a,b); }};
-
-typedef MorphRowIVec<VMin8u> ErodeRowVec8u;
-typedef MorphRowIVec<VMax8u> DilateRowVec8u;
-typedef MorphRowIVec<VMin16u> ErodeRowVec16u;
-typedef MorphRowIVec<VMax16u> DilateRowVec16u;
-typedef MorphRowIVec<VMin16s> ErodeRowVec16s;
-typedef MorphRowIVec<VMax16s> DilateRowVec16s;
-typedef MorphRowFVec<VMin32f> ErodeRowVec32f;
-typedef MorphRowFVec<VMax32f> DilateRowVec32f;
-
-typedef MorphColumnIVec<VMin8u> ErodeColumnVec8u;
-typedef MorphColumnIVec<VMax8u> DilateColumnVec8u;
-typedef MorphColumnIVec<VMin16u> ErodeColumnVec16u;
-typedef MorphColumnIVec<VMax16u> DilateColumnVec16u;
-typedef MorphColumnIVec<VMin16s> ErodeColumnVec16s;
-typedef MorphColumnIVec<VMax16s> DilateColumnVec16s;
-typedef MorphColumnFVec<VMin32f> ErodeColumnVec32f;
-typedef MorphColumnFVec<VMax32f> DilateColumnVec32f;
-
-typedef MorphIVec<VMin8u> ErodeVec8u;
-typedef MorphIVec<VMax8u> DilateVec8u;
-typedef MorphIVec<VMin16u> ErodeVec16u;
-typedef MorphIVec<VMax16u> DilateVec16u;
-typedef MorphIVec<VMin16s> ErodeVec16s;
-typedef MorphIVec<VMax16s> DilateVec16s;
-typedef MorphFVec<VMin32f> ErodeVec32f;
-typedef MorphFVec<VMax32f> DilateVec32f;
 
+#ifdef HAVE_TEGRA_OPTIMIZATION
+using tegra::ErodeRowVec8u;
+using tegra::DilateRowVec8u;
+
+using tegra::ErodeColumnVec8u;
+using tegra::DilateColumnVec8u;
+#else
+typedef MorphRowVec<VMin<v_uint8x16> > ErodeRowVec8u;
+typedef MorphRowVec<VMax<v_uint8x16> > DilateRowVec8u;
+
+typedef MorphColumnVec<VMin<v_uint8x16> > ErodeColumnVec8u;
+typedef MorphColumnVec<VMax<v_uint8x16> > DilateColumnVec8u;
+#endif
+
+typedef MorphRowVec<VMin<v_uint16x8> > ErodeRowVec16u;
+typedef MorphRowVec<VMax<v_uint16x8> > DilateRowVec16u;
+typedef MorphRowVec<VMin<v_int16x8> > ErodeRowVec16s;
+typedef MorphRowVec<VMax<v_int16x8> > DilateRowVec16s;
+typedef MorphRowVec<VMin<v_float32x4> > ErodeRowVec32f;
+typedef MorphRowVec<VMax<v_float32x4> > DilateRowVec32f;
+
+typedef MorphColumnVec<VMin<v_uint16x8> > ErodeColumnVec16u;
+typedef MorphColumnVec<VMax<v_uint16x8> > DilateColumnVec16u;
+typedef MorphColumnVec<VMin<v_int16x8> > ErodeColumnVec16s;
+typedef MorphColumnVec<VMax<v_int16x8> > DilateColumnVec16s;
+typedef MorphColumnVec<VMin<v_float32x4> > ErodeColumnVec32f;
+typedef MorphColumnVec<VMax<v_float32x4> > DilateColumnVec32f;
+
+typedef MorphVec<VMin<v_uint8x16> > ErodeVec8u;
+typedef MorphVec<VMax<v_uint8x16> > DilateVec8u;
+typedef MorphVec<VMin<v_uint16x8> > ErodeVec16u;
+typedef MorphVec<VMax<v_uint16x8> > DilateVec16u;
+typedef MorphVec<VMin<v_int16x8> > ErodeVec16s;
+typedef MorphVec<VMax<v_int16x8> > DilateVec16s;
+typedef MorphVec<VMin<v_float32x4> > ErodeVec32f;
+typedef MorphVec<VMax<v_float32x4> > DilateVec32f;
 #else
 
 #ifdef HAVE_TEGRA_OPTIMIZATION
@@ -685,7 +431,7 @@ template<class Op, class VecOp> struct MorphRowFilter : public BaseRowFilter
 };
 
 
-template<class Op, class VecOp> struct MorphColumnFilter : public BaseColumnFilter
+template<class Op, class VecOp> struct MorphColumnFilter : public BaseColumnFilter, public StatelessFilter
 {
     typedef typename Op::rtype T;
 
@@ -780,7 +526,7 @@ template<class Op, class VecOp> struct MorphColumnFilter : public BaseColumnFilt
 };
 
 
-template<class Op, class VecOp> struct MorphFilter : BaseFilter
+template<class Op, class VecOp> struct MorphFilter : BaseFilter, StatelessFilter
 {
     typedef typename Op::rtype T;
 
@@ -793,14 +539,14 @@ template<class Op, class VecOp> struct MorphFilter : BaseFilter
         vector<uchar> coeffs; // we do not really the values of non-zero
         // kernel elements, just their locations
         preprocess2DKernel( _kernel, coords, coeffs );
-        ptrs.resize( coords.size() );
     }
 
     void operator()(const uchar** src, uchar* dst, int dststep, int count, int width, int cn)
     {
         const Point* pt = &coords[0];
-        const T** kp = (const T**)&ptrs[0];
         int i, k, nz = (int)coords.size();
+        AutoBuffer<uchar*> ptrs(nz);
+        const T** kp = (const T**)(uchar**)ptrs;
         Op op;
 
         width *= cn;
@@ -811,7 +557,7 @@ template<class Op, class VecOp> struct MorphFilter : BaseFilter
             for( k = 0; k < nz; k++ )
                 kp[k] = (const T*)src[pt[k].y] + pt[k].x*cn;
 
-            i = vecOp(&ptrs[0], nz, dst, width);
+            i = vecOp(ptrs, nz, dst, width);
             #if CV_ENABLE_UNROLLED
             for( ; i <= width - 4; i += 4 )
             {
@@ -840,7 +586,160 @@ template<class Op, class VecOp> struct MorphFilter : BaseFilter
     }
 
     vector<Point> coords;
-    vector<uchar*> ptrs;
+    VecOp vecOp;
+};
+
+/*
+ van Herk/Gil-Werman filters for the rectangular and line structuring elements.
+
+ The input is split into blocks of ksize elements and the running minimums (maximums) are
+ computed within each block from both of its ends. Any window of ksize elements covers the end
+ of one block and the beginning of the next one, so its extremum is a combination of two
+ precomputed values, and the cost per pixel does not depend on the kernel size.
+*/
+// the table-based CV_MIN_8U/CV_MAX_8U are slow in the dependency chains of the running extremums
+template<class Op> struct RunningOp
+{
+    typedef typename Op::rtype T;
+    T operator ()(T a, T b) const { return Op()(a, b); }
+};
+
+template<> struct RunningOp<MinOp<uchar> >
+{
+    uchar operator ()(uchar a, uchar b) const { return std::min(a, b); }
+};
+
+template<> struct RunningOp<MaxOp<uchar> >
+{
+    uchar operator ()(uchar a, uchar b) const { return std::max(a, b); }
+};
+
+template<class Op, class VecOp> struct MorphRowVHGW : public BaseRowFilter
+{
+    typedef typename Op::rtype T;
+
+    MorphRowVHGW( int _ksize, int _anchor )
+    {
+        ksize = _ksize;
+        anchor = _anchor;
+    }
+
+    void operator()(const uchar* src, uchar* dst, int width, int cn)
+    {
+        int i, j, k, _ksize = ksize*cn, n = (width + ksize - 1)*cn;
+        AutoBuffer<T> _buf(n*2);
+        const T* S = (const T*)src;
+        T* D = (T*)dst;
+        T* g = _buf;
+        T* h = g + n;
+        RunningOp<Op> rop;
+        Op op;
+
+        // g and h keep the channels interleaved, so the blocks consist of ksize*cn elements
+        for( i = 0; i < n; i += _ksize )
+        {
+            int i1 = std::min(i + _ksize, n);
+            for( k = 0; k < cn; k++ )
+            {
+                T m = S[i + k];
+                g[i + k] = m;
+                for( j = i + k + cn; j < i1; j += cn )
+                    g[j] = m = rop(m, S[j]);
+
+                m = S[i1 - cn + k];
+                h[i1 - cn + k] = m;
+                for( j = i1 - cn*2 + k; j >= i; j -= cn )
+                    h[j] = m = rop(m, S[j]);
+            }
+        }
+
+        uchar* ptrs[] = { (uchar*)h, (uchar*)(g + _ksize - cn) };
+        width *= cn;
+        i = vecOp(ptrs, 2, dst, width);
+        for( ; i < width; i++ )
+            D[i] = op(h[i], g[i + _ksize - cn]);
+    }
+
+    VecOp vecOp;
+};
+
+
+template<class Op, class VecOp> struct MorphColumnVHGW : public BaseColumnFilter, public StatelessFilter
+{
+    typedef typename Op::rtype T;
+
+    MorphColumnVHGW( int _ksize, int _anchor )
+    {
+        ksize = _ksize;
+        anchor = _anchor;
+    }
+
+    // dst = op(src[0], ..., src[nz-1])
+    void combine( uchar** src, int nz, T* dst, int width ) const
+    {
+        int i = vecOp(src, nz, (uchar*)dst, width), k;
+        Op op;
+        for( ; i < width; i++ )
+        {
+            T s0 = ((const T*)src[0])[i];
+            for( k = 1; k < nz; k++ )
+                s0 = op(s0, ((const T*)src[k])[i]);
+            dst[i] = s0;
+        }
+    }
+
+    void operator()(const uchar** src, uchar* dst, int dststep, int count, int width)
+    {
+        int j, k, _ksize = ksize;
+        // the row buffers for the running extremums of the block tail, its center and the next block head
+        AutoBuffer<T> _buf(width*(_ksize + 1));
+        AutoBuffer<uchar*> _ptrs(_ksize + 1);
+        T* tail = _buf;
+        T* head = tail + width*(_ksize - 1);
+        T* center = head + width;
+        uchar** ptrs = _ptrs;
+
+        // process the output rows by groups of up to ksize rows: the windows of the group rows
+        // share the center rows [n-1, ksize-1], the rest is taken from the running extremums
+        for( ; count > 0; src += _ksize, dst += dststep*_ksize, count -= _ksize )
+        {
+            int n = std::min(count, _ksize);
+
+            for( k = n - 1; k < _ksize; k++ )
+                ptrs[k - n + 1] = (uchar*)src[k];
+            combine( ptrs, _ksize - n + 1, center, width );
+
+            if( n > 1 )
+                memcpy( tail + width*(n - 2), src[n - 2], width*sizeof(T) );
+            for( j = n - 3; j >= 0; j-- )
+            {
+                ptrs[0] = (uchar*)src[j];
+                ptrs[1] = (uchar*)(tail + width*(j + 1));
+                combine( ptrs, 2, tail + width*j, width );
+            }
+
+            for( j = 0; j < n; j++ )
+            {
+                int nz = 0;
+                ptrs[nz++] = (uchar*)center;
+                if( j < n - 1 )
+                    ptrs[nz++] = (uchar*)(tail + width*j);
+                if( j > 0 )
+                {
+                    if( j == 1 )
+                        memcpy( head, src[_ksize], width*sizeof(T) );
+                    else
+                    {
+                        uchar* hptrs[] = { (uchar*)head, (uchar*)src[_ksize + j - 1] };
+                        combine( hptrs, 2, head, width );
+                    }
+                    ptrs[nz++] = (uchar*)head;
+                }
+                combine( ptrs, nz, (T*)(dst + dststep*j), width );
+            }
+        }
+    }
+
     VecOp vecOp;
 };
 
@@ -848,12 +747,45 @@ template<class Op, class VecOp> struct MorphFilter : BaseFilter
 
 /////////////////////////////////// External Interface /////////////////////////////////////
 
+namespace cv
+{
+
+// returns the kernel size starting from which the van Herk/Gil-Werman filters are faster
+// than the direct ones. The running extremums along the rows can not be vectorized,
+// so the vectorized direct row filters win up to the quite large kernel sizes
+static int getMorphVHGWMinKSize( int depth, bool rowFilter )
+{
+    static const int rowTab[] = { 101, 101, 31, 31, 25, 25, 15 };
+    static const int colTab[] = { 11, 11, 9, 9, 15, 15, 9 };
+    return rowFilter ? rowTab[depth] : colTab[depth];
+}
+
+}
+
 cv::Ptr<cv::BaseRowFilter> cv::getMorphologyRowFilter(int op, int type, int ksize, int anchor)
 {
     int depth = CV_MAT_DEPTH(type);
     if( anchor < 0 )
         anchor = ksize/2;
     CV_Assert( op == MORPH_ERODE || op == MORPH_DILATE );
+    if( ksize >= getMorphVHGWMinKSize(depth, true) )
+    {
+        if( depth == CV_8U )
+            return op == MORPH_ERODE ? Ptr<BaseRowFilter>(new MorphRowVHGW<MinOp<uchar>, ErodeVec8u>(ksize, anchor)) :
+                                       Ptr<BaseRowFilter>(new MorphRowVHGW<MaxOp<uchar>, DilateVec8u>(ksize, anchor));
+        if( depth == CV_16U )
+            return op == MORPH_ERODE ? Ptr<BaseRowFilter>(new MorphRowVHGW<MinOp<ushort>, ErodeVec16u>(ksize, anchor)) :
+                                       Ptr<BaseRowFilter>(new MorphRowVHGW<MaxOp<ushort>, DilateVec16u>(ksize, anchor));
+        if( depth == CV_16S )
+            return op == MORPH_ERODE ? Ptr<BaseRowFilter>(new MorphRowVHGW<MinOp<short>, ErodeVec16s>(ksize, anchor)) :
+                                       Ptr<BaseRowFilter>(new MorphRowVHGW<MaxOp<short>, DilateVec16s>(ksize, anchor));
+        if( depth == CV_32F )
+            return op == MORPH_ERODE ? Ptr<BaseRowFilter>(new MorphRowVHGW<MinOp<float>, ErodeVec32f>(ksize, anchor)) :
+                                       Ptr<BaseRowFilter>(new MorphRowVHGW<MaxOp<float>, DilateVec32f>(ksize, anchor));
+        if( depth == CV_64F )
+            return op == MORPH_ERODE ? Ptr<BaseRowFilter>(new MorphRowVHGW<MinOp<double>, ErodeVec64f>(ksize, anchor)) :
+                                       Ptr<BaseRowFilter>(new MorphRowVHGW<MaxOp<double>, DilateVec64f>(ksize, anchor));
+    }
     if( op == MORPH_ERODE )
     {
         if( depth == CV_8U )
@@ -901,6 +833,29 @@ cv::Ptr<cv::BaseColumnFilter> cv::getMorphologyColumnFilter(int op, int type, in
     if( anchor < 0 )
         anchor = ksize/2;
     CV_Assert( op == MORPH_ERODE || op == MORPH_DILATE );
+    if( ksize >= getMorphVHGWMinKSize(depth, false) )
+    {
+        if( depth == CV_8U )
+            return op == MORPH_ERODE ?
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MinOp<uchar>, ErodeVec8u>(ksize, anchor)) :
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MaxOp<uchar>, DilateVec8u>(ksize, anchor));
+        if( depth == CV_16U )
+            return op == MORPH_ERODE ?
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MinOp<ushort>, ErodeVec16u>(ksize, anchor)) :
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MaxOp<ushort>, DilateVec16u>(ksize, anchor));
+        if( depth == CV_16S )
+            return op == MORPH_ERODE ?
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MinOp<short>, ErodeVec16s>(ksize, anchor)) :
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MaxOp<short>, DilateVec16s>(ksize, anchor));
+        if( depth == CV_32F )
+            return op == MORPH_ERODE ?
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MinOp<float>, ErodeVec32f>(ksize, anchor)) :
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MaxOp<float>, DilateVec32f>(ksize, anchor));
+        if( depth == CV_64F )
+            return op == MORPH_ERODE ?
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MinOp<double>, ErodeVec64f>(ksize, anchor)) :
+                Ptr<BaseColumnFilter>(new MorphColumnVHGW<MaxOp<double>, DilateVec64f>(ksize, anchor));
+    }
     if( op == MORPH_ERODE )
     {
         if( depth == CV_8U )
@@ -1081,20 +1036,16 @@ cv::Mat cv::getStructuringElement(int shape, Size ksize, Point anchor)
 namespace cv
 {
 
-class MorphologyRunner
+class MorphologyRunner : public ParallelLoopBody
 {
 public:
-    MorphologyRunner(Mat _src, Mat _dst, int _nStripes, int _iterations,
-                     int _op, Mat _kernel, Point _anchor,
+    MorphologyRunner(Mat _src, Mat _dst, int _op, Mat _kernel, Point _anchor,
                      int _rowBorderType, int _columnBorderType, const Scalar& _borderValue) :
         borderValue(_borderValue)
     {
         src = _src;
         dst = _dst;
 
-        nStripes = _nStripes;
-        iterations = _iterations;
-
         op = _op;
         kernel = _kernel;
         anchor = _anchor;
@@ -1102,31 +1053,24 @@ public:
         columnBorderType = _columnBorderType;
     }
 
-    void operator () ( const BlockedRange& range ) const
+    void operator () ( const Range& range ) const
     {
-        int row0 = min(cvRound(range.begin() * src.rows / nStripes), src.rows);
-        int row1 = min(cvRound(range.end() * src.rows / nStripes), src.rows);
-
-        /*if(0)
-            printf("Size = (%d, %d), range[%d,%d), row0 = %d, row1 = %d\n",
-                   src.rows, src.cols, range.begin(), range.end(), row0, row1);*/
-
-        Mat srcStripe = src.rowRange(row0, row1);
-        Mat dstStripe = dst.rowRange(row0, row1);
+        Mat srcStripe = src.rowRange(range.start, range.end);
+        Mat dstStripe = dst.rowRange(range.start, range.end);
 
         Ptr<FilterEngine> f = createMorphologyFilter(op, src.type(), kernel, anchor,
                                                      rowBorderType, columnBorderType, borderValue );
 
-        f->apply( srcStripe, dstStripe );
-        for( int i = 1; i < iterations; i++ )
-            f->apply( dstStripe, dstStripe );
+        // the rows outside of the stripe are taken from the source image.
+        // The larger ring buffer lets the column filter process up to ksize rows at once
+        int y = f->start(srcStripe, Rect(0,0,-1,-1), false, f->ksize.height*2 + 1);
+        f->proceed( srcStripe.data + y*srcStripe.step, (int)srcStripe.step, f->endY - f->startY,
+                    dstStripe.data, (int)dstStripe.step );
     }
 
 private:
     Mat src;
     Mat dst;
-    int nStripes;
-    int iterations;
 
     int op;
     Mat kernel;
@@ -1172,23 +1116,29 @@ static void morphOp( int op, InputArray _src, OutputArray _dst,
         iterations = 1;
     }
 
-    int nStripes = 1;
-#if defined HAVE_TBB && defined HAVE_TEGRA_OPTIMIZATION
-    if (src.data != dst.data && iterations == 1 &&  //NOTE: threads are not used for inplace processing
-        (borderType & BORDER_ISOLATED) == 0 && //TODO: check border types
-        src.rows >= 64 ) //NOTE: just heuristics
-        nStripes = 4;
-#endif
-
-    parallel_for(BlockedRange(0, nStripes),
-                 MorphologyRunner(src, dst, nStripes, iterations, op, kernel, anchor, borderType, borderType, borderValue));
+    // each stripe re-filters kernel.rows-1 rows of its neighbours, so the stripes should not be too thin
+    int minStripeRows = std::max((kernel.rows - 1)*4, 16);
+    double nstripes = std::min((double)src.rows/minStripeRows, src.total()/(double)(1 << 16));
+    Mat cur = src, buf[2];
 
-    //Ptr<FilterEngine> f = createMorphologyFilter(op, src.type(),
-    //                                             kernel, anchor, borderType, borderType, borderValue );
+    for( int i = 0; i < iterations; i++ )
+    {
+        // the intermediate results are stored in the temporary buffers, unless
+        // the pixels outside of dst are involved into the next iterations
+        Mat next = dst;
+        if( i < iterations - 1 && !dst.isSubmatrix() )
+        {
+            buf[i & 1].create(src.size(), src.type());
+            next = buf[i & 1];
+        }
 
-    //f->apply( src, dst );
-    //for( int i = 1; i < iterations; i++ )
-    //    f->apply( dst, dst );
+        MorphologyRunner runner(cur, next, op, kernel, anchor, borderType, borderType, borderValue);
+        if( nstripes >= 2 && !(cur.datastart < next.dataend && next.datastart < cur.dataend) )
+            parallel_for_(Range(0, src.rows), runner, nstripes);
+        else
+            runner(Range(0, src.rows));
+        cur = next;
+    }
 }
 
 template<> void Ptr<IplConvKernel>::delete_obj()
@@ -92,11 +92,36 @@ static inline Point normalizeAnchor( Point anchor, Size ksize )
 }
 
 void preprocess2DKernel( const Mat& kernel, vector<Point>& coords, vector<uchar>& coeffs );
+
+// a marker base of the column and 2D filters that keep no context between the calls;
+// FilterEngine::apply runs such filters on several image bands concurrently
+class StatelessFilter
+{
+public:
+    virtual ~StatelessFilter() {}
+};
 void crossCorr( const Mat& src, const Mat& templ, Mat& dst,
                 Size corrsize, int ctype,
                 Point anchor=Point(0,0), double delta=0,
                 int borderType=BORDER_REFLECT_101 );
 
+// DFT of every template plane, sized for the blocks crossCorr splits the result into;
+// it can be computed once and reused for any number of images of the same depth
+struct CrossCorrSpectrum
+{
+    Size templSize, blockSize, dftSize;
+    int imgDepth, cdepth, depth, cn;
+    Mat planes;
+};
+
+void getCrossCorrBlockSize( Size templSize, Size corrsize, Size& blocksize, Size& dftsize );
+void computeCrossCorrSpectrum( const Mat& templ, int imgDepth, int cdepth,
+                               Size blocksize, Size dftsize, CrossCorrSpectrum& spectrum );
+void crossCorr( const Mat& src, const CrossCorrSpectrum& templSpectrum, Mat& dst,
+                Size corrsize, int ctype,
+                Point anchor=Point(0,0), double delta=0,
+                int borderType=BORDER_REFLECT_101 );
+
 }
 
 typedef struct CvPyramid
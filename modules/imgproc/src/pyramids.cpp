@@ -184,237 +184,340 @@ typedef NoVec<float, float> PyrDownVec_32f;
 
 #endif
 
-template<class CastOp, class VecOp> void
-pyrDown_( const Mat& _src, Mat& _dst, int borderType )
+// Computes one or several successive pyrDown levels for a horizontal band of the last level.
+// levels[0] is the source image and levels[1..nlevels] are the preallocated destination
+// levels. The levels are produced in one top-to-bottom sweep: a row of an intermediate
+// level is computed when the next level needs it and is consumed while it is still in cache.
+// Each band owns the rows of every level that lie above its own rows of the last level
+// (with the band borders scaled by 2 per level) and writes only them; the few rows of the
+// intermediate levels it needs from the neighbouring bands are recomputed privately, so
+// the result does not depend on the band layout.
+template<class CastOp, class VecOp> class PyrDownInvoker : public ParallelLoopBody
 {
-    const int PD_SZ = 5;
+public:
     typedef typename CastOp::type1 WT;
     typedef typename CastOp::rtype T;
+    enum { PD_SZ = 5, CACHE_SZ = 8 };
+
+    PyrDownInvoker( const Mat* _levels, int _nlevels, int _borderType )
+        : levels(_levels), nlevels(_nlevels), borderType(_borderType)
+    {
+    }
 
-    Size ssize = _src.size(), dsize = _dst.size();
-    int cn = _src.channels();
-    int bufstep = (int)alignSize(dsize.width*cn, 16);
-    AutoBuffer<WT> _buf(bufstep*PD_SZ + 16);
-    WT* buf = alignPtr((WT*)_buf, 16);
-    int tabL[CV_CN_MAX*(PD_SZ+2)], tabR[CV_CN_MAX*(PD_SZ+2)];
-    AutoBuffer<int> _tabM(dsize.width*cn);
-    int* tabM = _tabM;
-    WT* rows[PD_SZ];
-    CastOp castOp;
-    VecOp vecOp;
-
-    CV_Assert( std::abs(dsize.width*2 - ssize.width) <= 2 &&
-               std::abs(dsize.height*2 - ssize.height) <= 2 );
-    int k, x, sy0 = -PD_SZ/2, sy = sy0, width0 = std::min((ssize.width-PD_SZ/2-1)/2 + 1, dsize.width);
-
-    for( x = 0; x <= PD_SZ+1; x++ )
+    void operator()( const Range& range ) const
     {
-        int sx0 = borderInterpolate(x - PD_SZ/2, ssize.width, borderType)*cn;
-        int sx1 = borderInterpolate(x + width0*2 - PD_SZ/2, ssize.width, borderType)*cn;
-        for( k = 0; k < cn; k++ )
+        std::vector<Level> lv(nlevels + 1);
+        int start = range.start;
+        bool last = range.end == levels[nlevels].rows;
+
+        for( int L = nlevels; L >= 1; L-- )
         {
-            tabL[x*cn + k] = sx0 + k;
-            tabR[x*cn + k] = sx1 + k;
+            int shift = nlevels - L;
+            initLevel(lv[L], L, start, range.start << shift,
+                      last ? levels[L].rows : range.end << shift);
+            start = std::max(start*2 - PD_SZ/2, 0);
         }
+
+        for( int y = range.start; y < range.end; y++ )
+            produceRow(&lv[0], nlevels);
     }
 
-    ssize.width *= cn;
-    dsize.width *= cn;
-    width0 *= cn;
+private:
+    struct Level
+    {
+        int swidth, dwidth, width0, srows, cn, bufstep;
+        int tabL[CV_CN_MAX*(PD_SZ+2)], tabR[CV_CN_MAX*(PD_SZ+2)];
+        std::vector<int> tabM;
+        std::vector<WT> _buf;
+        std::vector<T> _cache;
+        WT* buf;
+        const T* rowptr[CACHE_SZ];
+        int sy, sy0, ynext, ownStart, ownEnd;
+    };
+
+    void initLevel( Level& l, int L, int ystart, int ownStart, int ownEnd ) const
+    {
+        const Mat& src = levels[L-1];
+        const Mat& dst = levels[L];
+        Size ssize = src.size(), dsize = dst.size();
+        int x, k, cn = src.channels();
+        int width0 = std::min((ssize.width-PD_SZ/2-1)/2 + 1, dsize.width);
+
+        for( x = 0; x <= PD_SZ+1; x++ )
+        {
+            int sx0 = borderInterpolate(x - PD_SZ/2, ssize.width, borderType)*cn;
+            int sx1 = borderInterpolate(x + width0*2 - PD_SZ/2, ssize.width, borderType)*cn;
+            for( k = 0; k < cn; k++ )
+            {
+                l.tabL[x*cn + k] = sx0 + k;
+                l.tabR[x*cn + k] = sx1 + k;
+            }
+        }
 
-    for( x = 0; x < dsize.width; x++ )
-        tabM[x] = (x/cn)*2*cn + x % cn;
+        l.cn = cn;
+        l.swidth = ssize.width*cn;
+        l.dwidth = dsize.width*cn;
+        l.width0 = width0*cn;
+        l.srows = ssize.height;
+
+        l.tabM.resize(l.dwidth);
+        for( x = 0; x < l.dwidth; x++ )
+            l.tabM[x] = (x/cn)*2*cn + x % cn;
+
+        l.bufstep = (int)alignSize(l.dwidth, 16);
+        l._buf.resize(l.bufstep*PD_SZ + 16);
+        l.buf = alignPtr(&l._buf[0], 16);
+        if( L < nlevels )
+            l._cache.resize(l.dwidth*CACHE_SZ);
+
+        l.ynext = ystart;
+        l.sy = l.sy0 = ystart*2 - PD_SZ/2;
+        l.ownStart = ownStart;
+        l.ownEnd = ownEnd;
+    }
 
-    for( int y = 0; y < dsize.height; y++ )
+    // returns the row y of the level L; the row must be either ready or the next one
+    const T* getRow( Level* lv, int L, int y ) const
     {
-        T* dst = (T*)(_dst.data + _dst.step*y);
-        WT *row0, *row1, *row2, *row3, *row4;
+        if( L == 0 )
+            return (const T*)(levels[0].data + levels[0].step*y);
+        Level& l = lv[L];
+        while( l.ynext <= y )
+            produceRow(lv, L);
+        CV_DbgAssert( y >= l.ynext - CACHE_SZ );
+        return l.rowptr[y % CACHE_SZ];
+    }
 
-        // fill the ring buffer (horizontal convolution and decimation)
-        for( ; sy <= y*2 + 2; sy++ )
-        {
-            WT* row = buf + ((sy - sy0) % PD_SZ)*bufstep;
-            int _sy = borderInterpolate(sy, ssize.height, borderType);
-            const T* src = (const T*)(_src.data + _src.step*_sy);
-            int limit = cn;
-            const int* tab = tabL;
+    // horizontal convolution and decimation of a source row
+    void horizontal( const Level& l, const T* src, WT* row ) const
+    {
+        int x, cn = l.cn, width0 = l.width0, dwidth = l.dwidth;
+        int limit = cn;
+        const int* tab = l.tabL;
 
-            for( x = 0;;)
+        for( x = 0;;)
+        {
+            for( ; x < limit; x++ )
             {
-                for( ; x < limit; x++ )
-                {
-                    row[x] = src[tab[x+cn*2]]*6 + (src[tab[x+cn]] + src[tab[x+cn*3]])*4 +
-                        src[tab[x]] + src[tab[x+cn*4]];
-                }
+                row[x] = src[tab[x+cn*2]]*6 + (src[tab[x+cn]] + src[tab[x+cn*3]])*4 +
+                    src[tab[x]] + src[tab[x+cn*4]];
+            }
 
-                if( x == dsize.width )
-                    break;
+            if( x == dwidth )
+                break;
 
-                if( cn == 1 )
-                {
-                    for( ; x < width0; x++ )
-                        row[x] = src[x*2]*6 + (src[x*2 - 1] + src[x*2 + 1])*4 +
-                            src[x*2 - 2] + src[x*2 + 2];
-                }
-                else if( cn == 3 )
+            if( cn == 1 )
+            {
+                for( ; x < width0; x++ )
+                    row[x] = src[x*2]*6 + (src[x*2 - 1] + src[x*2 + 1])*4 +
+                        src[x*2 - 2] + src[x*2 + 2];
+            }
+            else if( cn == 3 )
+            {
+                for( ; x < width0; x += 3 )
                 {
-                    for( ; x < width0; x += 3 )
-                    {
-                        const T* s = src + x*2;
-                        WT t0 = s[0]*6 + (s[-3] + s[3])*4 + s[-6] + s[6];
-                        WT t1 = s[1]*6 + (s[-2] + s[4])*4 + s[-5] + s[7];
-                        WT t2 = s[2]*6 + (s[-1] + s[5])*4 + s[-4] + s[8];
-                        row[x] = t0; row[x+1] = t1; row[x+2] = t2;
-                    }
+                    const T* s = src + x*2;
+                    WT t0 = s[0]*6 + (s[-3] + s[3])*4 + s[-6] + s[6];
+                    WT t1 = s[1]*6 + (s[-2] + s[4])*4 + s[-5] + s[7];
+                    WT t2 = s[2]*6 + (s[-1] + s[5])*4 + s[-4] + s[8];
+                    row[x] = t0; row[x+1] = t1; row[x+2] = t2;
                 }
-                else if( cn == 4 )
+            }
+            else if( cn == 4 )
+            {
+                for( ; x < width0; x += 4 )
                 {
-                    for( ; x < width0; x += 4 )
-                    {
-                        const T* s = src + x*2;
-                        WT t0 = s[0]*6 + (s[-4] + s[4])*4 + s[-8] + s[8];
-                        WT t1 = s[1]*6 + (s[-3] + s[5])*4 + s[-7] + s[9];
-                        row[x] = t0; row[x+1] = t1;
-                        t0 = s[2]*6 + (s[-2] + s[6])*4 + s[-6] + s[10];
-                        t1 = s[3]*6 + (s[-1] + s[7])*4 + s[-5] + s[11];
-                        row[x+2] = t0; row[x+3] = t1;
-                    }
+                    const T* s = src + x*2;
+                    WT t0 = s[0]*6 + (s[-4] + s[4])*4 + s[-8] + s[8];
+                    WT t1 = s[1]*6 + (s[-3] + s[5])*4 + s[-7] + s[9];
+                    row[x] = t0; row[x+1] = t1;
+                    t0 = s[2]*6 + (s[-2] + s[6])*4 + s[-6] + s[10];
+                    t1 = s[3]*6 + (s[-1] + s[7])*4 + s[-5] + s[11];
+                    row[x+2] = t0; row[x+3] = t1;
                 }
-                else
+            }
+            else
+            {
+                for( ; x < width0; x++ )
                 {
-                    for( ; x < width0; x++ )
-                    {
-                        int sx = tabM[x];
-                        row[x] = src[sx]*6 + (src[sx - cn] + src[sx + cn])*4 +
-                            src[sx - cn*2] + src[sx + cn*2];
-                    }
+                    int sx = l.tabM[x];
+                    row[x] = src[sx]*6 + (src[sx - cn] + src[sx + cn])*4 +
+                        src[sx - cn*2] + src[sx + cn*2];
                 }
-
-                limit = dsize.width;
-                tab = tabR - x;
             }
+
+            limit = dwidth;
+            tab = l.tabR - x;
+        }
+    }
+
+    void produceRow( Level* lv, int L ) const
+    {
+        Level& l = lv[L];
+        const Mat& _dst = levels[L];
+        int x, k, y = l.ynext;
+        WT* rows[PD_SZ];
+        CastOp castOp;
+        VecOp vecOp;
+
+        // fill the ring buffer (horizontal convolution and decimation)
+        for( ; l.sy <= y*2 + 2; l.sy++ )
+        {
+            WT* row = l.buf + ((l.sy - l.sy0) % PD_SZ)*l.bufstep;
+            int _sy = borderInterpolate(l.sy, l.srows, borderType);
+            horizontal(l, getRow(lv, L-1, _sy), row);
         }
 
+        // the rows owned by the band go straight to the destination image,
+        // the rest is kept in the cache until the next level consumes it
+        T* dst = y >= l.ownStart && y < l.ownEnd ? (T*)(_dst.data + _dst.step*y) :
+            &l._cache[(y % CACHE_SZ)*l.dwidth];
+
         // do vertical convolution and decimation and write the result to the destination image
         for( k = 0; k < PD_SZ; k++ )
-            rows[k] = buf + ((y*2 - PD_SZ/2 + k - sy0) % PD_SZ)*bufstep;
-        row0 = rows[0]; row1 = rows[1]; row2 = rows[2]; row3 = rows[3]; row4 = rows[4];
+            rows[k] = l.buf + ((y*2 - PD_SZ/2 + k - l.sy0) % PD_SZ)*l.bufstep;
+        WT *row0 = rows[0], *row1 = rows[1], *row2 = rows[2], *row3 = rows[3], *row4 = rows[4];
 
-        x = vecOp(rows, dst, (int)_dst.step, dsize.width);
-        for( ; x < dsize.width; x++ )
+        x = vecOp(rows, dst, (int)_dst.step, l.dwidth);
+        for( ; x < l.dwidth; x++ )
             dst[x] = castOp(row2[x]*6 + (row1[x] + row3[x])*4 + row0[x] + row4[x]);
+
+        l.rowptr[y % CACHE_SZ] = dst;
+        l.ynext++;
     }
-}
 
+    const Mat* levels;
+    int nlevels;
+    int borderType;
+};
 
 template<class CastOp, class VecOp> void
-pyrUp_( const Mat& _src, Mat& _dst, int)
+pyrDown_( const Mat* levels, int nlevels, int borderType, int nstripes )
 {
-    const int PU_SZ = 3;
-    typedef typename CastOp::type1 WT;
-    typedef typename CastOp::rtype T;
-
-    Size ssize = _src.size(), dsize = _dst.size();
-    int cn = _src.channels();
-    int bufstep = (int)alignSize((dsize.width+1)*cn, 16);
-    AutoBuffer<WT> _buf(bufstep*PU_SZ + 16);
-    WT* buf = alignPtr((WT*)_buf, 16);
-    AutoBuffer<int> _dtab(ssize.width*cn);
-    int* dtab = _dtab;
-    WT* rows[PU_SZ];
-    CastOp castOp;
-    VecOp vecOp;
-
-    CV_Assert( std::abs(dsize.width - ssize.width*2) == dsize.width % 2 &&
-               std::abs(dsize.height - ssize.height*2) == dsize.height % 2);
-    int k, x, sy0 = -PU_SZ/2, sy = sy0, width0 = ssize.width - 1;
-
-    ssize.width *= cn;
-    dsize.width *= cn;
-    width0 *= cn;
-
-    for( x = 0; x < ssize.width; x++ )
-        dtab[x] = (x/cn)*2*cn + x % cn;
-
-    for( int y = 0; y < ssize.height; y++ )
+    for( int L = 1; L <= nlevels; L++ )
     {
-        T* dst0 = (T*)(_dst.data + _dst.step*y*2);
-        T* dst1 = (T*)(_dst.data + _dst.step*(y*2+1));
-        WT *row0, *row1, *row2;
+        Size ssize = levels[L-1].size(), dsize = levels[L].size();
+        CV_Assert( std::abs(dsize.width*2 - ssize.width) <= 2 &&
+                   std::abs(dsize.height*2 - ssize.height) <= 2 );
+    }
+    parallel_for_(Range(0, levels[nlevels].rows),
+                  PyrDownInvoker<CastOp, VecOp>(levels, nlevels, borderType), nstripes);
+}
 
-        if( y*2+1 >= dsize.height )
-            dst1 = dst0;
 
-        // fill the ring buffer (horizontal convolution and decimation)
-        for( ; sy <= y + 1; sy++ )
+template<class CastOp, class VecOp> class PyrUpInvoker : public ParallelLoopBody
+{
+public:
+    PyrUpInvoker( const Mat& _src, const Mat& _dst ) : src(_src), dst(_dst)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        const int PU_SZ = 3;
+        typedef typename CastOp::type1 WT;
+        typedef typename CastOp::rtype T;
+
+        const Mat& _src = src;
+        const Mat& _dst = dst;
+        Size ssize = _src.size(), dsize = _dst.size();
+        int cn = _src.channels();
+        int bufstep = (int)alignSize((dsize.width+1)*cn, 16);
+        AutoBuffer<WT> _buf(bufstep*PU_SZ + 16);
+        WT* buf = alignPtr((WT*)_buf, 16);
+        AutoBuffer<int> _dtab(ssize.width*cn);
+        int* dtab = _dtab;
+        WT* rows[PU_SZ];
+        CastOp castOp;
+        VecOp vecOp;
+
+        int k, x, sy0 = range.start - PU_SZ/2, sy = sy0;
+
+        ssize.width *= cn;
+        dsize.width *= cn;
+
+        for( x = 0; x < ssize.width; x++ )
+            dtab[x] = (x/cn)*2*cn + x % cn;
+
+        for( int y = range.start; y < range.end; y++ )
         {
-            WT* row = buf + ((sy - sy0) % PU_SZ)*bufstep;
-            int _sy = borderInterpolate(sy*2, dsize.height, BORDER_REFLECT_101)/2;
-            const T* src = (const T*)(_src.data + _src.step*_sy);
+            T* dst0 = (T*)(_dst.data + _dst.step*y*2);
+            T* dst1 = (T*)(_dst.data + _dst.step*(y*2+1));
+            WT *row0, *row1, *row2;
 
-            if( ssize.width == cn )
+            if( y*2+1 >= dsize.height )
+                dst1 = dst0;
+
+            // fill the ring buffer (horizontal convolution and decimation)
+            for( ; sy <= y + 1; sy++ )
             {
+                WT* row = buf + ((sy - sy0) % PU_SZ)*bufstep;
+                int _sy = borderInterpolate(sy*2, dsize.height, BORDER_REFLECT_101)/2;
+                const T* srow = (const T*)(_src.data + _src.step*_sy);
+
+                if( ssize.width == cn )
+                {
+                    for( x = 0; x < cn; x++ )
+                        row[x] = row[x + cn] = srow[x]*8;
+                    continue;
+                }
+
                 for( x = 0; x < cn; x++ )
-                    row[x] = row[x + cn] = src[x]*8;
-                continue;
-            }
+                {
+                    int dx = dtab[x];
+                    WT t0 = srow[x]*6 + srow[x + cn]*2;
+                    WT t1 = (srow[x] + srow[x + cn])*4;
+                    row[dx] = t0; row[dx + cn] = t1;
+                    dx = dtab[ssize.width - cn + x];
+                    int sx = ssize.width - cn + x;
+                    t0 = srow[sx - cn] + srow[sx]*7;
+                    t1 = srow[sx]*8;
+                    row[dx] = t0; row[dx + cn] = t1;
+                }
 
-            for( x = 0; x < cn; x++ )
-            {
-                int dx = dtab[x];
-                WT t0 = src[x]*6 + src[x + cn]*2;
-                WT t1 = (src[x] + src[x + cn])*4;
-                row[dx] = t0; row[dx + cn] = t1;
-                dx = dtab[ssize.width - cn + x];
-                int sx = ssize.width - cn + x;
-                t0 = src[sx - cn] + src[sx]*7;
-                t1 = src[sx]*8;
-                row[dx] = t0; row[dx + cn] = t1;
+                for( x = cn; x < ssize.width - cn; x++ )
+                {
+                    int dx = dtab[x];
+                    WT t0 = srow[x-cn] + srow[x]*6 + srow[x+cn];
+                    WT t1 = (srow[x] + srow[x+cn])*4;
+                    row[dx] = t0;
+                    row[dx+cn] = t1;
+                }
             }
 
-            for( x = cn; x < ssize.width - cn; x++ )
+            // do vertical convolution and decimation and write the result to the destination image
+            for( k = 0; k < PU_SZ; k++ )
+                rows[k] = buf + ((y - PU_SZ/2 + k - sy0) % PU_SZ)*bufstep;
+            row0 = rows[0]; row1 = rows[1]; row2 = rows[2];
+
+            x = vecOp(rows, dst0, (int)_dst.step, dsize.width);
+            for( ; x < dsize.width; x++ )
             {
-                int dx = dtab[x];
-                WT t0 = src[x-cn] + src[x]*6 + src[x+cn];
-                WT t1 = (src[x] + src[x+cn])*4;
-                row[dx] = t0;
-                row[dx+cn] = t1;
+                T t1 = castOp((row1[x] + row2[x])*4);
+                T t0 = castOp(row0[x] + row1[x]*6 + row2[x]);
+                dst1[x] = t1; dst0[x] = t0;
             }
         }
-
-        // do vertical convolution and decimation and write the result to the destination image
-        for( k = 0; k < PU_SZ; k++ )
-            rows[k] = buf + ((y - PU_SZ/2 + k - sy0) % PU_SZ)*bufstep;
-        row0 = rows[0]; row1 = rows[1]; row2 = rows[2];
-
-        x = vecOp(rows, dst0, (int)_dst.step, dsize.width);
-        for( ; x < dsize.width; x++ )
-        {
-            T t1 = castOp((row1[x] + row2[x])*4);
-            T t0 = castOp(row0[x] + row1[x]*6 + row2[x]);
-            dst1[x] = t1; dst0[x] = t0;
-        }
     }
-}
 
-typedef void (*PyrFunc)(const Mat&, Mat&, int);
-
-}
+private:
+    Mat src, dst;
+};
 
-void cv::pyrDown( InputArray _src, OutputArray _dst, const Size& _dsz, int borderType )
+template<class CastOp, class VecOp> void
+pyrUp_( const Mat& src, Mat& dst, int nstripes )
 {
-    Mat src = _src.getMat();
-    Size dsz = _dsz == Size() ? Size((src.cols + 1)/2, (src.rows + 1)/2) : _dsz;
-    _dst.create( dsz, src.type() );
-    Mat dst = _dst.getMat();
+    CV_Assert( std::abs(dst.cols - src.cols*2) == dst.cols % 2 &&
+               std::abs(dst.rows - src.rows*2) == dst.rows % 2);
+    parallel_for_(Range(0, src.rows), PyrUpInvoker<CastOp, VecOp>(src, dst), nstripes);
+}
 
-#ifdef HAVE_TEGRA_OPTIMIZATION
-    if(borderType == BORDER_DEFAULT && tegra::pyrDown(src, dst))
-        return;
-#endif
+typedef void (*PyrDownFunc)(const Mat*, int, int, int);
+typedef void (*PyrUpFunc)(const Mat&, Mat&, int);
 
-    int depth = src.depth();
-    PyrFunc func = 0;
+static PyrDownFunc getPyrDownFunc( int depth )
+{
+    PyrDownFunc func = 0;
     if( depth == CV_8U )
         func = pyrDown_<FixPtCast<uchar, 8>, PyrDownVec_32s8u>;
     else if( depth == CV_16S )
@@ -427,8 +530,35 @@ void cv::pyrDown( InputArray _src, OutputArray _dst, const Size& _dsz, int borde
         func = pyrDown_<FltCast<double, 8>, NoVec<double, double> >;
     else
         CV_Error( CV_StsUnsupportedFormat, "" );
+    return func;
+}
+
+enum { PYR_MIN_BAND_ROWS = 32 };
+
+// the number of bands a level of the given size is split to
+static int pyrNumStripes( const Mat& m )
+{
+    return std::max(std::min(m.rows/PYR_MIN_BAND_ROWS, (int)(m.total()/(1 << 16))), 1);
+}
+
+}
+
+void cv::pyrDown( InputArray _src, OutputArray _dst, const Size& _dsz, int borderType )
+{
+    Mat src = _src.getMat();
+    Size dsz = _dsz == Size() ? Size((src.cols + 1)/2, (src.rows + 1)/2) : _dsz;
+    _dst.create( dsz, src.type() );
+    Mat dst = _dst.getMat();
 
-    func( src, dst, borderType );
+#ifdef HAVE_TEGRA_OPTIMIZATION
+    if(borderType == BORDER_DEFAULT && tegra::pyrDown(src, dst))
+        return;
+#endif
+
+    CV_Assert( borderType != BORDER_CONSTANT );
+    PyrDownFunc func = getPyrDownFunc(src.depth());
+    Mat levels[] = { src, dst };
+    func( levels, 1, borderType, pyrNumStripes(dst) );
 }
 
 void cv::pyrUp( InputArray _src, OutputArray _dst, const Size& _dsz, int borderType )
@@ -443,8 +573,9 @@ void cv::pyrUp( InputArray _src, OutputArray _dst, const Size& _dsz, int borderT
         return;
 #endif
 
+    (void)borderType;
     int depth = src.depth();
-    PyrFunc func = 0;
+    PyrUpFunc func = 0;
     if( depth == CV_8U )
         func = pyrUp_<FixPtCast<uchar, 6>, NoVec<int, uchar> >;
     else if( depth == CV_16S )
@@ -458,7 +589,7 @@ void cv::pyrUp( InputArray _src, OutputArray _dst, const Size& _dsz, int borderT
     else
         CV_Error( CV_StsUnsupportedFormat, "" );
 
-    func( src, dst, borderType );
+    func( src, dst, pyrNumStripes(dst) );
 }
 
 void cv::buildPyramid( InputArray _src, OutputArrayOfArrays _dst, int maxlevel, int borderType )
@@ -466,8 +597,51 @@ void cv::buildPyramid( InputArray _src, OutputArrayOfArrays _dst, int maxlevel,
     Mat src = _src.getMat();
     _dst.create( maxlevel + 1, 1, 0 );
     _dst.getMatRef(0) = src;
+
+#ifdef HAVE_TEGRA_OPTIMIZATION
+    if( borderType == BORDER_DEFAULT )
+    {
+        for( int i = 1; i <= maxlevel; i++ )
+            pyrDown( _dst.getMatRef(i-1), _dst.getMatRef(i), Size(), borderType );
+        return;
+    }
+#endif
+
+    CV_Assert( borderType != BORDER_CONSTANT );
+    PyrDownFunc func = getPyrDownFunc(src.depth());
+
+    // the layers that already have the right size and type are reused,
+    // so a pyramid rebuilt for every frame of a video is not reallocated
+    std::vector<Mat> levels(maxlevel + 1);
+    levels[0] = src;
     for( int i = 1; i <= maxlevel; i++ )
-        pyrDown( _dst.getMatRef(i-1), _dst.getMatRef(i), Size(), borderType );
+    {
+        Mat& layer = _dst.getMatRef(i);
+        layer.create((levels[i-1].rows + 1)/2, (levels[i-1].cols + 1)/2, src.type());
+        levels[i] = layer;
+    }
+
+    // Build the pyramid in groups of fused levels. A group goes as deep as its last level
+    // can still be cut into as many bands as the first one; the small remaining levels
+    // are built together in a single band. BORDER_WRAP refers to the rows at the opposite
+    // side of a level, so every level is built separately then.
+    for( int L0 = 0; L0 < maxlevel; )
+    {
+        int L1 = L0 + 1, nstripes = pyrNumStripes(levels[L1]);
+        if( borderType != BORDER_WRAP )
+        {
+            if( nstripes > 1 )
+            {
+                while( L1 < maxlevel && levels[L1 + 1].rows >= nstripes*PYR_MIN_BAND_ROWS )
+                    L1++;
+            }
+            else
+                L1 = maxlevel;
+        }
+
+        func( &levels[L0], L1 - L0, borderType, nstripes );
+        L0 = L1;
+    }
 }
 
 CV_IMPL void cvPyrDown( const void* srcarr, void* dstarr, int _filter )
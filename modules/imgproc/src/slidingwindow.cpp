@@ -0,0 +1,181 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                        Intel License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000, Intel Corporation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of Intel Corporation may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+
+cv::SlidingWindowStats::SlidingWindowStats()
+    : pos(0, -2), sum(0), sqsum(0)
+{
+    memset(H, 0, sizeof(H));
+}
+
+cv::SlidingWindowStats::SlidingWindowStats(const Mat& _image, Size _winSize)
+{
+    init(_image, _winSize);
+}
+
+void cv::SlidingWindowStats::init(const Mat& _image, Size _winSize)
+{
+    CV_Assert( _image.type() == CV_8UC1 &&
+               _winSize.width > 0 && _winSize.width % 2 == 1 &&
+               _winSize.height > 0 && _winSize.height % 2 == 1 );
+
+    image = _image;
+    winSize = _winSize;
+    // any row other than the next one rebuilds the column histograms
+    pos = Point(0, -2);
+
+    colHist.assign(image.cols*256, 0);
+    colSum.assign(image.cols, 0);
+    colSqSum.assign(image.cols, 0);
+    memset(H, 0, sizeof(H));
+    sum = sqsum = 0;
+}
+
+void cv::SlidingWindowStats::addColumn(int x, int delta)
+{
+    const int* h = &colHist[x*256];
+    if( delta > 0 )
+        for( int b = 0; b < 256; b++ )
+            H[b] += h[b];
+    else
+        for( int b = 0; b < 256; b++ )
+            H[b] -= h[b];
+    sum += delta*colSum[x];
+    sqsum += delta*colSqSum[x];
+}
+
+void cv::SlidingWindowStats::setRow(int y)
+{
+    CV_Assert( image.data && 0 <= y && y < image.rows );
+
+    int x, i, cols = image.cols, rows = image.rows;
+    int rx = winSize.width/2, ry = winSize.height/2;
+    int* ch = &colHist[0];
+
+    if( y == pos.y + 1 )
+    {
+        // slide the column histograms one row down
+        const uchar* p0 = image.ptr(std::max(y - ry - 1, 0));
+        const uchar* p1 = image.ptr(std::min(y + ry, rows - 1));
+
+        for( x = 0; x < cols; x++, ch += 256 )
+        {
+            int v0 = p0[x], v1 = p1[x];
+            ch[v0]--;
+            ch[v1]++;
+            colSum[x] += v1 - v0;
+            colSqSum[x] += v1*v1 - v0*v0;
+        }
+    }
+    else
+    {
+        std::fill(colHist.begin(), colHist.end(), 0);
+        std::fill(colSum.begin(), colSum.end(), 0);
+        std::fill(colSqSum.begin(), colSqSum.end(), (int64)0);
+
+        for( i = y - ry; i <= y + ry; i++ )
+        {
+            const uchar* p = image.ptr(std::min(std::max(i, 0), rows - 1));
+            for( x = 0, ch = &colHist[0]; x < cols; x++, ch += 256 )
+            {
+                int v = p[x];
+                ch[v]++;
+                colSum[x] += v;
+                colSqSum[x] += v*v;
+            }
+        }
+    }
+
+    pos = Point(0, y);
+    memset(H, 0, sizeof(H));
+    sum = sqsum = 0;
+    for( x = -rx; x <= rx; x++ )
+        addColumn(std::min(std::max(x, 0), cols - 1), 1);
+}
+
+void cv::SlidingWindowStats::moveRight()
+{
+    CV_Assert( pos.y >= 0 && pos.x + 1 < image.cols );
+
+    int rx = winSize.width/2, cols = image.cols;
+    addColumn(std::min(pos.x + rx + 1, cols - 1), 1);
+    addColumn(std::max(pos.x - rx, 0), -1);
+    pos.x++;
+}
+
+cv::Point cv::SlidingWindowStats::center() const
+{
+    return pos;
+}
+
+int cv::SlidingWindowStats::count() const
+{
+    return winSize.area();
+}
+
+const int* cv::SlidingWindowStats::hist() const
+{
+    return H;
+}
+
+int cv::SlidingWindowStats::median() const
+{
+    int half = count()/2, s = 0, b = 0;
+    for( ; b < 255; b++ )
+    {
+        s += H[b];
+        if( s > half )
+            break;
+    }
+    return b;
+}
+
+double cv::SlidingWindowStats::mean() const
+{
+    return (double)sum/count();
+}
+
+double cv::SlidingWindowStats::stddev() const
+{
+    double m = mean();
+    return std::sqrt(std::max((double)sqsum/count() - m*m, 0.));
+}
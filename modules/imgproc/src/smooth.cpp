@@ -708,6 +708,41 @@ cv::Ptr<cv::FilterEngine> cv::createBoxFilter( int srcType, int dstType, Size ks
 }
 
 
+namespace cv
+{
+
+// The column sum filter keeps the sliding sum, so unlike the other filters it cannot be
+// shared between the bands processed by FilterEngine::apply; each band gets its own engine.
+class BoxFilterBandInvoker : public ParallelLoopBody
+{
+public:
+    BoxFilterBandInvoker(const Mat& _src, Mat& _dst, Size _ksize, Point _anchor,
+                         bool _normalize, int _borderType) :
+        ParallelLoopBody(), src(_src), dst(_dst), ksize(_ksize), anchor(_anchor),
+        normalize(_normalize), borderType(_borderType)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        Ptr<FilterEngine> f = createBoxFilter( src.type(), dst.type(),
+                            ksize, anchor, normalize, borderType );
+        Mat _dst = dst;
+        f->apply( src, _dst, Rect(0, range.start, src.cols, range.end - range.start),
+                  Point(0, range.start) );
+    }
+
+private:
+    Mat src;
+    Mat dst;
+    Size ksize;
+    Point anchor;
+    bool normalize;
+    int borderType;
+};
+
+}
+
 void cv::boxFilter( InputArray _src, OutputArray _dst, int ddepth,
                 Size ksize, Point anchor,
                 bool normalize, int borderType )
@@ -732,6 +767,17 @@ void cv::boxFilter( InputArray _src, OutputArray _dst, int ddepth,
 
     Ptr<FilterEngine> f = createBoxFilter( src.type(), dst.type(),
                         ksize, anchor, normalize, borderType );
+
+    // the bands give exactly the same result as the whole image only when the sums are integer
+    int minBandRows = std::max((f->ksize.height - 1)*4, 16);
+    double nstripes = std::min((double)src.rows/minBandRows, src.total()/(double)(1 << 16));
+    if( nstripes >= 2 && CV_MAT_DEPTH(f->bufType) == CV_32S &&
+        !(src.datastart < dst.dataend && dst.datastart < src.dataend) )
+    {
+        parallel_for_(Range(0, src.rows),
+                      BoxFilterBandInvoker(src, dst, ksize, anchor, normalize, borderType), nstripes);
+        return;
+    }
     f->apply( src, dst );
 }
 
@@ -935,8 +981,10 @@ static inline void histogram_muladd( int a, const HT x[16],
         y[i] = (HT)(y[i] + a * x[i]);
 }
 
+// Processes the tile of the destination image that starts at the column x0 and covers
+// the rows [i0, i1). The tiles are independent, so they can be processed in parallel.
 static void
-medianBlur_8u_O1( const Mat& _src, Mat& _dst, int ksize )
+medianBlur_8u_O1_tile( const Mat& _src, Mat& _dst, int ksize, int x0, int stripeSize, int i0, int i1 )
 {
 /**
  * HOP is short for Histogram OPeration. This macro makes an operation \a op on
@@ -955,184 +1003,176 @@ medianBlur_8u_O1( const Mat& _src, Mat& _dst, int ksize )
     Histogram CV_DECL_ALIGNED(16) H[4];
     HT CV_DECL_ALIGNED(16) luc[4][16];
 
-    int STRIPE_SIZE = std::min( _dst.cols, 512/cn );
+    int n = std::min(_dst.cols - x0, stripeSize) + r*2;
 
-    vector<HT> _h_coarse(1 * 16 * (STRIPE_SIZE + 2*r) * cn + 16);
-    vector<HT> _h_fine(16 * 16 * (STRIPE_SIZE + 2*r) * cn + 16);
+    vector<HT> _h_coarse(1 * 16 * n * cn + 16);
+    vector<HT> _h_fine(16 * 16 * n * cn + 16);
     HT* h_coarse = alignPtr(&_h_coarse[0], 16);
     HT* h_fine = alignPtr(&_h_fine[0], 16);
 #if MEDIAN_HAVE_SIMD
     volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
 #endif
 
-    for( int x = 0; x < _dst.cols; x += STRIPE_SIZE )
-    {
-        int i, j, k, c, n = std::min(_dst.cols - x, STRIPE_SIZE) + r*2;
-        const uchar* src = _src.data + x*cn;
-        uchar* dst = _dst.data + (x - r)*cn;
+    int i, j, k, c;
+    const uchar* src = _src.data + x0*cn;
+    uchar* dst = _dst.data + (x0 - r)*cn;
 
-        memset( h_coarse, 0, 16*n*cn*sizeof(h_coarse[0]) );
-        memset( h_fine, 0, 16*16*n*cn*sizeof(h_fine[0]) );
+    memset( h_coarse, 0, 16*n*cn*sizeof(h_coarse[0]) );
+    memset( h_fine, 0, 16*16*n*cn*sizeof(h_fine[0]) );
 
-        // First row initialization
+    // Column histograms of the rows [i0-r-1, i0+r-1], replicated at the top border
+    for( c = 0; c < cn; c++ )
+        for( i = i0 - r - 1; i < i0 + r; i++ )
+        {
+            const uchar* p = src + sstep*std::min(std::max(i, 0), m-1);
+            for ( j = 0; j < n; j++ )
+                COP( c, j, p[cn*j+c], ++ );
+        }
+
+    for( i = i0; i < i1; i++ )
+    {
+        const uchar* p0 = src + sstep * std::max( 0, i-r-1 );
+        const uchar* p1 = src + sstep * std::min( m-1, i+r );
+
+        memset( H, 0, cn*sizeof(H[0]) );
+        memset( luc, 0, cn*sizeof(luc[0]) );
         for( c = 0; c < cn; c++ )
         {
+            // Update column histograms for the entire row.
             for( j = 0; j < n; j++ )
-                COP( c, j, src[cn*j+c], += (cv::HT)(r+2) );
-
-            for( i = 1; i < r; i++ )
             {
-                const uchar* p = src + sstep*std::min(i, m-1);
-                for ( j = 0; j < n; j++ )
-                    COP( c, j, p[cn*j+c], ++ );
+                COP( c, j, p0[j*cn + c], -- );
+                COP( c, j, p1[j*cn + c], ++ );
             }
-        }
 
-        for( i = 0; i < m; i++ )
-        {
-            const uchar* p0 = src + sstep * std::max( 0, i-r-1 );
-            const uchar* p1 = src + sstep * std::min( m-1, i+r );
+            // First column initialization
+            for( k = 0; k < 16; ++k )
+                histogram_muladd( 2*r+1, &h_fine[16*n*(16*c+k)], &H[c].fine[k][0] );
 
-            memset( H, 0, cn*sizeof(H[0]) );
-            memset( luc, 0, cn*sizeof(luc[0]) );
-            for( c = 0; c < cn; c++ )
+        #if MEDIAN_HAVE_SIMD
+            if( useSIMD )
             {
-                // Update column histograms for the entire row.
-                for( j = 0; j < n; j++ )
-                {
-                    COP( c, j, p0[j*cn + c], -- );
-                    COP( c, j, p1[j*cn + c], ++ );
-                }
+                for( j = 0; j < 2*r; ++j )
+                    histogram_add_simd( &h_coarse[16*(n*c+j)], H[c].coarse );
 
-                // First column initialization
-                for( k = 0; k < 16; ++k )
-                    histogram_muladd( 2*r+1, &h_fine[16*n*(16*c+k)], &H[c].fine[k][0] );
-
-            #if MEDIAN_HAVE_SIMD
-                if( useSIMD )
+                for( j = r; j < n-r; j++ )
                 {
-                    for( j = 0; j < 2*r; ++j )
-                        histogram_add_simd( &h_coarse[16*(n*c+j)], H[c].coarse );
-
-                    for( j = r; j < n-r; j++ )
-                    {
-                        int t = 2*r*r + 2*r, b, sum = 0;
-                        HT* segment;
+                    int t = 2*r*r + 2*r, b, sum = 0;
+                    HT* segment;
 
-                        histogram_add_simd( &h_coarse[16*(n*c + std::min(j+r,n-1))], H[c].coarse );
+                    histogram_add_simd( &h_coarse[16*(n*c + std::min(j+r,n-1))], H[c].coarse );
 
-                        // Find median at coarse level
-                        for ( k = 0; k < 16 ; ++k )
+                    // Find median at coarse level
+                    for ( k = 0; k < 16 ; ++k )
+                    {
+                        sum += H[c].coarse[k];
+                        if ( sum > t )
                         {
-                            sum += H[c].coarse[k];
-                            if ( sum > t )
-                            {
-                                sum -= H[c].coarse[k];
-                                break;
-                            }
+                            sum -= H[c].coarse[k];
+                            break;
                         }
-                        assert( k < 16 );
+                    }
+                    assert( k < 16 );
 
-                        /* Update corresponding histogram segment */
-                        if ( luc[c][k] <= j-r )
+                    /* Update corresponding histogram segment */
+                    if ( luc[c][k] <= j-r )
+                    {
+                        memset( &H[c].fine[k], 0, 16 * sizeof(HT) );
+                        for ( luc[c][k] = cv::HT(j-r); luc[c][k] < MIN(j+r+1,n); ++luc[c][k] )
+                            histogram_add_simd( &h_fine[16*(n*(16*c+k)+luc[c][k])], H[c].fine[k] );
+
+                        if ( luc[c][k] < j+r+1 )
                         {
-                            memset( &H[c].fine[k], 0, 16 * sizeof(HT) );
-                            for ( luc[c][k] = cv::HT(j-r); luc[c][k] < MIN(j+r+1,n); ++luc[c][k] )
-                                histogram_add_simd( &h_fine[16*(n*(16*c+k)+luc[c][k])], H[c].fine[k] );
-
-                            if ( luc[c][k] < j+r+1 )
-                            {
-                                histogram_muladd( j+r+1 - n, &h_fine[16*(n*(16*c+k)+(n-1))], &H[c].fine[k][0] );
-                                luc[c][k] = (HT)(j+r+1);
-                            }
+                            histogram_muladd( j+r+1 - n, &h_fine[16*(n*(16*c+k)+(n-1))], &H[c].fine[k][0] );
+                            luc[c][k] = (HT)(j+r+1);
                         }
-                        else
+                    }
+                    else
+                    {
+                        for ( ; luc[c][k] < j+r+1; ++luc[c][k] )
                         {
-                            for ( ; luc[c][k] < j+r+1; ++luc[c][k] )
-                            {
-                                histogram_sub_simd( &h_fine[16*(n*(16*c+k)+MAX(luc[c][k]-2*r-1,0))], H[c].fine[k] );
-                                histogram_add_simd( &h_fine[16*(n*(16*c+k)+MIN(luc[c][k],n-1))], H[c].fine[k] );
-                            }
+                            histogram_sub_simd( &h_fine[16*(n*(16*c+k)+MAX(luc[c][k]-2*r-1,0))], H[c].fine[k] );
+                            histogram_add_simd( &h_fine[16*(n*(16*c+k)+MIN(luc[c][k],n-1))], H[c].fine[k] );
                         }
+                    }
 
-                        histogram_sub_simd( &h_coarse[16*(n*c+MAX(j-r,0))], H[c].coarse );
+                    histogram_sub_simd( &h_coarse[16*(n*c+MAX(j-r,0))], H[c].coarse );
 
-                        /* Find median in segment */
-                        segment = H[c].fine[k];
-                        for ( b = 0; b < 16 ; b++ )
+                    /* Find median in segment */
+                    segment = H[c].fine[k];
+                    for ( b = 0; b < 16 ; b++ )
+                    {
+                        sum += segment[b];
+                        if ( sum > t )
                         {
-                            sum += segment[b];
-                            if ( sum > t )
-                            {
-                                dst[dstep*i+cn*j+c] = (uchar)(16*k + b);
-                                break;
-                            }
+                            dst[dstep*i+cn*j+c] = (uchar)(16*k + b);
+                            break;
                         }
-                        assert( b < 16 );
                     }
+                    assert( b < 16 );
                 }
-                else
-            #endif
-                {
-                    for( j = 0; j < 2*r; ++j )
-                        histogram_add( &h_coarse[16*(n*c+j)], H[c].coarse );
+            }
+            else
+        #endif
+            {
+                for( j = 0; j < 2*r; ++j )
+                    histogram_add( &h_coarse[16*(n*c+j)], H[c].coarse );
 
-                    for( j = r; j < n-r; j++ )
-                    {
-                        int t = 2*r*r + 2*r, b, sum = 0;
-                        HT* segment;
+                for( j = r; j < n-r; j++ )
+                {
+                    int t = 2*r*r + 2*r, b, sum = 0;
+                    HT* segment;
 
-                        histogram_add( &h_coarse[16*(n*c + std::min(j+r,n-1))], H[c].coarse );
+                    histogram_add( &h_coarse[16*(n*c + std::min(j+r,n-1))], H[c].coarse );
 
-                        // Find median at coarse level
-                        for ( k = 0; k < 16 ; ++k )
+                    // Find median at coarse level
+                    for ( k = 0; k < 16 ; ++k )
+                    {
+                        sum += H[c].coarse[k];
+                        if ( sum > t )
                         {
-                            sum += H[c].coarse[k];
-                            if ( sum > t )
-                            {
-                                sum -= H[c].coarse[k];
-                                break;
-                            }
+                            sum -= H[c].coarse[k];
+                            break;
                         }
-                        assert( k < 16 );
+                    }
+                    assert( k < 16 );
+
+                    /* Update corresponding histogram segment */
+                    if ( luc[c][k] <= j-r )
+                    {
+                        memset( &H[c].fine[k], 0, 16 * sizeof(HT) );
+                        for ( luc[c][k] = cv::HT(j-r); luc[c][k] < MIN(j+r+1,n); ++luc[c][k] )
+                            histogram_add( &h_fine[16*(n*(16*c+k)+luc[c][k])], H[c].fine[k] );
 
-                        /* Update corresponding histogram segment */
-                        if ( luc[c][k] <= j-r )
+                        if ( luc[c][k] < j+r+1 )
                         {
-                            memset( &H[c].fine[k], 0, 16 * sizeof(HT) );
-                            for ( luc[c][k] = cv::HT(j-r); luc[c][k] < MIN(j+r+1,n); ++luc[c][k] )
-                                histogram_add( &h_fine[16*(n*(16*c+k)+luc[c][k])], H[c].fine[k] );
-
-                            if ( luc[c][k] < j+r+1 )
-                            {
-                                histogram_muladd( j+r+1 - n, &h_fine[16*(n*(16*c+k)+(n-1))], &H[c].fine[k][0] );
-                                luc[c][k] = (HT)(j+r+1);
-                            }
+                            histogram_muladd( j+r+1 - n, &h_fine[16*(n*(16*c+k)+(n-1))], &H[c].fine[k][0] );
+                            luc[c][k] = (HT)(j+r+1);
                         }
-                        else
+                    }
+                    else
+                    {
+                        for ( ; luc[c][k] < j+r+1; ++luc[c][k] )
                         {
-                            for ( ; luc[c][k] < j+r+1; ++luc[c][k] )
-                            {
-                                histogram_sub( &h_fine[16*(n*(16*c+k)+MAX(luc[c][k]-2*r-1,0))], H[c].fine[k] );
-                                histogram_add( &h_fine[16*(n*(16*c+k)+MIN(luc[c][k],n-1))], H[c].fine[k] );
-                            }
+                            histogram_sub( &h_fine[16*(n*(16*c+k)+MAX(luc[c][k]-2*r-1,0))], H[c].fine[k] );
+                            histogram_add( &h_fine[16*(n*(16*c+k)+MIN(luc[c][k],n-1))], H[c].fine[k] );
                         }
+                    }
 
-                        histogram_sub( &h_coarse[16*(n*c+MAX(j-r,0))], H[c].coarse );
+                    histogram_sub( &h_coarse[16*(n*c+MAX(j-r,0))], H[c].coarse );
 
-                        /* Find median in segment */
-                        segment = H[c].fine[k];
-                        for ( b = 0; b < 16 ; b++ )
+                    /* Find median in segment */
+                    segment = H[c].fine[k];
+                    for ( b = 0; b < 16 ; b++ )
+                    {
+                        sum += segment[b];
+                        if ( sum > t )
                         {
-                            sum += segment[b];
-                            if ( sum > t )
-                            {
-                                dst[dstep*i+cn*j+c] = (uchar)(16*k + b);
-                                break;
-                            }
+                            dst[dstep*i+cn*j+c] = (uchar)(16*k + b);
+                            break;
                         }
-                        assert( b < 16 );
                     }
+                    assert( b < 16 );
                 }
             }
         }
@@ -1142,6 +1182,50 @@ medianBlur_8u_O1( const Mat& _src, Mat& _dst, int ksize )
 #undef COP
 }
 
+class MedianBlur_8u_O1_Invoker : public ParallelLoopBody
+{
+public:
+    MedianBlur_8u_O1_Invoker( const Mat& _src, Mat& _dst, int _ksize,
+                              int _stripeSize, int _nstripes, int _bandRows )
+        : src(_src), dst(_dst), ksize(_ksize), stripeSize(_stripeSize),
+          nstripes(_nstripes), bandRows(_bandRows)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        Mat _dst = dst;
+        for( int t = range.start; t < range.end; t++ )
+        {
+            int x0 = (t % nstripes)*stripeSize, i0 = (t / nstripes)*bandRows;
+            int i1 = std::min(i0 + bandRows, dst.rows);
+            medianBlur_8u_O1_tile( src, _dst, ksize, x0, stripeSize, i0, i1 );
+        }
+    }
+
+private:
+    Mat src, dst;
+    int ksize, stripeSize, nstripes, bandRows;
+};
+
+static void
+medianBlur_8u_O1( const Mat& src, Mat& dst, int ksize )
+{
+    int cn = dst.channels(), m = dst.rows;
+    int stripeSize = std::min( dst.cols, 512/cn );
+    int nstripes = (dst.cols + stripeSize - 1)/stripeSize;
+
+    // every row band starts with building the column histograms of ksize rows,
+    // so the bands are kept a few times taller than the aperture
+    int nbands = std::min( std::max(m/(ksize*4), 1),
+                           std::max((getNumThreads()*2 + nstripes - 1)/nstripes, 1) );
+    int bandRows = (m + nbands - 1)/nbands;
+    nbands = (m + bandRows - 1)/bandRows;
+
+    MedianBlur_8u_O1_Invoker body( src, dst, ksize, stripeSize, nstripes, bandRows );
+    parallel_for_( Range(0, nstripes*nbands), body );
+}
+
 static void
 medianBlur_8u_Om( const Mat& _src, Mat& _dst, int m )
 {
@@ -2192,6 +2276,726 @@ bilateralFilter_32f( const Mat& src, Mat& dst, int d,
     parallel_for_(Range(0, size.height), body, dst.total()/(double)(1<<16));
 }
 
+
+/****************************************************************************************\
+                       Bilateral Filtering on the Permutohedral Lattice
+\****************************************************************************************/
+
+// The approximation of Adams, Baek and Davis, "Fast High-Dimensional Filtering Using the
+// Permutohedral Lattice". Every pixel is splatted onto the d+1 vertices of the lattice simplex
+// enclosing its (x, y, color) position, the lattice values are blurred along each of the
+// d+1 lattice axes, and the result is sliced back at the pixel positions. The lattice only
+// has vertices near the pixel positions, so the cost per pixel does not depend on the sigmas.
+
+enum { LATTICE_MAX_DIM = 5 };
+
+class PermutohedralLattice
+{
+public:
+    PermutohedralLattice(int _d, int _vd) : d(_d), vd(_vd), table(1 << 10, -1) {}
+
+    int size() const { return (int)(keys.size()/d); }
+
+    // returns the index of the vertex with the given key;
+    // the vertex is added if create is set, otherwise -1 is returned when it is absent
+    int find(const int* key, bool create)
+    {
+        if( create && size()*2 >= (int)table.size() )
+            grow();
+        size_t h = lookup(key);
+        if( table[h] < 0 && create )
+        {
+            table[h] = size();
+            keys.insert(keys.end(), key, key + d);
+            values.resize(values.size() + vd, 0.f);
+        }
+        return table[h];
+    }
+
+    int find(const int* key) const
+    {
+        return table[lookup(key)];
+    }
+
+    int d, vd;
+    vector<int> keys;
+    vector<float> values;
+
+protected:
+    size_t hash(const int* key) const
+    {
+        size_t k = 0;
+        for( int i = 0; i < d; i++ )
+        {
+            k += key[i];
+            k *= 2531011;
+        }
+        return k;
+    }
+
+    // the slot of the key in the table, or the empty slot where it is to be inserted
+    size_t lookup(const int* key) const
+    {
+        size_t mask = table.size() - 1, h = hash(key) & mask;
+        while( table[h] >= 0 && !std::equal(key, key + d, &keys[table[h]*d]) )
+            h = (h + 1) & mask;
+        return h;
+    }
+
+    void grow()
+    {
+        table.assign(table.size()*2, -1);
+        size_t mask = table.size() - 1;
+        for( int idx = 0, n = size(); idx < n; idx++ )
+        {
+            size_t h = hash(&keys[idx*d]) & mask;
+            while( table[h] >= 0 )
+                h = (h + 1) & mask;
+            table[h] = idx;
+        }
+    }
+
+    vector<int> table;
+};
+
+// finds the lattice simplex that encloses a position
+class LatticeEmbedding
+{
+public:
+    LatticeEmbedding(int _d) : d(_d)
+    {
+        // scale the positions so that the lattice blur has unit standard deviation
+        float invStdDev = (float)(std::sqrt(2./3)*(d + 1));
+        for( int i = 0; i < d; i++ )
+            scale[i] = (float)(invStdDev/std::sqrt((double)(i + 1)*(i + 2)));
+        for( int i = 0; i <= d; i++ )
+            for( int j = 0; j <= d; j++ )
+                canonical[i*(d+1) + j] = j <= d - i ? i : i - (d + 1);
+    }
+
+    // computes the keys (d per vertex) and the barycentric weights of the d+1 simplex vertices
+    void operator()(const float* pos, int* keys, float* weights) const
+    {
+        float elevated[LATTICE_MAX_DIM+1], bary[LATTICE_MAX_DIM+2];
+        int greedy[LATTICE_MAX_DIM+1], rank[LATTICE_MAX_DIM+1];
+        float invDp1 = 1.f/(d + 1);
+        int i, j, sum = 0;
+
+        // project onto the hyperplane of the lattice
+        float sm = 0;
+        for( i = d; i > 0; i-- )
+        {
+            float cf = pos[i-1]*scale[i-1];
+            elevated[i] = sm - i*cf;
+            sm += cf;
+        }
+        elevated[0] = sm;
+
+        // the closest remainder-0 point
+        for( i = 0; i <= d; i++ )
+        {
+            float v = elevated[i]*invDp1;
+            int up = cvCeil(v)*(d + 1), down = cvFloor(v)*(d + 1);
+            greedy[i] = up - elevated[i] < elevated[i] - down ? up : down;
+            sum += greedy[i];
+            rank[i] = 0;
+        }
+        sum /= d + 1;
+
+        // sort the differential to the point, then move it onto the lattice
+        for( i = 0; i < d; i++ )
+            for( j = i + 1; j <= d; j++ )
+            {
+                if( elevated[i] - greedy[i] < elevated[j] - greedy[j] )
+                    rank[i]++;
+                else
+                    rank[j]++;
+            }
+
+        if( sum > 0 )
+        {
+            for( i = 0; i <= d; i++ )
+            {
+                if( rank[i] >= d + 1 - sum )
+                {
+                    greedy[i] -= d + 1;
+                    rank[i] += sum - (d + 1);
+                }
+                else
+                    rank[i] += sum;
+            }
+        }
+        else if( sum < 0 )
+        {
+            for( i = 0; i <= d; i++ )
+            {
+                if( rank[i] < -sum )
+                {
+                    greedy[i] += d + 1;
+                    rank[i] += (d + 1) + sum;
+                }
+                else
+                    rank[i] += sum;
+            }
+        }
+
+        for( i = 0; i <= d + 1; i++ )
+            bary[i] = 0;
+        for( i = 0; i <= d; i++ )
+        {
+            float delta = (elevated[i] - greedy[i])*invDp1;
+            bary[d - rank[i]] += delta;
+            bary[d + 1 - rank[i]] -= delta;
+        }
+        bary[0] += 1.f + bary[d + 1];
+
+        for( int r = 0; r <= d; r++ )
+        {
+            const int* c = canonical + r*(d+1);
+            for( i = 0; i < d; i++ )
+                keys[r*d + i] = greedy[i] + c[rank[i]];
+            weights[r] = bary[r];
+        }
+    }
+
+    int d;
+
+protected:
+    float scale[LATTICE_MAX_DIM];
+    int canonical[(LATTICE_MAX_DIM+1)*(LATTICE_MAX_DIM+1)];
+};
+
+// neighbouring pixels mostly fall into the same simplex, so the vertex indices
+// found for the previous pixel are reused when the keys match
+class LatticeVertexCache
+{
+public:
+    LatticeVertexCache(int _d) : d(_d)
+    {
+        std::fill(idx, idx + LATTICE_MAX_DIM + 1, -1);
+    }
+
+    bool get(const int* key, int r, int& i) const
+    {
+        if( idx[r] < 0 || !std::equal(key, key + d, keys + r*d) )
+            return false;
+        i = idx[r];
+        return true;
+    }
+
+    void put(const int* key, int r, int i)
+    {
+        std::copy(key, key + d, keys + r*d);
+        idx[r] = i;
+    }
+
+protected:
+    int d, idx[LATTICE_MAX_DIM+1], keys[(LATTICE_MAX_DIM+1)*LATTICE_MAX_DIM];
+};
+
+// the lattice position of a pixel and the value it splats
+template<typename T> static inline void
+getLatticePosition( const T* p, int x, int y, int cn, float spaceScale, float colorScale,
+                    float* pos, float* val )
+{
+    pos[0] = x*spaceScale;
+    pos[1] = y*spaceScale;
+    for( int k = 0; k < cn; k++ )
+    {
+        float v = (float)p[x*cn + k];
+        pos[k + 2] = v*colorScale;
+        val[k] = v;
+    }
+    val[cn] = 1.f;
+}
+
+template<typename T> class LatticeSplatInvoker :
+    public ParallelLoopBody
+{
+public:
+    LatticeSplatInvoker(const Mat& _src, const LatticeEmbedding& _embed, float _spaceScale,
+                        float _colorScale, int _bandRows, vector<PermutohedralLattice>& _bands) :
+        src(&_src), embed(&_embed), spaceScale(_spaceScale), colorScale(_colorScale),
+        bandRows(_bandRows), bands(&_bands)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int cn = src->channels(), d = embed->d, vd = cn + 1;
+        int keys[(LATTICE_MAX_DIM+1)*LATTICE_MAX_DIM];
+        float pos[LATTICE_MAX_DIM], val[LATTICE_MAX_DIM], w[LATTICE_MAX_DIM+1];
+
+        for( int b = range.start; b < range.end; b++ )
+        {
+            PermutohedralLattice& lattice = (*bands)[b];
+            LatticeVertexCache cache(d);
+            int y1 = std::min((b + 1)*bandRows, src->rows);
+
+            for( int y = b*bandRows; y < y1; y++ )
+            {
+                const T* p = src->ptr<T>(y);
+                for( int x = 0; x < src->cols; x++ )
+                {
+                    getLatticePosition(p, x, y, cn, spaceScale, colorScale, pos, val);
+                    (*embed)(pos, keys, w);
+                    for( int r = 0; r <= d; r++ )
+                    {
+                        const int* key = keys + r*d;
+                        int idx;
+                        if( !cache.get(key, r, idx) )
+                            cache.put(key, r, idx = lattice.find(key, true));
+                        float* v = &lattice.values[idx*vd];
+                        for( int k = 0; k < vd; k++ )
+                            v[k] += w[r]*val[k];
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const Mat* src;
+    const LatticeEmbedding* embed;
+    float spaceScale, colorScale;
+    int bandRows;
+    vector<PermutohedralLattice>* bands;
+};
+
+// convolves the lattice values with [1 2 1]/4 along the lattice axis j
+class LatticeBlurInvoker :
+    public ParallelLoopBody
+{
+public:
+    LatticeBlurInvoker(const PermutohedralLattice& _lattice, int _j,
+                       const vector<float>& _src, vector<float>& _dst) :
+        lattice(&_lattice), j(_j), src(&_src), dst(&_dst)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int d = lattice->d, vd = lattice->vd;
+        int n1[LATTICE_MAX_DIM], n2[LATTICE_MAX_DIM];
+        const float* s = &(*src)[0];
+
+        for( int idx = range.start; idx < range.end; idx++ )
+        {
+            const int* key = &lattice->keys[idx*d];
+            for( int i = 0; i < d; i++ )
+            {
+                n1[i] = key[i] + 1;
+                n2[i] = key[i] - 1;
+            }
+            if( j < d )
+            {
+                n1[j] = key[j] - d;
+                n2[j] = key[j] + d;
+            }
+
+            int i1 = lattice->find(n1), i2 = lattice->find(n2);
+            const float* v = s + idx*vd;
+            float* out = &(*dst)[idx*vd];
+            for( int k = 0; k < vd; k++ )
+            {
+                float t = v[k]*0.5f;
+                if( i1 >= 0 )
+                    t += s[i1*vd + k]*0.25f;
+                if( i2 >= 0 )
+                    t += s[i2*vd + k]*0.25f;
+                out[k] = t;
+            }
+        }
+    }
+
+private:
+    const PermutohedralLattice* lattice;
+    int j;
+    const vector<float>* src;
+    vector<float>* dst;
+};
+
+template<typename T> class LatticeSliceInvoker :
+    public ParallelLoopBody
+{
+public:
+    LatticeSliceInvoker(const Mat& _src, Mat& _dst, const LatticeEmbedding& _embed,
+                        const PermutohedralLattice& _lattice, float _spaceScale, float _colorScale) :
+        src(&_src), dst(&_dst), embed(&_embed), lattice(&_lattice), spaceScale(_spaceScale),
+        colorScale(_colorScale)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        int cn = src->channels(), d = embed->d, vd = cn + 1;
+        int keys[(LATTICE_MAX_DIM+1)*LATTICE_MAX_DIM];
+        float pos[LATTICE_MAX_DIM], val[LATTICE_MAX_DIM], w[LATTICE_MAX_DIM+1];
+        const float* values = &lattice->values[0];
+        LatticeVertexCache cache(d);
+
+        for( int y = range.start; y < range.end; y++ )
+        {
+            const T* p = src->ptr<T>(y);
+            T* q = dst->ptr<T>(y);
+            for( int x = 0; x < src->cols; x++ )
+            {
+                getLatticePosition(p, x, y, cn, spaceScale, colorScale, pos, val);
+                (*embed)(pos, keys, w);
+                float sum[LATTICE_MAX_DIM] = {0};
+                for( int r = 0; r <= d; r++ )
+                {
+                    const int* key = keys + r*d;
+                    int idx;
+                    if( !cache.get(key, r, idx) )
+                        cache.put(key, r, idx = lattice->find(key));
+                    const float* v = values + idx*vd;
+                    for( int k = 0; k < vd; k++ )
+                        sum[k] += w[r]*v[k];
+                }
+                // the pixel itself always contributes, so the weight is positive
+                float scale = 1.f/sum[cn];
+                for( int k = 0; k < cn; k++ )
+                    q[x*cn + k] = saturate_cast<T>(sum[k]*scale);
+            }
+        }
+    }
+
+private:
+    const Mat* src;
+    Mat* dst;
+    const LatticeEmbedding* embed;
+    const PermutohedralLattice* lattice;
+    float spaceScale, colorScale;
+};
+
+template<typename T> static void
+bilateralFilterLattice_( const Mat& src, Mat& dst, double sigma_color, double sigma_space )
+{
+    CV_TRACE_REGION("bilateralFilter");
+
+    int cn = src.channels(), d = cn + 2, vd = cn + 1;
+    LatticeEmbedding embed(d);
+    float spaceScale = (float)(1./sigma_space), colorScale = (float)(1./sigma_color);
+
+    // the image is splatted in bands of rows into separate lattices, which are then merged;
+    // the band height only depends on the image and the sigma, so the result does not
+    // depend on the number of threads
+    int bandRows = std::max(64, cvCeil(sigma_space*4));
+    int nbands = (src.rows + bandRows - 1)/bandRows;
+    vector<PermutohedralLattice> bands(nbands, PermutohedralLattice(d, vd));
+    parallel_for_(Range(0, nbands),
+                  LatticeSplatInvoker<T>(src, embed, spaceScale, colorScale, bandRows, bands));
+
+    PermutohedralLattice lattice(d, vd);
+    for( int b = 0; b < nbands; b++ )
+    {
+        const PermutohedralLattice& band = bands[b];
+        for( int idx = 0, n = band.size(); idx < n; idx++ )
+        {
+            int i = lattice.find(&band.keys[idx*d], true);
+            const float* v = &band.values[idx*vd];
+            float* u = &lattice.values[i*vd];
+            for( int k = 0; k < vd; k++ )
+                u[k] += v[k];
+        }
+        bands[b] = PermutohedralLattice(d, vd);
+    }
+
+    int n = lattice.size();
+    vector<float> buf(lattice.values.size());
+    for( int j = 0; j <= d; j++ )
+    {
+        parallel_for_(Range(0, n), LatticeBlurInvoker(lattice, j, lattice.values, buf),
+                      n*vd/(double)(1<<16));
+        lattice.values.swap(buf);
+    }
+
+    parallel_for_(Range(0, src.rows),
+                  LatticeSliceInvoker<T>(src, dst, embed, lattice, spaceScale, colorScale),
+                  dst.total()/(double)(1<<16));
+}
+
+
+/****************************************************************************************\
+                              Bilateral Filtering on a Grid
+\****************************************************************************************/
+
+// The bilateral grid of Chen, Paris and Durand, "Real-time Edge-Aware Image Processing with
+// the Bilateral Grid", for single-channel images: the pixels are accumulated into the nearest
+// cells of a (x, y, value) grid sampled at the sigmas, the grid is blurred with a Gaussian of
+// one cell standard deviation, and the result is interpolated trilinearly at the pixel positions.
+// Each grid row holds the cells of one y, as width*depth pairs of (sum, weight).
+
+enum { BILATERAL_GRID_PAD = 2 };
+
+struct BilateralGrid
+{
+    int width, depth;
+    float spaceScale, colorScale, minVal;
+    Mat data;
+};
+
+template<typename T> class BilateralGridSplatInvoker :
+    public ParallelLoopBody
+{
+public:
+    BilateralGridSplatInvoker(const Mat& _src, BilateralGrid& _grid, const vector<int>& _gridRows) :
+        src(&_src), grid(&_grid), gridRows(&_gridRows)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        const int pad = BILATERAL_GRID_PAD;
+        int depth = grid->depth;
+        // the image rows are sorted by their grid rows, so each grid row is written by one task
+        const int* gy = &(*gridRows)[0];
+        int y0 = (int)(std::lower_bound(gy, gy + src->rows, range.start) - gy);
+        int y1 = (int)(std::lower_bound(gy, gy + src->rows, range.end) - gy);
+
+        for( int y = y0; y < y1; y++ )
+        {
+            const T* p = src->ptr<T>(y);
+            float* row = grid->data.ptr<float>(gy[y]);
+            for( int x = 0; x < src->cols; x++ )
+            {
+                float v = (float)p[x];
+                int i = cvRound(x*grid->spaceScale) + pad;
+                int z = cvRound((v - grid->minVal)*grid->colorScale) + pad;
+                float* cell = row + (i*depth + z)*2;
+                cell[0] += v;
+                cell[1] += 1.f;
+            }
+        }
+    }
+
+private:
+    const Mat* src;
+    BilateralGrid* grid;
+    const vector<int>* gridRows;
+};
+
+// the Gaussian of one cell standard deviation, truncated at BILATERAL_GRID_PAD cells
+static const float bilateralGridKernel[] = { 0.13533528f, 0.60653066f, 1.f, 0.60653066f, 0.13533528f };
+
+// blurs the grid along x and the value within each grid row
+class BilateralGridBlurRowInvoker :
+    public ParallelLoopBody
+{
+public:
+    BilateralGridBlurRowInvoker(BilateralGrid& _grid) : grid(&_grid) {}
+
+    virtual void operator() (const Range& range) const
+    {
+        const int pad = BILATERAL_GRID_PAD;
+        const float* k = bilateralGridKernel + pad;
+        int width = grid->width, depth = grid->depth, rowSize = width*depth*2;
+        AutoBuffer<float> _buf(rowSize);
+        float* buf = _buf;
+
+        for( int j = range.start; j < range.end; j++ )
+        {
+            float* row = grid->data.ptr<float>(j);
+
+            // along the value; the cells beyond the grid are empty
+            for( int i = 0; i < width; i++ )
+            {
+                const float* s = row + i*depth*2;
+                float* d = buf + i*depth*2;
+                for( int z = 0; z < depth; z++ )
+                {
+                    float s0 = 0, s1 = 0;
+                    for( int t = std::max(-pad, -z); t <= std::min(pad, depth - 1 - z); t++ )
+                    {
+                        s0 += k[t]*s[(z + t)*2];
+                        s1 += k[t]*s[(z + t)*2 + 1];
+                    }
+                    d[z*2] = s0;
+                    d[z*2 + 1] = s1;
+                }
+            }
+
+            // along x
+            int cstep = depth*2;
+            for( int i = 0; i < width; i++ )
+            {
+                float* d = row + i*cstep;
+                int t0 = std::max(-pad, -i), t1 = std::min(pad, width - 1 - i);
+                for( int c = 0; c < cstep; c++ )
+                {
+                    float s = 0;
+                    for( int t = t0; t <= t1; t++ )
+                        s += k[t]*buf[(i + t)*cstep + c];
+                    d[c] = s;
+                }
+            }
+        }
+    }
+
+private:
+    BilateralGrid* grid;
+};
+
+// blurs the grid along y
+class BilateralGridBlurColumnInvoker :
+    public ParallelLoopBody
+{
+public:
+    BilateralGridBlurColumnInvoker(const Mat& _src, Mat& _dst) : src(&_src), dst(&_dst) {}
+
+    virtual void operator() (const Range& range) const
+    {
+        const int pad = BILATERAL_GRID_PAD;
+        const float* k = bilateralGridKernel + pad;
+        int height = src->rows, rowSize = src->cols;
+
+        for( int j = range.start; j < range.end; j++ )
+        {
+            float* d = dst->ptr<float>(j);
+            int t0 = std::max(-pad, -j), t1 = std::min(pad, height - 1 - j);
+            for( int c = 0; c < rowSize; c++ )
+                d[c] = 0;
+            for( int t = t0; t <= t1; t++ )
+            {
+                const float* s = src->ptr<float>(j + t);
+                float kt = k[t];
+                for( int c = 0; c < rowSize; c++ )
+                    d[c] += kt*s[c];
+            }
+        }
+    }
+
+private:
+    const Mat* src;
+    Mat* dst;
+};
+
+template<typename T> class BilateralGridSliceInvoker :
+    public ParallelLoopBody
+{
+public:
+    BilateralGridSliceInvoker(const Mat& _src, Mat& _dst, const BilateralGrid& _grid) :
+        src(&_src), dst(&_dst), grid(&_grid)
+    {
+    }
+
+    virtual void operator() (const Range& range) const
+    {
+        const int pad = BILATERAL_GRID_PAD;
+        int depth = grid->depth, cstep = depth*2;
+
+        for( int y = range.start; y < range.end; y++ )
+        {
+            const T* p = src->ptr<T>(y);
+            T* q = dst->ptr<T>(y);
+            float fy = y*grid->spaceScale + pad;
+            int j = std::min(cvFloor(fy), grid->data.rows - 2);
+            float wy = fy - j;
+            const float* r0 = grid->data.ptr<float>(j);
+            const float* r1 = grid->data.ptr<float>(j + 1);
+
+            for( int x = 0; x < src->cols; x++ )
+            {
+                float fx = x*grid->spaceScale + pad;
+                float fz = ((float)p[x] - grid->minVal)*grid->colorScale + pad;
+                int i = std::min(cvFloor(fx), grid->width - 2);
+                int z = std::min(cvFloor(fz), depth - 2);
+                float wx = fx - i, wz = fz - z;
+                int ofs = i*cstep + z*2;
+                float s[2];
+
+                for( int c = 0; c < 2; c++ )
+                {
+                    const float* a = r0 + ofs + c;
+                    const float* b = r1 + ofs + c;
+                    float a0 = a[0] + (a[2] - a[0])*wz, a1 = a[cstep] + (a[cstep + 2] - a[cstep])*wz;
+                    float b0 = b[0] + (b[2] - b[0])*wz, b1 = b[cstep] + (b[cstep + 2] - b[cstep])*wz;
+                    a0 += (a1 - a0)*wx;
+                    b0 += (b1 - b0)*wx;
+                    s[c] = a0 + (b0 - a0)*wy;
+                }
+                // every pixel is within a cell of its own splat, so the weight is positive
+                q[x] = saturate_cast<T>(s[0]/s[1]);
+            }
+        }
+    }
+
+private:
+    const Mat* src;
+    Mat* dst;
+    const BilateralGrid* grid;
+};
+
+template<typename T> static void
+bilateralFilterGrid_( const Mat& src, Mat& dst, double sigma_color, double sigma_space,
+                      double minVal, double maxVal )
+{
+    CV_TRACE_REGION("bilateralFilter");
+
+    const int pad = BILATERAL_GRID_PAD;
+    BilateralGrid grid;
+    grid.spaceScale = (float)(1./sigma_space);
+    grid.colorScale = (float)(1./sigma_color);
+    grid.minVal = (float)minVal;
+    grid.width = cvRound((src.cols - 1)*grid.spaceScale) + 1 + pad*2;
+    grid.depth = cvRound((maxVal - minVal)*grid.colorScale) + 1 + pad*2;
+    int height = cvRound((src.rows - 1)*grid.spaceScale) + 1 + pad*2;
+    grid.data = Mat::zeros(height, grid.width*grid.depth*2, CV_32F);
+
+    vector<int> gridRows(src.rows);
+    for( int y = 0; y < src.rows; y++ )
+        gridRows[y] = cvRound(y*grid.spaceScale) + pad;
+
+    double nstripes = src.total()/(double)(1<<16);
+    parallel_for_(Range(0, height), BilateralGridSplatInvoker<T>(src, grid, gridRows), nstripes);
+    parallel_for_(Range(0, height), BilateralGridBlurRowInvoker(grid), nstripes);
+    Mat blurred(grid.data.size(), CV_32F);
+    parallel_for_(Range(0, height), BilateralGridBlurColumnInvoker(grid.data, blurred), nstripes);
+    grid.data = blurred;
+    parallel_for_(Range(0, src.rows), BilateralGridSliceInvoker<T>(src, dst, grid), nstripes);
+}
+
+static void
+bilateralFilterApprox( const Mat& _src, Mat& dst, double sigma_color, double sigma_space )
+{
+    Mat src = _src;
+    CV_Assert( (src.type() == CV_8UC1 || src.type() == CV_8UC3 ||
+                src.type() == CV_32FC1 || src.type() == CV_32FC3) &&
+               src.type() == dst.type() && src.size() == dst.size() &&
+               src.data != dst.data );
+
+    if( sigma_color <= 0 )
+        sigma_color = 1;
+    if( sigma_space <= 0 )
+        sigma_space = 1;
+
+    // NaNs are replaced the same way as in bilateralFilter_32f
+    if( src.depth() == CV_32F && !checkRange(src, true, 0, -FLT_MAX, FLT_MAX) )
+    {
+        src = src.clone();
+        patchNaNs(src, -5.*sigma_color);
+    }
+
+    double minVal = 0, maxVal = 0;
+    minMaxLoc(src.reshape(1), &minVal, &maxVal);
+
+    // the grid has a cell per sigma in every dimension; when the sigmas are small, most of
+    // its cells are empty, and the lattice, which only keeps the occupied vertices, is faster
+    double gridCells = (src.cols/sigma_space + 1)*(src.rows/sigma_space + 1)*
+                       ((maxVal - minVal)/sigma_color + 1);
+    if( src.channels() == 1 && gridCells <= (double)src.total()*4 )
+    {
+        if( src.depth() == CV_8U )
+            bilateralFilterGrid_<uchar>( src, dst, sigma_color, sigma_space, minVal, maxVal );
+        else
+            bilateralFilterGrid_<float>( src, dst, sigma_color, sigma_space, minVal, maxVal );
+    }
+    else if( src.depth() == CV_8U )
+        bilateralFilterLattice_<uchar>( src, dst, sigma_color, sigma_space );
+    else
+        bilateralFilterLattice_<float>( src, dst, sigma_color, sigma_space );
+}
 }
 
 void cv::bilateralFilter( InputArray _src, OutputArray _dst, int d,
@@ -2202,7 +3006,9 @@ void cv::bilateralFilter( InputArray _src, OutputArray _dst, int d,
     _dst.create( src.size(), src.type() );
     Mat dst = _dst.getMat();
 
-    if( src.depth() == CV_8U )
+    if( borderType & BILATERAL_APPROX )
+        bilateralFilterApprox( src, dst, sigmaColor, sigmaSpace );
+    else if( src.depth() == CV_8U )
         bilateralFilter_8u( src, dst, d, sigmaColor, sigmaSpace, borderType );
     else if( src.depth() == CV_32F )
         bilateralFilter_32f( src, dst, d, sigmaColor, sigmaSpace, borderType );
@@ -222,11 +222,312 @@ typedef void (*IntegralFunc)(const uchar* src, size_t srcstep, uchar* sum, size_
                              uchar* sqsum, size_t sqsumstep, uchar* tilted, size_t tstep,
                              Size size, int cn );
 
+/*
+   With an 8-bit source and 32-bit integer or double-precision outputs all the sums are exact,
+   so the image can be split into horizontal bands in any way without changing the result.
+   The first pass sums the columns of every band but the last one. From these sums the
+   integral row above each band is accumulated, and the second pass integrates the bands
+   independently, each starting from its own row above.
+*/
+
+template<typename ST, typename QT> struct IntegralRowNoVec
+{
+    int operator()(const uchar*, const ST*, ST*, const QT*, QT*, int, ST&, QT&) const { return 0; }
+};
+
+template<typename ST, typename QT> struct IntegralRowVec : public IntegralRowNoVec<ST, QT> {};
+
+#if CV_SSE2
+
+// single-channel row of 8-bit pixels; the running sums s and sq are updated
+template<> struct IntegralRowVec<int, int>
+{
+    IntegralRowVec() { useSIMD = checkHardwareSupport(CV_CPU_SSE2); }
+
+    int operator()(const uchar* src, const int* prev, int* sum, const int* qprev, int* sqsum,
+                   int width, int& s, int& sq) const
+    {
+        int x = 0;
+        if( !useSIMD )
+            return 0;
+
+        __m128i z = _mm_setzero_si128(), vs = _mm_set1_epi32(s), vsq = _mm_set1_epi32(sq);
+        for( ; x <= width - 8; x += 8 )
+        {
+            __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + x)), z);
+            // prefix sums of the 8 16-bit lanes do not exceed 8*255
+            __m128i p = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+            p = _mm_add_epi16(p, _mm_slli_si128(p, 4));
+            p = _mm_add_epi16(p, _mm_slli_si128(p, 8));
+            __m128i p0 = _mm_add_epi32(_mm_unpacklo_epi16(p, z), vs);
+            __m128i p1 = _mm_add_epi32(_mm_unpackhi_epi16(p, z), vs);
+            vs = _mm_shuffle_epi32(p1, _MM_SHUFFLE(3, 3, 3, 3));
+            _mm_storeu_si128((__m128i*)(sum + x),
+                             _mm_add_epi32(p0, _mm_loadu_si128((const __m128i*)(prev + x))));
+            _mm_storeu_si128((__m128i*)(sum + x + 4),
+                             _mm_add_epi32(p1, _mm_loadu_si128((const __m128i*)(prev + x + 4))));
+
+            if( sqsum )
+            {
+                // the squares fit into 16 bits, their prefix sums do not
+                __m128i q = _mm_mullo_epi16(v, v);
+                __m128i q0 = _mm_unpacklo_epi16(q, z), q1 = _mm_unpackhi_epi16(q, z);
+                q0 = _mm_add_epi32(q0, _mm_slli_si128(q0, 4));
+                q0 = _mm_add_epi32(q0, _mm_slli_si128(q0, 8));
+                q0 = _mm_add_epi32(q0, vsq);
+                q1 = _mm_add_epi32(q1, _mm_slli_si128(q1, 4));
+                q1 = _mm_add_epi32(q1, _mm_slli_si128(q1, 8));
+                q1 = _mm_add_epi32(q1, _mm_shuffle_epi32(q0, _MM_SHUFFLE(3, 3, 3, 3)));
+                vsq = _mm_shuffle_epi32(q1, _MM_SHUFFLE(3, 3, 3, 3));
+                _mm_storeu_si128((__m128i*)(sqsum + x),
+                                 _mm_add_epi32(q0, _mm_loadu_si128((const __m128i*)(qprev + x))));
+                _mm_storeu_si128((__m128i*)(sqsum + x + 4),
+                                 _mm_add_epi32(q1, _mm_loadu_si128((const __m128i*)(qprev + x + 4))));
+            }
+        }
+
+        s = _mm_cvtsi128_si32(vs);
+        sq = _mm_cvtsi128_si32(vsq);
+        return x;
+    }
+
+    bool useSIMD;
+};
+
+// only the sums are vectorized; the double-precision squares are left to the scalar loop
+template<> struct IntegralRowVec<int, double>
+{
+    int operator()(const uchar* src, const int* prev, int* sum, const double*, double* sqsum,
+                   int width, int& s, double&) const
+    {
+        int sq = 0;
+        return sqsum ? 0 : vecOp(src, prev, sum, 0, 0, width, s, sq);
+    }
+
+    IntegralRowVec<int, int> vecOp;
+};
+
+#endif
+
+// the rows of sum and sqsum start with cn zeros, as do prev and qprev;
+// either sum or sqsum can be NULL
+template<typename ST, typename QT, class VecOp> static void
+integralRow_( const uchar* src, const ST* prev, ST* sum, const QT* qprev, QT* sqsum,
+              int width, int cn, const VecOp& vecOp )
+{
+    int x, k;
+
+    if( sum )
+    {
+        for( k = 0; k < cn; k++ )
+            sum[k] = 0;
+        prev += cn;
+        sum += cn;
+    }
+
+    if( sqsum )
+    {
+        for( k = 0; k < cn; k++ )
+            sqsum[k] = 0;
+        qprev += cn;
+        sqsum += cn;
+    }
+
+    for( k = 0; k < cn; k++ )
+    {
+        ST s = 0;
+        QT sq = 0;
+
+        if( sum && sqsum )
+        {
+            x = cn == 1 ? vecOp(src, prev, sum, qprev, sqsum, width, s, sq) : k;
+            for( ; x < width; x += cn )
+            {
+                int it = src[x];
+                s += it;
+                sq += (QT)(it*it);
+                sum[x] = prev[x] + s;
+                sqsum[x] = qprev[x] + sq;
+            }
+        }
+        else if( sum )
+        {
+            x = cn == 1 ? vecOp(src, prev, sum, 0, 0, width, s, sq) : k;
+            for( ; x < width; x += cn )
+            {
+                s += src[x];
+                sum[x] = prev[x] + s;
+            }
+        }
+        else
+        {
+            for( x = k; x < width; x += cn )
+            {
+                int it = src[x];
+                sq += (QT)(it*it);
+                sqsum[x] = qprev[x] + sq;
+            }
+        }
+    }
+}
+
+template<typename ST, typename QT> struct IntegralColumnSumInvoker : public ParallelLoopBody
+{
+    IntegralColumnSumInvoker(const Mat& _src, ST* _colsum, QT* _colsqsum, int _nbands)
+        : src(&_src), colsum(_colsum), colsqsum(_colsqsum), nbands(_nbands) {}
+
+    void operator()(const Range& range) const
+    {
+        int width = src->cols*src->channels();
+
+        for( int b = range.start; b < range.end; b++ )
+        {
+            int y0 = src->rows*b/nbands, y1 = src->rows*(b + 1)/nbands, x;
+            ST* s = colsum ? colsum + (size_t)b*width : 0;
+            QT* sq = colsqsum ? colsqsum + (size_t)b*width : 0;
+
+            for( x = 0; x < width; x++ )
+            {
+                if( s )
+                    s[x] = 0;
+                if( sq )
+                    sq[x] = 0;
+            }
+
+            for( int y = y0; y < y1; y++ )
+            {
+                const uchar* row = src->ptr(y);
+                if( s )
+                    for( x = 0; x < width; x++ )
+                        s[x] += row[x];
+                if( sq )
+                    for( x = 0; x < width; x++ )
+                        sq[x] += (QT)(row[x]*row[x]);
+            }
+        }
+    }
+
+    const Mat* src;
+    ST* colsum;
+    QT* colsqsum;
+    int nbands;
+};
+
+template<typename ST, typename QT> struct IntegralBandInvoker : public ParallelLoopBody
+{
+    IntegralBandInvoker(const Mat& _src, Mat& _sum, Mat& _sqsum, const ST* _top,
+                        const QT* _qtop, int _nbands)
+        : src(&_src), sum(&_sum), sqsum(&_sqsum), top(_top), qtop(_qtop), nbands(_nbands) {}
+
+    void operator()(const Range& range) const
+    {
+        int cn = src->channels(), width = src->cols*cn, rowsize = width + cn;
+        IntegralRowVec<ST, QT> vecOp;
+
+        for( int b = range.start; b < range.end; b++ )
+        {
+            int y0 = src->rows*b/nbands, y1 = src->rows*(b + 1)/nbands;
+            const ST* prev = top ? top + (size_t)b*rowsize : 0;
+            const QT* qprev = qtop ? qtop + (size_t)b*rowsize : 0;
+
+            if( b == 0 )
+            {
+                if( sum->data )
+                    memset(sum->ptr(), 0, rowsize*sizeof(ST));
+                if( sqsum->data )
+                    memset(sqsum->ptr(), 0, rowsize*sizeof(QT));
+            }
+
+            for( int y = y0; y < y1; y++ )
+            {
+                ST* srow = sum->data ? (ST*)sum->ptr(y + 1) : 0;
+                QT* qrow = sqsum->data ? (QT*)sqsum->ptr(y + 1) : 0;
+                integralRow_(src->ptr(y), prev, srow, qprev, qrow, width, cn, vecOp);
+                prev = srow;
+                qprev = qrow;
+            }
+        }
+    }
+
+    const Mat* src;
+    Mat* sum;
+    Mat* sqsum;
+    const ST* top;
+    const QT* qtop;
+    int nbands;
+};
+
+// sum and sqsum are preallocated; either of them can be empty
+template<typename ST, typename QT> static void
+integralBands_( const Mat& src, Mat& sum, Mat& sqsum, int nbands )
+{
+    int cn = src.channels(), width = src.cols*cn, rowsize = width + cn;
+    bool haveSum = sum.data != 0, haveSqsum = sqsum.data != 0;
+    size_t bufsize = (size_t)(nbands - 1)*width + (size_t)nbands*rowsize;
+    AutoBuffer<ST> _sbuf(haveSum ? bufsize : 1);
+    AutoBuffer<QT> _qbuf(haveSqsum ? bufsize : 1);
+    ST* top = haveSum ? (ST*)_sbuf : 0;
+    QT* qtop = haveSqsum ? (QT*)_qbuf : 0;
+    ST* colsum = top ? top + (size_t)nbands*rowsize : 0;
+    QT* colsqsum = qtop ? qtop + (size_t)nbands*rowsize : 0;
+    int b, x, k;
+
+    if( nbands > 1 )
+    {
+        IntegralColumnSumInvoker<ST, QT> colInvoker(src, colsum, colsqsum, nbands);
+        parallel_for_(Range(0, nbands - 1), colInvoker, nbands - 1);
+    }
+
+    // the row above each band is the row above the previous band plus the prefix sums
+    // of the previous band column sums
+    for( x = 0; x < rowsize; x++ )
+    {
+        if( top )
+            top[x] = 0;
+        if( qtop )
+            qtop[x] = 0;
+    }
+
+    for( b = 1; b < nbands; b++ )
+    {
+        for( k = 0; k < cn; k++ )
+        {
+            ST s = 0;
+            QT sq = 0;
+            for( x = k; x < width; x += cn )
+            {
+                size_t i = (size_t)b*rowsize + cn + x, j = (size_t)(b - 1)*width + x;
+                if( top )
+                {
+                    s += colsum[j];
+                    top[i] = top[i - rowsize] + s;
+                }
+                if( qtop )
+                {
+                    sq += colsqsum[j];
+                    qtop[i] = qtop[i - rowsize] + sq;
+                }
+            }
+            if( top )
+                top[(size_t)b*rowsize + k] = 0;
+            if( qtop )
+                qtop[(size_t)b*rowsize + k] = 0;
+        }
+    }
+
+    IntegralBandInvoker<ST, QT> invoker(src, sum, sqsum, top, qtop, nbands);
+    parallel_for_(Range(0, nbands), invoker, nbands);
+}
+
+typedef void (*IntegralBandsFunc)(const Mat& src, Mat& sum, Mat& sqsum, int nbands);
+
 }
 
 
-void cv::integral( InputArray _src, OutputArray _sum, OutputArray _sqsum, OutputArray _tilted, int sdepth )
+void cv::integral( InputArray _src, OutputArray _sum, OutputArray _sqsum, OutputArray _tilted,
+                   int sdepth, int sqdepth )
 {
+    CV_TRACE_REGION("integral");
     Mat src = _src.getMat(), sum, sqsum, tilted;
     int depth = src.depth(), cn = src.channels();
     Size isize(src.cols + 1, src.rows+1);
@@ -234,8 +535,29 @@ void cv::integral( InputArray _src, OutputArray _sum, OutputArray _sqsum, Output
     if( sdepth <= 0 )
         sdepth = depth == CV_8U ? CV_32S : CV_64F;
     sdepth = CV_MAT_DEPTH(sdepth);
-    _sum.create( isize, CV_MAKETYPE(sdepth, cn) );
-    sum = _sum.getMat();
+    if( sqdepth <= 0 )
+        sqdepth = CV_64F;
+    sqdepth = CV_MAT_DEPTH(sqdepth);
+
+    if( _sqsum.needed() )
+    {
+        if( sqdepth != CV_32S && sqdepth != CV_32F && sqdepth != CV_64F )
+            CV_Error( CV_StsUnsupportedFormat, "sqsum must be CV_32S, CV_32F or CV_64F" );
+        if( sqdepth == CV_32S )
+        {
+            // the sum of squares over the whole image must fit into int
+            if( depth != CV_8U )
+                CV_Error( CV_StsUnsupportedFormat, "32-bit integer sqsum is only supported for 8-bit images" );
+            if( (double)src.total()*(255*255) > INT_MAX )
+                CV_Error( CV_StsOutOfRange, "The image is too large for 32-bit integer sqsum" );
+        }
+    }
+
+    if( _sum.needed() )
+    {
+        _sum.create( isize, CV_MAKETYPE(sdepth, cn) );
+        sum = _sum.getMat();
+    }
 
     if( _tilted.needed() )
     {
@@ -245,10 +567,26 @@ void cv::integral( InputArray _src, OutputArray _sum, OutputArray _sqsum, Output
 
     if( _sqsum.needed() )
     {
-        _sqsum.create( isize, CV_MAKETYPE(CV_64F, cn) );
+        _sqsum.create( isize, CV_MAKETYPE(sqdepth, cn) );
         sqsum = _sqsum.getMat();
     }
 
+    if( depth == CV_8U && !tilted.data && (sdepth == CV_32S || sdepth == CV_64F) &&
+        (!sqsum.data || sqdepth == CV_32S || sqdepth == CV_64F) )
+    {
+        IntegralBandsFunc func;
+        if( sdepth == CV_32S )
+            func = sqdepth == CV_32S ? integralBands_<int, int> : integralBands_<int, double>;
+        else
+            func = sqdepth == CV_32S ? integralBands_<double, int> : integralBands_<double, double>;
+
+        // every band but the last one costs an extra pass over its source rows
+        int nbands = std::min(getNumThreads(), (int)(src.total()*cn/(double)(1<<16)));
+        nbands = std::max(std::min(nbands, src.rows), 1);
+        func( src, sum, sqsum, nbands );
+        return;
+    }
+
     IntegralFunc func = 0;
 
     if( depth == CV_8U && sdepth == CV_32S )
@@ -266,8 +604,23 @@ void cv::integral( InputArray _src, OutputArray _sum, OutputArray _sqsum, Output
     else
         CV_Error( CV_StsUnsupportedFormat, "" );
 
-    func( src.data, src.step, sum.data, sum.step, sqsum.data, sqsum.step,
+    // the serial functions always compute sum and compute sqsum in double precision
+    Mat sumbuf = sum, sqsumbuf = sqsum;
+    if( !sum.data )
+        sumbuf.create( isize, CV_MAKETYPE(sdepth, cn) );
+    if( sqsum.data && sqdepth != CV_64F )
+        sqsumbuf = Mat( isize, CV_MAKETYPE(CV_64F, cn) );
+
+    func( src.data, src.step, sumbuf.data, sumbuf.step, sqsumbuf.data, sqsumbuf.step,
           tilted.data, tilted.step, src.size(), cn );
+
+    if( sqsumbuf.data != sqsum.data )
+        sqsumbuf.convertTo( sqsum, sqdepth );
+}
+
+void cv::integral( InputArray src, OutputArray sum, OutputArray sqsum, OutputArray tilted, int sdepth )
+{
+    integral( src, sum, sqsum, tilted, sdepth, -1 );
 }
 
 void cv::integral( InputArray src, OutputArray sum, int sdepth )
@@ -301,7 +654,8 @@ cvIntegral( const CvArr* image, CvArr* sumImage,
         ptilted = &tilted;
     }
     cv::integral( src, sum, psqsum ? cv::_OutputArray(*psqsum) : cv::_OutputArray(),
-                  ptilted ? cv::_OutputArray(*ptilted) : cv::_OutputArray(), sum.depth() );
+                  ptilted ? cv::_OutputArray(*ptilted) : cv::_OutputArray(), sum.depth(),
+                  psqsum ? sqsum.depth() : -1 );
 
     CV_Assert( sum.data == sum0.data && sqsum.data == sqsum0.data && tilted.data == tilted0.data );
 }
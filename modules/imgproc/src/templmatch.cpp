@@ -40,83 +40,75 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/intrin.hpp"
 
 namespace cv
 {
 
-void crossCorr( const Mat& img, const Mat& _templ, Mat& corr,
-                Size corrsize, int ctype,
-                Point anchor, double delta, int borderType )
+void getCrossCorrBlockSize( Size templSize, Size corrsize, Size& blocksize, Size& dftsize )
 {
     const double blockScale = 4.5;
     const int minBlockSize = 256;
-    std::vector<uchar> buf;
 
+    blocksize.width = cvRound(templSize.width*blockScale);
+    blocksize.width = std::max( blocksize.width, minBlockSize - templSize.width + 1 );
+    blocksize.width = std::min( blocksize.width, corrsize.width );
+    blocksize.height = cvRound(templSize.height*blockScale);
+    blocksize.height = std::max( blocksize.height, minBlockSize - templSize.height + 1 );
+    blocksize.height = std::min( blocksize.height, corrsize.height );
+
+    dftsize.width = std::max(getOptimalDFTSize(blocksize.width + templSize.width - 1), 2);
+    dftsize.height = getOptimalDFTSize(blocksize.height + templSize.height - 1);
+    if( dftsize.width <= 0 || dftsize.height <= 0 )
+        CV_Error( CV_StsOutOfRange, "the input arrays are too big" );
+
+    // recompute block size
+    blocksize.width = dftsize.width - templSize.width + 1;
+    blocksize.width = MIN( blocksize.width, corrsize.width );
+    blocksize.height = dftsize.height - templSize.height + 1;
+    blocksize.height = MIN( blocksize.height, corrsize.height );
+}
+
+void computeCrossCorrSpectrum( const Mat& _templ, int imgDepth, int cdepth,
+                               Size blocksize, Size dftsize, CrossCorrSpectrum& s )
+{
     Mat templ = _templ;
-    int depth = img.depth(), cn = img.channels();
     int tdepth = templ.depth(), tcn = templ.channels();
-    int cdepth = CV_MAT_DEPTH(ctype), ccn = CV_MAT_CN(ctype);
 
-    CV_Assert( img.dims <= 2 && templ.dims <= 2 && corr.dims <= 2 );
+    CV_Assert( templ.dims <= 2 );
 
-    if( depth != tdepth && tdepth != std::max(CV_32F, depth) )
+    if( imgDepth != tdepth && tdepth != std::max(CV_32F, imgDepth) )
     {
-        _templ.convertTo(templ, std::max(CV_32F, depth));
+        _templ.convertTo(templ, std::max(CV_32F, imgDepth));
         tdepth = templ.depth();
     }
 
-    CV_Assert( depth == tdepth || tdepth == CV_32F);
-    CV_Assert( corrsize.height <= img.rows + templ.rows - 1 &&
-               corrsize.width <= img.cols + templ.cols - 1 );
-
-    CV_Assert( ccn == 1 || delta == 0 );
-
-    corr.create(corrsize, ctype);
-
-    int maxDepth = depth > CV_8S ? CV_64F : std::max(std::max(CV_32F, tdepth), cdepth);
-    Size blocksize, dftsize;
+    CV_Assert( imgDepth == tdepth || tdepth == CV_32F);
+    CV_Assert( dftsize.width >= blocksize.width + templ.cols - 1 &&
+               dftsize.height >= blocksize.height + templ.rows - 1 );
 
-    blocksize.width = cvRound(templ.cols*blockScale);
-    blocksize.width = std::max( blocksize.width, minBlockSize - templ.cols + 1 );
-    blocksize.width = std::min( blocksize.width, corr.cols );
-    blocksize.height = cvRound(templ.rows*blockScale);
-    blocksize.height = std::max( blocksize.height, minBlockSize - templ.rows + 1 );
-    blocksize.height = std::min( blocksize.height, corr.rows );
+    int maxDepth = imgDepth > CV_8S ? CV_64F : std::max(std::max(CV_32F, tdepth), cdepth);
 
-    dftsize.width = std::max(getOptimalDFTSize(blocksize.width + templ.cols - 1), 2);
-    dftsize.height = getOptimalDFTSize(blocksize.height + templ.rows - 1);
-    if( dftsize.width <= 0 || dftsize.height <= 0 )
-        CV_Error( CV_StsOutOfRange, "the input arrays are too big" );
+    s.templSize = templ.size();
+    s.blockSize = blocksize;
+    s.dftSize = dftsize;
+    s.imgDepth = imgDepth;
+    s.cdepth = cdepth;
+    s.depth = maxDepth;
+    s.cn = tcn;
+    s.planes.create( dftsize.height*tcn, dftsize.width, maxDepth );
 
-    // recompute block size
-    blocksize.width = dftsize.width - templ.cols + 1;
-    blocksize.width = MIN( blocksize.width, corr.cols );
-    blocksize.height = dftsize.height - templ.rows + 1;
-    blocksize.height = MIN( blocksize.height, corr.rows );
-
-    Mat dftTempl( dftsize.height*tcn, dftsize.width, maxDepth );
-    Mat dftImg( dftsize, maxDepth );
-
-    int i, k, bufSize = 0;
+    std::vector<uchar> buf;
     if( tcn > 1 && tdepth != maxDepth )
-        bufSize = templ.cols*templ.rows*CV_ELEM_SIZE(tdepth);
-
-    if( cn > 1 && depth != maxDepth )
-        bufSize = std::max( bufSize, (blocksize.width + templ.cols - 1)*
-            (blocksize.height + templ.rows - 1)*CV_ELEM_SIZE(depth));
-
-    if( (ccn > 1 || cn > 1) && cdepth != maxDepth )
-        bufSize = std::max( bufSize, blocksize.width*blocksize.height*CV_ELEM_SIZE(cdepth));
-
-    buf.resize(bufSize);
+        buf.resize(templ.cols*templ.rows*CV_ELEM_SIZE(tdepth));
 
     // compute DFT of each template plane
-    for( k = 0; k < tcn; k++ )
+    for( int k = 0; k < tcn; k++ )
     {
         int yofs = k*dftsize.height;
         Mat src = templ;
-        Mat dst(dftTempl, Rect(0, yofs, dftsize.width, dftsize.height));
-        Mat dst1(dftTempl, Rect(0, yofs, templ.cols, templ.rows));
+        Mat dst(s.planes, Rect(0, yofs, dftsize.width, dftsize.height));
+        Mat dst1(s.planes, Rect(0, yofs, templ.cols, templ.rows));
 
         if( tcn > 1 )
         {
@@ -135,7 +127,148 @@ void crossCorr( const Mat& img, const Mat& _templ, Mat& corr,
         }
         dft(dst, dst, 0, templ.rows);
     }
+}
+
+// Correlates the image with the template spectrum block by block. The blocks write
+// disjoint parts of corr, so they are processed in parallel, each task with its own
+// DFT buffer.
+class CrossCorrBlockInvoker : public ParallelLoopBody
+{
+public:
+    CrossCorrBlockInvoker( const Mat& _img0, Point _roiofs, const CrossCorrSpectrum& _ts,
+                           Mat& _corr, Size _blocksize, int _tileCountX,
+                           Point _anchor, double _delta, int _borderType )
+        : img0(_img0), roiofs(_roiofs), ts(&_ts), corr(_corr), blocksize(_blocksize),
+          tileCountX(_tileCountX), anchor(_anchor), delta(_delta), borderType(_borderType)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int depth = img0.depth(), cn = img0.channels();
+        int cdepth = corr.depth(), ccn = corr.channels();
+        int maxDepth = ts->depth, tcn = ts->cn;
+        Size templSize = ts->templSize, dftsize = ts->dftSize;
+        Mat _corr = corr;
+
+        Mat dftImg( dftsize, maxDepth );
+        std::vector<uchar> buf;
+        int bufSize = 0;
+
+        if( cn > 1 && depth != maxDepth )
+            bufSize = (blocksize.width + templSize.width - 1)*
+                (blocksize.height + templSize.height - 1)*CV_ELEM_SIZE(depth);
+
+        if( (ccn > 1 || cn > 1) && cdepth != maxDepth )
+            bufSize = std::max( bufSize, blocksize.width*blocksize.height*CV_ELEM_SIZE(cdepth));
+
+        buf.resize(bufSize);
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            int x = (i%tileCountX)*blocksize.width;
+            int y = (i/tileCountX)*blocksize.height;
+
+            Size bsz(std::min(blocksize.width, _corr.cols - x),
+                     std::min(blocksize.height, _corr.rows - y));
+            Size dsz(bsz.width + templSize.width - 1, bsz.height + templSize.height - 1);
+            int x0 = x - anchor.x + roiofs.x, y0 = y - anchor.y + roiofs.y;
+            int x1 = std::max(0, x0), y1 = std::max(0, y0);
+            int x2 = std::min(img0.cols, x0 + dsz.width);
+            int y2 = std::min(img0.rows, y0 + dsz.height);
+            Mat src0(img0, Range(y1, y2), Range(x1, x2));
+            Mat dst(dftImg, Rect(0, 0, dsz.width, dsz.height));
+            Mat dst1(dftImg, Rect(x1-x0, y1-y0, x2-x1, y2-y1));
+            Mat cdst(_corr, Rect(x, y, bsz.width, bsz.height));
+
+            for( int k = 0; k < cn; k++ )
+            {
+                Mat src = src0;
+                dftImg = Scalar::all(0);
+
+                if( cn > 1 )
+                {
+                    src = depth == maxDepth ? dst1 : Mat(y2-y1, x2-x1, depth, &buf[0]);
+                    int pairs[] = {k, 0};
+                    mixChannels(&src0, 1, &src, 1, pairs, 1);
+                }
+
+                if( dst1.data != src.data )
+                    src.convertTo(dst1, dst1.depth());
+
+                if( x2 - x1 < dsz.width || y2 - y1 < dsz.height )
+                    copyMakeBorder(dst1, dst, y1-y0, dst.rows-dst1.rows-(y1-y0),
+                                   x1-x0, dst.cols-dst1.cols-(x1-x0), borderType);
+
+                dft( dftImg, dftImg, 0, dsz.height );
+                Mat dftTempl1(ts->planes, Rect(0, tcn > 1 ? k*dftsize.height : 0,
+                                               dftsize.width, dftsize.height));
+                mulSpectrums(dftImg, dftTempl1, dftImg, 0, true);
+                dft( dftImg, dftImg, DFT_INVERSE + DFT_SCALE, bsz.height );
+
+                src = dftImg(Rect(0, 0, bsz.width, bsz.height));
+
+                if( ccn > 1 )
+                {
+                    if( cdepth != maxDepth )
+                    {
+                        Mat plane(bsz, cdepth, &buf[0]);
+                        src.convertTo(plane, cdepth, 1, delta);
+                        src = plane;
+                    }
+                    int pairs[] = {0, k};
+                    mixChannels(&src, 1, &cdst, 1, pairs, 1);
+                }
+                else
+                {
+                    if( k == 0 )
+                        src.convertTo(cdst, cdepth, 1, delta);
+                    else
+                    {
+                        if( maxDepth != cdepth )
+                        {
+                            Mat plane(bsz, cdepth, &buf[0]);
+                            src.convertTo(plane, cdepth);
+                            src = plane;
+                        }
+                        add(src, cdst, cdst);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    Mat img0;
+    Point roiofs;
+    const CrossCorrSpectrum* ts;
+    Mat corr;
+    Size blocksize;
+    int tileCountX;
+    Point anchor;
+    double delta;
+    int borderType;
+};
+
+void crossCorr( const Mat& img, const CrossCorrSpectrum& ts, Mat& corr,
+                Size corrsize, int ctype,
+                Point anchor, double delta, int borderType )
+{
+    int depth = img.depth(), cn = img.channels();
+    int cdepth = CV_MAT_DEPTH(ctype), ccn = CV_MAT_CN(ctype);
+    Size templSize = ts.templSize;
 
+    CV_Assert( img.dims <= 2 && corr.dims <= 2 && !ts.planes.empty() );
+    CV_Assert( depth == ts.imgDepth && cdepth == ts.cdepth && (ts.cn == 1 || ts.cn == cn) );
+    CV_Assert( corrsize.height <= img.rows + templSize.height - 1 &&
+               corrsize.width <= img.cols + templSize.width - 1 );
+
+    CV_Assert( ccn == 1 || delta == 0 );
+
+    corr.create(corrsize, ctype);
+
+    Size blocksize(std::min(ts.blockSize.width, corr.cols),
+                   std::min(ts.blockSize.height, corr.rows));
     int tileCountX = (corr.cols + blocksize.width - 1)/blocksize.width;
     int tileCountY = (corr.rows + blocksize.height - 1)/blocksize.height;
     int tileCount = tileCountX * tileCountY;
@@ -153,161 +286,231 @@ void crossCorr( const Mat& img, const Mat& _templ, Mat& corr,
     borderType |= BORDER_ISOLATED;
 
     // calculate correlation by blocks
-    for( i = 0; i < tileCount; i++ )
-    {
-        int x = (i%tileCountX)*blocksize.width;
-        int y = (i/tileCountX)*blocksize.height;
-
-        Size bsz(std::min(blocksize.width, corr.cols - x),
-                 std::min(blocksize.height, corr.rows - y));
-        Size dsz(bsz.width + templ.cols - 1, bsz.height + templ.rows - 1);
-        int x0 = x - anchor.x + roiofs.x, y0 = y - anchor.y + roiofs.y;
-        int x1 = std::max(0, x0), y1 = std::max(0, y0);
-        int x2 = std::min(img0.cols, x0 + dsz.width);
-        int y2 = std::min(img0.rows, y0 + dsz.height);
-        Mat src0(img0, Range(y1, y2), Range(x1, x2));
-        Mat dst(dftImg, Rect(0, 0, dsz.width, dsz.height));
-        Mat dst1(dftImg, Rect(x1-x0, y1-y0, x2-x1, y2-y1));
-        Mat cdst(corr, Rect(x, y, bsz.width, bsz.height));
-
-        for( k = 0; k < cn; k++ )
-        {
-            Mat src = src0;
-            dftImg = Scalar::all(0);
+    parallel_for_(Range(0, tileCount),
+                  CrossCorrBlockInvoker(img0, roiofs, ts, corr, blocksize, tileCountX,
+                                        anchor, delta, borderType));
+}
 
-            if( cn > 1 )
-            {
-                src = depth == maxDepth ? dst1 : Mat(y2-y1, x2-x1, depth, &buf[0]);
-                int pairs[] = {k, 0};
-                mixChannels(&src0, 1, &src, 1, pairs, 1);
-            }
+void crossCorr( const Mat& img, const Mat& templ, Mat& corr,
+                Size corrsize, int ctype,
+                Point anchor, double delta, int borderType )
+{
+    CV_Assert( img.dims <= 2 && templ.dims <= 2 && corr.dims <= 2 );
+
+    Size blocksize, dftsize;
+    getCrossCorrBlockSize( templ.size(), corrsize, blocksize, dftsize );
+
+    CrossCorrSpectrum ts;
+    computeCrossCorrSpectrum( templ, img.depth(), CV_MAT_DEPTH(ctype), blocksize, dftsize, ts );
+    crossCorr( img, ts, corr, corrsize, ctype, anchor, delta, borderType );
+}
 
-            if( dst1.data != src.data )
-                src.convertTo(dst1, dst1.depth());
+// The template coefficients of the direct correlation: for every channel "phase" the
+// coefficients of the 8 lanes that start at it, i.e. lane l gets the coefficient of
+// channel (phase + l) % cn, for all the template pixels.
+static void getDirectCorrCoeffs( const Mat& templ, Mat& coeffs )
+{
+    int cn = templ.channels(), k = 0;
+    coeffs.create(1, cn*templ.rows*templ.cols*8, CV_16S);
+    short* w = coeffs.ptr<short>();
 
-            if( x2 - x1 < dsz.width || y2 - y1 < dsz.height )
-                copyMakeBorder(dst1, dst, y1-y0, dst.rows-dst1.rows-(y1-y0),
-                               x1-x0, dst.cols-dst1.cols-(x1-x0), borderType);
+    for( int phase = 0; phase < cn; phase++ )
+        for( int ty = 0; ty < templ.rows; ty++ )
+        {
+            const uchar* tptr = templ.ptr(ty);
+            for( int tx = 0; tx < templ.cols; tx++ )
+                for( int l = 0; l < 8; l++ )
+                    w[k++] = tptr[tx*cn + (phase + l) % cn];
+        }
+}
 
-            dft( dftImg, dftImg, 0, dsz.height );
-            Mat dftTempl1(dftTempl, Rect(0, tcn > 1 ? k*dftsize.height : 0,
-                                         dftsize.width, dftsize.height));
-            mulSpectrums(dftImg, dftTempl1, dftImg, 0, true);
-            dft( dftImg, dftImg, DFT_INVERSE + DFT_SCALE, bsz.height );
+// Direct correlation of an 8-bit image with a template of the same type; the products
+// are summed over the channels into a single-channel CV_32F result of the
+// (img.cols - templ.cols + 1) x (img.rows - templ.rows + 1) size. The sums are computed
+// in integers, so they are exact as long as templ.total()*cn*255*255 fits into int.
+// The rows of the result are independent and are processed in parallel.
+class DirectCorr8uInvoker : public ParallelLoopBody
+{
+public:
+    DirectCorr8uInvoker( const Mat& _img, const Mat& _templ, const Mat& _coeffs, Mat& _corr )
+        : img(_img), templ(_templ), coeffs(_coeffs), corr(_corr)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int cn = img.channels(), width = corr.cols*cn;
+        int trows = templ.rows, tcols = templ.cols;
+        AutoBuffer<int> _acc(width);
+        int* acc = _acc;
+        Mat _corr = corr;
 
-            src = dftImg(Rect(0, 0, bsz.width, bsz.height));
+        for( int y = range.start; y < range.end; y++ )
+        {
+            int j = 0;
 
-            if( ccn > 1 )
+#if CV_SIMD128
+            if( hasSIMD128() )
             {
-                if( cdepth != maxDepth )
+                int tstep = trows*tcols*8;
+                for( ; j <= width - 8; j += 8 )
                 {
-                    Mat plane(bsz, cdepth, &buf[0]);
-                    src.convertTo(plane, cdepth, 1, delta);
-                    src = plane;
+                    const short* w = coeffs.ptr<short>() + (j % cn)*tstep;
+                    v_int32x4 s0 = v_setzero_s32(), s1 = v_setzero_s32();
+
+                    for( int ty = 0; ty < trows; ty++ )
+                    {
+                        const uchar* src = img.ptr(y + ty) + j;
+                        for( int tx = 0; tx < tcols; tx++, src += cn, w += 8 )
+                        {
+                            v_int32x4 p0, p1;
+                            v_mul_expand(v_reinterpret_as_s16(v_load_expand(src)), v_load(w), p0, p1);
+                            s0 += p0;
+                            s1 += p1;
+                        }
+                    }
+                    v_store(acc + j, s0);
+                    v_store(acc + j + 4, s1);
                 }
-                int pairs[] = {0, k};
-                mixChannels(&src, 1, &cdst, 1, pairs, 1);
             }
-            else
+#endif
+
+            for( ; j < width; j++ )
             {
-                if( k == 0 )
-                    src.convertTo(cdst, cdepth, 1, delta);
-                else
+                int s = 0;
+                for( int ty = 0; ty < trows; ty++ )
                 {
-                    if( maxDepth != cdepth )
-                    {
-                        Mat plane(bsz, cdepth, &buf[0]);
-                        src.convertTo(plane, cdepth);
-                        src = plane;
-                    }
-                    add(src, cdst, cdst);
+                    const uchar* src = img.ptr(y + ty) + j;
+                    const uchar* tptr = templ.ptr(ty) + j % cn;
+                    for( int tx = 0; tx < tcols*cn; tx += cn )
+                        s += src[tx]*tptr[tx];
                 }
+                acc[j] = s;
+            }
+
+            float* dst = _corr.ptr<float>(y);
+            for( int x = 0; x < _corr.cols; x++ )
+            {
+                int s = acc[x*cn];
+                for( int k = 1; k < cn; k++ )
+                    s += acc[x*cn + k];
+                dst[x] = (float)s;
             }
         }
     }
-}
-
-}
-
-/*****************************************************************************************/
 
-void cv::matchTemplate( InputArray _img, InputArray _templ, OutputArray _result, int method )
+private:
+    Mat img;
+    Mat templ;
+    Mat coeffs;
+    Mat corr;
+};
+
+// Chooses between the direct correlation and the DFT-based one. The direct method costs
+// about corr.area*templ.area*cn multiply-adds, 8 per SIMD instruction; the DFT-based one
+// costs a forward and an inverse transform of every block and channel, plus the DFT of
+// the template. The constants were measured on 8-bit images: the direct method wins
+// up to about 10x10 single-channel templates, the DFT-based one beyond that, since its
+// cost barely depends on the template size.
+static bool useDirectCorr( Size imgSize, Size templSize, int type )
 {
-    CV_Assert( CV_TM_SQDIFF <= method && method <= CV_TM_CCOEFF_NORMED );
+    const double directScale = 12., dftScale = 1.;
+    int cn = CV_MAT_CN(type);
+    double tarea = (double)templSize.area()*cn;
 
-    int numType = method == CV_TM_CCORR || method == CV_TM_CCORR_NORMED ? 0 :
-                  method == CV_TM_CCOEFF || method == CV_TM_CCOEFF_NORMED ? 1 : 2;
-    bool isNormed = method == CV_TM_CCORR_NORMED ||
-                    method == CV_TM_SQDIFF_NORMED ||
-                    method == CV_TM_CCOEFF_NORMED;
+    if( CV_MAT_DEPTH(type) != CV_8U || tarea*255*255 > INT_MAX )
+        return false;
 
-    Mat img = _img.getMat(), templ = _templ.getMat();
-    if( img.rows < templ.rows || img.cols < templ.cols )
-        std::swap(img, templ);
-
-    CV_Assert( (img.depth() == CV_8U || img.depth() == CV_32F) &&
-               img.type() == templ.type() );
-
-    Size corrSize(img.cols - templ.cols + 1, img.rows - templ.rows + 1);
-    _result.create(corrSize, CV_32F);
-    Mat result = _result.getMat();
+    Size corrSize(imgSize.width - templSize.width + 1, imgSize.height - templSize.height + 1);
+    Size blocksize, dftsize;
+    getCrossCorrBlockSize( templSize, corrSize, blocksize, dftsize );
 
-    int cn = img.channels();
-    crossCorr( img, templ, result, result.size(), result.type(), Point(0,0), 0, 0);
+    double tiles = ((corrSize.width + blocksize.width - 1)/blocksize.width)*
+                   (double)((corrSize.height + blocksize.height - 1)/blocksize.height);
+    double n = (double)dftsize.area();
+    double dftCost = (tiles*2 + 1)*cn*n*std::log(n)*(1./CV_LOG2)*dftScale;
+    double directCost = (double)corrSize.area()*tarea*directScale/(hasSIMD128() ? 8 : 1);
 
-    if( method == CV_TM_CCORR )
-        return;
+    return directCost < dftCost;
+}
 
+// Computes the template statistics the correlation is normalized with. Returns false if
+// the method is CV_TM_CCOEFF_NORMED and the template is constant; the result is all
+// ones then.
+static bool getTemplStats( const Mat& templ, int method, Scalar& templMean,
+                           double& templNorm, double& templSum2 )
+{
+    int numType = method == CV_TM_CCORR || method == CV_TM_CCORR_NORMED ? 0 :
+                  method == CV_TM_CCOEFF || method == CV_TM_CCOEFF_NORMED ? 1 : 2;
     double invArea = 1./((double)templ.rows * templ.cols);
+    Scalar templSdv;
 
-    Mat sum, sqsum;
-    Scalar templMean, templSdv;
-    double *q0 = 0, *q1 = 0, *q2 = 0, *q3 = 0;
-    double templNorm = 0, templSum2 = 0;
+    templMean = Scalar::all(0);
+    templNorm = templSum2 = 0;
+
+    if( method == CV_TM_CCORR )
+        return true;
 
     if( method == CV_TM_CCOEFF )
     {
-        integral(img, sum, CV_64F);
         templMean = mean(templ);
+        return true;
     }
-    else
-    {
-        integral(img, sum, sqsum, CV_64F);
-        meanStdDev( templ, templMean, templSdv );
 
-        templNorm = CV_SQR(templSdv[0]) + CV_SQR(templSdv[1]) +
-                    CV_SQR(templSdv[2]) + CV_SQR(templSdv[3]);
+    meanStdDev( templ, templMean, templSdv );
 
-        if( templNorm < DBL_EPSILON && method == CV_TM_CCOEFF_NORMED )
-        {
-            result = Scalar::all(1);
-            return;
-        }
+    templNorm = CV_SQR(templSdv[0]) + CV_SQR(templSdv[1]) +
+                CV_SQR(templSdv[2]) + CV_SQR(templSdv[3]);
 
-        templSum2 = templNorm +
-                     CV_SQR(templMean[0]) + CV_SQR(templMean[1]) +
-                     CV_SQR(templMean[2]) + CV_SQR(templMean[3]);
+    if( templNorm < DBL_EPSILON && method == CV_TM_CCOEFF_NORMED )
+        return false;
 
-        if( numType != 1 )
-        {
-            templMean = Scalar::all(0);
-            templNorm = templSum2;
-        }
+    templSum2 = templNorm +
+                 CV_SQR(templMean[0]) + CV_SQR(templMean[1]) +
+                 CV_SQR(templMean[2]) + CV_SQR(templMean[3]);
+
+    if( numType != 1 )
+    {
+        templMean = Scalar::all(0);
+        templNorm = templSum2;
+    }
+
+    templSum2 /= invArea;
+    templNorm = sqrt(templNorm);
+    templNorm /= sqrt(invArea); // care of accuracy here
+    return true;
+}
+
+// Turns the correlation stored in result into the comparison result of the method.
+// sum and sqsum are the CV_64F integrals of the image; sqsum is not used by CV_TM_CCOEFF.
+static void normalizeCorr( const Mat& sum, const Mat& sqsum, Size templSize, int method,
+                           const Scalar& templMean, double templNorm, double templSum2,
+                           Mat& result )
+{
+    if( method == CV_TM_CCORR )
+        return;
 
-        templSum2 /= invArea;
-        templNorm = sqrt(templNorm);
-        templNorm /= sqrt(invArea); // care of accuracy here
+    int numType = method == CV_TM_CCORR || method == CV_TM_CCORR_NORMED ? 0 :
+                  method == CV_TM_CCOEFF || method == CV_TM_CCOEFF_NORMED ? 1 : 2;
+    bool isNormed = method == CV_TM_CCORR_NORMED ||
+                    method == CV_TM_SQDIFF_NORMED ||
+                    method == CV_TM_CCOEFF_NORMED;
+    int cn = sum.channels();
+    double invArea = 1./((double)templSize.height * templSize.width);
+    double *q0 = 0, *q1 = 0, *q2 = 0, *q3 = 0;
 
+    if( method != CV_TM_CCOEFF )
+    {
         q0 = (double*)sqsum.data;
-        q1 = q0 + templ.cols*cn;
-        q2 = (double*)(sqsum.data + templ.rows*sqsum.step);
-        q3 = q2 + templ.cols*cn;
+        q1 = q0 + templSize.width*cn;
+        q2 = (double*)(sqsum.data + templSize.height*sqsum.step);
+        q3 = q2 + templSize.width*cn;
     }
 
     double* p0 = (double*)sum.data;
-    double* p1 = p0 + templ.cols*cn;
-    double* p2 = (double*)(sum.data + templ.rows*sum.step);
-    double* p3 = p2 + templ.cols*cn;
+    double* p1 = p0 + templSize.width*cn;
+    double* p2 = (double*)(sum.data + templSize.height*sum.step);
+    double* p3 = p2 + templSize.width*cn;
 
     int sumstep = sum.data ? (int)(sum.step / sizeof(double)) : 0;
     int sqstep = sqsum.data ? (int)(sqsum.step / sizeof(double)) : 0;
@@ -368,6 +571,278 @@ void cv::matchTemplate( InputArray _img, InputArray _templ, OutputArray _result,
     }
 }
 
+// Correlates the image with several template spectra of the same DFT size. The blocks
+// cover the largest of the results; the spectrum of every image block is computed once
+// and is multiplied by the spectra of all the templates whose results overlap the block.
+// Since the spectra are linear, the channels are summed before the inverse transform.
+class MultiCorrBlockInvoker : public ParallelLoopBody
+{
+public:
+    MultiCorrBlockInvoker( const Mat& _img, const vector<Mat>& _spectra, vector<Mat>& _corrs,
+                           Size _maxTemplSize, Size _corrSize, Size _blocksize, Size _dftsize )
+        : img(_img), spectra(&_spectra), corrs(&_corrs), maxTemplSize(_maxTemplSize),
+          corrSize(_corrSize), blocksize(_blocksize), dftsize(_dftsize)
+    {
+        tileCountX = (corrSize.width + blocksize.width - 1)/blocksize.width;
+        maxDepth = CV_32F;
+        for( size_t t = 0; t < spectra->size(); t++ )
+            if( !(*spectra)[t].empty() )
+                maxDepth = (*spectra)[t].depth();
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int depth = img.depth(), cn = img.channels();
+        Mat imgSpectrum( dftsize.height*cn, dftsize.width, maxDepth );
+        Mat acc( dftsize, maxDepth ), prod( dftsize, maxDepth );
+        std::vector<uchar> buf;
+
+        if( cn > 1 && depth != maxDepth )
+            buf.resize((blocksize.width + maxTemplSize.width - 1)*
+                       (blocksize.height + maxTemplSize.height - 1)*CV_ELEM_SIZE(depth));
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            int x = (i%tileCountX)*blocksize.width;
+            int y = (i/tileCountX)*blocksize.height;
+            Size bsz(std::min(blocksize.width, corrSize.width - x),
+                     std::min(blocksize.height, corrSize.height - y));
+            int x2 = std::min(img.cols, x + bsz.width + maxTemplSize.width - 1);
+            int y2 = std::min(img.rows, y + bsz.height + maxTemplSize.height - 1);
+            Mat src0(img, Range(y, y2), Range(x, x2));
+
+            for( int k = 0; k < cn; k++ )
+            {
+                Mat plane(imgSpectrum, Rect(0, k*dftsize.height, dftsize.width, dftsize.height));
+                Mat dst1(plane, Rect(0, 0, x2 - x, y2 - y));
+                Mat src = src0;
+                plane = Scalar::all(0);
+
+                if( cn > 1 )
+                {
+                    src = depth == maxDepth ? dst1 : Mat(y2 - y, x2 - x, depth, &buf[0]);
+                    int pairs[] = {k, 0};
+                    mixChannels(&src0, 1, &src, 1, pairs, 1);
+                }
+
+                if( dst1.data != src.data )
+                    src.convertTo(dst1, maxDepth);
+
+                dft( plane, plane, 0, y2 - y );
+            }
+
+            for( size_t t = 0; t < spectra->size(); t++ )
+            {
+                const Mat& spectrum = (*spectra)[t];
+                if( spectrum.empty() )
+                    continue;
+
+                Mat corr = (*corrs)[t];
+                int w = std::min(bsz.width, corr.cols - x);
+                int h = std::min(bsz.height, corr.rows - y);
+                if( w <= 0 || h <= 0 )
+                    continue;
+
+                for( int k = 0; k < cn; k++ )
+                {
+                    Rect r(0, k*dftsize.height, dftsize.width, dftsize.height);
+                    if( k == 0 )
+                        mulSpectrums(imgSpectrum(r), spectrum(r), acc, 0, true);
+                    else
+                    {
+                        mulSpectrums(imgSpectrum(r), spectrum(r), prod, 0, true);
+                        acc += prod;
+                    }
+                }
+
+                dft( acc, acc, DFT_INVERSE + DFT_SCALE, h );
+                acc(Rect(0, 0, w, h)).convertTo(corr(Rect(x, y, w, h)), CV_32F);
+            }
+        }
+    }
+
+private:
+    Mat img;
+    const vector<Mat>* spectra;
+    vector<Mat>* corrs;
+    Size maxTemplSize, corrSize, blocksize, dftsize;
+    int tileCountX, maxDepth;
+};
+
+}
+
+/*****************************************************************************************/
+
+void cv::matchTemplate( InputArray _img, InputArray _templ, OutputArray _result, int method )
+{
+    CV_Assert( CV_TM_SQDIFF <= method && method <= CV_TM_CCOEFF_NORMED );
+
+    Mat img = _img.getMat(), templ = _templ.getMat();
+    if( img.rows < templ.rows || img.cols < templ.cols )
+        std::swap(img, templ);
+
+    CV_Assert( (img.depth() == CV_8U || img.depth() == CV_32F) &&
+               img.type() == templ.type() );
+
+    Size corrSize(img.cols - templ.cols + 1, img.rows - templ.rows + 1);
+    _result.create(corrSize, CV_32F);
+    Mat result = _result.getMat();
+
+    if( useDirectCorr(img.size(), templ.size(), img.type()) )
+    {
+        Mat coeffs;
+        getDirectCorrCoeffs(templ, coeffs);
+        parallel_for_(Range(0, result.rows), DirectCorr8uInvoker(img, templ, coeffs, result));
+    }
+    else
+        crossCorr( img, templ, result, result.size(), result.type(), Point(0,0), 0, 0);
+
+    if( method == CV_TM_CCORR )
+        return;
+
+    Scalar templMean;
+    double templNorm = 0, templSum2 = 0;
+
+    if( !getTemplStats(templ, method, templMean, templNorm, templSum2) )
+    {
+        result = Scalar::all(1);
+        return;
+    }
+
+    Mat sum, sqsum;
+    if( method == CV_TM_CCOEFF )
+        integral(img, sum, CV_64F);
+    else
+        integral(img, sum, sqsum, CV_64F);
+
+    normalizeCorr(sum, sqsum, templ.size(), method, templMean, templNorm, templSum2, result);
+}
+
+/*****************************************************************************************/
+
+cv::TemplateMatcher::TemplateMatcher()
+    : imageSize(0, 0), imageType(-1), method(CV_TM_CCORR)
+{
+}
+
+cv::TemplateMatcher::TemplateMatcher( Size _imageSize, int _imageType,
+                                      const vector<Mat>& templates, int _method )
+{
+    init(_imageSize, _imageType, templates, _method);
+}
+
+void cv::TemplateMatcher::init( Size _imageSize, int _imageType,
+                                const vector<Mat>& templates, int _method )
+{
+    CV_Assert( CV_TM_SQDIFF <= _method && _method <= CV_TM_CCOEFF_NORMED );
+    CV_Assert( (CV_MAT_DEPTH(_imageType) == CV_8U || CV_MAT_DEPTH(_imageType) == CV_32F) &&
+               _imageSize.width > 0 && _imageSize.height > 0 );
+
+    imageSize = _imageSize;
+    imageType = _imageType;
+    method = _method;
+
+    size_t i, ntempls = templates.size();
+    Size minSize(INT_MAX, INT_MAX), maxSize(0, 0);
+
+    templs.resize(ntempls);
+    for( i = 0; i < ntempls; i++ )
+    {
+        const Mat& templ = templates[i];
+        CV_Assert( templ.type() == imageType && templ.dims <= 2 && !templ.empty() &&
+                   templ.cols <= imageSize.width && templ.rows <= imageSize.height );
+
+        Templ& t = templs[i];
+        t.size = templ.size();
+        t.constant = !getTemplStats(templ, method, t.mean, t.norm, t.sum2);
+        t.data.release();
+        t.coeffs.release();
+        t.spectrum.release();
+
+        if( useDirectCorr(imageSize, templ.size(), imageType) )
+        {
+            templ.copyTo(t.data);
+            getDirectCorrCoeffs(templ, t.coeffs);
+        }
+        else
+        {
+            minSize.width = std::min(minSize.width, templ.cols);
+            minSize.height = std::min(minSize.height, templ.rows);
+            maxSize.width = std::max(maxSize.width, templ.cols);
+            maxSize.height = std::max(maxSize.height, templ.rows);
+        }
+    }
+
+    // all the spectra share the DFT size, chosen for the largest template,
+    // so that every image block is transformed only once
+    corrSize = Size(0, 0);
+    blockSize = dftSize = Size(0, 0);
+    maxTemplSize = maxSize;
+    if( maxSize.width == 0 )
+        return;
+
+    corrSize = Size(imageSize.width - minSize.width + 1, imageSize.height - minSize.height + 1);
+    getCrossCorrBlockSize( maxSize, corrSize, blockSize, dftSize );
+
+    for( i = 0; i < ntempls; i++ )
+        if( templs[i].data.empty() )
+        {
+            CrossCorrSpectrum ts;
+            computeCrossCorrSpectrum( templates[i], CV_MAT_DEPTH(imageType), CV_32F,
+                                      blockSize, dftSize, ts );
+            templs[i].spectrum = ts.planes;
+        }
+}
+
+void cv::TemplateMatcher::match( const Mat& image, vector<Mat>& results ) const
+{
+    CV_Assert( image.size() == imageSize && image.type() == imageType && image.dims <= 2 );
+
+    size_t i, ntempls = templs.size();
+    vector<Mat> spectra(ntempls);
+
+    results.resize(ntempls);
+    for( i = 0; i < ntempls; i++ )
+    {
+        const Templ& t = templs[i];
+        results[i].create(imageSize.height - t.size.height + 1,
+                          imageSize.width - t.size.width + 1, CV_32F);
+        if( !t.data.empty() )
+            parallel_for_(Range(0, results[i].rows),
+                          DirectCorr8uInvoker(image, t.data, t.coeffs, results[i]));
+        else
+            spectra[i] = t.spectrum;
+    }
+
+    if( maxTemplSize.width > 0 )
+    {
+        int tileCount = ((corrSize.width + blockSize.width - 1)/blockSize.width)*
+                        ((corrSize.height + blockSize.height - 1)/blockSize.height);
+        parallel_for_(Range(0, tileCount),
+                      MultiCorrBlockInvoker(image, spectra, results, maxTemplSize,
+                                            corrSize, blockSize, dftSize));
+    }
+
+    if( method == CV_TM_CCORR )
+        return;
+
+    // the integrals of the image are shared by all the templates
+    Mat sum, sqsum;
+    if( method == CV_TM_CCOEFF )
+        integral(image, sum, CV_64F);
+    else
+        integral(image, sum, sqsum, CV_64F);
+
+    for( i = 0; i < ntempls; i++ )
+    {
+        const Templ& t = templs[i];
+        if( t.constant )
+            results[i] = Scalar::all(1);
+        else
+            normalizeCorr(sum, sqsum, t.size, method, t.mean, t.norm, t.sum2, results[i]);
+    }
+}
+
 
 CV_IMPL void
 cvMatchTemplate( const CvArr* _img, const CvArr* _templ, CvArr* _result, int method )
@@ -41,6 +41,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/intrin.hpp"
 
 namespace cv
 {
@@ -100,14 +101,12 @@ thresh_8u( const Mat& _src, Mat& _dst, uchar thresh, uchar maxval, int type )
         CV_Error( CV_StsBadArg, "Unknown threshold type" );
     }
 
-#if CV_SSE2
-    if( checkHardwareSupport(CV_CPU_SSE2) )
+#if CV_SIMD128
+    if( hasSIMD128() )
     {
-        __m128i _x80 = _mm_set1_epi8('\x80');
-        __m128i thresh_u = _mm_set1_epi8(thresh);
-        __m128i thresh_s = _mm_set1_epi8(thresh ^ 0x80);
-        __m128i maxval_ = _mm_set1_epi8(maxval);
-        j_scalar = roi.width & -8;
+        v_uint8x16 thresh_u = v_setall_u8(thresh);
+        v_uint8x16 maxval_ = v_setall_u8(maxval);
+        j_scalar = roi.width & -16;
 
         for( i = 0; i < roi.height; i++ )
         {
@@ -119,106 +118,66 @@ thresh_8u( const Mat& _src, Mat& _dst, uchar thresh, uchar maxval, int type )
             case THRESH_BINARY:
                 for( j = 0; j <= roi.width - 32; j += 32 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 16) );
-                    v0 = _mm_cmpgt_epi8( _mm_xor_si128(v0, _x80), thresh_s );
-                    v1 = _mm_cmpgt_epi8( _mm_xor_si128(v1, _x80), thresh_s );
-                    v0 = _mm_and_si128( v0, maxval_ );
-                    v1 = _mm_and_si128( v1, maxval_ );
-                    _mm_storeu_si128( (__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128( (__m128i*)(dst + j + 16), v1 );
+                    v_uint8x16 v0 = v_load(src + j), v1 = v_load(src + j + 16);
+                    v_store(dst + j, (v0 > thresh_u) & maxval_);
+                    v_store(dst + j + 16, (v1 > thresh_u) & maxval_);
                 }
 
-                for( ; j <= roi.width - 8; j += 8 )
-                {
-                    __m128i v0 = _mm_loadl_epi64( (const __m128i*)(src + j) );
-                    v0 = _mm_cmpgt_epi8( _mm_xor_si128(v0, _x80), thresh_s );
-                    v0 = _mm_and_si128( v0, maxval_ );
-                    _mm_storel_epi64( (__m128i*)(dst + j), v0 );
-                }
+                for( ; j <= roi.width - 16; j += 16 )
+                    v_store(dst + j, (v_load(src + j) > thresh_u) & maxval_);
                 break;
 
             case THRESH_BINARY_INV:
                 for( j = 0; j <= roi.width - 32; j += 32 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 16) );
-                    v0 = _mm_cmpgt_epi8( _mm_xor_si128(v0, _x80), thresh_s );
-                    v1 = _mm_cmpgt_epi8( _mm_xor_si128(v1, _x80), thresh_s );
-                    v0 = _mm_andnot_si128( v0, maxval_ );
-                    v1 = _mm_andnot_si128( v1, maxval_ );
-                    _mm_storeu_si128( (__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128( (__m128i*)(dst + j + 16), v1 );
+                    v_uint8x16 v0 = v_load(src + j), v1 = v_load(src + j + 16);
+                    v_store(dst + j, (v0 <= thresh_u) & maxval_);
+                    v_store(dst + j + 16, (v1 <= thresh_u) & maxval_);
                 }
 
-                for( ; j <= roi.width - 8; j += 8 )
-                {
-                    __m128i v0 = _mm_loadl_epi64( (const __m128i*)(src + j) );
-                    v0 = _mm_cmpgt_epi8( _mm_xor_si128(v0, _x80), thresh_s );
-                    v0 = _mm_andnot_si128( v0, maxval_ );
-                    _mm_storel_epi64( (__m128i*)(dst + j), v0 );
-                }
+                for( ; j <= roi.width - 16; j += 16 )
+                    v_store(dst + j, (v_load(src + j) <= thresh_u) & maxval_);
                 break;
 
             case THRESH_TRUNC:
                 for( j = 0; j <= roi.width - 32; j += 32 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 16) );
-                    v0 = _mm_subs_epu8( v0, _mm_subs_epu8( v0, thresh_u ));
-                    v1 = _mm_subs_epu8( v1, _mm_subs_epu8( v1, thresh_u ));
-                    _mm_storeu_si128( (__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128( (__m128i*)(dst + j + 16), v1 );
+                    v_uint8x16 v0 = v_load(src + j), v1 = v_load(src + j + 16);
+                    v_store(dst + j, v_min(v0, thresh_u));
+                    v_store(dst + j + 16, v_min(v1, thresh_u));
                 }
 
-                for( ; j <= roi.width - 8; j += 8 )
-                {
-                    __m128i v0 = _mm_loadl_epi64( (const __m128i*)(src + j) );
-                    v0 = _mm_subs_epu8( v0, _mm_subs_epu8( v0, thresh_u ));
-                    _mm_storel_epi64( (__m128i*)(dst + j), v0 );
-                }
+                for( ; j <= roi.width - 16; j += 16 )
+                    v_store(dst + j, v_min(v_load(src + j), thresh_u));
                 break;
 
             case THRESH_TOZERO:
                 for( j = 0; j <= roi.width - 32; j += 32 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 16) );
-                    v0 = _mm_and_si128( v0, _mm_cmpgt_epi8(_mm_xor_si128(v0, _x80), thresh_s ));
-                    v1 = _mm_and_si128( v1, _mm_cmpgt_epi8(_mm_xor_si128(v1, _x80), thresh_s ));
-                    _mm_storeu_si128( (__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128( (__m128i*)(dst + j + 16), v1 );
+                    v_uint8x16 v0 = v_load(src + j), v1 = v_load(src + j + 16);
+                    v_store(dst + j, v0 & (v0 > thresh_u));
+                    v_store(dst + j + 16, v1 & (v1 > thresh_u));
                 }
 
-                for( ; j <= roi.width - 8; j += 8 )
+                for( ; j <= roi.width - 16; j += 16 )
                 {
-                    __m128i v0 = _mm_loadl_epi64( (const __m128i*)(src + j) );
-                    v0 = _mm_and_si128( v0, _mm_cmpgt_epi8(_mm_xor_si128(v0, _x80), thresh_s ));
-                    _mm_storel_epi64( (__m128i*)(dst + j), v0 );
+                    v_uint8x16 v0 = v_load(src + j);
+                    v_store(dst + j, v0 & (v0 > thresh_u));
                 }
                 break;
 
             case THRESH_TOZERO_INV:
                 for( j = 0; j <= roi.width - 32; j += 32 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 16) );
-                    v0 = _mm_andnot_si128( _mm_cmpgt_epi8(_mm_xor_si128(v0, _x80), thresh_s ), v0 );
-                    v1 = _mm_andnot_si128( _mm_cmpgt_epi8(_mm_xor_si128(v1, _x80), thresh_s ), v1 );
-                    _mm_storeu_si128( (__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128( (__m128i*)(dst + j + 16), v1 );
+                    v_uint8x16 v0 = v_load(src + j), v1 = v_load(src + j + 16);
+                    v_store(dst + j, v0 & (v0 <= thresh_u));
+                    v_store(dst + j + 16, v1 & (v1 <= thresh_u));
                 }
 
-                for( ; j <= roi.width - 8; j += 8 )
+                for( ; j <= roi.width - 16; j += 16 )
                 {
-                    __m128i v0 = _mm_loadl_epi64( (const __m128i*)(src + j) );
-                    v0 = _mm_andnot_si128( _mm_cmpgt_epi8(_mm_xor_si128(v0, _x80), thresh_s ), v0 );
-                    _mm_storel_epi64( (__m128i*)(dst + j), v0 );
+                    v_uint8x16 v0 = v_load(src + j);
+                    v_store(dst + j, v0 & (v0 <= thresh_u));
                 }
                 break;
             }
@@ -267,8 +226,8 @@ thresh_16s( const Mat& _src, Mat& _dst, short thresh, short maxval, int type )
     size_t src_step = _src.step/sizeof(src[0]);
     size_t dst_step = _dst.step/sizeof(dst[0]);
 
-#if CV_SSE2
-    volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE);
+#if CV_SIMD128
+    volatile bool useSIMD = hasSIMD128();
 #endif
 
     if( _src.isContinuous() && _dst.isContinuous() )
@@ -288,21 +247,15 @@ thresh_16s( const Mat& _src, Mat& _dst, short thresh, short maxval, int type )
         for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
         {
             j = 0;
-        #if CV_SSE2
+        #if CV_SIMD128
             if( useSIMD )
             {
-                __m128i thresh8 = _mm_set1_epi16(thresh), maxval8 = _mm_set1_epi16(maxval);
+                v_int16x8 thresh8 = v_setall_s16(thresh), maxval8 = v_setall_s16(maxval);
                 for( ; j <= roi.width - 16; j += 16 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 8) );
-                    v0 = _mm_cmpgt_epi16( v0, thresh8 );
-                    v1 = _mm_cmpgt_epi16( v1, thresh8 );
-                    v0 = _mm_and_si128( v0, maxval8 );
-                    v1 = _mm_and_si128( v1, maxval8 );
-                    _mm_storeu_si128((__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128((__m128i*)(dst + j + 8), v1 );
+                    v_int16x8 v0 = v_load( src + j ), v1 = v_load( src + j + 8 );
+                    v_store( dst + j, (v0 > thresh8) & maxval8 );
+                    v_store( dst + j + 8, (v1 > thresh8) & maxval8 );
                 }
             }
         #endif
@@ -316,21 +269,15 @@ thresh_16s( const Mat& _src, Mat& _dst, short thresh, short maxval, int type )
         for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
         {
             j = 0;
-        #if CV_SSE2
+        #if CV_SIMD128
             if( useSIMD )
             {
-                __m128i thresh8 = _mm_set1_epi16(thresh), maxval8 = _mm_set1_epi16(maxval);
+                v_int16x8 thresh8 = v_setall_s16(thresh), maxval8 = v_setall_s16(maxval);
                 for( ; j <= roi.width - 16; j += 16 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 8) );
-                    v0 = _mm_cmpgt_epi16( v0, thresh8 );
-                    v1 = _mm_cmpgt_epi16( v1, thresh8 );
-                    v0 = _mm_andnot_si128( v0, maxval8 );
-                    v1 = _mm_andnot_si128( v1, maxval8 );
-                    _mm_storeu_si128((__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128((__m128i*)(dst + j + 8), v1 );
+                    v_int16x8 v0 = v_load( src + j ), v1 = v_load( src + j + 8 );
+                    v_store( dst + j, (v0 <= thresh8) & maxval8 );
+                    v_store( dst + j + 8, (v1 <= thresh8) & maxval8 );
                 }
             }
         #endif
@@ -344,19 +291,15 @@ thresh_16s( const Mat& _src, Mat& _dst, short thresh, short maxval, int type )
         for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
         {
             j = 0;
-        #if CV_SSE2
+        #if CV_SIMD128
             if( useSIMD )
             {
-                __m128i thresh8 = _mm_set1_epi16(thresh);
+                v_int16x8 thresh8 = v_setall_s16(thresh);
                 for( ; j <= roi.width - 16; j += 16 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 8) );
-                    v0 = _mm_min_epi16( v0, thresh8 );
-                    v1 = _mm_min_epi16( v1, thresh8 );
-                    _mm_storeu_si128((__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128((__m128i*)(dst + j + 8), v1 );
+                    v_int16x8 v0 = v_load( src + j ), v1 = v_load( src + j + 8 );
+                    v_store( dst + j, v_min(v0, thresh8) );
+                    v_store( dst + j + 8, v_min(v1, thresh8) );
                 }
             }
         #endif
@@ -370,19 +313,15 @@ thresh_16s( const Mat& _src, Mat& _dst, short thresh, short maxval, int type )
         for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
         {
             j = 0;
-        #if CV_SSE2
+        #if CV_SIMD128
             if( useSIMD )
             {
-                __m128i thresh8 = _mm_set1_epi16(thresh);
+                v_int16x8 thresh8 = v_setall_s16(thresh);
                 for( ; j <= roi.width - 16; j += 16 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 8) );
-                    v0 = _mm_and_si128(v0, _mm_cmpgt_epi16(v0, thresh8));
-                    v1 = _mm_and_si128(v1, _mm_cmpgt_epi16(v1, thresh8));
-                    _mm_storeu_si128((__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128((__m128i*)(dst + j + 8), v1 );
+                    v_int16x8 v0 = v_load( src + j ), v1 = v_load( src + j + 8 );
+                    v_store( dst + j, v0 & (v0 > thresh8) );
+                    v_store( dst + j + 8, v1 & (v1 > thresh8) );
                 }
             }
         #endif
@@ -399,19 +338,15 @@ thresh_16s( const Mat& _src, Mat& _dst, short thresh, short maxval, int type )
         for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
         {
             j = 0;
-        #if CV_SSE2
+        #if CV_SIMD128
             if( useSIMD )
             {
-                __m128i thresh8 = _mm_set1_epi16(thresh);
+                v_int16x8 thresh8 = v_setall_s16(thresh);
                 for( ; j <= roi.width - 16; j += 16 )
                 {
-                    __m128i v0, v1;
-                    v0 = _mm_loadu_si128( (const __m128i*)(src + j) );
-                    v1 = _mm_loadu_si128( (const __m128i*)(src + j + 8) );
-                    v0 = _mm_andnot_si128(_mm_cmpgt_epi16(v0, thresh8), v0);
-                    v1 = _mm_andnot_si128(_mm_cmpgt_epi16(v1, thresh8), v1);
-                    _mm_storeu_si128((__m128i*)(dst + j), v0 );
-                    _mm_storeu_si128((__m128i*)(dst + j + 8), v1 );
+                    v_int16x8 v0 = v_load( src + j ), v1 = v_load( src + j + 8 );
+                    v_store( dst + j, v0 & (v0 <= thresh8) );
+                    v_store( dst + j + 8, v1 & (v1 <= thresh8) );
                 }
             }
         #endif
@@ -439,8 +374,8 @@ thresh_32f( const Mat& _src, Mat& _dst, float thresh, float maxval, int type )
     size_t src_step = _src.step/sizeof(src[0]);
     size_t dst_step = _dst.step/sizeof(dst[0]);
 
-#if CV_SSE2
-    volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE);
+#if CV_SIMD128
+    volatile bool useSIMD = hasSIMD128();
 #endif
 
     if( _src.isContinuous() && _dst.isContinuous() )
@@ -460,21 +395,15 @@ thresh_32f( const Mat& _src, Mat& _dst, float thresh, float maxval, int type )
             for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
             {
                 j = 0;
-#if CV_SSE2
+#if CV_SIMD128
                 if( useSIMD )
                 {
-                    __m128 thresh4 = _mm_set1_ps(thresh), maxval4 = _mm_set1_ps(maxval);
+                    v_float32x4 thresh4 = v_setall_f32(thresh), maxval4 = v_setall_f32(maxval);
                     for( ; j <= roi.width - 8; j += 8 )
                     {
-                        __m128 v0, v1;
-                        v0 = _mm_loadu_ps( src + j );
-                        v1 = _mm_loadu_ps( src + j + 4 );
-                        v0 = _mm_cmpgt_ps( v0, thresh4 );
-                        v1 = _mm_cmpgt_ps( v1, thresh4 );
-                        v0 = _mm_and_ps( v0, maxval4 );
-                        v1 = _mm_and_ps( v1, maxval4 );
-                        _mm_storeu_ps( dst + j, v0 );
-                        _mm_storeu_ps( dst + j + 4, v1 );
+                        v_float32x4 v0 = v_load( src + j ), v1 = v_load( src + j + 4 );
+                        v_store( dst + j, (v0 > thresh4) & maxval4 );
+                        v_store( dst + j + 4, (v1 > thresh4) & maxval4 );
                     }
                 }
 #endif
@@ -488,21 +417,15 @@ thresh_32f( const Mat& _src, Mat& _dst, float thresh, float maxval, int type )
             for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
             {
                 j = 0;
-#if CV_SSE2
+#if CV_SIMD128
                 if( useSIMD )
                 {
-                    __m128 thresh4 = _mm_set1_ps(thresh), maxval4 = _mm_set1_ps(maxval);
+                    v_float32x4 thresh4 = v_setall_f32(thresh), maxval4 = v_setall_f32(maxval);
                     for( ; j <= roi.width - 8; j += 8 )
                     {
-                        __m128 v0, v1;
-                        v0 = _mm_loadu_ps( src + j );
-                        v1 = _mm_loadu_ps( src + j + 4 );
-                        v0 = _mm_cmple_ps( v0, thresh4 );
-                        v1 = _mm_cmple_ps( v1, thresh4 );
-                        v0 = _mm_and_ps( v0, maxval4 );
-                        v1 = _mm_and_ps( v1, maxval4 );
-                        _mm_storeu_ps( dst + j, v0 );
-                        _mm_storeu_ps( dst + j + 4, v1 );
+                        v_float32x4 v0 = v_load( src + j ), v1 = v_load( src + j + 4 );
+                        v_store( dst + j, (v0 <= thresh4) & maxval4 );
+                        v_store( dst + j + 4, (v1 <= thresh4) & maxval4 );
                     }
                 }
 #endif
@@ -516,19 +439,15 @@ thresh_32f( const Mat& _src, Mat& _dst, float thresh, float maxval, int type )
             for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
             {
                 j = 0;
-#if CV_SSE2
+#if CV_SIMD128
                 if( useSIMD )
                 {
-                    __m128 thresh4 = _mm_set1_ps(thresh);
+                    v_float32x4 thresh4 = v_setall_f32(thresh);
                     for( ; j <= roi.width - 8; j += 8 )
                     {
-                        __m128 v0, v1;
-                        v0 = _mm_loadu_ps( src + j );
-                        v1 = _mm_loadu_ps( src + j + 4 );
-                        v0 = _mm_min_ps( v0, thresh4 );
-                        v1 = _mm_min_ps( v1, thresh4 );
-                        _mm_storeu_ps( dst + j, v0 );
-                        _mm_storeu_ps( dst + j + 4, v1 );
+                        v_float32x4 v0 = v_load( src + j ), v1 = v_load( src + j + 4 );
+                        v_store( dst + j, v_min(v0, thresh4) );
+                        v_store( dst + j + 4, v_min(v1, thresh4) );
                     }
                 }
 #endif
@@ -542,19 +461,15 @@ thresh_32f( const Mat& _src, Mat& _dst, float thresh, float maxval, int type )
             for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
             {
                 j = 0;
-#if CV_SSE2
+#if CV_SIMD128
                 if( useSIMD )
                 {
-                    __m128 thresh4 = _mm_set1_ps(thresh);
+                    v_float32x4 thresh4 = v_setall_f32(thresh);
                     for( ; j <= roi.width - 8; j += 8 )
                     {
-                        __m128 v0, v1;
-                        v0 = _mm_loadu_ps( src + j );
-                        v1 = _mm_loadu_ps( src + j + 4 );
-                        v0 = _mm_and_ps(v0, _mm_cmpgt_ps(v0, thresh4));
-                        v1 = _mm_and_ps(v1, _mm_cmpgt_ps(v1, thresh4));
-                        _mm_storeu_ps( dst + j, v0 );
-                        _mm_storeu_ps( dst + j + 4, v1 );
+                        v_float32x4 v0 = v_load( src + j ), v1 = v_load( src + j + 4 );
+                        v_store( dst + j, v0 & (v0 > thresh4) );
+                        v_store( dst + j + 4, v1 & (v1 > thresh4) );
                     }
                 }
 #endif
@@ -571,19 +486,15 @@ thresh_32f( const Mat& _src, Mat& _dst, float thresh, float maxval, int type )
             for( i = 0; i < roi.height; i++, src += src_step, dst += dst_step )
             {
                 j = 0;
-#if CV_SSE2
+#if CV_SIMD128
                 if( useSIMD )
                 {
-                    __m128 thresh4 = _mm_set1_ps(thresh);
+                    v_float32x4 thresh4 = v_setall_f32(thresh);
                     for( ; j <= roi.width - 8; j += 8 )
                     {
-                        __m128 v0, v1;
-                        v0 = _mm_loadu_ps( src + j );
-                        v1 = _mm_loadu_ps( src + j + 4 );
-                        v0 = _mm_and_ps(v0, _mm_cmple_ps(v0, thresh4));
-                        v1 = _mm_and_ps(v1, _mm_cmple_ps(v1, thresh4));
-                        _mm_storeu_ps( dst + j, v0 );
-                        _mm_storeu_ps( dst + j + 4, v1 );
+                        v_float32x4 v0 = v_load( src + j ), v1 = v_load( src + j + 4 );
+                        v_store( dst + j, v0 & (v0 <= thresh4) );
+                        v_store( dst + j + 4, v1 & (v1 <= thresh4) );
                     }
                 }
 #endif
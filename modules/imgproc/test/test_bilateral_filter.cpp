@@ -287,4 +287,51 @@ namespace cvtest
         test.safe_run();
     }
 
+    TEST(Imgproc_BilateralFilter, approximation)
+    {
+        const int types[] = { CV_8UC1, CV_8UC3, CV_32FC1, CV_32FC3 };
+        // (sigmaSpace, sigmaColor); the first pair selects the lattice for single-channel images
+        const double sigmas[][2] = { { 1, 5 }, { 4, 20 }, { 8, 40 }, { 12, 25 } };
+        ParallelThreadsScope threads(4);
+        Size size(200, 150);
+
+        // smooth shading, steps and noise
+        Mat base(size, CV_32FC3), noise(size, CV_32FC3);
+        for( int y = 0; y < size.height; y++ )
+            for( int x = 0; x < size.width; x++ )
+                base.at<Vec3f>(y, x) = Vec3f((float)(128 + 100*std::sin(x*0.05)*std::cos(y*0.04)),
+                                             (float)(x*255./size.width),
+                                             (x/37 + y/23) % 2 ? 200.f : 40.f);
+        theRNG().fill(noise, RNG::NORMAL, Scalar::all(0), Scalar::all(5));
+        base += noise;
+
+        for( int t = 0; t < 4; t++ )
+            for( int i = 0; i < 4; i++ )
+            {
+                double sigmaSpace = sigmas[i][0], sigmaColor = sigmas[i][1];
+                Mat src, exact, serial, parallel;
+                if( CV_MAT_CN(types[t]) == 1 )
+                    cvtColor(base, src, COLOR_BGR2GRAY);
+                else
+                    src = base;
+                src.convertTo(src, CV_MAT_DEPTH(types[t]));
+
+                bilateralFilter(src, exact, 0, sigmaColor, sigmaSpace);
+                {
+                    ParallelThreadsScope single(1);
+                    bilateralFilter(src, serial, 0, sigmaColor, sigmaSpace, BORDER_DEFAULT | BILATERAL_APPROX);
+                }
+                bilateralFilter(src, parallel, 0, sigmaColor, sigmaSpace, BORDER_DEFAULT | BILATERAL_APPROX);
+
+                ASSERT_EQ(src.type(), serial.type());
+                ASSERT_EQ(0, norm(serial, parallel, NORM_INF)) << "type " << types[t] << ", sigmas " << i;
+
+                // the approximation has no border extrapolation, so the margin is skipped
+                int margin = cvCeil(sigmaSpace*1.5);
+                Rect inner(margin, margin, size.width - margin*2, size.height - margin*2);
+                double err = norm(exact(inner), serial(inner), NORM_L1)/inner.area()/src.channels();
+                EXPECT_LE(err, sigmaColor*0.2) << "type " << types[t] << ", sigmas " << i;
+            }
+    }
+
 } // end of namespace cvtest
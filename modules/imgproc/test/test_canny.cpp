@@ -284,4 +284,32 @@ int CV_CannyTest::validate_test_results( int test_case_idx )
 
 TEST(Imgproc_Canny, accuracy) { CV_CannyTest test; test.safe_run(); }
 
+TEST(Imgproc_Canny, parallel_bands)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    for( int iter = 0; iter < 12; iter++ )
+    {
+        int cn = iter % 3 == 2 ? 3 : 1;
+        int aperture = 3 + (iter % 3)*2;
+        bool L2gradient = (iter & 1) != 0;
+        Mat big(600 + iter*7, 500 + iter*13, CV_8UC(cn));
+        rng.fill(big, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        GaussianBlur(big, big, Size(7, 7), 2);
+        // the source is a ROI, so the bands see real pixels beyond the image borders
+        Mat src = big(Rect(3, 5, big.cols - 10, big.rows - 9));
+        double low = aperture == 7 ? 2000 : aperture == 5 ? 200 : 20, high = low*3;
+
+        Mat serial, parallel;
+        {
+            ParallelThreadsScope single(1);
+            Canny(src, serial, low, high, aperture, L2gradient);
+        }
+        Canny(src, parallel, low, high, aperture, L2gradient);
+
+        ASSERT_GT(countNonZero(serial), 0);
+        ASSERT_EQ(0, norm(serial, parallel, NORM_INF)) << "iter = " << iter;
+    }
+}
+
 /* End of file. */
@@ -106,3 +106,92 @@ void CV_ConnectedComponentsTest::run( int /* start_from */)
 
 TEST(Imgproc_ConnectedComponents, regression) { CV_ConnectedComponentsTest test; test.safe_run(); }
 
+
+// breadth-first labeling, the components are numbered in the raster order of their first pixels
+static int labelComponentsBFS(const Mat& img, Mat& labels, int connectivity)
+{
+    labels = Mat::zeros(img.size(), CV_32S);
+    std::vector<Point> queue;
+    int nlabels = 1;
+    for( int y = 0; y < img.rows; y++ )
+        for( int x = 0; x < img.cols; x++ )
+        {
+            if( !img.at<uchar>(y, x) || labels.at<int>(y, x) )
+                continue;
+            queue.clear();
+            queue.push_back(Point(x, y));
+            labels.at<int>(y, x) = nlabels;
+            for( size_t i = 0; i < queue.size(); i++ )
+            {
+                Point p = queue[i];
+                for( int dy = -1; dy <= 1; dy++ )
+                    for( int dx = -1; dx <= 1; dx++ )
+                    {
+                        Point q(p.x + dx, p.y + dy);
+                        if( (connectivity == 4 && dx != 0 && dy != 0) ||
+                            !Rect(0, 0, img.cols, img.rows).contains(q) ||
+                            !img.at<uchar>(q) || labels.at<int>(q) )
+                            continue;
+                        labels.at<int>(q) = nlabels;
+                        queue.push_back(q);
+                    }
+            }
+            nlabels++;
+        }
+    return nlabels;
+}
+
+TEST(Imgproc_ConnectedComponents, parallel_strips)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    for( int iter = 0; iter < 6; iter++ )
+    {
+        int connectivity = iter % 2 ? 4 : 8;
+        Mat noise(640 + iter*37, 480 + iter*23, CV_8U), img;
+        rng.fill(noise, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        // blobs of various sizes, many of them crossing the strip boundaries
+        GaussianBlur(noise, noise, Size(0, 0), 1 + iter);
+        threshold(noise, img, 128, 255, THRESH_BINARY);
+        if( iter == 5 )
+            // isolated pixels on every other row and column
+            for( int y = 0; y < img.rows; y++ )
+                for( int x = 0; x < img.cols; x++ )
+                    img.at<uchar>(y, x) = (x % 2 == 0 && y % 2 == 0) ? 255 : 0;
+
+        Mat ref;
+        int nref = labelComponentsBFS(img, ref, connectivity);
+
+        Mat labels, stats, centroids, labels1, stats1, centroids1;
+        int n = connectedComponentsWithStats(img, labels, stats, centroids, connectivity, CV_32S), n1;
+        {
+            ParallelThreadsScope single(1);
+            n1 = connectedComponentsWithStats(img, labels1, stats1, centroids1, connectivity, CV_32S);
+        }
+
+        ASSERT_EQ(nref, n) << "iter = " << iter;
+        ASSERT_EQ(0, norm(ref, labels, NORM_INF)) << "iter = " << iter;
+        ASSERT_EQ(n, n1);
+        ASSERT_EQ(0, norm(labels, labels1, NORM_INF));
+        ASSERT_EQ(0, norm(stats, stats1, NORM_INF));
+        ASSERT_EQ(0, norm(centroids, centroids1, NORM_INF));
+
+        for( int l = 0; l < n; l++ )
+        {
+            Mat mask = ref == l;
+            std::vector<Point> pts;
+            findNonZero(mask, pts);
+            Rect r = boundingRect(pts);
+            Moments m = moments(mask, true);
+            ASSERT_EQ(r.x, stats.at<int>(l, CC_STAT_LEFT)) << "label = " << l;
+            ASSERT_EQ(r.y, stats.at<int>(l, CC_STAT_TOP));
+            ASSERT_EQ(r.width, stats.at<int>(l, CC_STAT_WIDTH));
+            ASSERT_EQ(r.height, stats.at<int>(l, CC_STAT_HEIGHT));
+            ASSERT_EQ((int)m.m00, stats.at<int>(l, CC_STAT_AREA));
+            ASSERT_NEAR(m.m10/m.m00, centroids.at<double>(l, 0), 1e-6);
+            ASSERT_NEAR(m.m01/m.m00, centroids.at<double>(l, 1), 1e-6);
+            if( l > 3 )
+                break;
+        }
+    }
+}
@@ -390,4 +390,51 @@ _exit_:
 
 TEST(Imgproc_FindContours, accuracy) { CV_FindContourTest test; test.safe_run(); }
 
+static bool lessPoint(const Point& a, const Point& b)
+{
+    return a.y < b.y || (a.y == b.y && a.x < b.x);
+}
+
+static bool lessContour(const vector<Point>& a, const vector<Point>& b)
+{
+    if( a[0].y != b[0].y )
+        return a[0].y < b[0].y;
+    if( a[0].x != b[0].x )
+        return a[0].x < b[0].x;
+    if( a.size() != b.size() )
+        return a.size() < b.size();
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), lessPoint);
+}
+
+TEST(Imgproc_FindContours, parallel)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    int modes[] = { RETR_LIST, RETR_EXTERNAL };
+    int methods[] = { CHAIN_APPROX_NONE, CHAIN_APPROX_SIMPLE, CHAIN_APPROX_TC89_KCOS };
+    for( int iter = 0; iter < 6; iter++ )
+    {
+        int mode = modes[iter % 2], method = methods[iter % 3];
+        Mat noise(500 + iter*31, 400 + iter*17, CV_8U), img;
+        rng.fill(noise, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        GaussianBlur(noise, noise, Size(0, 0), 2 + iter*0.3);
+        // nested rings and blobs with holes, some of them touching the image frame
+        threshold(noise, img, 120 + iter*2, 255, THRESH_BINARY);
+        circle(img, Point(img.cols/2, img.rows/2), img.rows/3, Scalar::all(255), 9);
+        circle(img, Point(img.cols/2, img.rows/2), img.rows/4, Scalar::all(0), 9);
+
+        vector<vector<Point> > ref, contours;
+        Mat tmp = img.clone();
+        findContours(tmp, ref, mode, method, Point(3, -2));
+        findContoursParallel(img, contours, mode, method, Point(3, -2));
+
+        ASSERT_GT(ref.size(), (size_t)10) << "iter = " << iter;
+        ASSERT_EQ(ref.size(), contours.size()) << "iter = " << iter;
+        std::sort(ref.begin(), ref.end(), lessContour);
+        std::sort(contours.begin(), contours.end(), lessContour);
+        for( size_t i = 0; i < ref.size(); i++ )
+            ASSERT_TRUE(ref[i] == contours[i]) << "iter = " << iter << ", contour = " << i;
+    }
+}
+
 /* End of file. */
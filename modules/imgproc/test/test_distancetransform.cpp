@@ -295,3 +295,64 @@ void CV_DisTransTest::prepare_to_validation( int /*test_case_idx*/ )
 TEST(Imgproc_DistanceTransform, accuracy) { CV_DisTransTest test; test.safe_run(); }
 
 
+TEST(Imgproc_DistanceTransform, precise_labels)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+
+    for( int iter = 0; iter < 30; iter++ )
+    {
+        Size size(rng.uniform(1, 120), rng.uniform(1, 90));
+        int labelType = iter % 2 == 0 ? DIST_LABEL_PIXEL : DIST_LABEL_CCOMP;
+        Mat src(size, CV_8U);
+        // from isolated zero pixels to large zero regions; some images have no zeros at all
+        rng.fill(src, RNG::UNIFORM, 0, 1000);
+        threshold(src, src, (iter % 6)*(iter % 6)*10, 255, THRESH_BINARY);
+        if( iter % 5 == 0 )
+            erode(src, src, Mat(), Point(-1, -1), 2);
+
+        vector<Point> zeros;
+        for( int y = 0; y < size.height; y++ )
+            for( int x = 0; x < size.width; x++ )
+                if( src.at<uchar>(y, x) == 0 )
+                    zeros.push_back(Point(x, y));
+
+        Mat dist, labels, dist4, labels4;
+        {
+            ParallelThreadsScope single(1);
+            distanceTransform(src, dist, labels, CV_DIST_L2, CV_DIST_MASK_PRECISE, labelType);
+        }
+        distanceTransform(src, dist4, labels4, CV_DIST_L2, CV_DIST_MASK_PRECISE, labelType);
+
+        ASSERT_EQ(0, norm(dist, dist4, NORM_INF)) << "iter = " << iter;
+        ASSERT_EQ(0, norm(labels, labels4, NORM_INF)) << "iter = " << iter;
+
+        for( int y = 0; y < size.height; y++ )
+            for( int x = 0; x < size.width; x++ )
+            {
+                int label = labels.at<int>(y, x);
+                int best = INT_MAX, bestLabeled = INT_MAX;
+                for( size_t k = 0; k < zeros.size(); k++ )
+                {
+                    Point d = zeros[k] - Point(x, y);
+                    int d2 = d.dot(d);
+                    best = std::min(best, d2);
+                    // the labels of the zero pixels are either their numbers in the raster
+                    // order or the numbers of their connected components
+                    int zeroLabel = labelType == DIST_LABEL_PIXEL ? (int)k + 1 :
+                                    labels.at<int>(zeros[k]);
+                    if( zeroLabel == label )
+                        bestLabeled = std::min(bestLabeled, d2);
+                }
+
+                if( zeros.empty() )
+                {
+                    ASSERT_EQ(0, label);
+                    continue;
+                }
+                ASSERT_NEAR(std::sqrt((double)best), dist.at<float>(y, x), 1e-3)
+                    << "iter = " << iter << ", x = " << x << ", y = " << y;
+                ASSERT_EQ(best, bestLabeled) << "iter = " << iter << ", x = " << x << ", y = " << y;
+            }
+    }
+}
@@ -1887,3 +1887,251 @@ protected:
 
 TEST(Imgproc_Filtering, supportedFormats) { CV_FilterSupportedFormatsTest test; test.safe_run(); }
 
+
+static void filterSerially(Ptr<FilterEngine> f, const Mat& src, Mat& dst)
+{
+    dst.create(src.size(), f->dstType);
+    int y = f->start(src);
+    f->proceed(src.data + y*src.step, (int)src.step, f->endY - f->startY, dst.data, (int)dst.step);
+}
+
+TEST(Imgproc_Filtering, parallel_bands)
+{
+    const int types[] = { CV_8UC1, CV_8UC3, CV_16SC1, CV_32FC1, CV_32FC3 };
+    const int borders[] = { BORDER_REPLICATE, BORDER_REFLECT_101, BORDER_CONSTANT };
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+
+    for( int iter = 0; iter < 30; iter++ )
+    {
+        int type = types[rng.uniform(0, 5)], borderType = borders[rng.uniform(0, 3)];
+        int rows = rng.uniform(300, 700), cols = rng.uniform(300, 700);
+        Mat big(rows + 20, cols + 20, type);
+        randu(big, Scalar::all(0), Scalar::all(200));
+        // the rows outside of the ROI are used by the filters as well
+        Mat src = big(Rect(rng.uniform(0, 20), rng.uniform(0, 20), cols, rows));
+        Mat dst, ref;
+        Ptr<FilterEngine> f;
+
+        switch( iter % 6 )
+        {
+        case 0:
+        {
+            Mat kx(1, 5, CV_32F), ky(1, 9, CV_32F);
+            randu(kx, -1, 1);
+            randu(ky, -1, 1);
+            sepFilter2D(src, dst, CV_32F, kx, ky, Point(-1,-1), 0, borderType);
+            f = createSeparableLinearFilter(type, CV_MAKETYPE(CV_32F, src.channels()), kx, ky,
+                                            Point(-1,-1), 0, borderType);
+            break;
+        }
+        case 1:
+        {
+            Mat kernel(5, 5, CV_32F);
+            randu(kernel, -1, 1);
+            filter2D(src, dst, -1, kernel, Point(-1,-1), 0, borderType);
+            f = createLinearFilter(type, type, kernel, Point(-1,-1), 0, borderType);
+            break;
+        }
+        case 2:
+            GaussianBlur(src, dst, Size(7, 7), 2, 2, borderType);
+            f = createGaussianFilter(type, Size(7, 7), 2, 2, borderType);
+            break;
+        case 3:
+            boxFilter(src, dst, -1, Size(15, 11), Point(-1,-1), true, borderType);
+            f = createBoxFilter(type, type, Size(15, 11), Point(-1,-1), true, borderType);
+            break;
+        case 4:
+            Sobel(src, dst, CV_32F, 1, 1, 5, 1, 0, borderType);
+            f = createDerivFilter(type, CV_MAKETYPE(CV_32F, src.channels()), 1, 1, 5, borderType);
+            break;
+        default:
+        {
+            Mat kernel = getStructuringElement(MORPH_ELLIPSE, Size(9, 9));
+            dilate(src, dst, kernel, Point(-1,-1), 1, borderType, morphologyDefaultBorderValue());
+            f = createMorphologyFilter(MORPH_DILATE, type, kernel, Point(-1,-1),
+                                       borderType, borderType, morphologyDefaultBorderValue());
+        }
+        }
+
+        filterSerially(f, src, ref);
+        EXPECT_EQ(0, norm(dst, ref, NORM_INF)) << "iter " << iter << ", type " << type;
+    }
+}
+
+TEST(Imgproc_Morphology, large_rect_kernels)
+{
+    const int types[] = { CV_8UC1, CV_8UC3, CV_16UC1, CV_16SC1, CV_32FC1, CV_64FC1 };
+    const int borders[] = { BORDER_REPLICATE, BORDER_REFLECT_101, BORDER_CONSTANT };
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+
+    for( int iter = 0; iter < 40; iter++ )
+    {
+        int type = types[rng.uniform(0, 6)], borderType = borders[rng.uniform(0, 3)];
+        int op = rng.uniform(0, 2) ? MORPH_DILATE : MORPH_ERODE;
+        int k = rng.uniform(9, 140);
+        Size ksize = iter % 3 == 0 ? Size(k, 1) : iter % 3 == 1 ? Size(1, k) : Size(k, rng.uniform(9, 140));
+        Point anchor(rng.uniform(0, ksize.width), rng.uniform(0, ksize.height));
+        Scalar borderValue = Scalar::all(rng.uniform(0, 256));
+
+        Mat big(rng.uniform(200, 400), rng.uniform(200, 400), type), dst, ref;
+        randu(big, Scalar::all(0), Scalar::all(256));
+        Mat src = big(Rect(3, 5, big.cols - 10, big.rows - 7));
+        Mat kernel = getStructuringElement(MORPH_RECT, ksize);
+
+        if( op == MORPH_ERODE )
+            erode(src, dst, kernel, anchor, 1, borderType, borderValue);
+        else
+            dilate(src, dst, kernel, anchor, 1, borderType, borderValue);
+
+        // the non-separable filter processes the kernel elements directly
+        Ptr<FilterEngine> f = new FilterEngine(getMorphologyFilter(op, type, kernel, anchor),
+                                               Ptr<BaseRowFilter>(), Ptr<BaseColumnFilter>(),
+                                               type, type, type, borderType, borderType, borderValue);
+        filterSerially(f, src, ref);
+        EXPECT_EQ(0, norm(dst, ref, NORM_INF)) << "iter " << iter << ", type " << type << ", ksize " << ksize;
+    }
+
+    // the intermediate iterations are stored in the temporary buffers
+    Mat src(480, 640, CV_8UC1), dst, ref;
+    randu(src, Scalar::all(0), Scalar::all(256));
+    Mat kernel = getStructuringElement(MORPH_ELLIPSE, Size(7, 7));
+    erode(src, dst, kernel, Point(-1,-1), 3);
+    erode(src, ref, kernel);
+    erode(ref, ref, kernel);
+    erode(ref, ref, kernel);
+    EXPECT_EQ(0, norm(dst, ref, NORM_INF));
+}
+
+TEST(Imgproc_Pyramid, fused_levels)
+{
+    ParallelThreadsScope threads(4);
+    RNG& rng = theRNG();
+    const int types[] = { CV_8UC1, CV_8UC3, CV_16SC1, CV_32FC4, CV_64FC2 };
+    const int borders[] = { BORDER_REFLECT_101, BORDER_REPLICATE, BORDER_REFLECT, BORDER_WRAP };
+
+    for( int iter = 0; iter < 10; iter++ )
+    {
+        int type = types[iter % 5], borderType = borders[iter % 4];
+        Mat src(rng.uniform(700, 1100), rng.uniform(300, 600), type);
+        rng.fill(src, RNG::UNIFORM, Scalar::all(-100), Scalar::all(256));
+        int maxlevel = rng.uniform(1, 7);
+
+        // the reference is built level by level in one band
+        vector<Mat> ref(maxlevel + 1);
+        ref[0] = src;
+        {
+            ParallelThreadsScope single(1);
+            for( int i = 1; i <= maxlevel; i++ )
+                pyrDown(ref[i-1], ref[i], Size(), borderType);
+        }
+
+        vector<Mat> pyr;
+        buildPyramid(src, pyr, maxlevel, borderType);
+        ASSERT_EQ(maxlevel + 1, (int)pyr.size());
+        vector<uchar*> data(maxlevel + 1);
+        for( int i = 1; i <= maxlevel; i++ )
+        {
+            ASSERT_EQ(0, norm(pyr[i], ref[i], NORM_INF)) << "level " << i;
+            data[i] = pyr[i].data;
+        }
+
+        // the layers are reused when the pyramid is rebuilt
+        buildPyramid(src, pyr, maxlevel, borderType);
+        for( int i = 1; i <= maxlevel; i++ )
+            ASSERT_EQ(data[i], pyr[i].data);
+
+        Mat up, upref;
+        pyrUp(ref[1], up);
+        {
+            ParallelThreadsScope single(1);
+            pyrUp(ref[1], upref);
+        }
+        ASSERT_EQ(0, norm(up, upref, NORM_INF));
+    }
+}
+
+TEST(Imgproc_MedianBlur, parallel_tiles)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    int ksizes[] = { 9, 17, 31 };
+    for( int iter = 0; iter < 6; iter++ )
+    {
+        int ksize = ksizes[iter % 3], cn = iter < 3 ? 1 : 3;
+        Mat src(300 + iter*23, 700 + iter*41, CV_8UC(cn));
+        rng.fill(src, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+
+        Mat serial, parallel;
+        {
+            ParallelThreadsScope single(1);
+            medianBlur(src, serial, ksize);
+        }
+        medianBlur(src, parallel, ksize);
+
+        ASSERT_EQ(0, norm(serial, parallel, NORM_INF)) << "iter = " << iter;
+
+        if( cn == 1 )
+        {
+            SlidingWindowStats stats(src, Size(ksize, ksize));
+            for( int y = 0; y < src.rows; y += 7 )
+            {
+                stats.setRow(y);
+                for( int x = 0; ; x++ )
+                {
+                    ASSERT_EQ(stats.median(), (int)serial.at<uchar>(y, x)) << "iter = " << iter;
+                    if( x + 1 >= src.cols )
+                        break;
+                    stats.moveRight();
+                }
+            }
+        }
+    }
+}
+
+TEST(Imgproc_Integral, parallel_bands)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    for( int iter = 0; iter < 12; iter++ )
+    {
+        int cn = iter % 4 + 1;
+        int sdepth = iter % 2 == 0 ? CV_32S : CV_64F;
+        int sqdepth = iter % 3 == 0 ? CV_32S : iter % 3 == 1 ? CV_32F : CV_64F;
+        Size size(rng.uniform(1, 200), rng.uniform(1, 160));
+        if( iter >= 6 && sqdepth != CV_32S )
+            size = Size(size.width*3, size.height*5);
+        Mat src(size, CV_8UC(cn));
+        rng.fill(src, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+
+        // the floating-point integrals of the integer values are exact
+        Mat srcf, sum0, sqsum0;
+        src.convertTo(srcf, CV_32F);
+        integral(srcf, sum0, sqsum0, CV_64F);
+
+        Mat sum1, sqsum1, sum4, sqsum4, sqsumOnly;
+        {
+            ParallelThreadsScope single(1);
+            integral(src, sum1, sqsum1, noArray(), sdepth, sqdepth);
+        }
+        integral(src, sum4, sqsum4, noArray(), sdepth, sqdepth);
+        integral(src, noArray(), sqsumOnly, noArray(), sdepth, sqdepth);
+
+        ASSERT_EQ(CV_MAKETYPE(sdepth, cn), sum4.type());
+        ASSERT_EQ(CV_MAKETYPE(sqdepth, cn), sqsum4.type());
+        ASSERT_EQ(0, norm(sum1, sum4, NORM_INF)) << "iter = " << iter;
+        ASSERT_EQ(0, norm(sqsum1, sqsum4, NORM_INF)) << "iter = " << iter;
+        ASSERT_EQ(0, norm(sqsum4, sqsumOnly, NORM_INF)) << "iter = " << iter;
+
+        Mat sum, sqsum;
+        sum4.convertTo(sum, CV_64F);
+        sqsum4.convertTo(sqsum, CV_64F);
+        ASSERT_EQ(0, norm(sum, sum0, NORM_INF)) << "iter = " << iter;
+        ASSERT_LE(norm(sqsum, sqsum0, NORM_INF), sqdepth == CV_32F ? 1e-7*norm(sqsum0, NORM_INF) : 0)
+            << "iter = " << iter;
+    }
+
+    Mat big(300, 300, CV_8U, Scalar::all(255)), sum, sqsum;
+    EXPECT_THROW(integral(big, sum, sqsum, noArray(), CV_32S, CV_32S), cv::Exception);
+}
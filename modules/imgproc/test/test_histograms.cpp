@@ -1834,4 +1834,128 @@ TEST(Imgproc_Hist_CalcBackProject, accuracy) { CV_CalcBackProjectTest test; test
 TEST(Imgproc_Hist_CalcBackProjectPatch, accuracy) { CV_CalcBackProjectPatchTest test; test.safe_run(); }
 TEST(Imgproc_Hist_BayesianProb, accuracy) { CV_BayesianProbTest test; test.safe_run(); }
 
+TEST(Imgproc_Hist_Calc, parallel_stripes)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    for( int iter = 0; iter < 12; iter++ )
+    {
+        int depth = iter % 3 == 0 ? CV_8U : iter % 3 == 1 ? CV_16U : CV_32F;
+        int dims = iter % 4 == 3 ? 4 : iter % 4 + 1;
+        bool useMask = (iter & 2) != 0;
+        Mat big(700 + iter*11, 600 + iter*17, CV_MAKETYPE(depth, dims));
+        rng.fill(big, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        // a ROI, so that the stripes cannot be collapsed into a single row
+        Mat src = iter & 1 ? big(Rect(3, 5, big.cols - 10, big.rows - 9)) : big;
+        Mat mask;
+        if( useMask )
+        {
+            mask.create(src.size(), CV_8U);
+            rng.fill(mask, RNG::UNIFORM, Scalar::all(0), Scalar::all(2));
+        }
+
+        int channels[] = { 0, 1, 2, 3 };
+        int histSize[] = { 256, 32, 16, 8 };
+        if( dims > 1 )
+            histSize[0] = 64;
+        float r0[] = { 0, 256 };
+        float r1[] = { 0, 10, 50, 51, 100, 200, 220, 256, 257 };
+        const float* ranges[] = { r0, r0, r0, r0 };
+        bool uniform = dims > 1 || iter == 0;
+        if( !uniform )
+        {
+            histSize[0] = 8;
+            ranges[0] = r1;
+        }
+
+        Mat serial, parallel;
+        {
+            ParallelThreadsScope single(1);
+            calcHist(&src, 1, channels, mask, serial, dims, histSize, ranges, uniform);
+        }
+        calcHist(&src, 1, channels, mask, parallel, dims, histSize, ranges, uniform);
+
+        ASSERT_EQ((double)countNonZero(useMask ? mask : Mat::ones(src.size(), CV_8U)),
+                  sum(serial)[0]) << "iter = " << iter;
+        ASSERT_EQ(0, norm(serial, parallel, NORM_INF)) << "iter = " << iter;
+
+        Mat bpSerial, bpParallel;
+        normalize(serial, serial, 255, 0, NORM_INF);
+        {
+            ParallelThreadsScope single(1);
+            calcBackProject(&src, 1, channels, serial, bpSerial, ranges, 1, uniform);
+        }
+        calcBackProject(&src, 1, channels, serial, bpParallel, ranges, 1, uniform);
+
+        ASSERT_EQ(0, norm(bpSerial, bpParallel, NORM_INF)) << "iter = " << iter;
+    }
+}
+
+TEST(Imgproc_EqualizeHist, parallel_stripes)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    Mat big(800, 900, CV_8U);
+    rng.fill(big, RNG::NORMAL, Scalar::all(128), Scalar::all(20));
+    Mat src = big(Rect(1, 2, 850, 790));
+
+    Mat serial, parallel;
+    {
+        ParallelThreadsScope single(1);
+        equalizeHist(src, serial);
+    }
+    equalizeHist(src, parallel);
+
+    ASSERT_EQ(0, norm(serial, parallel, NORM_INF));
+}
+
+TEST(Imgproc_SlidingWindowStats, accuracy)
+{
+    RNG& rng = theRNG();
+    Size winSizes[] = { Size(1, 1), Size(7, 5), Size(3, 21), Size(81, 9) };
+    for( int iter = 0; iter < 4; iter++ )
+    {
+        Size winSize = winSizes[iter];
+        Mat img(37 + iter, 53 - iter, CV_8U);
+        rng.fill(img, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        int rx = winSize.width/2, ry = winSize.height/2;
+        Mat padded;
+        copyMakeBorder(img, padded, ry, ry, rx, rx, BORDER_REPLICATE);
+
+        SlidingWindowStats stats(img, winSize);
+        // consecutive rows update the column histograms, the jumps rebuild them
+        int rows[] = { 0, 1, 2, 10, 11, img.rows - 1, 5 };
+        for( int k = 0; k < (int)(sizeof(rows)/sizeof(rows[0])); k++ )
+        {
+            int y = rows[k];
+            stats.setRow(y);
+            for( int x = 0; ; x++ )
+            {
+                ASSERT_EQ(Point(x, y), stats.center());
+                Mat win = padded(Rect(Point(x, y), winSize));
+                int href[256] = { 0 };
+                std::vector<uchar> values;
+                for( int i = 0; i < win.rows; i++ )
+                    for( int j = 0; j < win.cols; j++ )
+                    {
+                        href[win.at<uchar>(i, j)]++;
+                        values.push_back(win.at<uchar>(i, j));
+                    }
+                std::nth_element(values.begin(), values.begin() + values.size()/2, values.end());
+                Scalar m, sd;
+                meanStdDev(win, m, sd);
+
+                ASSERT_EQ(0, memcmp(href, stats.hist(), sizeof(href))) << "x = " << x << ", y = " << y;
+                ASSERT_EQ((int)values[values.size()/2], stats.median());
+                ASSERT_NEAR(m[0], stats.mean(), 1e-6);
+                ASSERT_NEAR(sd[0], stats.stddev(), 1e-6);
+
+                if( x + 1 >= img.cols )
+                    break;
+                stats.moveRight();
+            }
+        }
+    }
+}
+
 /* End Of File */
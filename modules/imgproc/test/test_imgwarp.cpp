@@ -1545,4 +1545,118 @@ TEST(Imgproc_InitUndistortMap, accuracy) { CV_UndistortMapTest test; test.safe_r
 TEST(Imgproc_GetRectSubPix, accuracy) { CV_GetRectSubPixTest test; test.safe_run(); }
 TEST(Imgproc_GetQuadSubPix, accuracy) { CV_GetQuadSubPixTest test; test.safe_run(); }
 
+// the fused stage must give exactly what the three separate passes give
+TEST(Imgproc_Preprocess, accuracy)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    const int codes[] = { -1, COLOR_BGR2RGB, COLOR_BGR2GRAY, COLOR_BGR2HSV, COLOR_BGR2Lab,
+                          COLOR_BayerBG2BGR, COLOR_BGR2BGRA, COLOR_YUV2BGR_NV12 };
+    const int inters[] = { INTER_NEAREST, INTER_LINEAR, INTER_CUBIC, INTER_AREA, INTER_LANCZOS4 };
+    const Size dsizes[] = { Size(224, 224), Size(320, 240), Size(1000, 700), Size(160, 120) };
+
+    for( int iter = 0; iter < 40; iter++ )
+    {
+        int code = codes[iter % 8], interpolation = inters[iter % 5];
+        Size dsize = dsizes[iter % 4];
+        bool isFloat = iter % 3 == 2, planar = iter % 2 == 1;
+        // demosaicing and NV12 are converted before the bands, the rest inside them
+        bool isRaw = code == COLOR_BayerBG2BGR || code == COLOR_YUV2BGR_NV12;
+        isFloat = isFloat && !isRaw;
+        int stype = isRaw ? CV_8UC1 : isFloat ? CV_32FC3 : CV_8UC3;
+        Mat src(code == COLOR_YUV2BGR_NV12 ? 720 : 480, 640, stype);
+        rng.fill(src, RNG::UNIFORM, Scalar::all(0), Scalar::all(isFloat ? 1 : 256));
+
+        double alpha = 1./255, beta = -0.5;
+        int dtype = CV_32F;
+        if( iter % 4 == 0 )
+        {
+            alpha = 1;
+            beta = 0;
+            dtype = -1;
+        }
+
+        Mat converted, resized, ref;
+        if( code >= 0 )
+            cvtColor(src, converted, code);
+        else
+            converted = src;
+        resize(converted, resized, dsize, 0, 0, interpolation);
+        resized.convertTo(ref, dtype, alpha, beta);
+        if( planar )
+        {
+            vector<Mat> planes;
+            split(ref, planes);
+            vconcat(planes, ref);
+        }
+
+        Mat serial, parallel;
+        {
+            ParallelThreadsScope single(1);
+            preprocess(src, serial, dsize, code, interpolation, dtype, alpha, beta, planar);
+        }
+        preprocess(src, parallel, dsize, code, interpolation, dtype, alpha, beta, planar);
+
+        ASSERT_EQ(ref.size(), serial.size()) << "iter = " << iter;
+        ASSERT_EQ(ref.type(), serial.type()) << "iter = " << iter;
+        ASSERT_EQ(0, norm(ref, serial, NORM_INF)) << "iter = " << iter;
+        ASSERT_EQ(0, norm(ref, parallel, NORM_INF)) << "iter = " << iter;
+    }
+}
+
+TEST(Imgproc_WarpPlan, accuracy)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    const int inters[] = { INTER_NEAREST, INTER_LINEAR, INTER_CUBIC, INTER_LANCZOS4 };
+    const int types[] = { CV_8UC1, CV_8UC3, CV_8UC4, CV_16UC1, CV_32FC3 };
+    const int borders[] = { BORDER_CONSTANT, BORDER_REPLICATE, BORDER_REFLECT_101, BORDER_WRAP };
+
+    for( int iter = 0; iter < 40; iter++ )
+    {
+        int interpolation = inters[iter % 4], type = types[iter % 5], border = borders[(iter/4) % 4];
+        int flags = interpolation | (iter % 3 == 0 ? WARP_INVERSE_MAP : 0);
+        Size ssize(rng.uniform(20, 400), rng.uniform(20, 300));
+        Size dsize(rng.uniform(1, 500), rng.uniform(1, 300));
+        Mat src(ssize, type);
+        rng.fill(src, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        Scalar borderValue = Scalar::all(rng.uniform(0, 256));
+
+        Point2f center(ssize.width*0.5f, ssize.height*0.5f);
+        Mat A = getRotationMatrix2D(center, rng.uniform(-180., 180.), rng.uniform(0.5, 2.));
+        Mat P = Mat::eye(3, 3, CV_64F);
+        A.copyTo(P.rowRange(0, 2));
+        P.at<double>(2, 0) = rng.uniform(-1e-3, 1e-3);
+        P.at<double>(2, 1) = rng.uniform(-1e-3, 1e-3);
+
+        Mat mapx(dsize, CV_32F), mapy(dsize, CV_32F);
+        rng.fill(mapx, RNG::UNIFORM, Scalar::all(-10), Scalar::all(ssize.width + 10));
+        rng.fill(mapy, RNG::UNIFORM, Scalar::all(-10), Scalar::all(ssize.height + 10));
+
+        Mat ref[3], serial[3], parallel[3];
+        warpAffine(src, ref[0], A, dsize, flags, border, borderValue);
+        warpPerspective(src, ref[1], P, dsize, flags, border, borderValue);
+        remap(src, ref[2], mapx, mapy, interpolation, border, borderValue);
+
+        WarpPlan plans[3];
+        plans[0].initAffine(A, dsize, flags);
+        plans[1].initPerspective(P, dsize, flags);
+        plans[2].initRemap(mapx, mapy, interpolation);
+
+        for( int k = 0; k < 3; k++ )
+        {
+            ASSERT_EQ(dsize, plans[k].size());
+            {
+                ParallelThreadsScope single(1);
+                plans[k].apply(src, serial[k], border, borderValue);
+            }
+            plans[k].apply(src, parallel[k], border, borderValue);
+
+            ASSERT_EQ(ref[k].size(), serial[k].size()) << "iter = " << iter << ", k = " << k;
+            ASSERT_EQ(0, norm(ref[k], serial[k], NORM_INF)) << "iter = " << iter << ", k = " << k;
+            ASSERT_EQ(0, norm(ref[k], parallel[k], NORM_INF)) << "iter = " << iter << ", k = " << k;
+        }
+    }
+}
+
 /* End of file. */
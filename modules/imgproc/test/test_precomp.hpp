@@ -16,4 +16,14 @@
 #include "opencv2/highgui/highgui_c.h"
 #include <iostream>
 
+// sets the number of threads used by cv::parallel_for_ until the end of the scope
+class ParallelThreadsScope
+{
+public:
+    ParallelThreadsScope(int n) : prev(cv::getNumThreads()) { cv::setNumThreads(n); }
+    ~ParallelThreadsScope() { cv::setNumThreads(prev); }
+protected:
+    int prev;
+};
+
 #endif
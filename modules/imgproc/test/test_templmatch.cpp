@@ -334,3 +334,113 @@ void CV_TemplMatchTest::prepare_to_validation( int /*test_case_idx*/ )
 }
 
 TEST(Imgproc_MatchTemplate, accuracy) { CV_TemplMatchTest test; test.safe_run(); }
+
+static void matchTemplateCCorrNaive( const Mat& img, const Mat& templ, Mat& result )
+{
+    int cn = img.channels();
+    result.create(img.rows - templ.rows + 1, img.cols - templ.cols + 1, CV_64F);
+    for( int y = 0; y < result.rows; y++ )
+        for( int x = 0; x < result.cols; x++ )
+        {
+            double s = 0;
+            for( int ty = 0; ty < templ.rows; ty++ )
+            {
+                const uchar* src = img.ptr(y + ty) + x*cn;
+                const uchar* tptr = templ.ptr(ty);
+                for( int k = 0; k < templ.cols*cn; k++ )
+                    s += src[k]*tptr[k];
+            }
+            result.at<double>(y, x) = s;
+        }
+}
+
+// small templates are correlated directly, larger ones through the DFT of image blocks;
+// both must agree with the plain sum and must not depend on the number of threads
+TEST(Imgproc_MatchTemplate, direct_and_dft)
+{
+    RNG& rng = theRNG();
+    ParallelThreadsScope threads(4);
+    for( int iter = 0; iter < 16; iter++ )
+    {
+        int cn = iter % 4 == 3 ? 4 : iter % 4 + 1;
+        Size tsize(2 + iter*2, 1 + iter*3 % 23);
+        Mat big(190 + iter*5, 260 + iter*3, CV_8UC(cn)), templ(tsize, CV_8UC(cn));
+        rng.fill(big, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        rng.fill(templ, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+        // a ROI, so that the neighbourhood outside of it must not be touched
+        Mat img = big(Rect(3, 2, big.cols - 7, big.rows - 5));
+
+        Mat ref, serial, parallel;
+        matchTemplateCCorrNaive(img, templ, ref);
+        {
+            ParallelThreadsScope single(1);
+            matchTemplate(img, templ, serial, CV_TM_CCORR);
+        }
+        matchTemplate(img, templ, parallel, CV_TM_CCORR);
+
+        ASSERT_EQ(ref.size(), serial.size());
+        ASSERT_EQ(0, norm(serial, parallel, NORM_INF)) << "iter = " << iter;
+
+        Mat serial64;
+        serial.convertTo(serial64, CV_64F);
+        double maxval = (double)tsize.area()*cn*255*255;
+        ASSERT_LE(norm(serial64, ref, NORM_INF), maxval*1e-6) << "iter = " << iter;
+
+        // floating-point images always go through the DFT
+        Mat img32f, templ32f, normed, normedRef;
+        img.convertTo(img32f, CV_32F);
+        templ.convertTo(templ32f, CV_32F);
+        matchTemplate(img, templ, normed, CV_TM_CCOEFF_NORMED);
+        matchTemplate(img32f, templ32f, normedRef, CV_TM_CCOEFF_NORMED);
+        ASSERT_LE(norm(normed, normedRef, NORM_INF), 1e-4) << "iter = " << iter;
+    }
+}
+
+TEST(Imgproc_TemplateMatcher, accuracy)
+{
+    RNG& rng = theRNG();
+    int types[] = { CV_8UC1, CV_8UC3, CV_32FC1, CV_32FC3 };
+    for( int iter = 0; iter < 8; iter++ )
+    {
+        int type = types[iter % 4], method = iter % 6;
+        Size imgSize(300 + iter*7, 200 + iter*5);
+
+        // a mix of small templates, correlated directly, and large ones, sharing the DFT
+        vector<Mat> templs;
+        Size tsizes[] = { Size(3, 3), Size(7, 5), Size(16, 16), Size(40, 25), Size(23, 61) };
+        for( int i = 0; i < 5; i++ )
+        {
+            Mat templ(tsizes[i], type);
+            rng.fill(templ, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+            templs.push_back(templ);
+        }
+        templs.push_back(Mat(8, 8, type, Scalar::all(100)));
+
+        TemplateMatcher matcher(imgSize, type, templs, method);
+
+        for( int frame = 0; frame < 2; frame++ )
+        {
+            Mat img(imgSize, type);
+            rng.fill(img, RNG::UNIFORM, Scalar::all(0), Scalar::all(256));
+
+            vector<Mat> results;
+            matcher.match(img, results);
+            ASSERT_EQ(templs.size(), results.size());
+
+            for( size_t i = 0; i < templs.size(); i++ )
+            {
+                Mat ref;
+                matchTemplate(img, templs[i], ref, method);
+                ASSERT_EQ(ref.size(), results[i].size());
+                ASSERT_EQ(CV_32F, results[i].type());
+
+                // the unnormalized results are compared relatively to the largest possible
+                // correlation, since CV_TM_CCOEFF subtracts two values of that magnitude
+                bool isNormed = method % 2 == 1;
+                double eps = isNormed ? 1e-3 : templs[i].total()*CV_MAT_CN(type)*255*255*1e-6;
+                ASSERT_LE(norm(results[i], ref, NORM_INF), eps)
+                    << "iter = " << iter << ", templ = " << i;
+            }
+        }
+    }
+}
@@ -1093,6 +1093,7 @@ void CascadeClassifier::detectMultiScale( const Mat& image, vector<Rect>& object
                                           int flags, Size minObjectSize, Size maxObjectSize,
                                           bool outputRejectLevels )
 {
+    CV_TRACE_REGION("CascadeClassifier::detectMultiScale");
     const double GROUP_EPS = 0.2;
 
     CV_Assert( scaleFactor > 1 && image.depth() == CV_8U );